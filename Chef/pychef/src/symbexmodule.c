@@ -186,8 +186,7 @@ symbex_concrete(PyObject *self, PyObject *args) {
 	}
 
 	if (PyInt_Check(target)) {
-		PyIntObject *int_target = (PyIntObject*)target;
-		long value = int_target->ob_ival;
+		long value = PyInt_AS_LONG(target);
 		s2e_get_example(&value, sizeof(value));
 
 		return PyInt_FromLong(value);
@@ -152,8 +152,7 @@ PyObject *Sym_MakeConcolicInt(PyObject *target, const char *name,
         return NULL;
     }
 
-    PyIntObject *int_target = (PyIntObject*)target;
-    long value = int_target->ob_ival;
+    long value = PyInt_AS_LONG(target);
 
     if (max_value >= min_value && (value < min_value || value > max_value)) {
         PyErr_SetString(PyExc_ValueError, "Incompatible value constraints");
@@ -532,9 +532,9 @@ xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx*/
     /* new buffer API */
 
 #define PyObject_CheckBuffer(obj) \
-    (((obj)->ob_type->tp_as_buffer != NULL) &&                          \
-     (PyType_HasFeature((obj)->ob_type, Py_TPFLAGS_HAVE_NEWBUFFER)) && \
-     ((obj)->ob_type->tp_as_buffer->bf_getbuffer != NULL))
+    ((Py_TYPE((obj))->tp_as_buffer != NULL) &&                          \
+     (PyType_HasFeature(Py_TYPE((obj)), Py_TPFLAGS_HAVE_NEWBUFFER)) && \
+     (Py_TYPE((obj))->tp_as_buffer->bf_getbuffer != NULL))
 
     /* Return 1 if the getbuffer function is available, otherwise
        return 0 */
@@ -635,9 +635,9 @@ xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx*/
     is an iterator, this returns itself. */
 
 #define PyIter_Check(obj) \
-    (PyType_HasFeature((obj)->ob_type, Py_TPFLAGS_HAVE_ITER) && \
-     (obj)->ob_type->tp_iternext != NULL && \
-     (obj)->ob_type->tp_iternext != &_PyObject_NextNotImplemented)
+    (PyType_HasFeature(Py_TYPE((obj)), Py_TPFLAGS_HAVE_ITER) && \
+     Py_TYPE((obj))->tp_iternext != NULL && \
+     Py_TYPE((obj))->tp_iternext != &_PyObject_NextNotImplemented)
 
      PyAPI_FUNC(PyObject *) PyIter_Next(PyObject *);
      /* Takes an iterator object and calls its tp_iternext slot,
@@ -846,9 +846,9 @@ xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx*/
        */
 
 #define PyIndex_Check(obj) \
-   ((obj)->ob_type->tp_as_number != NULL && \
-    PyType_HasFeature((obj)->ob_type, Py_TPFLAGS_HAVE_INDEX) && \
-    (obj)->ob_type->tp_as_number->nb_index != NULL)
+   (Py_TYPE((obj))->tp_as_number != NULL && \
+    PyType_HasFeature(Py_TYPE((obj)), Py_TPFLAGS_HAVE_INDEX) && \
+    Py_TYPE((obj))->tp_as_number->nb_index != NULL)
 
      PyAPI_FUNC(PyObject *) PyNumber_Index(PyObject *o);
 
@@ -69,6 +69,13 @@ PyAPI_FUNC(PyObject *) PyEval_EvalFrameEx(struct _frame *f, int exc);
 PyAPI_DATA(volatile int) _Py_Ticker;
 PyAPI_DATA(int) _Py_CheckInterval;
 
+#ifdef WITH_THREAD
+/* Preferred thread switching period, in microseconds.  A thread waiting
+   for the GIL asks the running thread to drop it once this has elapsed. */
+PyAPI_FUNC(void) _PyEval_SetSwitchInterval(unsigned long microseconds);
+PyAPI_FUNC(unsigned long) _PyEval_GetSwitchInterval(void);
+#endif
+
 /* Interface for threads.
 
    A module that plans to do a blocking system call (or something else
@@ -38,9 +38,9 @@ typedef struct {
 
 PyAPI_DATA(PyTypeObject) PyClass_Type, PyInstance_Type, PyMethod_Type;
 
-#define PyClass_Check(op) ((op)->ob_type == &PyClass_Type)
-#define PyInstance_Check(op) ((op)->ob_type == &PyInstance_Type)
-#define PyMethod_Check(op) ((op)->ob_type == &PyMethod_Type)
+#define PyClass_Check(op) (Py_TYPE((op)) == &PyClass_Type)
+#define PyInstance_Check(op) (Py_TYPE((op)) == &PyInstance_Type)
+#define PyMethod_Check(op) (Py_TYPE((op)) == &PyMethod_Type)
 
 PyAPI_FUNC(PyObject *) PyClass_New(PyObject *, PyObject *, PyObject *);
 PyAPI_FUNC(PyObject *) PyInstance_New(PyObject *, PyObject *,
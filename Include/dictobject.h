@@ -15,57 +15,59 @@ extern "C" {
 */
 
 /*
-There are three kinds of slots in the table:
-
-1. Unused.  me_key == me_value == NULL
-   Does not hold an active (key, value) pair now and never did.  Unused can
-   transition to Active upon key insertion.  This is the only case in which
-   me_key is NULL, and is each slot's initial state.
-
-2. Active.  me_key != NULL and me_key != dummy and me_value != NULL
-   Holds an active (key, value) pair.  Active can transition to Dummy upon
-   key deletion.  This is the only case in which me_value != NULL.
-
-3. Dummy.  me_key == dummy and me_value == NULL
-   Previously held an active (key, value) pair, but that was deleted and an
-   active pair has not yet overwritten the slot.  Dummy can transition to
-   Active upon key insertion.  Dummy slots cannot be made Unused again
-   (cannot have me_key set to NULL), else the probe sequence in case of
-   collision would have no way to know they were once active.
-
-Note: .popitem() abuses the me_hash field of an Unused or Dummy slot to
-hold a search finger.  The me_hash field of Unused or Dummy slots has no
-meaning otherwise.
+A dict is made of two tables, allocated together in a single block:
+
+1. The entries, ma_table:  the (hash, key, value) triples, stored densely in
+   the order the keys were inserted.  The first ma_nentries are in use; an
+   entry whose key was deleted has me_key == me_value == NULL, and stays in
+   the table until it is rebuilt.
+
+2. The indices, ma_indices:  the hash table proper.  Each of its ma_mask + 1
+   slots is the index of an entry, or one of two negative values:
+   DKIX_EMPTY, for a slot that never held an entry, or DKIX_DUMMY, for a
+   slot whose entry was deleted.  Dummy slots cannot be made empty again,
+   else the probe sequence in case of collision would have no way to know
+   they were once active.  The indices are 1, 2, 4 or 8 bytes wide, the
+   smallest that can index the entries.
+
+Since an entry takes 24 bytes but an index only one for small dicts, and the
+entries only take as much room as the dict can hold before it is resized,
+this uses about a third less memory than a sparse table of entries, and
+iterating over a dict only scans its entries.
 */
 
-/* PyDict_MINSIZE is the minimum size of a dictionary.  This many slots are
- * allocated directly in the dict object (in the ma_smalltable member).
- * It must be a power of 2, and at least 4.  8 allows dicts with no more
- * than 5 active entries to live in ma_smalltable (and so avoid an
- * additional malloc); instrumentation suggested this suffices for the
- * majority of dicts (consisting mostly of usually-small instance dicts and
- * usually-small dicts created to pass keyword arguments).
+/*
+The instance dicts of a class can also be split:  they then share the
+indices, hashes and keys of a single table held by the class, and each only
+stores its values, in ma_values.  Their ma_used values fill ma_values[0]
+onwards, in the order of the shared keys; a dict that deletes a key or
+inserts one out of that order gets tables of its own first.
+*/
+
+/* PyDict_MINSIZE is the minimum size of the hash table of a dictionary.  It
+ * must be a power of 2, and at least 4.  8 allows dicts with no more than 5
+ * active entries to use the smallest table; instrumentation suggested this
+ * suffices for the majority of dicts (consisting mostly of usually-small
+ * instance dicts and usually-small dicts created to pass keyword arguments).
+ * An empty dict allocates no table at all.
  */
 #define PyDict_MINSIZE 8
 
 typedef struct {
-    /* Cached hash code of me_key.  Note that hash codes are C longs.
-     * We have to use Py_ssize_t instead because dict_popitem() abuses
-     * me_hash to hold a search finger.
-     */
+    /* Cached hash code of me_key.  Note that hash codes are C longs. */
     Py_ssize_t me_hash;
     PyObject *me_key;
     PyObject *me_value;
 } PyDictEntry;
 
 /*
-To ensure the lookup algorithm terminates, there must be at least one Unused
-slot (NULL key) in the table.
-The value ma_fill is the number of non-NULL keys (sum of Active and Dummy);
-ma_used is the number of non-NULL, non-dummy keys (== the number of non-NULL
-values == the number of Active items).
-To avoid slowing down lookups on a near-full table, we resize the table when
-it's two-thirds full.
+To ensure the lookup algorithm terminates, there must be at least one empty
+slot in the indices.
+The value ma_fill is the number of non-empty slots of the indices (sum of
+Active and Dummy); ma_used is the number of active entries.  The entries
+table only has room for two thirds of the slots of the indices:  to avoid
+slowing down lookups on a near-full table, the tables are resized when
+ma_fill reaches that, before a new key is inserted.
 */
 typedef struct _dictobject PyDictObject;
 struct _dictobject {
@@ -73,20 +75,29 @@ struct _dictobject {
     Py_ssize_t ma_fill;  /* # Active + # Dummy */
     Py_ssize_t ma_used;  /* # Active */
 
-    /* The table contains ma_mask + 1 slots, and that's a power of 2.
+    /* The indices contain ma_mask + 1 slots, and that's a power of 2.
      * We store the mask instead of the size because the mask is more
      * frequently needed.
      */
     Py_ssize_t ma_mask;
 
-    /* ma_table points to ma_smalltable for small tables, else to
-     * additional malloc'ed memory.  ma_table is never NULL!  This rule
-     * saves repeated runtime null-tests in the workhorse getitem and
-     * setitem calls.
+    /* The number of entries of ma_table in use, deleted or not:  new
+     * entries are appended at ma_table[ma_nentries].
      */
+    Py_ssize_t ma_nentries;
+
+    /* ma_indices points to the indices, and ma_table to the entries that
+     * follow them in the same block.  An empty dict shares a static table
+     * of PyDict_MINSIZE empty indices and no entries:  ma_indices is never
+     * NULL, which saves repeated runtime null-tests in the workhorse
+     * getitem and setitem calls.
+     */
+    void *ma_indices;
     PyDictEntry *ma_table;
+
+    /* The values of a split dict, or NULL if its entries hold them. */
+    PyObject **ma_values;
     PyDictEntry *(*ma_lookup)(PyDictObject *mp, PyObject *key, long hash);
-    PyDictEntry ma_smalltable[PyDict_MINSIZE];
 #ifdef _SYMBEX_DICT_HASHES
     int ma_flat;
 #endif
@@ -129,6 +140,15 @@ PyAPI_FUNC(int) _PyDict_Contains(PyObject *mp, PyObject *key, long hash);
 PyAPI_FUNC(PyObject *) _PyDict_NewPresized(Py_ssize_t minused);
 PyAPI_FUNC(void) _PyDict_MaybeUntrack(PyObject *mp);
 
+/* The keys shared by the instance dicts of a class */
+typedef struct _dictkeysobject PyDictKeysObject;
+
+PyAPI_FUNC(PyDictKeysObject *) _PyDict_NewKeysForClass(void);
+PyAPI_FUNC(void) _PyDictKeys_DecRef(PyDictKeysObject *keys);
+PyAPI_FUNC(PyObject *) _PyObjectDict_New(PyTypeObject *tp);
+PyAPI_FUNC(int) _PyObjectDict_SetItem(PyTypeObject *tp, PyObject **dictptr,
+                                      PyObject *key, PyObject *value);
+
 /* PyDict_Update(mp, other) is equivalent to PyDict_Merge(mp, other, 1). */
 PyAPI_FUNC(int) PyDict_Update(PyObject *mp, PyObject *other);
 
@@ -7,6 +7,8 @@ PyAPI_FUNC(double) _Py_dg_strtod(const char *str, char **ptr);
 PyAPI_FUNC(char *) _Py_dg_dtoa(double d, int mode, int ndigits,
                         int *decpt, int *sign, char **rve);
 PyAPI_FUNC(void) _Py_dg_freedtoa(char *s);
+PyAPI_FUNC(int) _Py_ryu_shortest(double d, char *digits,
+                                 int *decpt, int *sign);
 
 
 #ifdef __cplusplus
@@ -28,8 +28,13 @@ typedef struct {
 PyAPI_DATA(PyTypeObject) PyInt_Type;
 
 #define PyInt_Check(op) \
-		 PyType_FastSubclass((op)->ob_type, Py_TPFLAGS_INT_SUBCLASS)
-#define PyInt_CheckExact(op) ((op)->ob_type == &PyInt_Type)
+		 PyType_FastSubclass(Py_TYPE(op), Py_TPFLAGS_INT_SUBCLASS)
+#ifdef Py_TAGGED_INTS
+#define PyInt_CheckExact(op) \
+		 (_Py_IsTagged(op) || Py_TYPE(((PyObject *)(op))) == &PyInt_Type)
+#else
+#define PyInt_CheckExact(op) (Py_TYPE(op) == &PyInt_Type)
+#endif
 
 PyAPI_FUNC(PyObject *) PyInt_FromString(char*, char**, int);
 #ifdef Py_USING_UNICODE
@@ -47,8 +52,37 @@ PyAPI_FUNC(unsigned PY_LONG_LONG) PyInt_AsUnsignedLongLongMask(PyObject *);
 
 PyAPI_FUNC(long) PyInt_GetMax(void);
 
+#ifdef Py_TAGGED_INTS
+/* Tagged ints (see object.h).  _PyInt_CAN_TAG(v) tells whether the long v
+   fits in a tagged pointer, _PyInt_TAG(v) makes one and _PyInt_UNTAG(op)
+   gives its value back.  _PyInt_FROM_LONG(v) is PyInt_FromLong(v), inline
+   when v can be tagged. */
+#if SIZEOF_LONG < SIZEOF_VOID_P
+#define _PyInt_CAN_TAG(v) 1
+#else
+#define _PyInt_CAN_TAG(v) ((v) >= LONG_MIN / 2 && (v) <= LONG_MAX / 2)
+#endif
+#define _PyInt_TAG(v) ((PyObject *)(((Py_uintptr_t)(Py_intptr_t)(v) << 1) | 1))
+#define _PyInt_UNTAG(op) \
+		 ((long)Py_ARITHMETIC_RIGHT_SHIFT(Py_intptr_t, (Py_intptr_t)(op), 1))
+#define _PyInt_FROM_LONG(v) \
+		 (_PyInt_CAN_TAG(v) ? _PyInt_TAG(v) : PyInt_FromLong(v))
+
+/* Macro, trading safety for speed */
+#define PyInt_AS_LONG(op) (_Py_IsTagged(op) ? _PyInt_UNTAG(op) : \
+			   ((PyIntObject *)(op))->ob_ival)
+#else
+#define _PyInt_FROM_LONG(v) PyInt_FromLong(v)
+
 /* Macro, trading safety for speed */
 #define PyInt_AS_LONG(op) (((PyIntObject *)(op))->ob_ival)
+#endif /* Py_TAGGED_INTS */
+
+/* Return a new reference to an int object with the value of the int op that
+   is a real PyIntObject in memory, even in a build with tagged ints, for
+   code that needs to reach into the object or uses the low bit of object
+   pointers itself. */
+PyAPI_FUNC(PyObject *) PyInt_Box(PyObject *op);
 
 /* These aren't really part of the Int object, but they're handy; the protos
  * are necessary for systems that need the magic of PyAPI_FUNC and that want
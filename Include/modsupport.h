@@ -114,6 +114,17 @@ PyAPI_FUNC(int) PyModule_AddStringConstant(PyObject *, const char *, const char
  #endif
 #endif
 
+#ifdef Py_TAGGED_INTS
+ /* With tagged ints, extensions that read ob_type or ob_refcnt without
+    Py_TYPE() and Py_REFCNT() would crash; make them fail to load instead. */
+ #undef Py_InitModule4
+ #if SIZEOF_SIZE_T != SIZEOF_INT
+ #define Py_InitModule4 Py_InitModule4TaggedInts_64
+ #else
+ #define Py_InitModule4 Py_InitModule4TaggedInts
+ #endif
+#endif
+
 PyAPI_FUNC(PyObject *) Py_InitModule4(const char *name, PyMethodDef *methods,
                                       const char *doc, PyObject *self,
                                       int apiver);
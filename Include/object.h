@@ -111,8 +111,31 @@ typedef struct {
     PyObject_VAR_HEAD
 } PyVarObject;
 
+#ifdef Py_TAGGED_INTS
+/* In a build with tagged ints, an int whose value fits in a pointer with a
+ * bit to spare isn't allocated:  the PyObject* holding it is the value
+ * shifted left by one bit, with the low bit set (see intobject.h).  Real
+ * objects are at least 2-aligned, so their low bit is clear.  Py_TYPE() of
+ * a tagged int is &PyInt_Type and Py_REFCNT() a dummy that reference
+ * counting never touches; both stay lvalues, so that the usual
+ * assignments through them still compile.  Like Py_DECREF(), these macros
+ * evaluate their argument more than once.  Code that reads ob_type or
+ * ob_refcnt directly must go through them instead.
+ */
+#define _Py_IsTagged(ob)        (((Py_uintptr_t)(ob) & 1) != 0)
+PyAPI_DATA(struct _typeobject *) _Py_TaggedIntType;
+PyAPI_DATA(Py_ssize_t) _Py_TaggedIntRefcnt;
+#define Py_REFCNT(ob)           (*(_Py_IsTagged(ob) ?                   \
+                                   &_Py_TaggedIntRefcnt :               \
+                                   &((PyObject*)(ob))->ob_refcnt))
+#define Py_TYPE(ob)             (*(_Py_IsTagged(ob) ?                   \
+                                   &_Py_TaggedIntType :                 \
+                                   &((PyObject*)(ob))->ob_type))
+#else
+#define _Py_IsTagged(ob)        0
 #define Py_REFCNT(ob)           (((PyObject*)(ob))->ob_refcnt)
 #define Py_TYPE(ob)             (((PyObject*)(ob))->ob_type)
+#endif /* Py_TAGGED_INTS */
 #define Py_SIZE(ob)             (((PyVarObject*)(ob))->ob_size)
 
 /*
@@ -425,6 +448,8 @@ typedef struct _heaptypeobject {
                                       see add_operators() in typeobject.c . */
     PyBufferProcs as_buffer;
     PyObject *ht_name, *ht_slots;
+    /* The keys shared by the dicts of the instances, or NULL */
+    struct _dictkeysobject *ht_cached_keys;
     /* here are optional user slots, followed by the members. */
 } PyHeapTypeObject;
 
@@ -705,7 +730,6 @@ environment the global variable trick is not safe.)
 PyAPI_DATA(Py_ssize_t) _Py_RefTotal;
 PyAPI_FUNC(void) _Py_NegativeRefcount(const char *fname,
                                             int lineno, PyObject *op);
-PyAPI_FUNC(PyObject *) _PyDict_Dummy(void);
 PyAPI_FUNC(PyObject *) _PySet_Dummy(void);
 PyAPI_FUNC(Py_ssize_t) _Py_GetRefTotal(void);
 #define _Py_INC_REFTOTAL        _Py_RefTotal++
@@ -762,6 +786,40 @@ PyAPI_FUNC(void) _Py_AddToAllObjects(PyObject *, int force);
     (*Py_TYPE(op)->tp_dealloc)((PyObject *)(op)))
 #endif /* !Py_TRACE_REFS */
 
+#ifdef Py_IMMORTAL_OBJECTS
+/* Immortal objects are never deallocated, and Py_INCREF and Py_DECREF
+ * leave their refcount alone, so that the memory pages holding them stay
+ * shared between forked processes.  _Py_SetImmortal() sets their refcount
+ * to _Py_IMMORTAL_REFCNT, but any refcount above PY_SSIZE_T_MAX / 4 is
+ * immortal:  code that changes it without these macros, like extension
+ * modules built without Py_IMMORTAL_OBJECTS, can't make them mortal again.
+ * The dummy refcount of tagged ints is immortal, too.
+ */
+#define _Py_IMMORTAL_REFCNT     (PY_SSIZE_T_MAX / 2)
+#define _Py_IsImmortal(op)      (Py_REFCNT(op) > PY_SSIZE_T_MAX / 4)
+PyAPI_FUNC(void) _Py_SetImmortal(PyObject *);
+#define _Py_SkipRefcnt(op)      _Py_IsImmortal(op)
+#elif defined(Py_TAGGED_INTS)
+#define _Py_SkipRefcnt(op)      _Py_IsTagged(op)
+#endif
+
+#ifdef _Py_SkipRefcnt
+#define Py_INCREF(op) (                         \
+    _Py_SkipRefcnt(op) ? (void)0 : (void)(      \
+    _Py_INC_REFTOTAL  _Py_REF_DEBUG_COMMA       \
+    ((PyObject*)(op))->ob_refcnt++))
+
+#define Py_DECREF(op)                                   \
+    do {                                                \
+        if (_Py_SkipRefcnt(op))                         \
+            ;                                           \
+        else if (_Py_DEC_REFTOTAL  _Py_REF_DEBUG_COMMA  \
+        --((PyObject*)(op))->ob_refcnt != 0)            \
+            _Py_CHECK_REFCNT(op)                        \
+        else                                            \
+        _Py_Dealloc((PyObject *)(op));                  \
+    } while (0)
+#else
 #define Py_INCREF(op) (                         \
     _Py_INC_REFTOTAL  _Py_REF_DEBUG_COMMA       \
     ((PyObject*)(op))->ob_refcnt++)
@@ -774,6 +832,7 @@ PyAPI_FUNC(void) _Py_AddToAllObjects(PyObject *, int force);
         else                                            \
         _Py_Dealloc((PyObject *)(op));                  \
     } while (0)
+#endif /* _Py_SkipRefcnt */
 
 /* Safely decref `op` and set `op` to NULL, especially useful in tp_clear
  * and tp_dealloc implementatons.
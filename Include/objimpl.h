@@ -98,6 +98,20 @@ PyAPI_FUNC(void *) PyObject_Malloc(size_t);
 PyAPI_FUNC(void *) PyObject_Realloc(void *, size_t);
 PyAPI_FUNC(void) PyObject_Free(void *);
 
+/* Sampled allocation tracing, used by the _tracemalloc module.  While hooks
+   are set, each time `countdown` bytes have been allocated by
+   PyObject_Malloc() or PyObject_Realloc(), the block that crossed it is
+   passed to hooks->sample(), which returns the bytes until the next sample.
+   Every block freed, or resized, is passed to hooks->forget().  The hooks
+   are called with the GIL held and tracing suspended.  Pass NULL hooks to
+   stop tracing. */
+typedef struct {
+    Py_ssize_t (*sample)(void *ptr, size_t size);
+    void (*forget)(void *ptr);
+} _PyObject_TraceHooks;
+PyAPI_FUNC(void) _PyObject_SetTraceHooks(_PyObject_TraceHooks *hooks,
+                                         Py_ssize_t countdown);
+
 
 /* Macros */
 #ifdef WITH_PYMALLOC
@@ -150,6 +150,21 @@ extern "C" {
 #define SET_ADD         146
 #define MAP_ADD         147
 
+/* Type-specialized forms of the opcodes above.  The compiler never emits
+   these: the eval loop rewrites generic instructions into them in the
+   private quickened copy of a code object's bytecode (see ceval.c). */
+#define BINARY_ADD_INT          6
+#define BINARY_SUBTRACT_INT     7
+#define BINARY_MULTIPLY_INT     8
+#define BINARY_FLOOR_DIVIDE_INT 14
+#define BINARY_MODULO_INT       16
+#define BINARY_ADD_FLOAT        17
+#define BINARY_SUBTRACT_FLOAT   18
+#define BINARY_MULTIPLY_FLOAT   34
+#define BINARY_DIVIDE_FLOAT     35
+#define COMPARE_OP_INT          117
+#define COMPARE_OP_FLOAT        118
+
 
 enum cmp_op {PyCmp_LT=Py_LT, PyCmp_LE=Py_LE, PyCmp_EQ=Py_EQ, PyCmp_NE=Py_NE, PyCmp_GT=Py_GT, PyCmp_GE=Py_GE,
 	     PyCmp_IN, PyCmp_NOT_IN, PyCmp_IS, PyCmp_IS_NOT, PyCmp_EXC_MATCH, PyCmp_BAD};
@@ -100,7 +100,7 @@ PyAPI_FUNC(void) PyErr_NormalizeException(PyObject**, PyObject**, PyObject**);
 
 #define PyExceptionInstance_Check(x)                    \
     (PyInstance_Check((x)) ||                           \
-     PyType_FastSubclass((x)->ob_type, Py_TPFLAGS_BASE_EXC_SUBCLASS))
+     PyType_FastSubclass(Py_TYPE((x)), Py_TPFLAGS_BASE_EXC_SUBCLASS))
 
 #define PyExceptionClass_Name(x)                                   \
     (PyClass_Check((x))                                            \
@@ -110,7 +110,7 @@ PyAPI_FUNC(void) PyErr_NormalizeException(PyObject**, PyObject**, PyObject**);
 #define PyExceptionInstance_Class(x)                                    \
     ((PyInstance_Check((x))                                             \
       ? (PyObject*)((PyInstanceObject*)(x))->in_class                   \
-      : (PyObject*)((x)->ob_type)))
+      : (PyObject*)(Py_TYPE((x)))))
 
 
 /* Predefined exceptions */
@@ -95,6 +95,13 @@ typedef struct _ts {
     PyObject *async_exc; /* Asynchronous exception to raise */
     long thread_id; /* Thread id where this tstate was created */
 
+    struct _framechunk *frame_chunk; /* frame arena (see frameobject.c) */
+
+    /* Frame of a FOR_ITER or PyIter_Next() in progress.  StopIteration
+       escaping one of its callees is discarded, so no traceback entry
+       needs to be recorded for it (see ceval.c). */
+    struct _frame *iternext_frame;
+
     /* XXX signal handlers should also be here */
 
 } PyThreadState;
@@ -129,6 +129,44 @@ PyAPI_FUNC(int) _PyLong_Init(void);
 PyAPI_FUNC(void) _PyFloat_Init(void);
 PyAPI_FUNC(int) PyByteArray_Init(void);
 PyAPI_FUNC(void) _PyRandom_Init(void);
+PyAPI_FUNC(void) _PyFreeLists_Init(void);
+
+/* The free list on which a type keeps deallocated objects to reuse them.
+   maxfree is set from PYTHONFREELISTS at startup; sys.getfreeliststats()
+   reports the rest.  hits and misses are only counted with
+   Py_FREELIST_STATS (see Misc/SpecialBuilds.txt), so that allocations
+   don't pay for them otherwise. */
+typedef struct {
+    const char *name;
+    Py_ssize_t maxfree;         /* most objects kept */
+    Py_ssize_t numfree;         /* objects kept now */
+    Py_ssize_t hits;            /* allocations that reused one */
+    Py_ssize_t misses;          /* allocations that didn't */
+} _PyFreeList;
+
+/* Py_DEBUG implies Py_FREELIST_STATS. */
+#if defined(Py_DEBUG) && !defined(Py_FREELIST_STATS)
+#define Py_FREELIST_STATS
+#endif
+
+#ifdef Py_FREELIST_STATS
+#define _PyFreeList_HIT(fl)     ((fl).hits++)
+#define _PyFreeList_MISS(fl)    ((fl).misses++)
+#else
+#define _PyFreeList_HIT(fl)     ((void)0)
+#define _PyFreeList_MISS(fl)    ((void)0)
+#endif
+
+PyAPI_DATA(_PyFreeList) _PyInt_FreeList;
+PyAPI_DATA(_PyFreeList) _PyInt_SmallInts;
+PyAPI_DATA(_PyFreeList) _PyFloat_FreeList;
+PyAPI_DATA(_PyFreeList) _PyTuple_FreeList;
+PyAPI_DATA(_PyFreeList) _PyList_FreeList;
+PyAPI_DATA(_PyFreeList) _PyDict_FreeList;
+PyAPI_DATA(_PyFreeList) _PyFrame_FreeList;
+
+/* The free lists above, NULL-terminated */
+PyAPI_DATA(_PyFreeList *) _PyFreeLists[];
 
 /* Various internal finalizers */
 PyAPI_FUNC(void) _PyExc_Fini(void);
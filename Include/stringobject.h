@@ -95,6 +95,47 @@ PyAPI_FUNC(void) _Py_ReleaseInternedStrings(void);
    x must be an iterable object. */
 PyAPI_FUNC(PyObject *) _PyString_Join(PyObject *sep, PyObject *x);
 
+/* _PyStringWriter builds a string a piece at a time, for join(), the %
+   operator, format() and the repr of containers.  It writes into
+   small_buffer, an array of small_size bytes the caller keeps on the
+   stack, until the result outgrows it: only then does it move to a string
+   object, which grows by a quarter more than asked for while overallocate
+   is set (it is, after _PyStringWriter_Init()).  A short result is thus
+   only allocated by _PyStringWriter_Finish().  Functions that can recurse
+   through themselves in C, like the repr of containers, should pass NULL
+   and 0 instead, so that each level's stack frame stays small.
+   _PyStringWriter_SMALL is the size to give small_buffer.
+
+   Bytes are written at str + pos, up to str + size; the macro
+   _PyStringWriter_PREPARE(writer, count) makes room for count more and
+   returns 0, or -1 with an exception set.  Once initialized, a writer
+   must be given to _PyStringWriter_Finish() or _PyStringWriter_Dealloc(). */
+
+#define _PyStringWriter_SMALL 512
+
+typedef struct {
+    char *str;                  /* start of the buffer */
+    Py_ssize_t pos;             /* bytes written */
+    Py_ssize_t size;            /* bytes the buffer holds */
+    PyObject *buffer;           /* the string object holding str, or NULL
+                                   while str is the caller's small_buffer */
+    int overallocate;
+} _PyStringWriter;
+
+PyAPI_FUNC(void) _PyStringWriter_Init(_PyStringWriter *writer,
+                                      char *small_buffer,
+                                      Py_ssize_t small_size);
+PyAPI_FUNC(int) _PyStringWriter_Grow(_PyStringWriter *writer,
+                                     Py_ssize_t count);
+PyAPI_FUNC(int) _PyStringWriter_Write(_PyStringWriter *writer,
+                                      const char *s, Py_ssize_t count);
+PyAPI_FUNC(PyObject *) _PyStringWriter_Finish(_PyStringWriter *writer);
+PyAPI_FUNC(void) _PyStringWriter_Dealloc(_PyStringWriter *writer);
+
+#define _PyStringWriter_PREPARE(writer, count) \
+    ((count) <= (writer)->size - (writer)->pos ? 0 : \
+     _PyStringWriter_Grow((writer), (count)))
+
 /* --- Generic Codecs ----------------------------------------------------- */
 
 /* Create an object by decoding the encoded string s of the
@@ -229,6 +229,11 @@ typedef PY_UNICODE_TYPE Py_UNICODE;
 # define _PyUnicode_ToNumeric _PyUnicodeUCS2_ToNumeric
 # define _PyUnicode_ToTitlecase _PyUnicodeUCS2_ToTitlecase
 # define _PyUnicode_ToUppercase _PyUnicodeUCS2_ToUppercase
+# define _PyUnicodeWriter_Dealloc _PyUnicodeUCS2Writer_Dealloc
+# define _PyUnicodeWriter_Finish _PyUnicodeUCS2Writer_Finish
+# define _PyUnicodeWriter_Grow _PyUnicodeUCS2Writer_Grow
+# define _PyUnicodeWriter_Init _PyUnicodeUCS2Writer_Init
+# define _PyUnicodeWriter_Write _PyUnicodeUCS2Writer_Write
 
 #else
 
@@ -316,6 +321,11 @@ typedef PY_UNICODE_TYPE Py_UNICODE;
 # define _PyUnicode_ToNumeric _PyUnicodeUCS4_ToNumeric
 # define _PyUnicode_ToTitlecase _PyUnicodeUCS4_ToTitlecase
 # define _PyUnicode_ToUppercase _PyUnicodeUCS4_ToUppercase
+# define _PyUnicodeWriter_Dealloc _PyUnicodeUCS4Writer_Dealloc
+# define _PyUnicodeWriter_Finish _PyUnicodeUCS4Writer_Finish
+# define _PyUnicodeWriter_Grow _PyUnicodeUCS4Writer_Grow
+# define _PyUnicodeWriter_Init _PyUnicodeUCS4Writer_Init
+# define _PyUnicodeWriter_Write _PyUnicodeUCS4Writer_Write
 
 
 #endif
@@ -402,9 +412,9 @@ typedef PY_UNICODE_TYPE Py_UNICODE;
    valid, and the substring must not be empty */
 
 #define Py_UNICODE_MATCH(string, offset, substring) \
-    ((*((string)->str + (offset)) == *((substring)->str)) && \
-    ((*((string)->str + (offset) + (substring)->length-1) == *((substring)->str + (substring)->length-1))) && \
-     !memcmp((string)->str + (offset), (substring)->str, (substring)->length*sizeof(Py_UNICODE)))
+    ((*(PyUnicode_AS_UNICODE(string) + (offset)) == *PyUnicode_AS_UNICODE(substring)) && \
+    ((*(PyUnicode_AS_UNICODE(string) + (offset) + (substring)->length-1) == *(PyUnicode_AS_UNICODE(substring) + (substring)->length-1))) && \
+     !memcmp(PyUnicode_AS_UNICODE(string) + (offset), PyUnicode_AS_UNICODE(substring), (substring)->length*sizeof(Py_UNICODE)))
 
 #ifdef __cplusplus
 extern "C" {
@@ -420,6 +430,12 @@ typedef struct {
     PyObject *defenc;           /* (Default) Encoded version as Python
                                    string, or NULL; this is used for
                                    implementing the buffer protocol */
+#ifdef Py_COMPACT_UNICODE
+    void *data;                 /* Narrow buffer while str is NULL */
+    int kind;                   /* Bytes per code unit in data: 1, or 2 in
+                                   UCS4 builds; Py_UNICODE_SIZE once the
+                                   string is wide */
+#endif
 } PyUnicodeObject;
 
 PyAPI_DATA(PyTypeObject) PyUnicode_Type;
@@ -433,10 +449,23 @@ PyAPI_DATA(PyTypeObject) PyUnicode_Type;
     (((PyUnicodeObject *)(op))->length)
 #define PyUnicode_GET_DATA_SIZE(op) \
     (((PyUnicodeObject *)(op))->length * sizeof(Py_UNICODE))
+#ifdef Py_COMPACT_UNICODE
+/* A compact string only gets its Py_UNICODE buffer when it's first asked
+   for; this can fail with a MemoryError and return NULL. */
+#define PyUnicode_AS_UNICODE(op) \
+    (((PyUnicodeObject *)(op))->str != NULL ? \
+     ((PyUnicodeObject *)(op))->str : \
+     _PyUnicode_Widen((PyUnicodeObject *)(op)))
+#else
 #define PyUnicode_AS_UNICODE(op) \
     (((PyUnicodeObject *)(op))->str)
+#endif
 #define PyUnicode_AS_DATA(op) \
-    ((const char *)((PyUnicodeObject *)(op))->str)
+    ((const char *)PyUnicode_AS_UNICODE(op))
+
+#ifdef Py_COMPACT_UNICODE
+PyAPI_FUNC(Py_UNICODE *) _PyUnicode_Widen(PyUnicodeObject *unicode);
+#endif
 
 /* --- Constants ---------------------------------------------------------- */
 
@@ -562,6 +591,35 @@ PyAPI_FUNC(PyObject *) _PyUnicode_FormatAdvanced(PyObject *obj,
                                                  Py_UNICODE *format_spec,
                                                  Py_ssize_t format_spec_len);
 
+/* _PyUnicodeWriter builds a Unicode object a piece at a time, as
+   _PyStringWriter does a string (see stringobject.h); the buffer inside
+   it holds _PyUnicodeWriter_SMALL characters. */
+
+#define _PyUnicodeWriter_SMALL 256
+
+typedef struct {
+    Py_UNICODE *str;            /* start of the buffer */
+    Py_ssize_t pos;             /* characters written */
+    Py_ssize_t size;            /* characters the buffer holds */
+    PyObject *buffer;           /* the Unicode object holding str, or NULL
+                                   while str is small_buffer */
+    int overallocate;
+    Py_UNICODE small_buffer[_PyUnicodeWriter_SMALL];
+} _PyUnicodeWriter;
+
+PyAPI_FUNC(void) _PyUnicodeWriter_Init(_PyUnicodeWriter *writer);
+PyAPI_FUNC(int) _PyUnicodeWriter_Grow(_PyUnicodeWriter *writer,
+                                      Py_ssize_t count);
+PyAPI_FUNC(int) _PyUnicodeWriter_Write(_PyUnicodeWriter *writer,
+                                       const Py_UNICODE *s,
+                                       Py_ssize_t count);
+PyAPI_FUNC(PyObject *) _PyUnicodeWriter_Finish(_PyUnicodeWriter *writer);
+PyAPI_FUNC(void) _PyUnicodeWriter_Dealloc(_PyUnicodeWriter *writer);
+
+#define _PyUnicodeWriter_PREPARE(writer, count) \
+    ((count) <= (writer)->size - (writer)->pos ? 0 : \
+     _PyUnicodeWriter_Grow((writer), (count)))
+
 /* --- wchar_t support for platforms which support it --------------------- */
 
 #ifdef HAVE_WCHAR_H
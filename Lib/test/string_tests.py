@@ -212,6 +212,58 @@ class CommonTest(unittest.TestCase):
                 if loc != -1:
                     self.assertEqual(i[loc:loc+len(j)], j)
 
+    def test_find_periodic_pattern(self):
+        # Needles that keep almost matching make the search switch to
+        # the linear two-way algorithm part of the way through
+        def naive_find(haystack, needle):
+            for i in xrange(len(haystack) - len(needle) + 1):
+                if haystack[i:i+len(needle)] == needle:
+                    return i
+            return -1
+        haystacks = ['a' * 5000, 'ab' * 2500, 'aab' * 1700,
+                     ('x' * 99 + '\n') * 50]
+        needles = ['a' * 100 + 'ba', 'a' * 100 + 'b', 'a' * 3000,
+                   'ab' * 60 + 'bb', 'ab' * 100 + 'a', 'aab' * 40 + 'aa',
+                   'ba' * 30 + 'a' * 70, 'x' * 100 + '\n', 'x' * 98 + '\n']
+        for haystack in haystacks:
+            for needle in needles:
+                for tail in ['', needle, needle + 'c' + needle]:
+                    h = haystack + tail
+                    expected = naive_find(h, needle)
+                    self.checkequal(expected, h, 'find', needle)
+        self.checkequal(4, 'c' + 'a' * 4000 + 'c', 'count', 'a' * 1000)
+        self.checkequal(2, ('a' * 1200 + 'b') * 2 + 'a' * 200, 'count',
+                        'a' * 1000 + 'b' + 'a' * 200)
+        self.checkequal(1000, 'aab' * 5000, 'count', 'aab' * 5)
+        self.checkequal(1, 'aab' * 5000, 'count', 'aab' * 5, 0, 20)
+        self.checkequal(19, 'ab' * 5000, 'count', 'ab' * 100 + 'a', 0, 4000)
+        self.checkequal(7, 'a' * 3000 + 'b' * 7, 'find', 'a' * 2993 + 'b')
+        self.checkequal(-1, 'a' * 3000 + 'b' * 7, 'find',
+                        'a' * 2993 + 'b', 8)
+
+    def test_rfind_periodic_pattern(self):
+        # The mirror images of the needles above make the reverse search
+        # switch to two-way as well
+        def naive_rfind(haystack, needle):
+            for i in xrange(len(haystack) - len(needle), -1, -1):
+                if haystack[i:i+len(needle)] == needle:
+                    return i
+            return -1
+        haystacks = ['a' * 5000, 'ba' * 2500, 'baa' * 1700,
+                     ('\n' + 'x' * 99) * 50]
+        needles = ['ab' + 'a' * 100, 'b' + 'a' * 100, 'a' * 3000,
+                   'bb' + 'ba' * 60, 'a' + 'ba' * 100, 'aa' + 'baa' * 40,
+                   'a' * 70 + 'ab' * 30, '\n' + 'x' * 100, '\n' + 'x' * 98]
+        for haystack in haystacks:
+            for needle in needles:
+                for head in ['', needle, needle + 'c' + needle]:
+                    h = head + haystack
+                    expected = naive_rfind(h, needle)
+                    self.checkequal(expected, h, 'rfind', needle)
+        self.checkequal(6, 'b' * 7 + 'a' * 3000, 'rfind', 'b' + 'a' * 2993)
+        self.checkequal(-1, 'b' * 7 + 'a' * 3000, 'rfind',
+                        'b' + 'a' * 2993, 0, 2999)
+
     def test_rfind(self):
         self.checkequal(9,  'abcdefghiabc', 'rfind', 'abc')
         self.checkequal(12, 'abcdefghiabc', 'rfind', '')
@@ -1103,6 +1155,12 @@ class MixinStrUnicodeUserStringTest:
         self.checkraises(TypeError, '%d', '__mod__', "42") # not numeric
         self.checkraises(TypeError, '%d', '__mod__', (42+0j)) # no int/long conversion provided
 
+        # results that outgrow the first buffer
+        self.checkequal('<' + 'x' * 1000 + '> 42', '<%s> %d', '__mod__',
+                        ('x' * 1000, 42))
+        self.checkequal(' ' * 997 + 'abc' + 'abc|' * 300, '%1000s' + '%s|' * 300,
+                        '__mod__', ('abc',) * 301)
+
         # argument names with properly nested brackets are supported
         self.checkequal('bar', '%((foo))s', '__mod__', {'(foo)': 'bar'})
 
@@ -1177,6 +1235,11 @@ class MixinStrUnicodeUserStringTest:
         # mixed use of str and unicode
         self.assertEqual('a/b/c'.rpartition(u'/'), ('a/b', '/', 'c'))
 
+        # a needle that keeps almost matching
+        self.checkequal(('a' * 1000, 'ab' + 'a' * 999, 'c' + 'a' * 3000),
+                        'a' * 1000 + 'ab' + 'a' * 999 + 'c' + 'a' * 3000,
+                        'rpartition', 'ab' + 'a' * 999)
+
     def test_none_arguments(self):
         # issue 11828
         s = 'hello'
@@ -2,7 +2,7 @@ import unittest
 from test import test_support
 
 import UserDict, random, string
-import gc, weakref
+import gc, weakref, sys
 
 
 class DictTest(unittest.TestCase):
@@ -650,6 +650,80 @@ class DictTest(unittest.TestCase):
             pass
         self._tracked(MyDict())
 
+    @test_support.cpython_only
+    def test_split_table(self):
+        # The instances of a class share the keys of their dicts
+        class C(object):
+            def __init__(self, n):
+                self.a, self.b, self.c = n, n + 1, n + 2
+        a, b = C(1), C(2)
+        self.assertEqual(sys.getsizeof(a.__dict__), sys.getsizeof(b.__dict__))
+        self.assertLess(sys.getsizeof(a.__dict__),
+                        sys.getsizeof(dict(a.__dict__)))
+        self.assertEqual(a.__dict__, {'a': 1, 'b': 2, 'c': 3})
+        self.assertEqual(b.__dict__.items(), [('a', 2), ('b', 3), ('c', 4)])
+        self.assertEqual(list(b.__dict__.itervalues()), [2, 3, 4])
+        self.assertEqual(vars(b).popitem(), ('c', 4))
+        b.c = 5
+        self.assertEqual(b.__dict__.items(), [('a', 2), ('b', 3), ('c', 5)])
+        self.assertEqual(a.__dict__.copy(), {'a': 1, 'b': 2, 'c': 3})
+
+        # The dicts that diverge from the others get keys of their own
+        c = C(3)
+        c.d = 6
+        del c.a
+        self.assertEqual(c.__dict__.items(), [('b', 4), ('c', 5), ('d', 6)])
+        self.assertRaises(AttributeError, getattr, c, 'a')
+        d = C(4)
+        d.e, d.d = 8, 7
+        self.assertEqual(d.__dict__.keys(), ['a', 'b', 'c', 'e', 'd'])
+        d.__dict__[1] = 'one'
+        self.assertEqual(d.__dict__[1], 'one')
+        self.assertEqual((d.a, d.b, d.c, d.d, d.e), (4, 5, 6, 7, 8))
+        self.assertEqual(a.__dict__, {'a': 1, 'b': 2, 'c': 3})
+        e = C(5)
+        self.assertRaises(KeyError, e.__dict__.pop, 'd')
+        self.assertEqual(e.__dict__.pop('a'), 5)
+        self.assertEqual(e.__dict__, {'b': 6, 'c': 7})
+        e.__dict__.clear()
+        self.assertEqual(e.__dict__, {})
+        e.z = 1
+        self.assertEqual(e.__dict__, {'z': 1})
+
+    @test_support.cpython_only
+    def test_split_table_grows(self):
+        # The keys shared by a class grow with its first instance
+        class C(object):
+            def __init__(self, n):
+                for i in range(n):
+                    setattr(self, 'x%d' % i, i)
+        a, b = C(50), C(50)
+        self.assertEqual(sys.getsizeof(a.__dict__), sys.getsizeof(b.__dict__))
+        self.assertLess(sys.getsizeof(b.__dict__),
+                        sys.getsizeof(dict(b.__dict__)))
+        self.assertEqual(b.__dict__, dict(('x%d' % i, i) for i in range(50)))
+        self.assertEqual(C(10).__dict__,
+                         dict(('x%d' % i, i) for i in range(10)))
+
+    def test_split_table_cycles(self):
+        class C(object):
+            pass
+        a = C()
+        a.x = 1
+        a.me = a
+        ref = weakref.ref(a)
+        del a
+        gc.collect()
+        self.assertIsNone(ref())
+
+    def test_split_table_globals(self):
+        class C(object):
+            pass
+        a = C()
+        a.x = 2
+        exec "y = x * len([x])" in vars(a)
+        self.assertEqual(a.y, 2)
+
 
 from test import mapping_tests
 
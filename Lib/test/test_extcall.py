@@ -310,6 +310,33 @@ class ExtCallTest(unittest.TestCase):
         else:
             self.fail("duplicate arguments didn't raise")
 
+    def test_keywords_bound_without_merging(self):
+        # Calls to Python functions with *args/**kwargs bind the stack and
+        # the mapping directly into the callee's frame.
+        def f(a, b=2, *args, **kw):
+            return a, b, args, kw
+        self.assertEqual(f(1, *(2, 3), **{'c': 4}), (1, 2, (3,), {'c': 4}))
+        self.assertEqual(f(*range(20), **{})[2], tuple(range(2, 20)))
+        kwargs = dict(('k%d' % i, i) for i in range(40))
+        self.assertEqual(f(0, x=1, **kwargs)[3],
+                         dict(kwargs, x=1))
+        self.assertRaises(TypeError, lambda: f(1, b=2, **{'b': 3}))
+        self.assertRaises(TypeError, lambda: f(1, c=2, **{'c': 3}))
+        # the callee gets its own **kw dict
+        self.assertIsNot(f(1, **kwargs)[3], kwargs)
+        # a non-interned keyword still matches a named parameter; a
+        # one-character name would come from the interned character cache
+        def h(alpha, beta=2, **kw):
+            return beta, kw
+        name = ''.join(['be', 'ta'])
+        self.assertIsNot(name, 'beta')
+        self.assertEqual(h(1, **{name: 5}), (5, {}))
+
+        def g(**kw):
+            kwargs.clear()
+            return kw
+        self.assertEqual(len(g(**kwargs)), 40)
+
 
 def test_main():
     test_support.run_doctest(sys.modules[__name__], True)
@@ -689,6 +689,49 @@ class ReprTestCase(unittest.TestCase):
             self.assertEqual(s, repr(float(s)))
             self.assertEqual(negs, repr(float(negs)))
 
+    @unittest.skipUnless(getattr(sys, 'float_repr_style', '') == 'short',
+                         "applies only when using short float repr style")
+    def test_shortest_and_rounded_digits(self):
+        # repr() gives the shortest digits that round back to the float,
+        # and of those the closest; '%e' and '%f' round the exact value
+        # half-even.  Check both against exact decimal arithmetic, for
+        # values that include exact ties and subnormals.
+        from decimal import Decimal, Context, ROUND_HALF_EVEN
+        ctx = Context(prec=800, rounding=ROUND_HALF_EVEN)
+        rng = random.Random(4512)
+        values = [5e-324, 2.2250738585072014e-308, 2.2250738585072009e-308,
+                  1.7976931348623157e+308, 1e23, 9007199254740993.0,
+                  2.0**-1022 * 3, 0.3, 2.675, 0.125, 1.5e-5]
+        for i in range(300):
+            values.append(struct.unpack('<d', struct.pack('<Q',
+                rng.randrange(0x7ff0000000000000)))[0])
+            values.append(ldexp(rng.randrange(1, 2**20) * 5**rng.randrange(8),
+                                rng.randrange(-1074, 960)))
+            values.append(float('%d.%de%d' % (rng.randrange(10**6),
+                rng.randrange(1000), rng.randrange(-300, 300))))
+        for x in values:
+            exact = Decimal(x)
+            r = repr(x)
+            self.assertEqual(float(r), x)
+            digits = Decimal(r).normalize().as_tuple().digits
+            n = len(digits)
+            if n > 1:
+                short_ctx = Context(prec=n-1)
+                shorter = short_ctx.create_decimal(exact)
+                for d in (shorter.next_minus(context=short_ctx), shorter,
+                          shorter.next_plus(context=short_ctx)):
+                    self.assertNotEqual(float(d), x, (r, d))
+            nearest = Context(prec=n, rounding=ROUND_HALF_EVEN).plus(exact)
+            self.assertEqual(abs(Decimal(r) - exact),
+                             abs(nearest - exact), r)
+            for p in (0, 1, 5, 11, 14, 15, 16):
+                rounded = Context(prec=p+1).plus(exact)
+                self.assertEqual(Decimal('%.*e' % (p, x)), rounded,
+                                 (r, p))
+                self.assertEqual(Decimal('%.*f' % (p, x)),
+                                 exact.quantize(Decimal(10) ** -p,
+                                                context=ctx), (r, p))
+
 
 @requires_IEEE_754
 class RoundTestCase(unittest.TestCase):
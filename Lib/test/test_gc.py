@@ -1,8 +1,9 @@
 import unittest
-from test.test_support import verbose, run_unittest
+from test.test_support import verbose, run_unittest, captured_output
 import sys
 import gc
 import weakref
+from test.script_helper import assert_python_ok
 
 ### Support code
 ###############################################################################
@@ -264,6 +265,64 @@ class GCTests(unittest.TestCase):
         gc.collect(2)
         assertEqual(gc.get_count(), (0, 0, 0))
 
+    def test_get_stats(self):
+        stats = gc.get_stats()
+        self.assertEqual(len(stats), 3)
+        for st in stats:
+            self.assertEqual(len(st['pause_histogram']), 24)
+            self.assertEqual(sum(st['pause_histogram']), st['collections'])
+            self.assertGreaterEqual(st['pause_total'], st['pause_max'])
+        old = gc.get_stats()
+        L = [[]]
+        L[0].append(L)
+        del L
+        gc.collect(0)
+        new = gc.get_stats()
+        self.assertEqual(new[0]['collections'], old[0]['collections'] + 1)
+        self.assertGreaterEqual(new[0]['examined'], old[0]['examined'] + 2)
+        self.assertEqual(new[0]['collected'], old[0]['collected'] + 2)
+        self.assertEqual(sum(new[0]['pause_histogram']),
+                         sum(old[0]['pause_histogram']) + 1)
+        self.assertEqual(new[1:], old[1:])
+
+    def test_freeze(self):
+        gc.freeze()
+        try:
+            self.assertGreater(gc.get_freeze_count(), 0)
+            # Frozen objects stay tracked, but are not examined
+            self.assertTrue(gc.is_tracked(self))
+            old = gc.get_stats()[2]
+            gc.collect()
+            new = gc.get_stats()[2]
+            self.assertLess(new['examined'] - old['examined'],
+                            gc.get_freeze_count())
+        finally:
+            gc.unfreeze()
+        self.assertEqual(gc.get_freeze_count(), 0)
+
+    def test_freeze_cycles(self):
+        # Garbage cycles made before freezing are only collected once
+        # unfrozen; those made after are collected as usual.
+        class C(object):
+            pass
+        a = C()
+        a.a = a
+        wra = weakref.ref(a)
+        del a
+        gc.freeze()
+        try:
+            b = C()
+            b.b = b
+            wrb = weakref.ref(b)
+            del b
+            gc.collect()
+            self.assertIsNotNone(wra())
+            self.assertIsNone(wrb())
+        finally:
+            gc.unfreeze()
+        gc.collect()
+        self.assertIsNone(wra())
+
     def test_trashcan(self):
         class Ouch:
             n = 0
@@ -470,6 +529,208 @@ class GCTests(unittest.TestCase):
             # would be damaged, with an empty __dict__.
             self.assertEqual(x, None)
 
+class GCCallbackTests(unittest.TestCase):
+    def setUp(self):
+        self.visit = []
+        self.raise_error = False
+        gc.callbacks.append(self.cb1)
+        gc.callbacks.append(self.cb2)
+
+    def tearDown(self):
+        # Also drop the callbacks left by a failure
+        gc.callbacks[:] = [cb for cb in gc.callbacks
+                           if cb not in (self.cb1, self.cb2)]
+
+    def cb1(self, phase, info):
+        self.visit.append((1, phase, dict(info)))
+
+    def cb2(self, phase, info):
+        self.visit.append((2, phase, dict(info)))
+        if phase == "stop" and self.raise_error:
+            raise RuntimeError("callback error")
+
+    def test_collect(self):
+        L = [[]]
+        L[0].append(L)
+        del L
+        n = gc.collect()
+        self.assertEqual([(v[0], v[1]) for v in self.visit],
+                         [(1, "start"), (2, "start"),
+                          (1, "stop"), (2, "stop")])
+        start, stop = self.visit[0][2], self.visit[2][2]
+        self.assertEqual(start["generation"], 2)
+        self.assertEqual(stop["generation"], 2)
+        self.assertEqual(stop["collected"], n)
+        self.assertEqual(stop["uncollectable"], 0)
+        self.assertGreaterEqual(stop["examined"], 2)
+        self.assertGreaterEqual(stop["pause"], 0.0)
+
+    def test_collect_generation(self):
+        gc.collect(1)
+        for v in self.visit:
+            self.assertEqual(v[2]["generation"], 1)
+
+    def test_automatic(self):
+        # Collections triggered by allocations call back as well
+        gc.enable()
+        try:
+            junk = [[] for i in range(gc.get_threshold()[0] * 2)]
+        finally:
+            gc.disable()
+        self.assertIn((1, "stop"), [(v[0], v[1]) for v in self.visit])
+
+    def test_callback_error(self):
+        self.raise_error = True
+        with captured_output("stderr") as stderr:
+            gc.collect()
+        self.assertIn("callback error", stderr.getvalue())
+        # The other callbacks ran
+        self.assertEqual(len(self.visit), 4)
+
+    def test_remove_during_collection(self):
+        # The callbacks registered when a phase starts are all called
+        def remove(phase, info):
+            gc.callbacks.remove(remove)
+            self.visit.append((3, phase, info))
+        gc.callbacks.insert(0, remove)
+        gc.collect()
+        self.assertEqual([(v[0], v[1]) for v in self.visit],
+                         [(3, "start"), (1, "start"), (2, "start"),
+                          (1, "stop"), (2, "stop")])
+
+
+class GCIncrementalTests(unittest.TestCase):
+    def setUp(self):
+        self.threshold = gc.get_threshold()
+        gc.set_threshold(100, 10, 10)
+        gc.set_incremental(200)
+        gc.enable()
+
+    def tearDown(self):
+        gc.disable()
+        gc.set_incremental(0)
+        gc.set_threshold(*self.threshold)
+
+    def test_set_incremental(self):
+        self.assertEqual(gc.get_incremental(), 200)
+        gc.set_incremental(0)
+        self.assertEqual(gc.get_incremental(), 0)
+        self.assertRaises(ValueError, gc.set_incremental, -1)
+        def cb(phase, info):
+            gc.set_incremental(10)
+        gc.callbacks.append(cb)
+        try:
+            with captured_output("stderr") as stderr:
+                gc.collect()
+        finally:
+            gc.callbacks.remove(cb)
+        self.assertIn("RuntimeError", stderr.getvalue())
+        self.assertEqual(gc.get_incremental(), 0)
+
+    def test_objects(self):
+        # All the objects are still tracked, whatever the mode
+        L = [[i] for i in range(1000)]
+        gc.collect()
+        n = len(gc.get_objects())
+        gc.set_incremental(0)
+        n0 = len(gc.get_objects())
+        gc.set_incremental(10)
+        n10 = len(gc.get_objects())
+        self.assertEqual((n0, n10), (n, n))
+        self.assertIn(L[0], gc.get_referents(L))
+        self.assertEqual(gc.get_referrers(L[0]), [L])
+
+    def test_collect_in_slices(self):
+        class C(object):
+            pass
+        # A large heap, in the oldest generation
+        keep = [[i] for i in range(30000)]
+        cycles = []
+        for i in range(100):
+            c = C()
+            c.c = c
+            c.l = [c]
+            cycles.append(c)
+        wrs = [weakref.ref(c) for c in cycles]
+        del c
+        gc.collect()
+        # Old garbage
+        del cycles
+        examined = []
+        def cb(phase, info):
+            if phase == "stop" and info["generation"] == 2:
+                examined.append(info["examined"])
+        gc.callbacks.append(cb)
+        try:
+            # Allocate until the automatic collections free the cycles
+            junk = []
+            for i in xrange(2000000):
+                junk.append([])
+                if len(junk) >= 5000:
+                    junk = []
+                    if all(wr() is None for wr in wrs):
+                        break
+        finally:
+            gc.callbacks.remove(cb)
+        self.assertEqual([wr for wr in wrs if wr() is not None], [])
+        # Each slice examined a small part of the heap
+        self.assertGreater(len(examined), 10)
+        self.assertLess(max(examined), 5000)
+
+    def test_freeze(self):
+        L = [[i] for i in range(100)]
+        gc.collect()
+        gc.freeze()
+        try:
+            for i in xrange(100000):
+                [[]]
+            gc.collect()
+            self.assertTrue(gc.is_tracked(L[0]))
+        finally:
+            gc.unfreeze()
+        gc.collect()
+        self.assertIn(L[0], gc.get_objects())
+
+
+@unittest.skipUnless(hasattr(gc, "immortalize_heap"),
+                     "requires a build configured --with-immortal-objects")
+class GCImmortalTests(unittest.TestCase):
+    def test_singletons(self):
+        for obj in (None, True, False, Ellipsis, NotImplemented, 0, 5, -5):
+            self.assertTrue(gc.is_immortal(obj), obj)
+        self.assertFalse(gc.is_immortal(object()))
+        self.assertFalse(gc.is_immortal(1000 * 1000))
+
+    def test_refcount(self):
+        c = sys.getrefcount(None)
+        L = [None] * 1000
+        self.assertEqual(sys.getrefcount(None), c)
+        del L
+        self.assertEqual(sys.getrefcount(None), c)
+
+    def test_immortalize_heap(self):
+        # Immortal objects are never freed, so run it in a child process
+        code = """if 1:
+            import gc, sys, os
+            def f():
+                return 'a constant'
+            class C(object):
+                pass
+            c = C()
+            c.c = c
+            gc.immortalize_heap()
+            for obj in (sys, os, f, f.__code__, f.__code__.co_consts[1],
+                        f.__code__.co_name, C, c, c.__dict__):
+                assert gc.is_immortal(obj), obj
+            c = C()
+            assert not gc.is_immortal(c)
+            n = sys.getrefcount(f)
+            g = f
+            assert sys.getrefcount(f) == n
+            """
+        assert_python_ok("-c", code)
+
+
 class GCTogglingTests(unittest.TestCase):
     def setUp(self):
         gc.enable()
@@ -623,7 +884,8 @@ def test_main():
 
     try:
         gc.collect() # Delete 2nd generation garbage
-        run_unittest(GCTests, GCTogglingTests)
+        run_unittest(GCTests, GCCallbackTests, GCIncrementalTests,
+                     GCImmortalTests, GCTogglingTests)
     finally:
         gc.set_debug(debug)
         # test gc.enable() even if GC is disabled by default
@@ -399,6 +399,25 @@ class IntTestCases(unittest.TestCase):
                     self.fail("Failed to raise TypeError with %s" %
                               ((base, trunc_result_base),))
 
+    def test_tag_boundaries(self):
+        # With tagged ints, the values around half of sys.maxint switch
+        # between tagged pointers and int objects
+        half = sys.maxint // 2
+        for x in (half - 1, half, half + 1, -half - 2, -half - 1, -half):
+            self.assertIs(type(x), int)
+            self.assertEqual(x + 1 - 1, x)
+            self.assertEqual(x * 1, x)
+            self.assertEqual(-(-x), x)
+            self.assertEqual(int(str(x)), x)
+            self.assertEqual(hash(x), hash(long(x)))
+            self.assertEqual(x // 3 * 3 + x % 3, x)
+        self.assertEqual(half + half, sys.maxint - 1)
+        self.assertEqual(half + half + 1, sys.maxint)
+        self.assertIs(type(sys.maxint + 1), long)
+        self.assertEqual((-half - 1) * 2, -sys.maxint - 1)
+        self.assertEqual([half + i for i in range(3)],
+                         [half, half + 1, half + 2])
+
 def test_main():
     run_unittest(IntTestCases)
 
@@ -1,5 +1,6 @@
 # Test iterators.
 
+import sys
 import unittest
 from test.test_support import run_unittest, TESTFN, unlink, have_unicode, \
                               check_py3k_warnings, cpython_only
@@ -128,6 +129,63 @@ class TestCase(unittest.TestCase):
                 return self
         self.assertRaises(TypeError, iter, IterClass())
 
+    # Test StopIteration raised by a new-style class's next() method
+    def test_new_style_stop_iteration(self):
+        class CountDown(object):
+            def __init__(self, n):
+                self.n = n
+            def __iter__(self):
+                return self
+            def next(self):
+                if self.n == 0:
+                    raise StopIteration
+                self.n -= 1
+                return self.n
+        self.check_for_loop(CountDown(5), [4, 3, 2, 1, 0])
+        self.assertEqual(list(CountDown(3)), [2, 1, 0])
+        self.assertEqual(zip(CountDown(3), CountDown(4)),
+                         [(2, 3), (1, 2), (0, 1)])
+        a, b = CountDown(2)
+        self.assertEqual((a, b), (1, 0))
+
+    # Test a StopIteration that is seen by Python code
+    def test_stop_iteration_traceback(self):
+        class Stop(object):
+            def __iter__(self):
+                return self
+            def next(self):
+                raise StopIteration
+        it = Stop()
+        code = Stop.next.im_func.func_code
+        try:
+            it.next()
+        except StopIteration:
+            exc, value, tb = sys.exc_info()
+        self.assertIsInstance(value, StopIteration)
+        self.assertEqual(tb.tb_next.tb_frame.f_code, code)
+        try:
+            next(it)
+        except StopIteration:
+            tb = sys.exc_info()[2]
+        self.assertEqual(tb.tb_next.tb_frame.f_code, code)
+        def gen():
+            try:
+                raise StopIteration
+            except StopIteration:
+                yield sys.exc_info()
+        for exc, value, tb in gen():
+            self.assertIsInstance(value, StopIteration)
+            self.assertEqual(tb.tb_frame.f_code.co_name, 'gen')
+        def finally_gen(log):
+            try:
+                yield 1
+                raise StopIteration
+            finally:
+                log.append('finally')
+        log = []
+        self.assertEqual(list(finally_gen(log)), [1])
+        self.assertEqual(log, ['finally'])
+
     # Test two-argument iter() with callable instance
     def test_iter_callable(self):
         class C:
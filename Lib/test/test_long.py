@@ -19,6 +19,11 @@ SHIFT = sys.long_info.bits_per_digit
 BASE = 2 ** SHIFT
 MASK = BASE - 1
 KARATSUBA_CUTOFF = 70   # from longobject.c
+TOOM3_CUTOFF = 400      # from longobject.c
+NTT_CUTOFF = 20000      # from longobject.c
+BARRETT_CUTOFF = 100    # from longobject.c
+DECIMAL_DC_CUTOFF = 80000 // SHIFT  # from longobject.c
+STR_DC_CUTOFF = 10000   # from longobject.c
 
 # Max number of base BASE digits to use in test cases.  Doubling
 # this will more than double the runtime.
@@ -194,6 +199,77 @@ class LongTest(unittest.TestCase):
                 self.assertEqual(x, y,
                     Frm("bad result for a*b: a=%r, b=%r, x=%r, y=%r", a, b, x, y))
 
+    def chunked_mul(self, a, b):
+        # a * b computed by multiplying a by chunks of b too short for
+        # anything but the gradeschool algorithm
+        width = (KARATSUBA_CUTOFF - 1) * SHIFT
+        x = 0L
+        for shift in xrange(0, b.bit_length(), width):
+            x += (a * ((b >> shift) & ((1L << width) - 1))) << shift
+        return x
+
+    def test_toom_cook_and_ntt(self):
+        # Toom-Cook splitting, and number-theoretic transforms, are used
+        # above TOOM3_CUTOFF and NTT_CUTOFF digits
+        for ndigits in (TOOM3_CUTOFF - 1, TOOM3_CUTOFF + 1, TOOM3_CUTOFF * 3):
+            for bdigits in (ndigits, ndigits * 3 // 4 + 1, ndigits * 2):
+                a = self.getran(ndigits)
+                b = self.getran(bdigits)
+                x = a * b
+                y = self.chunked_mul(abs(a), abs(b))
+                if (a < 0) != (b < 0):
+                    y = -y
+                self.assertEqual(x, y, Frm("bad result for a*b: a=%r, b=%r",
+                                           a, b))
+                self.assertEqual(a * a, self.chunked_mul(abs(a), abs(a)))
+
+        moduli = [2 ** 61 - 1, 10 ** 18 + 9, 3 ** 40]
+        for ndigits in (NTT_CUTOFF - 1, NTT_CUTOFF + 1, NTT_CUTOFF * 3):
+            nbits = ndigits * SHIFT
+            for bbits in (nbits, nbits // 2, nbits * 3 + 7):
+                a = random.getrandbits(nbits) | (1L << (nbits - 1))
+                b = -random.getrandbits(bbits)
+                x = a * b
+                y = a * a
+                for m in moduli:
+                    self.assertEqual(x % m, (a % m) * (b % m) % m)
+                    self.assertEqual(y % m, (a % m) ** 2 % m)
+            # products of strings of 1 bits, as in test_karatsuba
+            x = (1L << nbits) - 1
+            y = (1L << (nbits + 3 * SHIFT + 1)) - 1
+            self.assertEqual(x * y, (1L << (2 * nbits + 3 * SHIFT + 1)) -
+                             (1L << nbits) - (1L << (nbits + 3 * SHIFT + 1)) +
+                             1)
+            self.assertEqual(x * x,
+                             (1L << (2 * nbits)) - (1L << (nbits + 1)) + 1)
+
+    def test_barrett_pow(self):
+        # pow() with a modulus of more than BARRETT_CUTOFF digits reduces
+        # by multiplying with a reciprocal of the modulus
+        def slow_pow(a, e, m):
+            r = 1L
+            a %= m
+            while e:
+                if e & 1:
+                    r = r * a % m
+                a = a * a % m
+                e >>= 1
+            return r
+
+        for ndigits in (BARRETT_CUTOFF, BARRETT_CUTOFF + 1,
+                        BARRETT_CUTOFF * 4):
+            m = abs(self.getran(ndigits)) | 1
+            for a in (self.getran(ndigits), self.getran(ndigits * 3), m - 1,
+                      m, 2):
+                for e in (0, 1, 2, 65537, abs(self.getran(4))):
+                    x = slow_pow(a, e, m)
+                    self.assertEqual(pow(a, e, m), x,
+                                     Frm("bad result for pow(a, e, m): "
+                                         "a=%r, e=%r, m=%r", a, e, m))
+                    self.assertEqual(pow(a, e, -m), x - m if x else 0)
+        m = (1L << (BARRETT_CUTOFF * 2 * SHIFT)) - 1
+        self.assertEqual(pow(2, BARRETT_CUTOFF * 2 * SHIFT * 5 + 3, m), 8)
+
     def check_bitop_identities_1(self, x):
         eq = self.assertEqual
         eq(x & 0, 0, Frm("x & 0 != 0 for x=%r", x))
@@ -252,6 +328,43 @@ class LongTest(unittest.TestCase):
         eq(x | (y & z), (x | y) & (x | z),
              Frm("x | (y & z) != (x | y) & (x | z) for x=%r, y=%r, z=%r", (x, y, z)))
 
+    def chunked_format(self, x, base):
+        # format abs(x) in base with the quadratic algorithm, using divmod
+        # by small numbers only
+        digits = []
+        x = abs(x)
+        while x:
+            x, r = divmod(x, base ** 20)
+            for i in xrange(20):
+                r, d = divmod(r, base)
+                digits.append("0123456789abcdefghijklmnopqrstuvwxyz"[d])
+        digits.reverse()
+        return "".join(digits).lstrip("0") or "0"
+
+    def test_divide_and_conquer_conversion(self):
+        # decimal strings of more than DECIMAL_DC_CUTOFF digits, and longs
+        # parsed from more than STR_DC_CUTOFF characters, are converted by
+        # splitting them at powers of the base
+        for n in (STR_DC_CUTOFF - 1, STR_DC_CUTOFF + 1, 30000):
+            self.assertEqual(str(10L ** n - 1), '9' * n)
+            self.assertEqual(str(10L ** n), '1' + '0' * n)
+            self.assertEqual(long('9' * n), 10L ** n - 1)
+            self.assertEqual(long('1' + '0' * n), 10L ** n)
+            self.assertEqual(long('0' * n + '7'), 7)
+        for ndigits in (DECIMAL_DC_CUTOFF - 1, DECIMAL_DC_CUTOFF + 1,
+                        DECIMAL_DC_CUTOFF * 3):
+            x = self.getran(ndigits)
+            s = self.chunked_format(x, 10)
+            if x < 0:
+                s = '-' + s
+            self.assertEqual(str(x), s)
+            self.assertEqual(repr(x), s + 'L')
+            self.assertEqual(long(s), x)
+            self.assertEqual(int(s + ' '), x)
+            for base in 3, 7, 36:
+                self.assertEqual(long(self.chunked_format(x, base), base),
+                                 abs(x))
+
     def test_bitop_identities(self):
         for x in special:
             self.check_bitop_identities_1(x)
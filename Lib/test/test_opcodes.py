@@ -2,6 +2,7 @@
 
 from test.test_support import run_unittest, check_py3k_warnings
 import unittest
+import sys
 
 class OpcodeTest(unittest.TestCase):
 
@@ -108,6 +109,85 @@ class OpcodeTest(unittest.TestCase):
                 return 42
         self.assertEqual(MyString() % 3, 42)
 
+    # The eval loop specializes arithmetic and comparison instructions after
+    # they have seen a few monomorphic int or float operands, and falls back
+    # when the operand types change.  Run every site often enough to be
+    # specialized, then feed it other types.
+
+    def check_binary_ops(self, a, b):
+        results = []
+        for i in range(20):
+            results.append((a + b, a - b, a * b, a < b, a <= b, a == b,
+                            a != b, a > b, a >= b))
+        x = a
+        for i in range(20):
+            x = a
+            x += b
+            x -= b
+            x *= b
+        results.append(x)
+        self.assertEqual(len(set(results[:20])), 1)
+        return results[0]
+
+    def test_specialized_int_ops(self):
+        for a, b in [(7, 3), (-7, 3), (7, -3), (-7, -3), (0, 5)]:
+            self.assertEqual(self.check_binary_ops(a, b),
+                             (a + b, a - b, a * b, a < b, a <= b, a == b,
+                              a != b, a > b, a >= b))
+        for i in range(20):
+            q = [a // b for a, b in [(7, 3), (-7, 3), (7, -3), (-7, -3)]]
+            r = [a % b for a, b in [(7, 3), (-7, 3), (7, -3), (-7, -3)]]
+        self.assertEqual(q, [2, -3, -3, 2])
+        self.assertEqual(r, [1, 2, -2, -1])
+
+    def test_specialized_int_overflow(self):
+        big = sys.maxint
+        for i in range(20):
+            s = big + i
+            d = -big - 2 - i
+            m = (big // 2 + 1) * (i + 2)
+            q = (-big - 1) // -1
+            r = (-big - 1) % -1
+        self.assertEqual(s, big + 19)
+        self.assertIsInstance(s, long)
+        self.assertEqual(d, -big - 21)
+        self.assertEqual(m, (big // 2 + 1) * 21)
+        self.assertEqual(q, big + 1)
+        self.assertEqual(r, 0)
+        self.assertRaises(ZeroDivisionError, lambda: [n // 0 for n in range(20)])
+        self.assertRaises(ZeroDivisionError, lambda: [n % 0 for n in range(20)])
+
+    def test_specialized_float_ops(self):
+        for a, b in [(1.5, 0.25), (-2.0, 3.0), (float('inf'), 1.0)]:
+            self.assertEqual(self.check_binary_ops(a, b),
+                             (a + b, a - b, a * b, a < b, a <= b, a == b,
+                              a != b, a > b, a >= b))
+        nan = float('nan')
+        for i in range(20):
+            res = (nan < 1.0, nan == nan, nan != nan, 1.0 / 4.0)
+        self.assertEqual(res, (False, False, True, 0.25))
+        self.assertRaises(ZeroDivisionError,
+                          lambda: [1.0 / x for x in [2.0] * 20 + [0.0]])
+
+    def test_specialized_ops_fall_back(self):
+        def f(a, b):
+            return a + b, a * b, a - b, a < b
+        for i in range(20):
+            f(i, 3)
+        self.assertEqual(f(1.5, 2.0), (3.5, 3.0, -0.5, True))
+        self.assertEqual(f(2L, 3), (5L, 6L, -1L, True))
+        self.assertEqual(f(True, True), (2, 1, 0, False))
+        self.assertRaises(TypeError, f, [1], [2])
+        self.assertRaises(TypeError, f, "a", 1)
+        for i in range(20):
+            f(i * 0.5, 3.0)
+        self.assertEqual(f(3, 4), (7, 12, -1, True))
+
+        class Num(int):
+            def __add__(self, other):
+                return "added"
+        self.assertEqual(f(Num(1), 2)[0], "added")
+
 
 def test_main():
     with check_py3k_warnings(("exceptions must derive from BaseException",
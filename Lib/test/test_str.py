@@ -1,7 +1,12 @@
 
 import struct
 import sys
+import unittest
 from test import test_support, string_tests
+try:
+    import threading
+except ImportError:
+    threading = None
 
 
 class StrTest(
@@ -35,6 +40,52 @@ class StrTest(
         string_tests.MixinStrUnicodeUserStringTest.test_formatting(self)
         self.assertRaises(OverflowError, '%c'.__mod__, 0x1234)
 
+    def test_join_iterable(self):
+        # iterables other than lists and tuples are joined in one pass
+        s = 'abc' * 1000
+        self.assertIs(''.join(iter([s])), s)
+        self.assertEqual('-'.join(str(i) for i in range(1000)),
+                         '-'.join(map(str, range(1000))))
+        def gen(*items):
+            for item in items:
+                yield item
+        self.assertEqual(' '.join(gen('a', 'b', u'c', 'd')), u'a b c d')
+        self.assertEqual(' '.join(gen(u'a', 'b')), u'a b')
+        self.assertEqual(' '.join(gen('x' * 1000, u'y')),
+                         u'x' * 1000 + u' y')
+        with self.assertRaisesRegexp(TypeError, 'item 2: expected string,'):
+            ' '.join(gen('a', 'b', 3))
+        with self.assertRaisesRegexp(TypeError, 'item 2: expected string or'):
+            ' '.join(gen('a', u'b', 3))
+
+    @unittest.skipUnless(threading, 'requires threading')
+    def test_repr_nested_small_stack(self):
+        # the reprs of nested containers recurse in C; each level must not
+        # hold a writer buffer on the stack
+        def nested_reprs():
+            for make in (lambda x: [x], lambda x: (x,), lambda x: {1: x}):
+                x = 0
+                for i in range(900):
+                    x = make(x)
+                results.append(len(repr(x)))
+        results = []
+        try:
+            old_size = threading.stack_size(512 * 1024)
+        except (ValueError, threading.ThreadError):
+            self.skipTest('cannot set the thread stack size')
+        try:
+            old_limit = sys.getrecursionlimit()
+            sys.setrecursionlimit(2000)
+            try:
+                t = threading.Thread(target=nested_reprs)
+                t.start()
+                t.join()
+            finally:
+                sys.setrecursionlimit(old_limit)
+        finally:
+            threading.stack_size(old_size)
+        self.assertEqual(results, [1801, 2701, 4501])
+
     def test_conversion(self):
         # Make sure __str__() behaves properly
         class Foo0:
@@ -427,6 +478,66 @@ class StrTest(
             self.assertIn('str', exc)
             self.assertIn('tuple', exc)
 
+    def test_inplace_concat_targets(self):
+        # s += x resizes s in place when the target holds the only other
+        # reference to it; other references must not see the change
+        global concat_global
+        class Old:
+            pass
+        class New(object):
+            pass
+        class Slots(object):
+            __slots__ = ('s',)
+        class Prop(object):
+            def _get(self):
+                return self._s
+            def _set(self, value):
+                self.log.append(value)
+                self._s = value
+            s = property(_get, _set)
+        class Hook(object):
+            def __setattr__(self, name, value):
+                self.__dict__.setdefault('log', []).append(value)
+                self.__dict__[name] = value
+        for cls in Old, New, Slots, Prop, Hook:
+            o = cls()
+            if cls is Prop:
+                o.log = []
+            o.s = ''
+            aliases = []
+            for i in range(10):
+                aliases.append(o.s)
+                o.s += str(i)
+                o.s += 'x'
+            self.assertEqual(o.s, '0x1x2x3x4x5x6x7x8x9x', cls)
+            self.assertEqual(aliases[3], '0x1x2x', cls)
+            if cls in (Prop, Hook):
+                self.assertEqual(o.log[-1], o.s)
+        o = New()
+        o.a = o.b = o.c = ''
+        for i in range(3):
+            o.b += 'b'
+        self.assertEqual(list(o.__dict__), ['a', 'b', 'c'])
+        self.assertEqual(o.b, 'bbb')
+
+        l = ['', 'y', '']
+        d = {'k': '', 1: ''}
+        for i in range(5):
+            l[0] += 'a'
+            l[-1] += 'c'
+            d['k'] += 'k'
+            d[1] += 'i'
+        self.assertEqual(l, ['aaaaa', 'y', 'ccccc'])
+        self.assertEqual(d, {'k': 'kkkkk', 1: 'iiiii'})
+
+        concat_global = ''
+        for i in range(5):
+            concat_global += 'g'
+            saved = concat_global
+            concat_global = concat_global + 'h'
+        self.assertEqual(concat_global, 'ghghghghgh')
+        self.assertEqual(saved, 'ghghghghg')
+
 def test_main():
     test_support.run_unittest(StrTest)
 
@@ -173,6 +173,30 @@ class StrtodTests(unittest.TestCase):
             s = '{}e{}'.format(digits, exponent)
             self.check_strtod(s)
 
+    def test_near_halfway_cases(self):
+        # halfway cases cut to 16 to 21 significant digits, which lie just
+        # above or below the halfway point; 19 digits or fewer are decided
+        # from a 128-bit product with 10**e, more from the first 19 digits
+        # rounded down and up
+        for i in xrange(100 * TEST_SIZE):
+            bits = random.randrange(1, 2047*2**52)
+            e, m = divmod(bits, 2**52)
+            if e:
+                m, e = m + 2**52, e - 1
+            e -= 1074
+            m, e = 2*m + 1, e - 1
+            if e >= 0:
+                digits, exponent = m << e, 0
+            else:
+                digits, exponent = m * 5**-e, e
+            for ndigits in 16, 17, 18, 19, 20, 21:
+                excess = len(str(digits)) - ndigits
+                if excess <= 0:
+                    continue
+                for cut in (digits // 10**excess, -(-digits // 10**excess)):
+                    s = '{}e{}'.format(cut, exponent + excess)
+                    self.check_strtod(s)
+
     def test_boundaries(self):
         # boundaries expressed as triples (n, e, u), where
         # n*10**e is an approximation to the boundary value and
@@ -1,6 +1,7 @@
 # -*- coding: iso-8859-1 -*-
 import unittest, test.test_support
 import sys, os, cStringIO
+import gc
 import struct
 import operator
 
@@ -215,6 +216,23 @@ class SysModuleTest(unittest.TestCase):
             sys.setcheckinterval(n)
             self.assertEqual(sys.getcheckinterval(), n)
 
+    @unittest.skipUnless(hasattr(sys, "setswitchinterval"),
+                         "requires sys.setswitchinterval()")
+    def test_switchinterval(self):
+        self.assertRaises(TypeError, sys.setswitchinterval)
+        self.assertRaises(TypeError, sys.setswitchinterval, "a")
+        self.assertRaises(ValueError, sys.setswitchinterval, -1.0)
+        self.assertRaises(ValueError, sys.setswitchinterval, 0.0)
+        orig = sys.getswitchinterval()
+        # sanity check
+        self.assertTrue(orig < 0.5, orig)
+        try:
+            for n in 0.00001, 0.05, 3.0, orig:
+                sys.setswitchinterval(n)
+                self.assertAlmostEqual(sys.getswitchinterval(), n)
+        finally:
+            sys.setswitchinterval(orig)
+
     def test_recursionlimit(self):
         self.assertRaises(TypeError, sys.getrecursionlimit, 42)
         oldlimit = sys.getrecursionlimit()
@@ -285,7 +303,11 @@ class SysModuleTest(unittest.TestCase):
         self.assertRaises(TypeError, sys.getrefcount)
         c = sys.getrefcount(None)
         n = None
-        self.assertEqual(sys.getrefcount(None), c+1)
+        if getattr(gc, "is_immortal", lambda o: False)(None):
+            # Immortal objects keep their reference count
+            self.assertEqual(sys.getrefcount(None), c)
+        else:
+            self.assertEqual(sys.getrefcount(None), c+1)
         del n
         self.assertEqual(sys.getrefcount(None), c)
         if hasattr(sys, "gettotalrefcount"):
@@ -299,6 +321,50 @@ class SysModuleTest(unittest.TestCase):
             is sys._getframe().f_code
         )
 
+    def test_getframe_outlives_recursion(self):
+        # Frames of recursive calls come from a per-thread arena; those
+        # captured by sys._getframe() or a traceback must stay valid after
+        # the calls return and the arena is reused.
+        captured = []
+        def rec(n):
+            if n % 7 == 0:
+                captured.append(sys._getframe())
+            if n:
+                return rec(n - 1)
+            try:
+                1 // 0
+            except ZeroDivisionError:
+                return sys.exc_info()[2]
+        def count(n):
+            return count(n - 1) + 1 if n else 0
+        for i in range(3):
+            tb = rec(300)
+        rec(300)
+        self.assertEqual(len(captured), 4 * 43)
+        self.assertEqual([f.f_locals['n'] for f in captured[:43]],
+                         range(0, 301, 7)[::-1])
+        self.assertEqual(tb.tb_frame.f_locals['n'], 0)
+        self.assertEqual(tb.tb_frame.f_back.f_locals['n'], 1)
+        del captured[:], tb
+        self.assertEqual(count(500), 500)
+
+    @test.test_support.reap_threads
+    def test_frame_outlives_thread(self):
+        try:
+            import threading
+        except ImportError:
+            self.skipTest('requires threading')
+        frames = []
+        def rec(n):
+            if n:
+                return rec(n - 1)
+            frames.append(sys._getframe(50))
+        t = threading.Thread(target=rec, args=(100,))
+        t.start()
+        t.join()
+        self.assertEqual(frames[0].f_locals['n'], 50)
+        self.assertEqual(frames[0].f_back.f_locals['n'], 51)
+
     # sys._current_frames() is a CPython-only gimmick.
     def test_current_frames(self):
         have_threads = True
@@ -466,6 +532,96 @@ class SysModuleTest(unittest.TestCase):
         out = p.communicate()[0].strip()
         self.assertEqual(out, '?')
 
+    def test_malloc_environment(self):
+        # The object allocator's arena and pool layout can be changed at
+        # startup; none of the settings may affect program behaviour.
+        import subprocess
+        code = ('x = [str(i) * 3 for i in xrange(200000)]; del x[::3]; '
+                'y = [(i,) for i in xrange(50000)]; del x; '
+                'print sum(len(t) for t in y)')
+        for settings in [{"PYTHONMALLOCPOOLSIZE": "1"},
+                         {"PYTHONMALLOCPOOLSIZE": "1000000"},
+                         {"PYTHONMALLOCARENASIZE": "64"},
+                         {"PYTHONMALLOCARENASIZE": "8192",
+                          "PYTHONMALLOCHUGEPAGES": "1"},
+                         {"PYTHONMALLOCARENASIZE": "spam"}]:
+            env = dict(os.environ)
+            env.update(settings)
+            p = subprocess.Popen([sys.executable, "-c", code],
+                                 stdout = subprocess.PIPE, env=env)
+            out = p.communicate()[0].strip()
+            self.assertEqual(out, '50000', settings)
+
+    def test_getfreeliststats(self):
+        stats = sys.getfreeliststats()
+        self.assertEqual(set(stats), set(["int", "smallint", "float", "tuple",
+                                          "list", "dict", "frame"]))
+        counted = "hits" in stats["tuple"]
+        for name, s in stats.items():
+            if counted:
+                self.assertEqual(sorted(s),
+                                 ["hits", "maxfree", "misses", "numfree"])
+            else:
+                self.assertEqual(sorted(s), ["maxfree", "numfree"])
+            for value in s.values():
+                self.assertIsInstance(value, (int, long))
+                self.assertGreaterEqual(value, 0)
+        for name in ("smallint", "list", "dict", "frame"):
+            self.assertLessEqual(stats[name]["numfree"],
+                                 stats[name]["maxfree"])
+        if counted:
+            before = sys.getfreeliststats()["tuple"]["hits"]
+            for i in range(100):
+                t = (i, i)
+            self.assertGreater(sys.getfreeliststats()["tuple"]["hits"],
+                               before)
+
+    def test_int_blocks_released(self):
+        # Once a burst of ints is freed, the blocks that held them go
+        # back to the system instead of staying on the free list.
+        x = range(1000000)
+        del x
+        self.assertLess(sys.getfreeliststats()["int"]["numfree"], 200000)
+
+    def test_freelists_environment(self):
+        import subprocess
+        import sysconfig
+        tagged = sysconfig.get_config_var('Py_TAGGED_INTS')
+        code = ('import sys; s = sys.getfreeliststats(); '
+                'print " ".join("%s=%d" % (k, s[k]["maxfree"]) '
+                'for k in sorted(s)); '
+                'x = [[(i, float(i), {}) for i in xrange(1000)] '
+                'for j in xrange(100)]; del x; '
+                'print int("12") is 12, int("256") is 256')
+        for settings, result in [
+            ({"PYTHONFREELISTS": "tuple=3,list=0,,dict=7,bogus=1,frame=x,"
+                                 "int=-1,float=100"},
+             "dict=7 float=100 frame=200 int=10000 list=0 smallint=262 "
+             "tuple=3\nTrue True"),
+            ({"PYTHONSMALLINTS": "-1,10"},
+             "dict=80 float=10000 frame=200 int=10000 list=80 smallint=11 "
+             "tuple=2000\nFalse False"),
+            ({"PYTHONSMALLINTS": "0,0"},
+             "dict=80 float=10000 frame=200 int=10000 list=80 smallint=0 "
+             "tuple=2000\nFalse False"),
+            ({"PYTHONSMALLINTS": "5,10"},
+             "dict=80 float=10000 frame=200 int=10000 list=80 smallint=262 "
+             "tuple=2000\nTrue True")]:
+            if tagged:
+                # small ints are never allocated, so there is no cache
+                result = result.split("\n")[0].split()
+                result = [k.startswith("smallint=") and "smallint=0" or k
+                          for k in result]
+                result = " ".join(result) + "\nTrue True"
+            env = dict(os.environ)
+            env.pop("PYTHONFREELISTS", None)
+            env.pop("PYTHONSMALLINTS", None)
+            env.update(settings)
+            p = subprocess.Popen([sys.executable, "-c", code],
+                                 stdout = subprocess.PIPE, env=env)
+            out = p.communicate()[0].strip()
+            self.assertEqual(out, result, settings)
+
     def test_call_tracing(self):
         self.assertEqual(sys.call_tracing(str, (2,)), "2")
         self.assertRaises(TypeError, sys.call_tracing, str, 2)
@@ -587,7 +743,7 @@ class SizeofTest(unittest.TestCase):
         # complex
         check(complex(0,1), size(h + '2d'))
         # code
-        check(get_cell().func_code, size(h + '4i8Pi3P'))
+        check(get_cell().func_code, size(h + '4i8Pi4P'))
         # BaseException
         check(BaseException(), size(h + '3P'))
         # UnicodeEncodeError
@@ -614,9 +770,16 @@ class SizeofTest(unittest.TestCase):
         # method-wrapper (descriptor object)
         check({}.__iter__, size(h + '2P'))
         # dict
-        check({}, size(h + '3P2P' + 8*'P2P'))
+        check({}, size(h + '4P4P'))
         x = {1:1, 2:2, 3:3, 4:4, 5:5, 6:6, 7:7, 8:8}
-        check(x, size(h + '3P2P' + 8*'P2P') + 16*size('P2P'))
+        # 16 one-byte indices, and room for 10 entries
+        check(x, size(h + '4P4P') + 16 + 10*size('P2P'))
+        # instance dict sharing the keys of its class: room for 5 values
+        class C(object):
+            pass
+        c = C()
+        c.a = 1
+        check(c.__dict__, size(h + '4P4P') + 5*self.P)
         # dictionary-keyiterator
         check({}.iterkeys(), size(h + 'P2PPP'))
         # dictionary-valueiterator
@@ -645,7 +808,7 @@ class SizeofTest(unittest.TestCase):
         nfrees = len(x.f_code.co_freevars)
         extras = x.f_code.co_stacksize + x.f_code.co_nlocals +\
                  ncells + nfrees - 1
-        check(x, size(vh + '12P3i' + CO_MAXBLOCKS*'3i' + 'P' + extras*'P'))
+        check(x, size(vh + '13P3i' + CO_MAXBLOCKS*'3i' + 'P' + extras*'P'))
         # function
         def func(): pass
         check(func, size(h + '9P'))
@@ -747,8 +910,8 @@ class SizeofTest(unittest.TestCase):
         check(iter(()), size(h + 'lP'))
         # type
         # (PyTypeObject + PyNumberMethods +  PyMappingMethods +
-        #  PySequenceMethods + PyBufferProcs)
-        s = size(vh + 'P2P15Pl4PP9PP11PI') + size('41P 10P 3P 6P')
+        #  PySequenceMethods + PyBufferProcs + ht_cached_keys)
+        s = size(vh + 'P2P15Pl4PP9PP11PI') + size('41P 10P 3P 6P P')
         class newstyleclass(object):
             pass
         check(newstyleclass, s)
@@ -758,12 +921,18 @@ class SizeofTest(unittest.TestCase):
         import types
         check(types.NotImplementedType, s)
         # unicode
+        import sysconfig
         usize = len(u'\0'.encode('unicode-internal'))
+        compact = sysconfig.get_config_var('Py_COMPACT_UNICODE')
+        uh = h + ('PPlPPi' if compact else 'PPlP')
         samples = [u'', u'1'*100]
         # we need to test for both sizes, because we don't know if the string
         # has been cached
         for s in samples:
-            check(s, size(h + 'PPlP') + usize * (len(s) + 1))
+            check(s, size(uh) + usize * (len(s) + 1))
+        if compact:
+            # decoded from ASCII, so stored a byte per character
+            check(unicode('1'*100), size(uh) + 101)
         # weakref
         import weakref
         check(weakref.ref(int), size(h + '2Pl2P'))
@@ -0,0 +1,151 @@
+import gc
+import sys
+import unittest
+import weakref
+from test import test_support
+
+tracemalloc = test_support.import_module('tracemalloc')
+
+
+def allocate_objects(n):
+    # One string of 68 bytes per iteration, allocated by the next line.
+    lineno = sys._getframe().f_lineno + 1
+    objs = [str(i).zfill(30) + 'x' for i in xrange(n)]
+    return objs, (__file__.rstrip('co'), lineno)
+
+
+def find_stat(stats, location):
+    filename, lineno = location
+    for stat in stats:
+        if stat.filename.rstrip('co') == filename and stat.lineno == lineno:
+            return stat
+    return None
+
+
+class TestTracemalloc(unittest.TestCase):
+
+    def tearDown(self):
+        tracemalloc.disable()
+
+    def test_enable_disable(self):
+        self.assertFalse(tracemalloc.is_enabled())
+        tracemalloc.enable()
+        self.assertTrue(tracemalloc.is_enabled())
+        self.assertEqual(tracemalloc.get_interval(),
+                         tracemalloc.DEFAULT_INTERVAL)
+        tracemalloc.enable(interval=1000)
+        self.assertEqual(tracemalloc.get_interval(), 1000)
+        tracemalloc.disable()
+        self.assertFalse(tracemalloc.is_enabled())
+        self.assertRaises(RuntimeError, tracemalloc.take_snapshot)
+        self.assertRaises(ValueError, tracemalloc.enable, 0)
+        self.assertRaises(ValueError, tracemalloc.enable, interval=-1)
+
+    def test_trace_all(self):
+        tracemalloc.enable(interval=1)
+        objs, location = allocate_objects(1000)
+        stat = find_stat(tracemalloc.take_snapshot().statistics(), location)
+        self.assertIsNotNone(stat)
+        self.assertGreaterEqual(stat.count, 1000)
+        self.assertGreaterEqual(stat.size, 1000 * sys.getsizeof(objs[0]))
+
+        # Freed blocks are forgotten
+        del objs
+        stat = find_stat(tracemalloc.take_snapshot().statistics(), location)
+        self.assertIsNone(stat)
+
+    def test_compare_to(self):
+        tracemalloc.enable(interval=1)
+        old = tracemalloc.take_snapshot()
+        objs, location = allocate_objects(500)
+        new = tracemalloc.take_snapshot()
+        diff = find_stat(new.compare_to(old), location)
+        self.assertIsNotNone(diff)
+        self.assertGreaterEqual(diff.count_diff, 500)
+        self.assertEqual(diff.size_diff, diff.size)
+        # The biggest change comes first
+        self.assertEqual(new.compare_to(old)[0].lineno, location[1])
+
+        del objs
+        diff = find_stat(tracemalloc.take_snapshot().compare_to(new),
+                         location)
+        self.assertEqual(diff.size, 0)
+        self.assertLessEqual(diff.count_diff, -500)
+
+    def test_statistics_by_filename(self):
+        tracemalloc.enable(interval=1)
+        objs, location = allocate_objects(500)
+        snapshot = tracemalloc.take_snapshot()
+        by_line = [stat for stat in snapshot.statistics()
+                   if stat.filename.rstrip('co') == location[0]]
+        by_file = [stat for stat in snapshot.statistics('filename')
+                   if stat.filename.rstrip('co') == location[0]]
+        self.assertEqual(len(by_file), 1)
+        self.assertIsNone(by_file[0].lineno)
+        self.assertEqual(by_file[0].size,
+                         sum(stat.size for stat in by_line))
+        self.assertRaises(ValueError, snapshot.statistics, 'module')
+
+    def test_clear_traces(self):
+        tracemalloc.enable(interval=1)
+        objs, location = allocate_objects(100)
+        tracemalloc.clear_traces()
+        self.assertTrue(tracemalloc.is_enabled())
+        stat = find_stat(tracemalloc.take_snapshot().statistics(), location)
+        self.assertIsNone(stat)
+
+    def test_sites_keep_no_code(self):
+        # A line that allocated live blocks doesn't keep its code object,
+        # and its constants, alive
+        tracemalloc.enable(interval=1)
+        ns = {}
+        exec compile("def f(n):\n"
+                     "    return [str(i).zfill(30) for i in xrange(n)]\n",
+                     "<tracemalloc test>", "exec") in ns
+        objs = ns['f'](100)
+        code = weakref.ref(ns['f'].__code__)
+        ns.clear()
+        gc.collect()
+        self.assertIsNone(code())
+        stat = find_stat(tracemalloc.take_snapshot().statistics(),
+                         ("<tracemalloc test>", 2))
+        self.assertGreaterEqual(stat.count, 100)
+
+        # Lines are told apart by file name, not by code object
+        exec compile("def f(n):\n"
+                     "    return [str(i).zfill(30) for i in xrange(n)]\n",
+                     "<tracemalloc test>", "exec") in ns
+        objs += ns['f'](100)
+        stat = find_stat(tracemalloc.take_snapshot().statistics(),
+                         ("<tracemalloc test>", 2))
+        self.assertGreaterEqual(stat.count, 200)
+
+    def test_sampling_estimate(self):
+        # The size of the blocks, which debug builds pad
+        tracemalloc.enable(interval=1)
+        objs, location = allocate_objects(1000)
+        stat = find_stat(tracemalloc.take_snapshot().statistics(), location)
+        block_size = stat.size // stat.count
+        del objs
+        tracemalloc.disable()
+
+        # With sampling, the estimate is unbiased:  for 1M blocks, and a
+        # sample per 64 KB, it is within a few percent.
+        tracemalloc.enable(interval=64 * 1024)
+        objs, location = allocate_objects(1000000)
+        size = block_size * len(objs)
+        stat = find_stat(tracemalloc.take_snapshot().statistics(), location)
+        self.assertIsNotNone(stat)
+        self.assertTrue(0.75 * size < stat.size < 1.25 * size,
+                        (stat.size, size))
+        self.assertTrue(0.75 * len(objs) < stat.count < 1.25 * len(objs),
+                        (stat.count, len(objs)))
+        # Only about a thousand blocks are traced
+        self.assertLess(tracemalloc.get_tracemalloc_memory(), 1 << 20)
+
+
+def test_main():
+    test_support.run_unittest(TestTracemalloc)
+
+if __name__ == "__main__":
+    test_main()
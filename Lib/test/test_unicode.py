@@ -8,6 +8,7 @@ Written by Marc-Andre Lemburg (mal@lemburg.com).
 import sys
 import struct
 import codecs
+import sysconfig
 import unittest
 from test import test_support, string_tests
 
@@ -134,6 +135,26 @@ class UnicodeTest(
         self.assertRaises(TypeError, u'hello'.find)
         self.assertRaises(TypeError, u'hello'.find, 42)
 
+    def test_find_shared_shift(self):
+        # The two-way search shifts on the low byte of a character, so
+        # u'\u0161' and u'a' have to be told apart by comparing them
+        for a, b in [(u'a', u'\u0161'), (u'\u0161', u'a'),
+                     (u'\u0100', u'\u0200')]:
+            needle = a * 100 + b
+            haystack = a * 3000 + b * 5
+            self.assertEqual(haystack.find(needle), 2900)
+            self.assertEqual(haystack.count(needle), 1)
+            self.assertEqual((b * 3000).find(needle), -1)
+            self.assertEqual((b * 3000 + needle).count(needle), 1)
+            self.assertEqual(((a * 99 + b) * 100).find(needle), -1)
+            self.assertEqual(((a * 99 + b) * 100).count(a * 99 + b), 100)
+            # and so does the reverse search, on the mirror images
+            needle = b + a * 100
+            haystack = b * 5 + a * 3000
+            self.assertEqual(haystack.rfind(needle), 4)
+            self.assertEqual((b * 3000).rfind(needle), -1)
+            self.assertEqual(((b + a * 99) * 100).rfind(needle), -1)
+
     def test_rfind(self):
         string_tests.CommonTest.test_rfind(self)
         # check mixed argument types
@@ -1632,6 +1653,91 @@ class UnicodeTest(
                          b'123?0')
 
 
+class StorageTest(unittest.TestCase):
+    # Strings below are built so that, in a build configured
+    # --with-compact-unicode, they are stored a byte per character, two
+    # bytes per character, or as Py_UNICODE.
+
+    latin1 = '\xe9t\xe9 caf\xe9 '.decode('latin-1') * 10
+    bmp = u'\u0100\u20ac abc'.encode('utf-8').decode('utf-8') * 10
+    ascii = 'plain ascii text '.decode('ascii') * 10
+
+    def test_equality_and_hash(self):
+        for s in (self.ascii, self.latin1, self.bmp):
+            wide = u''.join(list(s))
+            self.assertEqual(s, wide)
+            self.assertEqual(hash(s), hash(wide))
+            self.assertEqual(cmp(s, wide + u'x'), -1)
+            self.assertEqual(cmp(s + u'\uffff', wide + u'x'), 1)
+        self.assertEqual(hash(self.ascii), hash(str(self.ascii)))
+        d = {self.ascii: 1, self.latin1: 2}
+        self.assertEqual(d['plain ascii text ' * 10], 1)
+
+    def test_ordering_across_widths(self):
+        self.assertLess(self.ascii[:5], self.latin1[:5])
+        self.assertLess(self.latin1[:5] + u'\xff', self.latin1[:5] +
+                        u'\u0100')
+        self.assertLess(u'ab\ud800', u'ab\uffff' if sys.maxunicode > 0xffff
+                        else u'ab\ue000')
+
+    def test_search_across_widths(self):
+        self.assertEqual(self.ascii.find(u'ascii'), 6)
+        self.assertEqual(self.ascii.find(u'\u20ac'), -1)
+        self.assertEqual(self.ascii.rfind(u'text'), len(self.ascii) - 5)
+        self.assertEqual(self.latin1.count(u'caf\xe9'), 10)
+        self.assertEqual(self.latin1.count(u'\u20ac'), 0)
+        self.assertEqual(self.bmp.count(u'\u20ac a'), 10)
+        self.assertEqual(self.bmp.index(u'abc', 5), 9)
+        self.assertIn(u'\xe9t\xe9', self.latin1)
+        self.assertNotIn(u'\u0100', self.latin1)
+        self.assertIn(self.ascii[3:70], self.ascii)
+        self.assertTrue(self.bmp.endswith(u'\u20ac abc'))
+        self.assertTrue(self.latin1.startswith(u'\xe9t\xe9', 9))
+        self.assertEqual(self.latin1.replace(u'\xe9', u'\u0100').count(
+                         u'\u0100'), 30)
+
+    def test_slices_and_concatenation(self):
+        for s in (self.ascii, self.latin1, self.bmp):
+            self.assertEqual(s[3:20], u''.join(list(s)[3:20]))
+            self.assertEqual(s[::-3], u''.join(list(s)[::-3]))
+            self.assertEqual(s[5], list(s)[5])
+            self.assertEqual(s + self.bmp, u''.join(list(s) + list(self.bmp)))
+            self.assertEqual(s * 3, u''.join(list(s) * 3))
+            self.assertEqual((u'  ' + s + u' ').strip(), s.strip())
+
+    def test_codecs(self):
+        for s in (self.ascii, self.latin1, self.bmp):
+            self.assertEqual(s.encode('utf-8').decode('utf-8'), s)
+            self.assertEqual(s.encode('utf-16').decode('utf-16'), s)
+        self.assertEqual(self.latin1.encode('latin-1'),
+                         '\xe9t\xe9 caf\xe9 ' * 10)
+        self.assertEqual(self.ascii.encode('ascii'), 'plain ascii text ' * 10)
+        self.assertRaises(UnicodeEncodeError, self.latin1.encode, 'ascii')
+        self.assertRaises(UnicodeEncodeError, self.bmp.encode, 'latin-1')
+        pair = u'ab\ud800\udc00'.encode('utf-8')
+        self.assertEqual(pair, 'ab\xf0\x90\x80\x80')
+
+    @unittest.skipUnless(sysconfig.get_config_var('Py_COMPACT_UNICODE'),
+                         'requires a build configured --with-compact-unicode')
+    def test_compact_sizes(self):
+        # The other tests may have widened the class's strings
+        empty = sys.getsizeof(u'')
+        usize = len(u'\0'.encode('unicode-internal'))
+        for s in ('plain ascii text'.decode('ascii'),
+                  '\xe9t\xe9'.decode('latin-1'),
+                  u'caf\xe9'.encode('utf-8').decode('utf-8'),
+                  u''.join([u'ab', u'\xe9'])):
+            self.assertEqual(sys.getsizeof(s), empty - usize + len(s) + 1)
+        if usize == 4:
+            s = u'\u20ac\u0100'.encode('utf-8').decode('utf-8')
+            self.assertEqual(sys.getsizeof(s), empty - usize +
+                             2 * (len(s) + 1))
+        # Asking for the Py_UNICODE buffer widens a string for good
+        s = 'widened'.decode('ascii')
+        buffer(s)[:]
+        self.assertEqual(sys.getsizeof(s), empty + usize * len(s))
+
+
 def test_main():
     test_support.run_unittest(__name__)
 
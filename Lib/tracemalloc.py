@@ -0,0 +1,116 @@
+"""Find the lines of Python code that hold memory, by sampling allocations.
+
+While tracing is enabled, about one memory block of Python objects in
+every interval bytes allocated is sampled, along with the file name and
+line number of the Python code that allocated it.  Taking a snapshot
+gives, for each line, an estimate of the bytes and blocks still allocated
+there; comparing two snapshots shows where memory grew.  With the default
+interval the overhead is low enough for tracing to stay enabled in
+production.
+
+    import tracemalloc
+    tracemalloc.enable()
+    ...
+    old = tracemalloc.take_snapshot()
+    ...
+    for stat in tracemalloc.take_snapshot().compare_to(old)[:10]:
+        print stat
+"""
+
+from collections import namedtuple
+from _tracemalloc import (enable, disable, is_enabled, get_interval,
+                          clear_traces, get_tracemalloc_memory,
+                          DEFAULT_INTERVAL)
+import _tracemalloc
+
+__all__ = ["enable", "disable", "is_enabled", "get_interval",
+           "clear_traces", "get_tracemalloc_memory", "take_snapshot",
+           "Snapshot", "Statistic", "StatisticDiff", "DEFAULT_INTERVAL"]
+
+
+class Statistic(namedtuple('Statistic', 'filename lineno size count')):
+    """Estimated bytes and blocks allocated by a line, or by a file if
+    lineno is None."""
+
+    __slots__ = ()
+
+    def __str__(self):
+        return "%s: size=%d, count=%d" % (_location(self), self.size,
+                                          self.count)
+
+
+class StatisticDiff(namedtuple('StatisticDiff',
+                               'filename lineno size size_diff '
+                               'count count_diff')):
+    """Statistic of a line, or file, and how it changed since an older
+    snapshot."""
+
+    __slots__ = ()
+
+    def __str__(self):
+        return "%s: size=%d (%+d), count=%d (%+d)" % (
+            _location(self), self.size, self.size_diff,
+            self.count, self.count_diff)
+
+
+def _location(stat):
+    if stat.lineno is None:
+        return stat.filename
+    return "%s:%d" % (stat.filename, stat.lineno)
+
+
+class Snapshot(object):
+    """Memory held by each line of code when the snapshot was taken.
+
+    sites is a list of (filename, lineno, size, count) tuples.
+    """
+
+    def __init__(self, sites, interval):
+        self.sites = sites
+        self.interval = interval
+
+    def _group_by(self, key_type):
+        if key_type == 'lineno':
+            key = lambda filename, lineno: (filename, lineno)
+        elif key_type == 'filename':
+            key = lambda filename, lineno: (filename, None)
+        else:
+            raise ValueError("unknown key_type: %r" % (key_type,))
+        stats = {}
+        for filename, lineno, size, count in self.sites:
+            k = key(filename, lineno)
+            old_size, old_count = stats.get(k, (0, 0))
+            stats[k] = (old_size + size, old_count + count)
+        return stats
+
+    def statistics(self, key_type='lineno'):
+        """Return a list of Statistic, biggest first, by line if key_type
+        is 'lineno' or by file if it is 'filename'."""
+        stats = [Statistic(filename, lineno, size, count)
+                 for (filename, lineno), (size, count)
+                 in self._group_by(key_type).iteritems()]
+        stats.sort(key=lambda stat: (stat.size, stat.count), reverse=True)
+        return stats
+
+    def compare_to(self, old_snapshot, key_type='lineno'):
+        """Return a list of StatisticDiff, biggest change first, from
+        old_snapshot to this one."""
+        new = self._group_by(key_type)
+        old = old_snapshot._group_by(key_type)
+        diffs = []
+        for k in set(new) | set(old):
+            size, count = new.get(k, (0, 0))
+            old_size, old_count = old.get(k, (0, 0))
+            diffs.append(StatisticDiff(k[0], k[1], size, size - old_size,
+                                       count, count - old_count))
+        diffs.sort(key=lambda diff: (abs(diff.size_diff), diff.size),
+                   reverse=True)
+        return diffs
+
+
+def take_snapshot():
+    """Return a Snapshot of the sampled blocks still allocated."""
+    if not is_enabled():
+        raise RuntimeError("allocations must be traced to take a snapshot: "
+                           "call tracemalloc.enable() first")
+    return Snapshot(_tracemalloc._get_sites(), get_interval())
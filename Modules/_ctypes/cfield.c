@@ -265,7 +265,7 @@ static void
 PyCField_dealloc(PyObject *self)
 {
     PyCField_clear((CFieldObject *)self);
-    self->ob_type->tp_free((PyObject *)self);
+    Py_TYPE(self)->tp_free((PyObject *)self);
 }
 
 static PyObject *
@@ -1006,7 +1006,7 @@ g_set(void *ptr, PyObject *value, Py_ssize_t size)
     if (x == -1 && PyErr_Occurred()) {
         PyErr_Format(PyExc_TypeError,
                      " float expected instead of %s instance",
-                     value->ob_type->tp_name);
+                     Py_TYPE(value)->tp_name);
         return NULL;
     }
     memcpy(ptr, &x, sizeof(long double));
@@ -1030,7 +1030,7 @@ d_set(void *ptr, PyObject *value, Py_ssize_t size)
     if (x == -1 && PyErr_Occurred()) {
         PyErr_Format(PyExc_TypeError,
                      " float expected instead of %s instance",
-                     value->ob_type->tp_name);
+                     Py_TYPE(value)->tp_name);
         return NULL;
     }
     memcpy(ptr, &x, sizeof(double));
@@ -1054,7 +1054,7 @@ d_set_sw(void *ptr, PyObject *value, Py_ssize_t size)
     if (x == -1 && PyErr_Occurred()) {
         PyErr_Format(PyExc_TypeError,
                      " float expected instead of %s instance",
-                     value->ob_type->tp_name);
+                     Py_TYPE(value)->tp_name);
         return NULL;
     }
 #ifdef WORDS_BIGENDIAN
@@ -1086,7 +1086,7 @@ f_set(void *ptr, PyObject *value, Py_ssize_t size)
     if (x == -1 && PyErr_Occurred()) {
         PyErr_Format(PyExc_TypeError,
                      " float expected instead of %s instance",
-                     value->ob_type->tp_name);
+                     Py_TYPE(value)->tp_name);
         return NULL;
     }
     memcpy(ptr, &x, sizeof(x));
@@ -1110,7 +1110,7 @@ f_set_sw(void *ptr, PyObject *value, Py_ssize_t size)
     if (x == -1 && PyErr_Occurred()) {
         PyErr_Format(PyExc_TypeError,
                      " float expected instead of %s instance",
-                     value->ob_type->tp_name);
+                     Py_TYPE(value)->tp_name);
         return NULL;
     }
 #ifdef WORDS_BIGENDIAN
@@ -1203,7 +1203,7 @@ u_set(void *ptr, PyObject *value, Py_ssize_t size)
     } else if (!PyUnicode_Check(value)) {
         PyErr_Format(PyExc_TypeError,
                         "unicode string expected instead of %s instance",
-                        value->ob_type->tp_name);
+                        Py_TYPE(value)->tp_name);
         return NULL;
     } else
         Py_INCREF(value);
@@ -1278,7 +1278,7 @@ U_set(void *ptr, PyObject *value, Py_ssize_t length)
     } else if (!PyUnicode_Check(value)) {
         PyErr_Format(PyExc_TypeError,
                         "unicode string expected instead of %s instance",
-                        value->ob_type->tp_name);
+                        Py_TYPE(value)->tp_name);
         return NULL;
     } else
         Py_INCREF(value);
@@ -1316,7 +1316,7 @@ s_get(void *ptr, Py_ssize_t size)
      */
     slen = strlen(PyString_AS_STRING(result));
     size = min(size, (Py_ssize_t)slen);
-    if (result->ob_refcnt == 1) {
+    if (Py_REFCNT(result) == 1) {
         /* shorten the result */
         _PyString_Resize(&result, size);
         return result;
@@ -1385,7 +1385,7 @@ z_set(void *ptr, PyObject *value, Py_ssize_t size)
     }
     PyErr_Format(PyExc_TypeError,
                  "string or integer address expected instead of %s instance",
-                 value->ob_type->tp_name);
+                 Py_TYPE(value)->tp_name);
     return NULL;
 }
 
@@ -1435,7 +1435,7 @@ Z_set(void *ptr, PyObject *value, Py_ssize_t size)
     } else if (!PyUnicode_Check(value)) {
         PyErr_Format(PyExc_TypeError,
                      "unicode string or integer address expected instead of %s instance",
-                     value->ob_type->tp_name);
+                     Py_TYPE(value)->tp_name);
         return NULL;
     } else
         Py_INCREF(value);
@@ -1523,7 +1523,7 @@ BSTR_set(void *ptr, PyObject *value, Py_ssize_t size)
     } else {
         PyErr_Format(PyExc_TypeError,
                         "unicode string expected instead of %s instance",
-                        value->ob_type->tp_name);
+                        Py_TYPE(value)->tp_name);
         return NULL;
     }
 
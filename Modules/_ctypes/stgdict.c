@@ -172,7 +172,7 @@ PyType_stgdict(PyObject *obj)
 StgDictObject *
 PyObject_stgdict(PyObject *self)
 {
-    PyTypeObject *type = self->ob_type;
+    PyTypeObject *type = Py_TYPE(self);
     if (!PyType_HasFeature(type, Py_TPFLAGS_HAVE_CLASS))
         return NULL;
     if (!type->tp_dict || !PyCStgDict_CheckExact(type->tp_dict))
@@ -501,7 +501,7 @@ PyCStructUnionType_update_stgdict(PyObject *type, PyObject *fields, int isStruct
             {
                 PyErr_Format(PyExc_TypeError,
                              "structure field name must be string not %s",
-                             name->ob_type->tp_name);
+                             Py_TYPE(name)->tp_name);
                                 
                 Py_DECREF(pair);
                 return -1;
@@ -1545,13 +1545,18 @@ element_setattr(ElementObject* self, const char* name, PyObject* value)
         self->tag = value;
         Py_INCREF(self->tag);
     } else if (strcmp(name, "text") == 0) {
+        /* the join flag lives in the low pointer bit; box tagged ints */
+        value = PyInt_Box(value);
+        if (!value)
+            return -1;
         Py_DECREF(JOIN_OBJ(self->text));
         self->text = value;
-        Py_INCREF(self->text);
     } else if (strcmp(name, "tail") == 0) {
+        value = PyInt_Box(value);
+        if (!value)
+            return -1;
         Py_DECREF(JOIN_OBJ(self->tail));
         self->tail = value;
-        Py_INCREF(self->tail);
     } else if (strcmp(name, "attrib") == 0) {
         if (!self->extra)
             element_new_extra(self, NULL);
@@ -1787,8 +1792,12 @@ treebuilder_handle_data(TreeBuilderObject* self, PyObject* data)
             /* ignore calls to data before the first call to start */
             Py_RETURN_NONE;
         }
-        /* store the first item as is */
-        Py_INCREF(data); self->data = data;
+        /* store the first item as is; a tagged int would collide with
+           the join flag, so box it */
+        data = PyInt_Box(data);
+        if (!data)
+            return NULL;
+        self->data = data;
     } else {
         /* more than one item; use a list to collect items */
         if (PyString_CheckExact(self->data) && Py_REFCNT(self->data) == 1 &&
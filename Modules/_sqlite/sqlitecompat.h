@@ -36,7 +36,7 @@ typedef int (*lenfunc)(PyObject*);
 
 /* define PyDict_CheckExact for pre-2.4 versions of Python */
 #ifndef PyDict_CheckExact
-#define PyDict_CheckExact(op) ((op)->ob_type == &PyDict_Type)
+#define PyDict_CheckExact(op) (Py_TYPE((op)) == &PyDict_Type)
 #endif
 
 /* define Py_CLEAR for pre-2.4 versions of Python */
@@ -759,7 +759,7 @@ typedef struct {
 } PyTclObject;
 
 staticforward PyTypeObject PyTclObject_Type;
-#define PyTclObject_Check(v)    ((v)->ob_type == &PyTclObject_Type)
+#define PyTclObject_Check(v)    (Py_TYPE((v)) == &PyTclObject_Type)
 
 static PyObject *
 newPyTclObject(Tcl_Obj *arg)
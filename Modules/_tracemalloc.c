@@ -0,0 +1,479 @@
+/* Sampled allocation tracing:  attributes the blocks allocated through
+   PyObject_Malloc() to the line of Python code that was running.  See
+   Lib/tracemalloc.py for the interface built on top of this.
+
+   Allocations are sampled as if each byte allocated was picked with
+   probability 1/interval, so that one block per `interval` bytes is
+   sampled on average, whatever the block sizes.  A sampled block of
+   `size` bytes, which had a probability P = 1 - exp(-size/interval) to be
+   picked, stands for 1/P blocks and size/P bytes; summing these over the
+   live sampled blocks of a line estimates what the line holds.  An
+   interval of 1 traces every block exactly.
+
+   Both tables are open-addressed with linear probing, and allocated with
+   malloc() so as not to trace themselves.  Sites are keyed by the
+   interned file name of the code and the line number, and keep a
+   reference to the file name until the traces are cleared; they never
+   keep code objects, or what those hold, alive.
+*/
+
+#include "Python.h"
+#include "code.h"
+#include "frameobject.h"
+#include <math.h>
+
+#define DEFAULT_INTERVAL        (512 * 1024)
+
+/* A line of Python code that allocated sampled blocks still alive */
+typedef struct {
+    PyObject *filename;         /* interned; unknown_filename if no Python
+                                   code was running */
+    int lineno;
+    size_t size;                /* estimated bytes */
+    size_t count;               /* estimated blocks */
+} site_t;
+
+/* A sampled block */
+typedef struct {
+    void *ptr;                  /* NULL for an empty slot */
+    unsigned int site;          /* index in sites */
+    unsigned int count;         /* blocks it stands for */
+    size_t size;                /* bytes it stands for */
+} trace_t;
+
+static int tracing = 0;
+/* Set while taking a snapshot, so that no site is added meanwhile */
+static int suspended = 0;
+static Py_ssize_t interval = DEFAULT_INTERVAL;
+static unsigned long rng_state = 2463534242UL;
+
+static trace_t *traces = NULL;
+static size_t traces_mask = 0;          /* number of slots - 1 */
+static size_t ntraces = 0;
+
+static site_t *sites = NULL;
+static size_t nsites = 0;
+static size_t sites_allocated = 0;
+static unsigned int *site_slots = NULL; /* site index + 1, 0 if empty */
+static size_t site_slots_mask = 0;
+
+/* Reported for blocks allocated while no Python code was running */
+static PyObject *unknown_filename = NULL;
+
+#define MIN_TRACES              1024
+#define MIN_SITE_SLOTS          256
+
+static size_t
+hash_pointer(void *p)
+{
+    Py_uintptr_t h = (Py_uintptr_t)p >> 3;
+    h ^= h >> 15;
+    h *= 2654435761UL;
+    h ^= h >> 13;
+    return (size_t)h;
+}
+
+/* Bytes to allocate before the next sample:  exponentially distributed,
+   with mean `interval`. */
+static Py_ssize_t
+next_countdown(void)
+{
+    double u, n;
+
+    if (interval == 1)
+        return 1;
+    /* xorshift */
+    rng_state ^= (rng_state << 13) & 0xffffffffUL;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= (rng_state << 5) & 0xffffffffUL;
+    u = ((double)rng_state + 0.5) / 4294967296.0;
+    n = -log(u) * (double)interval + 1.0;
+    if (n >= (double)PY_SSIZE_T_MAX)
+        return PY_SSIZE_T_MAX;
+    return (Py_ssize_t)n;
+}
+
+/* Index in sites of (filename, lineno), added if needed.  filename must
+   be interned.  Return -1 if memory runs out. */
+static Py_ssize_t
+find_site(PyObject *filename, int lineno)
+{
+    size_t i, h;
+    unsigned int s;
+
+    if ((nsites + 1) * 3 >= (site_slots_mask + 1) * 2) {
+        /* Grow the slots, and rehash */
+        size_t n = site_slots_mask ? (site_slots_mask + 1) * 2
+                                   : MIN_SITE_SLOTS;
+        unsigned int *slots;
+
+        if (n > UINT_MAX)
+            return -1;
+        slots = (unsigned int *)calloc(n, sizeof(unsigned int));
+        if (slots == NULL)
+            return -1;
+        for (s = 0; s < nsites; ++s) {
+            h = hash_pointer(sites[s].filename) ^
+                (sites[s].lineno * 40503UL);
+            for (i = h & (n - 1); slots[i] != 0; i = (i + 1) & (n - 1))
+                ;
+            slots[i] = s + 1;
+        }
+        free(site_slots);
+        site_slots = slots;
+        site_slots_mask = n - 1;
+    }
+
+    h = hash_pointer(filename) ^ (lineno * 40503UL);
+    for (i = h & site_slots_mask; (s = site_slots[i]) != 0;
+         i = (i + 1) & site_slots_mask) {
+        if (sites[s - 1].filename == filename &&
+            sites[s - 1].lineno == lineno)
+            return s - 1;
+    }
+
+    if (nsites == sites_allocated) {
+        size_t n = sites_allocated ? sites_allocated * 2 : MIN_SITE_SLOTS;
+        site_t *p = (site_t *)realloc(sites, n * sizeof(site_t));
+        if (p == NULL)
+            return -1;
+        sites = p;
+        sites_allocated = n;
+    }
+    Py_INCREF(filename);
+    sites[nsites].filename = filename;
+    sites[nsites].lineno = lineno;
+    sites[nsites].size = 0;
+    sites[nsites].count = 0;
+    site_slots[i] = (unsigned int)++nsites;
+    return nsites - 1;
+}
+
+/* Double the number of trace slots.  Return -1 if memory runs out. */
+static int
+grow_traces(void)
+{
+    size_t n = traces_mask ? (traces_mask + 1) * 2 : MIN_TRACES;
+    size_t i, j;
+    trace_t *t = (trace_t *)calloc(n, sizeof(trace_t));
+
+    if (t == NULL)
+        return -1;
+    if (traces != NULL) {
+        for (j = 0; j <= traces_mask; ++j) {
+            if (traces[j].ptr == NULL)
+                continue;
+            for (i = hash_pointer(traces[j].ptr) & (n - 1);
+                 t[i].ptr != NULL; i = (i + 1) & (n - 1))
+                ;
+            t[i] = traces[j];
+        }
+        free(traces);
+    }
+    traces = t;
+    traces_mask = n - 1;
+    return 0;
+}
+
+/* Slot of ptr in traces, or of the empty slot ending its probe sequence */
+static size_t
+find_trace(void *ptr)
+{
+    size_t i;
+
+    for (i = hash_pointer(ptr) & traces_mask;
+         traces[i].ptr != NULL && traces[i].ptr != ptr;
+         i = (i + 1) & traces_mask)
+        ;
+    return i;
+}
+
+/* Empty slot i, moving back the entries that probed past it */
+static void
+delete_trace(size_t i)
+{
+    size_t j, k;
+
+    for (j = i; ; ) {
+        traces[i].ptr = NULL;
+        do {
+            j = (j + 1) & traces_mask;
+            if (traces[j].ptr == NULL)
+                return;
+            k = hash_pointer(traces[j].ptr) & traces_mask;
+            /* Entry j may stay if k lies cyclically in (i, j] */
+        } while (i <= j ? (i < k && k <= j) : (i < k || k <= j));
+        traces[i] = traces[j];
+        i = j;
+    }
+}
+
+static void
+forget_trace(size_t i)
+{
+    site_t *site = &sites[traces[i].site];
+
+    site->size -= traces[i].size;
+    site->count -= traces[i].count;
+    delete_trace(i);
+    --ntraces;
+}
+
+static Py_ssize_t
+tracemalloc_sample(void *ptr, size_t size)
+{
+    PyThreadState *tstate = _PyThreadState_Current;
+    PyFrameObject *f = tstate != NULL ? tstate->frame : NULL;
+    Py_ssize_t s;
+    size_t i;
+    double p;
+
+    if (suspended)
+        return next_countdown();
+    if ((ntraces + 1) * 3 >= (traces_mask + 1) * 2 && grow_traces() < 0)
+        return next_countdown();
+    if (f != NULL) {
+        PyObject *filename = f->f_code->co_filename;
+
+        /* Files compiled or loaded apart get equal but distinct names */
+        Py_INCREF(filename);
+        PyString_InternInPlace(&filename);
+        s = find_site(filename, PyFrame_GetLineNumber(f));
+        Py_DECREF(filename);
+    }
+    else
+        s = find_site(unknown_filename, 0);
+    if (s < 0)
+        return next_countdown();
+
+    i = find_trace(ptr);
+    if (traces[i].ptr != NULL) {
+        /* Missed the free of the block previously at this address */
+        forget_trace(i);
+        i = find_trace(ptr);
+    }
+    traces[i].ptr = ptr;
+    traces[i].site = (unsigned int)s;
+    if (interval == 1 || size == 0)
+        p = 1.0;
+    else
+        p = 1.0 - exp(-(double)size / (double)interval);
+    traces[i].size = (size_t)((double)size / p + 0.5);
+    traces[i].count = 1.0 / p >= (double)UINT_MAX ? UINT_MAX :
+                      (unsigned int)(1.0 / p + 0.5);
+    sites[s].size += traces[i].size;
+    sites[s].count += traces[i].count;
+    ++ntraces;
+    return next_countdown();
+}
+
+static void
+tracemalloc_forget(void *ptr)
+{
+    size_t i;
+
+    if (ntraces == 0)
+        return;
+    i = find_trace(ptr);
+    if (traces[i].ptr != NULL)
+        forget_trace(i);
+}
+
+static _PyObject_TraceHooks hooks = {
+    tracemalloc_sample,
+    tracemalloc_forget
+};
+
+/* Drop all traces and sites */
+static void
+clear_traces(void)
+{
+    site_t *old_sites = sites;
+    size_t i, n = nsites;
+
+    /* Detach the tables first:  releasing the file names frees memory,
+       which calls tracemalloc_forget(). */
+    free(traces);
+    traces = NULL;
+    traces_mask = 0;
+    ntraces = 0;
+    free(site_slots);
+    site_slots = NULL;
+    site_slots_mask = 0;
+    sites = NULL;
+    nsites = sites_allocated = 0;
+
+    suspended = 1;
+    for (i = 0; i < n; ++i)
+        Py_DECREF(old_sites[i].filename);
+    suspended = 0;
+    free(old_sites);
+}
+
+PyDoc_STRVAR(enable_doc,
+"enable(interval=524288)\n\
+\n\
+Start tracing the allocations of Python objects, sampling one block per\n\
+interval bytes allocated, on average.  An interval of 1 traces all\n\
+blocks.  If tracing was already enabled, only the interval changes.");
+
+static PyObject *
+tracemalloc_enable(PyObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"interval", 0};
+    Py_ssize_t n = DEFAULT_INTERVAL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|n:enable", kwlist, &n))
+        return NULL;
+    if (n < 1) {
+        PyErr_SetString(PyExc_ValueError,
+                        "the sampling interval must be at least 1");
+        return NULL;
+    }
+    interval = n;
+    tracing = 1;
+    _PyObject_SetTraceHooks(&hooks, next_countdown());
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(disable_doc,
+"disable()\n\
+\n\
+Stop tracing allocations, and clear the traces.");
+
+static PyObject *
+tracemalloc_disable(PyObject *self, PyObject *noargs)
+{
+    if (tracing) {
+        _PyObject_SetTraceHooks(NULL, 0);
+        tracing = 0;
+        clear_traces();
+    }
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(is_enabled_doc,
+"is_enabled() -> bool\n\
+\n\
+Return True if allocations are being traced.");
+
+static PyObject *
+tracemalloc_is_enabled(PyObject *self, PyObject *noargs)
+{
+    return PyBool_FromLong(tracing);
+}
+
+PyDoc_STRVAR(get_interval_doc,
+"get_interval() -> int\n\
+\n\
+Return the mean number of bytes allocated between two samples.");
+
+static PyObject *
+tracemalloc_get_interval(PyObject *self, PyObject *noargs)
+{
+    return PyInt_FromSsize_t(interval);
+}
+
+PyDoc_STRVAR(clear_traces_doc,
+"clear_traces()\n\
+\n\
+Forget the blocks sampled so far.");
+
+static PyObject *
+tracemalloc_clear_traces(PyObject *self, PyObject *noargs)
+{
+    clear_traces();
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(get_tracemalloc_memory_doc,
+"get_tracemalloc_memory() -> int\n\
+\n\
+Return the number of bytes used to store the traces.");
+
+static PyObject *
+tracemalloc_get_tracemalloc_memory(PyObject *self, PyObject *noargs)
+{
+    size_t size = 0;
+
+    if (traces != NULL)
+        size += (traces_mask + 1) * sizeof(trace_t);
+    if (site_slots != NULL)
+        size += (site_slots_mask + 1) * sizeof(unsigned int);
+    size += sites_allocated * sizeof(site_t);
+    return PyInt_FromSize_t(size);
+}
+
+PyDoc_STRVAR(get_sites_doc,
+"_get_sites() -> list\n\
+\n\
+Return a list of (filename, lineno, size, count) tuples, giving the\n\
+estimated bytes and blocks still allocated by each line of code.");
+
+static PyObject *
+tracemalloc_get_sites(PyObject *self, PyObject *noargs)
+{
+    PyObject *result, *item;
+    size_t i;
+
+    result = PyList_New(0);
+    if (result == NULL)
+        return NULL;
+    suspended = 1;
+    for (i = 0; i < nsites; ++i) {
+        site_t *site = &sites[i];
+
+        if (site->count == 0)
+            continue;
+        item = Py_BuildValue("(Oink)", site->filename, site->lineno,
+                             (Py_ssize_t)site->size,
+                             (unsigned long)site->count);
+        if (item == NULL || PyList_Append(result, item) < 0) {
+            Py_XDECREF(item);
+            Py_DECREF(result);
+            suspended = 0;
+            return NULL;
+        }
+        Py_DECREF(item);
+    }
+    suspended = 0;
+    return result;
+}
+
+static PyMethodDef tracemalloc_methods[] = {
+    {"enable",          (PyCFunction)tracemalloc_enable,
+     METH_VARARGS | METH_KEYWORDS, enable_doc},
+    {"disable",         (PyCFunction)tracemalloc_disable,
+     METH_NOARGS, disable_doc},
+    {"is_enabled",      (PyCFunction)tracemalloc_is_enabled,
+     METH_NOARGS, is_enabled_doc},
+    {"get_interval",    (PyCFunction)tracemalloc_get_interval,
+     METH_NOARGS, get_interval_doc},
+    {"clear_traces",    (PyCFunction)tracemalloc_clear_traces,
+     METH_NOARGS, clear_traces_doc},
+    {"get_tracemalloc_memory",
+     (PyCFunction)tracemalloc_get_tracemalloc_memory,
+     METH_NOARGS, get_tracemalloc_memory_doc},
+    {"_get_sites",      (PyCFunction)tracemalloc_get_sites,
+     METH_NOARGS, get_sites_doc},
+    {NULL,              NULL}           /* sentinel */
+};
+
+PyDoc_STRVAR(module_doc,
+"Sampled tracing of the memory blocks allocated by Python code.");
+
+PyMODINIT_FUNC
+init_tracemalloc(void)
+{
+    PyObject *m;
+
+    m = Py_InitModule3("_tracemalloc", tracemalloc_methods, module_doc);
+    if (m == NULL)
+        return;
+    if (unknown_filename == NULL) {
+        unknown_filename = PyString_InternFromString("<unknown>");
+        if (unknown_filename == NULL)
+            return;
+    }
+    PyModule_AddIntConstant(m, "DEFAULT_INTERVAL", DEFAULT_INTERVAL);
+}
@@ -284,13 +284,13 @@ typedef struct {
    pointing to the api structure.
 */
 
-#define DBObject_Check(v)       ((v)->ob_type == bsddb_api->db_type)
-#define DBCursorObject_Check(v) ((v)->ob_type == bsddb_api->dbcursor_type)
-#define DBEnvObject_Check(v)    ((v)->ob_type == bsddb_api->dbenv_type)
-#define DBTxnObject_Check(v)    ((v)->ob_type == bsddb_api->dbtxn_type)
-#define DBLockObject_Check(v)   ((v)->ob_type == bsddb_api->dblock_type)
+#define DBObject_Check(v)       (Py_TYPE((v)) == bsddb_api->db_type)
+#define DBCursorObject_Check(v) (Py_TYPE((v)) == bsddb_api->dbcursor_type)
+#define DBEnvObject_Check(v)    (Py_TYPE((v)) == bsddb_api->dbenv_type)
+#define DBTxnObject_Check(v)    (Py_TYPE((v)) == bsddb_api->dbtxn_type)
+#define DBLockObject_Check(v)   (Py_TYPE((v)) == bsddb_api->dblock_type)
 #if (DBVER >= 43)
-#define DBSequenceObject_Check(v)  ((v)->ob_type == bsddb_api->dbsequence_type)
+#define DBSequenceObject_Check(v)  (Py_TYPE((v)) == bsddb_api->dbsequence_type)
 #endif
 
 #endif /* COMPILING_BSDDB_C */
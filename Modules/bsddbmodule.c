@@ -41,7 +41,7 @@ typedef struct {
 
 static PyTypeObject Bsddbtype;
 
-#define is_bsddbobject(v) ((v)->ob_type == &Bsddbtype)
+#define is_bsddbobject(v) (Py_TYPE((v)) == &Bsddbtype)
 #define check_bsddbobject_open(v, r) if ((v)->di_bsddb == NULL) \
                { PyErr_SetString(BsddbError, \
                                  "BSDDB object has already been closed"); \
@@ -667,7 +667,7 @@ newIobject(PyObject *s) {
   }
   else if (PyObject_AsReadBuffer(s, (const void **)&buf, &size)) {
     PyErr_Format(PyExc_TypeError, "expected read buffer, %.200s found",
-                 s->ob_type->tp_name);
+                 Py_TYPE(s)->tp_name);
     return NULL;
   }
 
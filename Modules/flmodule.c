@@ -31,7 +31,7 @@ typedef struct {
 
 static PyTypeObject GenericObjecttype;
 
-#define is_genericobject(g) ((g)->ob_type == &GenericObjecttype)
+#define is_genericobject(g) (Py_TYPE((g)) == &GenericObjecttype)
 
 /* List of all objects (XXX this should be a hash table on address...) */
 
@@ -1190,7 +1190,7 @@ typedef struct {
 
 static PyTypeObject Formtype;
 
-#define is_formobject(v) ((v)->ob_type == &Formtype)
+#define is_formobject(v) (Py_TYPE((v)) == &Formtype)
 
 static PyObject *
 form_show_form(formobject *f, PyObject *args)
@@ -17,7 +17,7 @@ typedef struct {
 
 static PyTypeObject Fhtype;
 
-#define is_fhobject(v)          ((v)->ob_type == &Fhtype)
+#define is_fhobject(v)          (Py_TYPE((v)) == &Fhtype)
 
 static PyObject *
 newfhobject(fmfonthandle fh)
@@ -49,6 +49,54 @@ static struct gc_generation generations[NUM_GENERATIONS] = {
 
 PyGC_Head *_PyGC_generation0 = GEN_HEAD(0);
 
+/* Objects moved out of the generations by gc.freeze(): they are never
+   examined, so the collections don't write to their GC headers, and the
+   pages holding them stay shared with the processes forked after. */
+static PyGC_Head permanent_generation = {{&permanent_generation,
+                                          &permanent_generation, 0}};
+
+/* Incremental collection of the oldest generation.  When incremental_slice
+   is not 0, the automatic collections of the oldest generation are done in
+   slices, each examining the young generations along with about
+   incremental_slice objects of the oldest one, until all of them were
+   examined: that's an incremental cycle.  Between slices, the objects of
+   the oldest generation are either pending, in GEN_HEAD(NUM_GENERATIONS-1),
+   or visited in the current cycle, in old_visited.  The survivors of the
+   slices and of the middle generation go to old_visited; a new cycle
+   starts by making them all pending.
+
+   A slice takes along all the pending objects its old objects reach, so
+   that cycles of old objects are never split between slices.  To keep
+   that from taking most of the heap at once, a cycle first marks the
+   objects reachable from the modules and the frames as visited, again
+   about incremental_slice of them per slice, moving them through
+   old_gray.  To tell the pending objects from the others in O(1), they
+   have gc_refs set to pending_refs, and visited ones to visited_refs: the
+   two swap at the start of each cycle, so old_visited becomes the pending
+   list without walking it.  The two are GC_OLD_A and GC_OLD_B, unused by
+   the other objects.
+
+   Slices are sound without a write barrier, since an object referred to
+   from outside the slice is kept like any object referred to from an
+   older generation.  Garbage left by the changes made during a cycle is
+   found in the next one.
+*/
+static Py_ssize_t incremental_slice = 0;
+
+/* true if an incremental cycle is in progress */
+static int incremental_cycle = 0;
+
+static PyGC_Head old_visited = {{&old_visited, &old_visited, 0}};
+
+/* objects marked as visited, whose referents are not marked yet */
+static PyGC_Head old_gray = {{&old_gray, &old_gray, 0}};
+
+/* # of objects that survived the slices of the current cycle */
+static Py_ssize_t incremental_survivors = 0;
+
+static Py_ssize_t pending_refs;
+static Py_ssize_t visited_refs;
+
 static int enabled = 1; /* automatic collection enabled? */
 
 /* true if we are currently running the collector */
@@ -127,6 +175,35 @@ static Py_ssize_t long_lived_pending = 0;
 static int debug;
 static PyObject *tmod = NULL;
 
+/* Statistics on the collections of each generation, see gc.get_stats() */
+#define NUM_PAUSE_BUCKETS       24
+
+struct gc_generation_stats {
+    Py_ssize_t collections;
+    Py_ssize_t examined;        /* objects examined */
+    Py_ssize_t collected;       /* unreachable objects freed */
+    Py_ssize_t uncollectable;   /* unreachable objects left in garbage */
+    double pause_total;         /* seconds */
+    double pause_max;
+    /* pause_histogram[i] counts the pauses that lasted less than 2**i
+       microseconds, and at least 2**(i-1); the last bucket counts all the
+       longer ones. */
+    Py_ssize_t pause_histogram[NUM_PAUSE_BUCKETS];
+};
+
+static struct gc_generation_stats generation_stats[NUM_GENERATIONS];
+
+/* What a collection did, as reported to the callbacks */
+struct gc_collection_info {
+    Py_ssize_t examined;
+    Py_ssize_t collected;
+    Py_ssize_t uncollectable;
+    double pause;
+};
+
+/* List of functions called before and after each collection */
+static PyObject *callbacks = NULL;
+
 /*--------------------------------------------------------------------------
 gc_refs values.
 
@@ -164,14 +241,23 @@ GC_TENTATIVELY_UNREACHABLE
     Only objects with GC_TENTATIVELY_UNREACHABLE still set are candidates
     for collection.  If it's decided not to collect such an object (e.g.,
     it has a __del__ method), its gc_refs is restored to GC_REACHABLE again.
+
+In incremental mode, the objects of the oldest generation have gc_refs set
+to GC_OLD_A or GC_OLD_B instead of GC_REACHABLE, to tell the ones pending in
+the current incremental cycle from the ones already visited.
 ----------------------------------------------------------------------------
 */
 #define GC_UNTRACKED                    _PyGC_REFS_UNTRACKED
 #define GC_REACHABLE                    _PyGC_REFS_REACHABLE
 #define GC_TENTATIVELY_UNREACHABLE      _PyGC_REFS_TENTATIVELY_UNREACHABLE
+#define GC_OLD_A                        (-5)
+#define GC_OLD_B                        (-6)
+
+#define IS_REACHABLE_REFS(refs) \
+    ((refs) == GC_REACHABLE || (refs) == GC_OLD_A || (refs) == GC_OLD_B)
 
 #define IS_TRACKED(o) ((AS_GC(o))->gc.gc_refs != GC_UNTRACKED)
-#define IS_REACHABLE(o) ((AS_GC(o))->gc.gc_refs == GC_REACHABLE)
+#define IS_REACHABLE(o) IS_REACHABLE_REFS((AS_GC(o))->gc.gc_refs)
 #define IS_TENTATIVELY_UNREACHABLE(o) ( \
     (AS_GC(o))->gc.gc_refs == GC_TENTATIVELY_UNREACHABLE)
 
@@ -281,14 +367,15 @@ append_objects(PyObject *py_list, PyGC_Head *gc_list)
 
 /* Set all gc_refs = ob_refcnt.  After this, gc_refs is > 0 for all objects
  * in containers, and is GC_REACHABLE for all tracked gc objects not in
- * containers.
+ * containers.  Return the number of objects in containers.
  */
-static void
+static Py_ssize_t
 update_refs(PyGC_Head *containers)
 {
+    Py_ssize_t n = 0;
     PyGC_Head *gc = containers->gc.gc_next;
-    for (; gc != containers; gc = gc->gc.gc_next) {
-        assert(gc->gc.gc_refs == GC_REACHABLE);
+    for (; gc != containers; gc = gc->gc.gc_next, ++n) {
+        assert(IS_REACHABLE_REFS(gc->gc.gc_refs));
         gc->gc.gc_refs = Py_REFCNT(FROM_GC(gc));
         /* Python's cyclic gc should never see an incoming refcount
          * of 0:  if something decref'ed to 0, it should have been
@@ -310,6 +397,7 @@ update_refs(PyGC_Head *containers)
          */
         assert(gc->gc.gc_refs != 0);
     }
+    return n;
 }
 
 /* A traversal callback for subtract_refs. */
@@ -379,12 +467,12 @@ visit_reachable(PyObject *op, PyGC_Head *reachable)
          * list, and move_unreachable will eventually get to it.
          * If gc_refs == GC_REACHABLE, it's either in some other
          * generation so we don't care about it, or move_unreachable
-         * already dealt with it.
+         * already dealt with it.  So are GC_OLD_A and GC_OLD_B.
          * If gc_refs == GC_UNTRACKED, it must be ignored.
          */
          else {
             assert(gc_refs > 0
-                   || gc_refs == GC_REACHABLE
+                   || IS_REACHABLE_REFS(gc_refs)
                    || gc_refs == GC_UNTRACKED);
          }
     }
@@ -470,8 +558,8 @@ has_finalizer(PyObject *op)
         assert(delstr != NULL);
         return _PyInstance_Lookup(op, delstr) != NULL;
     }
-    else if (PyType_HasFeature(op->ob_type, Py_TPFLAGS_HEAPTYPE))
-        return op->ob_type->tp_del != NULL;
+    else if (PyType_HasFeature(Py_TYPE(op), Py_TPFLAGS_HEAPTYPE))
+        return Py_TYPE(op)->tp_del != NULL;
     else if (PyGen_CheckExact(op))
         return PyGen_NeedsFinalizing((PyGenObject *)op);
     else
@@ -680,6 +768,7 @@ handle_weakrefs(PyGC_Head *unreachable, PyGC_Head *old)
         if (wrcb_to_call.gc.gc_next == gc) {
             /* object is still alive -- move it */
             gc_list_move(gc, old);
+            gc->gc.gc_refs = GC_REACHABLE;
         }
         else
             ++num_freed;
@@ -801,6 +890,15 @@ static double
 get_time(void)
 {
     double result = 0;
+#ifdef HAVE_GETTIMEOFDAY
+    struct timeval t;
+#ifdef GETTIMEOFDAY_NO_TZ
+    if (gettimeofday(&t) == 0)
+#else
+    if (gettimeofday(&t, (struct timezone *)NULL) == 0)
+#endif
+        return (double)t.tv_sec + t.tv_usec * 0.000001;
+#endif
     if (tmod != NULL) {
         PyObject *f = PyObject_CallMethod(tmod, "time", NULL);
         if (f == NULL) {
@@ -815,10 +913,210 @@ get_time(void)
     return result;
 }
 
+/* Account for a collection of `generation` in generation_stats */
+static void
+update_stats(int generation, struct gc_collection_info *info)
+{
+    struct gc_generation_stats *stats = &generation_stats[generation];
+    double t = info->pause * 1e6;
+    int i;
+
+    stats->collections++;
+    stats->examined += info->examined;
+    stats->collected += info->collected;
+    stats->uncollectable += info->uncollectable;
+    stats->pause_total += info->pause;
+    if (info->pause > stats->pause_max)
+        stats->pause_max = info->pause;
+    for (i = 0; t >= 1.0 && i < NUM_PAUSE_BUCKETS - 1; i++)
+        t *= 0.5;
+    stats->pause_histogram[i]++;
+}
+
+/* Set gc_refs = refs for all objects in list */
+static void
+set_refs(PyGC_Head *list, Py_ssize_t refs)
+{
+    PyGC_Head *gc;
+    for (gc = list->gc.gc_next; gc != list; gc = gc->gc.gc_next)
+        gc->gc.gc_refs = refs;
+}
+
+/* Move the objects of list, all reachable, to the visited objects of the
+ * oldest generation.
+ */
+static void
+move_to_visited(PyGC_Head *list)
+{
+    Py_ssize_t n = 0;
+    PyGC_Head *gc;
+    for (gc = list->gc.gc_next; gc != list; gc = gc->gc.gc_next, ++n) {
+        assert(gc->gc.gc_refs == GC_REACHABLE);
+        gc->gc.gc_refs = visited_refs;
+    }
+    gc_list_merge(list, &old_visited);
+    if (incremental_cycle)
+        incremental_survivors += n;
+}
+
+/* Move the objects visited in the current incremental cycle to list, and
+ * set their gc_refs.
+ */
+static void
+merge_visited(PyGC_Head *list, Py_ssize_t refs)
+{
+    set_refs(&old_gray, refs);
+    set_refs(&old_visited, refs);
+    gc_list_merge(&old_gray, list);
+    gc_list_merge(&old_visited, list);
+    incremental_cycle = 0;
+}
+
+/* A traversal callback for mark_roots and mark_alive. */
+static int
+visit_alive(PyObject *op, void *unused)
+{
+    if (PyObject_IS_GC(op)) {
+        PyGC_Head *gc = AS_GC(op);
+        if (gc->gc.gc_refs == pending_refs) {
+            gc_list_move(gc, &old_gray);
+            gc->gc.gc_refs = visited_refs;
+        }
+    }
+    return 0;
+}
+
+/* Mark a root and the pending objects it refers to as visited:  roots
+ * may be young, and then are not marked themselves.
+ */
+static void
+mark_root(PyObject *op)
+{
+    if (op != NULL && PyObject_IS_GC(op) && IS_TRACKED(op)) {
+        (void) visit_alive(op, NULL);
+        (void) Py_TYPE(op)->tp_traverse(op, (visitproc)visit_alive, NULL);
+    }
+}
+
+/* Mark the modules and the frames of all threads, which are surely alive,
+ * as roots.
+ */
+static void
+mark_roots(void)
+{
+    PyInterpreterState *interp;
+    PyThreadState *tstate;
+    PyFrameObject *f;
+
+    for (interp = PyInterpreterState_Head(); interp != NULL;
+         interp = PyInterpreterState_Next(interp)) {
+        mark_root(interp->modules);
+        mark_root(interp->sysdict);
+        mark_root(interp->builtins);
+        for (tstate = PyInterpreterState_ThreadHead(interp); tstate != NULL;
+             tstate = PyThreadState_Next(tstate)) {
+            for (f = tstate->frame; f != NULL; f = f->f_back)
+                mark_root((PyObject *)f);
+        }
+    }
+}
+
+/* Mark the pending objects referred to by about `budget` of the objects
+ * in old_gray as visited, and move those to old_visited.  Return the
+ * number of objects moved.
+ */
+static Py_ssize_t
+mark_alive(Py_ssize_t budget)
+{
+    Py_ssize_t n = 0;
+
+    while (n < budget && !gc_list_is_empty(&old_gray)) {
+        PyGC_Head *gc = old_gray.gc.gc_next;
+        PyObject *op = FROM_GC(gc);
+        assert(gc->gc.gc_refs == visited_refs);
+        gc_list_move(gc, &old_visited);
+        (void) Py_TYPE(op)->tp_traverse(op, (visitproc)visit_alive, NULL);
+        n++;
+    }
+    return n;
+}
+
+/* Start an incremental cycle:  all the objects of the oldest generation
+ * become pending, but the ones the roots refer to.
+ */
+static void
+start_incremental_cycle(void)
+{
+    Py_ssize_t refs = pending_refs;
+
+    assert(!incremental_cycle && gc_list_is_empty(&old_gray));
+    gc_list_merge(&old_visited, GEN_HEAD(NUM_GENERATIONS-1));
+    pending_refs = visited_refs;
+    visited_refs = refs;
+    incremental_cycle = 1;
+    incremental_survivors = 0;
+    long_lived_pending = 0;
+    mark_roots();
+}
+
+struct increment {
+    PyGC_Head *list;
+    Py_ssize_t size;
+};
+
+/* A traversal callback for move_increment. */
+static int
+visit_increment(PyObject *op, struct increment *inc)
+{
+    if (PyObject_IS_GC(op)) {
+        PyGC_Head *gc = AS_GC(op);
+        if (gc->gc.gc_refs == pending_refs) {
+            gc_list_move(gc, inc->list);
+            gc->gc.gc_refs = Py_REFCNT(op);
+            assert(gc->gc.gc_refs != 0);
+            inc->size++;
+        }
+    }
+    return 0;
+}
+
+/* Move pending objects of the oldest generation into young, the slice of
+ * an incremental cycle, setting their gc_refs as update_refs() does:  the
+ * first ones until `budget` were moved, along with all the pending objects
+ * they reach, directly or not.  Return the number of objects moved.
+ */
+static Py_ssize_t
+move_increment(PyGC_Head *young, Py_ssize_t budget)
+{
+    PyGC_Head *pending = GEN_HEAD(NUM_GENERATIONS-1);
+    struct increment inc;
+
+    inc.list = young;
+    inc.size = 0;
+    while (inc.size < budget && !gc_list_is_empty(pending)) {
+        PyGC_Head *gc = pending->gc.gc_next;
+        assert(gc->gc.gc_refs == pending_refs);
+        gc_list_move(gc, young);
+        gc->gc.gc_refs = Py_REFCNT(FROM_GC(gc));
+        assert(gc->gc.gc_refs != 0);
+        inc.size++;
+        /* Objects reached are appended to young, and scanned in turn */
+        for (; gc != young; gc = gc->gc.gc_next) {
+            PyObject *op = FROM_GC(gc);
+            (void) Py_TYPE(op)->tp_traverse(op,
+                                            (visitproc)visit_increment,
+                                            (void *)&inc);
+        }
+    }
+    return inc.size;
+}
+
 /* This is the main function.  Read this to understand how the
- * collection process works. */
+ * collection process works.  If increment is true, generation is the
+ * oldest one, and only a slice of it is collected.
+ */
 static Py_ssize_t
-collect(int generation)
+collect(int generation, int increment, struct gc_collection_info *info)
 {
     int i;
     Py_ssize_t m = 0; /* # objects collected */
@@ -827,8 +1125,11 @@ collect(int generation)
     PyGC_Head *old; /* next older generation */
     PyGC_Head unreachable; /* non-problematic unreachable trash */
     PyGC_Head finalizers;  /* objects with, & reachable from, __del__ */
+    PyGC_Head slice; /* the slice collected, if increment is true */
+    PyGC_Head reached; /* survivors to move to the visited objects */
+    Py_ssize_t marked = 0; /* # objects marked alive, if increment is true */
     PyGC_Head *gc;
-    double t1 = 0.0;
+    double t1;
 
     if (delstr == NULL) {
         delstr = PyString_InternFromString("__del__");
@@ -843,9 +1144,9 @@ collect(int generation)
         for (i = 0; i < NUM_GENERATIONS; i++)
             PySys_WriteStderr(" %" PY_FORMAT_SIZE_T "d",
                               gc_list_size(GEN_HEAD(i)));
-        t1 = get_time();
         PySys_WriteStderr("\n");
     }
+    t1 = get_time();
 
     /* update collection and allocation counters */
     if (generation+1 < NUM_GENERATIONS)
@@ -853,14 +1154,33 @@ collect(int generation)
     for (i = 0; i <= generation; i++)
         generations[i].count = 0;
 
-    /* merge younger generations with one we are currently collecting */
-    for (i = 0; i < generation; i++) {
-        gc_list_merge(GEN_HEAD(i), GEN_HEAD(generation));
+    if (increment) {
+        assert(generation == NUM_GENERATIONS-1 && incremental_slice > 0);
+        if (!incremental_cycle)
+            start_incremental_cycle();
+        marked = mark_alive(incremental_slice);
+        young = &slice;
+        gc_list_init(young);
+        for (i = 0; i < generation; i++)
+            gc_list_merge(GEN_HEAD(i), young);
+    }
+    else {
+        /* merge younger generations with one we are currently collecting */
+        for (i = 0; i < generation; i++) {
+            gc_list_merge(GEN_HEAD(i), GEN_HEAD(generation));
+        }
+        if (incremental_slice && generation == NUM_GENERATIONS-1)
+            merge_visited(GEN_HEAD(generation), GC_REACHABLE);
+        young = GEN_HEAD(generation);
     }
 
     /* handy references */
-    young = GEN_HEAD(generation);
-    if (generation < NUM_GENERATIONS-1)
+    if (incremental_slice && generation >= NUM_GENERATIONS-2) {
+        /* the survivors are visited in the current incremental cycle */
+        old = &reached;
+        gc_list_init(old);
+    }
+    else if (generation < NUM_GENERATIONS-1)
         old = GEN_HEAD(generation+1);
     else
         old = young;
@@ -870,7 +1190,10 @@ collect(int generation)
      * refcount greater than 0 when all the references within the
      * set are taken into account).
      */
-    update_refs(young);
+    info->examined = marked + update_refs(young);
+    /* The slice only starts once the marking is done */
+    if (increment && gc_list_is_empty(&old_gray))
+        info->examined += move_increment(young, incremental_slice - marked);
     subtract_refs(young);
 
     /* Leave everything reachable from outside young in young, and move
@@ -883,16 +1206,15 @@ collect(int generation)
     move_unreachable(young, &unreachable);
 
     /* Move reachable objects to next generation. */
-    if (young != old) {
-        if (generation == NUM_GENERATIONS - 2) {
-            long_lived_pending += gc_list_size(young);
-        }
-        gc_list_merge(young, old);
+    if (generation == NUM_GENERATIONS - 2) {
+        long_lived_pending += gc_list_size(young);
     }
-    else {
+    else if (generation == NUM_GENERATIONS - 1 && !increment) {
         long_lived_pending = 0;
         long_lived_total = gc_list_size(young);
     }
+    if (young != old)
+        gc_list_merge(young, old);
 
     /* All objects in unreachable are trash, but objects reachable from
      * finalizers can't safely be deleted.  Python programmers should take
@@ -960,9 +1282,19 @@ collect(int generation)
      */
     (void)handle_finalizers(&finalizers, old);
 
+    if (old == &reached) {
+        move_to_visited(old);
+        if (incremental_cycle && gc_list_is_empty(&old_gray)
+            && gc_list_is_empty(GEN_HEAD(NUM_GENERATIONS-1))) {
+            /* all the oldest generation was visited */
+            incremental_cycle = 0;
+            long_lived_total = incremental_survivors;
+        }
+    }
+
     /* Clear free list only during the collection of the highest
      * generation */
-    if (generation == NUM_GENERATIONS-1) {
+    if (generation == NUM_GENERATIONS-1 && !increment) {
         clear_freelists();
     }
 
@@ -972,9 +1304,66 @@ collect(int generation)
         PyErr_WriteUnraisable(gc_str);
         Py_FatalError("unexpected exception during garbage collection");
     }
+
+    info->collected = m;
+    info->uncollectable = n;
+    info->pause = t1 ? get_time() - t1 : 0.0;
+    update_stats(generation, info);
     return n+m;
 }
 
+/* Call the functions in gc.callbacks as callback(phase, info), where phase
+ * is "start" or "stop".  Exceptions they raise are reported, and ignored.
+ */
+static void
+invoke_gc_callbacks(const char *phase, int generation,
+                    struct gc_collection_info *info)
+{
+    Py_ssize_t i;
+    PyObject *d, *cbs;
+
+    if (callbacks == NULL || PyList_GET_SIZE(callbacks) == 0)
+        return;
+    assert(!PyErr_Occurred());
+    d = Py_BuildValue("{sisnsnsnsd}",
+                      "generation", generation,
+                      "examined", info->examined,
+                      "collected", info->collected,
+                      "uncollectable", info->uncollectable,
+                      "pause", info->pause);
+    /* Call a copy, as the callbacks may change the list */
+    cbs = PyList_GetSlice(callbacks, 0, PyList_GET_SIZE(callbacks));
+    if (d == NULL || cbs == NULL) {
+        PyErr_WriteUnraisable(NULL);
+        Py_XDECREF(d);
+        Py_XDECREF(cbs);
+        return;
+    }
+    for (i = 0; i < PyList_GET_SIZE(cbs); i++) {
+        PyObject *r, *cb = PyList_GET_ITEM(cbs, i);
+        r = PyObject_CallFunction(cb, "sO", phase, d);
+        if (r == NULL)
+            PyErr_WriteUnraisable(cb);
+        else
+            Py_DECREF(r);
+    }
+    Py_DECREF(cbs);
+    Py_DECREF(d);
+}
+
+/* Run a collection, between the calls to the callbacks */
+static Py_ssize_t
+collect_with_callbacks(int generation, int increment)
+{
+    struct gc_collection_info info = {0, 0, 0, 0.0};
+    Py_ssize_t n;
+
+    invoke_gc_callbacks("start", generation, &info);
+    n = collect(generation, increment, &info);
+    invoke_gc_callbacks("stop", generation, &info);
+    return n;
+}
+
 static Py_ssize_t
 collect_generations(void)
 {
@@ -990,10 +1379,17 @@ collect_generations(void)
                of tracked objects. See comments at the beginning
                of this file, and issue #4074.
             */
-            if (i == NUM_GENERATIONS - 1
+            if (i == NUM_GENERATIONS - 1 && !incremental_cycle
                 && long_lived_pending < long_lived_total / 4)
                 continue;
-            n = collect(i);
+            /* Once started, an incremental cycle goes on in place of
+               the collections of the middle generation. */
+            if (incremental_slice
+                && (i == NUM_GENERATIONS - 1
+                    || (i == NUM_GENERATIONS - 2 && incremental_cycle)))
+                n = collect_with_callbacks(NUM_GENERATIONS - 1, 1);
+            else
+                n = collect_with_callbacks(i, 0);
             break;
         }
     }
@@ -1064,7 +1460,7 @@ gc_collect(PyObject *self, PyObject *args, PyObject *kws)
         n = 0; /* already collecting, don't do anything */
     else {
         collecting = 1;
-        n = collect(genarg);
+        n = collect_with_callbacks(genarg, 0);
         collecting = 0;
     }
 
@@ -1160,6 +1556,303 @@ gc_get_count(PyObject *self, PyObject *noargs)
                          generations[2].count);
 }
 
+PyDoc_STRVAR(gc_freeze__doc__,
+"freeze() -> None\n"
+"\n"
+"Move all the objects tracked by the collector to a permanent\n"
+"generation, ignored by the collections from now on.  To be called\n"
+"before fork(), so that the pages of the objects created before stay\n"
+"shared with the child processes.\n");
+
+static PyObject *
+gc_freeze(PyObject *self, PyObject *noargs)
+{
+    int i;
+
+    if (incremental_slice) {
+        /* Frozen objects must not look pending */
+        set_refs(GEN_HEAD(NUM_GENERATIONS-1), GC_REACHABLE);
+        merge_visited(&permanent_generation, GC_REACHABLE);
+    }
+    for (i = 0; i < NUM_GENERATIONS; i++) {
+        gc_list_merge(GEN_HEAD(i), &permanent_generation);
+        generations[i].count = 0;
+    }
+    /* The long lived objects are frozen, and no more delay the full
+       collections */
+    long_lived_total = 0;
+    long_lived_pending = 0;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyDoc_STRVAR(gc_unfreeze__doc__,
+"unfreeze() -> None\n"
+"\n"
+"Move the objects of the permanent generation back to the oldest\n"
+"generation, to be examined by the full collections again.\n");
+
+static PyObject *
+gc_unfreeze(PyObject *self, PyObject *noargs)
+{
+    long_lived_pending += gc_list_size(&permanent_generation);
+    if (incremental_slice) {
+        set_refs(&permanent_generation, visited_refs);
+        gc_list_merge(&permanent_generation, &old_visited);
+    }
+    else
+        gc_list_merge(&permanent_generation, GEN_HEAD(NUM_GENERATIONS-1));
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+#ifdef Py_IMMORTAL_OBJECTS
+/* A traversal callback for immortalize:  objects that are not tracked,
+ * but may refer to other objects, are appended to `todo`, to be
+ * traversed too.
+ */
+static int
+visit_immortalize(PyObject *op, PyObject *todo)
+{
+    if (_Py_IsImmortal(op))
+        return 0;
+    _Py_SetImmortal(op);
+    if ((PyObject_IS_GC(op) && !IS_TRACKED(op)) || PyCode_Check(op))
+        return PyList_Append(todo, op);
+    return 0;
+}
+
+/* Make the objects in list, and the objects they refer to, immortal */
+static int
+immortalize_list(PyGC_Head *list, PyObject *todo)
+{
+    PyGC_Head *gc;
+    for (gc = list->gc.gc_next; gc != list; gc = gc->gc.gc_next) {
+        PyObject *op = FROM_GC(gc);
+        if (!_Py_IsImmortal(op))
+            _Py_SetImmortal(op);
+        if (Py_TYPE(op)->tp_traverse(op, (visitproc)visit_immortalize,
+                                     todo))
+            return -1;
+    }
+    return 0;
+}
+
+/* Make the objects in todo, and the objects they refer to, immortal */
+static int
+immortalize_todo(PyObject *todo)
+{
+    while (PyList_GET_SIZE(todo) > 0) {
+        Py_ssize_t n = PyList_GET_SIZE(todo) - 1;
+        PyObject *op = PyList_GET_ITEM(todo, n);
+        int err = 0;
+
+        /* op is immortal, so it needn't be decref'ed */
+        if (PyList_SetSlice(todo, n, n + 1, NULL) < 0)
+            return -1;
+        if (PyCode_Check(op)) {
+            PyCodeObject *co = (PyCodeObject *)op;
+            PyObject *fields[9];
+            int i;
+
+            fields[0] = co->co_code;
+            fields[1] = co->co_consts;
+            fields[2] = co->co_names;
+            fields[3] = co->co_varnames;
+            fields[4] = co->co_freevars;
+            fields[5] = co->co_cellvars;
+            fields[6] = co->co_filename;
+            fields[7] = co->co_name;
+            fields[8] = co->co_lnotab;
+            for (i = 0; i < 9 && !err; i++) {
+                if (fields[i] != NULL)
+                    err = visit_immortalize(fields[i], todo);
+            }
+        }
+        else
+            err = Py_TYPE(op)->tp_traverse(op,
+                                           (visitproc)visit_immortalize,
+                                           todo);
+        if (err)
+            return -1;
+    }
+    return 0;
+}
+
+PyDoc_STRVAR(gc_immortalize_heap__doc__,
+"immortalize_heap() -> None\n"
+"\n"
+"Run a full collection, then make all the objects tracked by the\n"
+"collector, and all the objects they refer to, immortal:  they are\n"
+"never freed, and their reference count is left alone, so that the\n"
+"memory pages holding them stay shared with forked processes.\n");
+
+static PyObject *
+gc_immortalize_heap(PyObject *self, PyObject *noargs)
+{
+    PyObject *todo;
+    int i, err = 0;
+
+    if (collecting) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "can't immortalize objects during a collection");
+        return NULL;
+    }
+    collecting = 1;
+    (void)collect_with_callbacks(NUM_GENERATIONS - 1, 0);
+    collecting = 0;
+
+    todo = PyList_New(0);
+    if (todo == NULL)
+        return NULL;
+    for (i = 0; i < NUM_GENERATIONS && !err; i++)
+        err = immortalize_list(GEN_HEAD(i), todo);
+    if (!err)
+        err = immortalize_list(&old_visited, todo);
+    if (!err)
+        err = immortalize_list(&old_gray, todo);
+    if (!err)
+        err = immortalize_list(&permanent_generation, todo);
+    if (!err)
+        err = immortalize_todo(todo);
+    Py_DECREF(todo);
+    if (err)
+        return NULL;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyDoc_STRVAR(gc_is_immortal__doc__,
+"is_immortal(obj) -> bool\n"
+"\n"
+"Returns true if the object is immortal.\n");
+
+static PyObject *
+gc_is_immortal(PyObject *self, PyObject *obj)
+{
+    return PyBool_FromLong(_Py_IsImmortal(obj));
+}
+#endif /* Py_IMMORTAL_OBJECTS */
+
+PyDoc_STRVAR(gc_set_incremental__doc__,
+"set_incremental(slice) -> None\n"
+"\n"
+"Collect the oldest generation in slices of about `slice` objects,\n"
+"instead of all at once, if slice is not 0.\n");
+
+static PyObject *
+gc_set_incremental(PyObject *self, PyObject *args)
+{
+    Py_ssize_t slice;
+
+    if (!PyArg_ParseTuple(args, "n:set_incremental", &slice))
+        return NULL;
+    if (slice < 0) {
+        PyErr_SetString(PyExc_ValueError, "slice must be >= 0");
+        return NULL;
+    }
+    if (collecting) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "can't change the incremental mode "
+                        "during a collection");
+        return NULL;
+    }
+    if (slice && !incremental_slice) {
+        /* All the oldest generation is visited, until the next cycle */
+        pending_refs = GC_OLD_A;
+        visited_refs = GC_OLD_B;
+        set_refs(GEN_HEAD(NUM_GENERATIONS-1), visited_refs);
+        gc_list_merge(GEN_HEAD(NUM_GENERATIONS-1), &old_visited);
+        incremental_cycle = 0;
+    }
+    else if (!slice && incremental_slice) {
+        set_refs(GEN_HEAD(NUM_GENERATIONS-1), GC_REACHABLE);
+        merge_visited(GEN_HEAD(NUM_GENERATIONS-1), GC_REACHABLE);
+    }
+    incremental_slice = slice;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyDoc_STRVAR(gc_get_incremental__doc__,
+"get_incremental() -> slice\n"
+"\n"
+"Return the size of the slices in which the oldest generation is\n"
+"collected, or 0 if it is collected all at once.\n");
+
+static PyObject *
+gc_get_incremental(PyObject *self, PyObject *noargs)
+{
+    return PyInt_FromSsize_t(incremental_slice);
+}
+
+PyDoc_STRVAR(gc_get_freeze_count__doc__,
+"get_freeze_count() -> int\n"
+"\n"
+"Return the number of objects in the permanent generation.\n");
+
+static PyObject *
+gc_get_freeze_count(PyObject *self, PyObject *noargs)
+{
+    return PyInt_FromSsize_t(gc_list_size(&permanent_generation));
+}
+
+PyDoc_STRVAR(gc_get_stats__doc__,
+"get_stats() -> [dict, ...]\n"
+"\n"
+"Return a list of dictionaries with the statistics of the collections\n"
+"of each generation since the interpreter started:  'collections',\n"
+"'examined', 'collected' and 'uncollectable' counts, 'pause_total'\n"
+"and 'pause_max' in seconds, and 'pause_histogram', a list whose item\n"
+"i counts the pauses shorter than 2**i microseconds, and at least\n"
+"2**(i-1).\n");
+
+static PyObject *
+gc_get_stats(PyObject *self, PyObject *noargs)
+{
+    int i, j;
+    PyObject *result, *d, *histogram;
+
+    result = PyList_New(0);
+    if (result == NULL)
+        return NULL;
+    for (i = 0; i < NUM_GENERATIONS; i++) {
+        struct gc_generation_stats *stats = &generation_stats[i];
+
+        histogram = PyList_New(NUM_PAUSE_BUCKETS);
+        if (histogram == NULL)
+            goto error;
+        for (j = 0; j < NUM_PAUSE_BUCKETS; j++) {
+            PyObject *v = PyInt_FromSsize_t(stats->pause_histogram[j]);
+            if (v == NULL) {
+                Py_DECREF(histogram);
+                goto error;
+            }
+            PyList_SET_ITEM(histogram, j, v);
+        }
+        d = Py_BuildValue("{snsnsnsnsdsdsN}",
+                          "collections", stats->collections,
+                          "examined", stats->examined,
+                          "collected", stats->collected,
+                          "uncollectable", stats->uncollectable,
+                          "pause_total", stats->pause_total,
+                          "pause_max", stats->pause_max,
+                          "pause_histogram", histogram);
+        if (d == NULL)
+            goto error;
+        if (PyList_Append(result, d)) {
+            Py_DECREF(d);
+            goto error;
+        }
+        Py_DECREF(d);
+    }
+    return result;
+
+error:
+    Py_DECREF(result);
+    return NULL;
+}
+
 static int
 referrersvisit(PyObject* obj, PyObject *objs)
 {
@@ -1206,6 +1899,11 @@ gc_get_referrers(PyObject *self, PyObject *args)
             return NULL;
         }
     }
+    if (!(gc_referrers_for(args, &old_visited, result)) ||
+        !(gc_referrers_for(args, &old_gray, result))) {
+        Py_DECREF(result);
+        return NULL;
+    }
     return result;
 }
 
@@ -1267,6 +1965,11 @@ gc_get_objects(PyObject *self, PyObject *noargs)
             return NULL;
         }
     }
+    if (append_objects(result, &old_visited) ||
+        append_objects(result, &old_gray)) {
+        Py_DECREF(result);
+        return NULL;
+    }
     return result;
 }
 
@@ -1299,6 +2002,7 @@ PyDoc_STRVAR(gc__doc__,
 "isenabled() -- Returns true if automatic collection is enabled.\n"
 "collect() -- Do a full collection right now.\n"
 "get_count() -- Return the current collection counts.\n"
+"get_stats() -- Return statistics on the collections of each generation.\n"
 "set_debug() -- Set debugging flags.\n"
 "get_debug() -- Get debugging flags.\n"
 "set_threshold() -- Set the collection thresholds.\n"
@@ -1306,7 +2010,19 @@ PyDoc_STRVAR(gc__doc__,
 "get_objects() -- Return a list of all objects tracked by the collector.\n"
 "is_tracked() -- Returns true if a given object is tracked.\n"
 "get_referrers() -- Return the list of objects that refer to an object.\n"
-"get_referents() -- Return the list of objects that an object refers to.\n");
+"get_referents() -- Return the list of objects that an object refers to.\n"
+"freeze() -- Freeze all tracked objects and ignore them in collections.\n"
+"unfreeze() -- Unfreeze all objects in the permanent generation.\n"
+"get_freeze_count() -- Return the number of objects in the permanent\n"
+"                      generation.\n"
+"set_incremental() -- Set the size of the slices of the oldest generation.\n"
+"get_incremental() -- Return the size of the slices of the oldest\n"
+"                     generation.\n"
+#ifdef Py_IMMORTAL_OBJECTS
+"immortalize_heap() -- Make all the objects immortal.\n"
+"is_immortal() -- Returns true if a given object is immortal.\n"
+#endif
+);
 
 static PyMethodDef GcMethods[] = {
     {"enable",             gc_enable,     METH_NOARGS,  gc_enable__doc__},
@@ -1315,6 +2031,7 @@ static PyMethodDef GcMethods[] = {
     {"set_debug",          gc_set_debug,  METH_VARARGS, gc_set_debug__doc__},
     {"get_debug",          gc_get_debug,  METH_NOARGS,  gc_get_debug__doc__},
     {"get_count",          gc_get_count,  METH_NOARGS,  gc_get_count__doc__},
+    {"get_stats",          gc_get_stats,  METH_NOARGS,  gc_get_stats__doc__},
     {"set_threshold",  gc_set_thresh, METH_VARARGS, gc_set_thresh__doc__},
     {"get_threshold",  gc_get_thresh, METH_NOARGS,  gc_get_thresh__doc__},
     {"collect",            (PyCFunction)gc_collect,
@@ -1325,6 +2042,19 @@ static PyMethodDef GcMethods[] = {
         gc_get_referrers__doc__},
     {"get_referents",  gc_get_referents, METH_VARARGS,
         gc_get_referents__doc__},
+    {"freeze",             gc_freeze,     METH_NOARGS,  gc_freeze__doc__},
+    {"unfreeze",           gc_unfreeze,   METH_NOARGS,  gc_unfreeze__doc__},
+    {"get_freeze_count",   gc_get_freeze_count, METH_NOARGS,
+        gc_get_freeze_count__doc__},
+    {"set_incremental",    gc_set_incremental, METH_VARARGS,
+        gc_set_incremental__doc__},
+    {"get_incremental",    gc_get_incremental, METH_NOARGS,
+        gc_get_incremental__doc__},
+#ifdef Py_IMMORTAL_OBJECTS
+    {"immortalize_heap",   gc_immortalize_heap, METH_NOARGS,
+        gc_immortalize_heap__doc__},
+    {"is_immortal",        gc_is_immortal, METH_O, gc_is_immortal__doc__},
+#endif
     {NULL,      NULL}           /* Sentinel */
 };
 
@@ -1350,6 +2080,15 @@ initgc(void)
     if (PyModule_AddObject(m, "garbage", garbage) < 0)
         return;
 
+    if (callbacks == NULL) {
+        callbacks = PyList_New(0);
+        if (callbacks == NULL)
+            return;
+    }
+    Py_INCREF(callbacks);
+    if (PyModule_AddObject(m, "callbacks", callbacks) < 0)
+        return;
+
     /* Importing can't be done in collect() because collect()
      * can be called via PyGC_Collect() in Py_Finalize().
      * This wouldn't be a problem, except that <initialized> is
@@ -1383,7 +2122,7 @@ PyGC_Collect(void)
         n = 0; /* already collecting, don't do anything */
     else {
         collecting = 1;
-        n = collect(NUM_GENERATIONS - 1);
+        n = collect_with_callbacks(NUM_GENERATIONS - 1, 0);
         collecting = 0;
     }
 
@@ -191,7 +191,7 @@ dbm_contains(register dbmobject *dp, PyObject *arg)
     if (!PyString_Check(arg)) {
         PyErr_Format(PyExc_TypeError,
                      "gdbm key must be string, not %.100s",
-                     arg->ob_type->tp_name);
+                     Py_TYPE(arg)->tp_name);
         return -1;
     }
     key.dptr = PyString_AS_STRING(arg);
@@ -209,7 +209,7 @@ static int RunMainFromImporter(char *filename)
 
     if ((argv0 = PyString_FromString(filename)) &&
         (importer = PyImport_GetImporter(argv0)) &&
-        (importer->ob_type != &PyNullImporter_Type))
+        (Py_TYPE(importer) != &PyNullImporter_Type))
     {
              /* argv0 is usable as an import source, so
                     put it in sys.path[0] and import __main__ */
@@ -20,7 +20,7 @@ typedef struct {
 
 static PyTypeObject MD5type;
 
-#define is_md5object(v)         ((v)->ob_type == &MD5type)
+#define is_md5object(v)         (Py_TYPE((v)) == &MD5type)
 
 static md5object *
 newmd5object(void)
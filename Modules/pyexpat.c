@@ -1246,8 +1246,10 @@ PyUnknownEncodingHandler(void *encodingHandlerData,
     _u_string = (PyUnicodeObject *)
         PyUnicode_Decode(template_buffer, 256, name, "replace");
 
-    if (_u_string == NULL)
+    if (_u_string == NULL || PyUnicode_AS_UNICODE(_u_string) == NULL) {
+        Py_XDECREF(_u_string);
         return result;
+    }
 
     for (i = 0; i < 256; i++) {
         /* Stupid to access directly, but fast */
@@ -475,7 +475,7 @@ SHA512_copy(SHAobject *self, PyObject *unused)
 {
     SHAobject *newobj;
 
-    if (((PyObject*)self)->ob_type == &SHA512type) {
+    if (Py_TYPE(((PyObject*)self)) == &SHA512type) {
         if ( (newobj = newSHA512object())==NULL)
             return NULL;
     } else {
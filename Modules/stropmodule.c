@@ -242,8 +242,8 @@ strop_joinfields(PyObject *self, PyObject *args)
         return res;
     }
 
-    if (seq->ob_type->tp_as_sequence == NULL ||
-             (getitemfunc = seq->ob_type->tp_as_sequence->sq_item) == NULL)
+    if (Py_TYPE(seq)->tp_as_sequence == NULL ||
+             (getitemfunc = Py_TYPE(seq)->tp_as_sequence->sq_item) == NULL)
     {
         PyErr_SetString(PyExc_TypeError,
                         "first argument must be a sequence");
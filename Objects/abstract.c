@@ -5,7 +5,7 @@
 #include "structmember.h" /* we need the offsetof() macro from there */
 #include "longintrepr.h"
 
-#define NEW_STYLE_NUMBER(o) PyType_HasFeature((o)->ob_type, \
+#define NEW_STYLE_NUMBER(o) PyType_HasFeature(Py_TYPE((o)), \
                 Py_TPFLAGS_CHECKTYPES)
 
 
@@ -14,7 +14,7 @@
 static PyObject *
 type_error(const char *msg, PyObject *obj)
 {
-    PyErr_Format(PyExc_TypeError, msg, obj->ob_type->tp_name);
+    PyErr_Format(PyExc_TypeError, msg, Py_TYPE(obj)->tp_name);
     return NULL;
 }
 
@@ -52,7 +52,7 @@ PyObject_Type(PyObject *o)
 
     if (o == NULL)
         return null_error();
-    v = (PyObject *)o->ob_type;
+    v = (PyObject *)Py_TYPE(o);
     Py_INCREF(v);
     return v;
 }
@@ -67,7 +67,7 @@ PyObject_Size(PyObject *o)
         return -1;
     }
 
-    m = o->ob_type->tp_as_sequence;
+    m = Py_TYPE(o)->tp_as_sequence;
     if (m && m->sq_length)
         return m->sq_length(o);
 
@@ -139,11 +139,11 @@ PyObject_GetItem(PyObject *o, PyObject *key)
     if (o == NULL || key == NULL)
         return null_error();
 
-    m = o->ob_type->tp_as_mapping;
+    m = Py_TYPE(o)->tp_as_mapping;
     if (m && m->mp_subscript)
         return m->mp_subscript(o, key);
 
-    if (o->ob_type->tp_as_sequence) {
+    if (Py_TYPE(o)->tp_as_sequence) {
         if (PyIndex_Check(key)) {
             Py_ssize_t key_value;
             key_value = PyNumber_AsSsize_t(key, PyExc_IndexError);
@@ -151,7 +151,7 @@ PyObject_GetItem(PyObject *o, PyObject *key)
                 return NULL;
             return PySequence_GetItem(o, key_value);
         }
-        else if (o->ob_type->tp_as_sequence->sq_item)
+        else if (Py_TYPE(o)->tp_as_sequence->sq_item)
             return type_error("sequence index must "
                               "be integer, not '%.200s'", key);
     }
@@ -168,11 +168,11 @@ PyObject_SetItem(PyObject *o, PyObject *key, PyObject *value)
         null_error();
         return -1;
     }
-    m = o->ob_type->tp_as_mapping;
+    m = Py_TYPE(o)->tp_as_mapping;
     if (m && m->mp_ass_subscript)
         return m->mp_ass_subscript(o, key, value);
 
-    if (o->ob_type->tp_as_sequence) {
+    if (Py_TYPE(o)->tp_as_sequence) {
         if (PyIndex_Check(key)) {
             Py_ssize_t key_value;
             key_value = PyNumber_AsSsize_t(key, PyExc_IndexError);
@@ -180,7 +180,7 @@ PyObject_SetItem(PyObject *o, PyObject *key, PyObject *value)
                 return -1;
             return PySequence_SetItem(o, key_value, value);
         }
-        else if (o->ob_type->tp_as_sequence->sq_ass_item) {
+        else if (Py_TYPE(o)->tp_as_sequence->sq_ass_item) {
             type_error("sequence index must be "
                        "integer, not '%.200s'", key);
             return -1;
@@ -200,11 +200,11 @@ PyObject_DelItem(PyObject *o, PyObject *key)
         null_error();
         return -1;
     }
-    m = o->ob_type->tp_as_mapping;
+    m = Py_TYPE(o)->tp_as_mapping;
     if (m && m->mp_ass_subscript)
         return m->mp_ass_subscript(o, key, (PyObject*)NULL);
 
-    if (o->ob_type->tp_as_sequence) {
+    if (Py_TYPE(o)->tp_as_sequence) {
         if (PyIndex_Check(key)) {
             Py_ssize_t key_value;
             key_value = PyNumber_AsSsize_t(key, PyExc_IndexError);
@@ -212,7 +212,7 @@ PyObject_DelItem(PyObject *o, PyObject *key)
                 return -1;
             return PySequence_DelItem(o, key_value);
         }
-        else if (o->ob_type->tp_as_sequence->sq_ass_item) {
+        else if (Py_TYPE(o)->tp_as_sequence->sq_ass_item) {
             type_error("sequence index must be "
                        "integer, not '%.200s'", key);
             return -1;
@@ -254,7 +254,7 @@ PyObject_AsCharBuffer(PyObject *obj,
         null_error();
         return -1;
     }
-    pb = obj->ob_type->tp_as_buffer;
+    pb = Py_TYPE(obj)->tp_as_buffer;
     if (pb == NULL ||
          pb->bf_getcharbuffer == NULL ||
          pb->bf_getsegcount == NULL) {
@@ -278,7 +278,7 @@ PyObject_AsCharBuffer(PyObject *obj,
 int
 PyObject_CheckReadBuffer(PyObject *obj)
 {
-    PyBufferProcs *pb = obj->ob_type->tp_as_buffer;
+    PyBufferProcs *pb = Py_TYPE(obj)->tp_as_buffer;
 
     if (pb == NULL ||
         pb->bf_getreadbuffer == NULL ||
@@ -300,7 +300,7 @@ int PyObject_AsReadBuffer(PyObject *obj,
         null_error();
         return -1;
     }
-    pb = obj->ob_type->tp_as_buffer;
+    pb = Py_TYPE(obj)->tp_as_buffer;
     if (pb == NULL ||
          pb->bf_getreadbuffer == NULL ||
          pb->bf_getsegcount == NULL) {
@@ -333,7 +333,7 @@ int PyObject_AsWriteBuffer(PyObject *obj,
         null_error();
         return -1;
     }
-    pb = obj->ob_type->tp_as_buffer;
+    pb = Py_TYPE(obj)->tp_as_buffer;
     if (pb == NULL ||
          pb->bf_getwritebuffer == NULL ||
          pb->bf_getsegcount == NULL) {
@@ -365,7 +365,7 @@ PyObject_GetBuffer(PyObject *obj, Py_buffer *view, int flags)
                      Py_TYPE(obj)->tp_name);
         return -1;
     }
-    return (*(obj->ob_type->tp_as_buffer->bf_getbuffer))(obj, view, flags);
+    return (*(Py_TYPE(obj)->tp_as_buffer->bf_getbuffer))(obj, view, flags);
 }
 
 static int
@@ -882,9 +882,9 @@ done:
 int
 PyNumber_Check(PyObject *o)
 {
-    return o && o->ob_type->tp_as_number &&
-           (o->ob_type->tp_as_number->nb_int ||
-        o->ob_type->tp_as_number->nb_float);
+    return o && Py_TYPE(o)->tp_as_number &&
+           (Py_TYPE(o)->tp_as_number->nb_int ||
+        Py_TYPE(o)->tp_as_number->nb_float);
 }
 
 /* Binary operators */
@@ -907,8 +907,8 @@ PyNumber_Check(PyObject *o)
   old   new     w.op(v,w), coerce(v,w), v.op(v,w)
   old   old     coerce(v,w), v.op(v,w)
 
-  [*] only when v->ob_type != w->ob_type && w->ob_type is a subclass of
-      v->ob_type
+  [*] only when Py_TYPE(v) != Py_TYPE(w) && Py_TYPE(w) is a subclass of
+      Py_TYPE(v)
 
   Legend:
   -------
@@ -926,16 +926,16 @@ binary_op1(PyObject *v, PyObject *w, const int op_slot)
     binaryfunc slotv = NULL;
     binaryfunc slotw = NULL;
 
-    if (v->ob_type->tp_as_number != NULL && NEW_STYLE_NUMBER(v))
-        slotv = NB_BINOP(v->ob_type->tp_as_number, op_slot);
-    if (w->ob_type != v->ob_type &&
-        w->ob_type->tp_as_number != NULL && NEW_STYLE_NUMBER(w)) {
-        slotw = NB_BINOP(w->ob_type->tp_as_number, op_slot);
+    if (Py_TYPE(v)->tp_as_number != NULL && NEW_STYLE_NUMBER(v))
+        slotv = NB_BINOP(Py_TYPE(v)->tp_as_number, op_slot);
+    if (Py_TYPE(w) != Py_TYPE(v) &&
+        Py_TYPE(w)->tp_as_number != NULL && NEW_STYLE_NUMBER(w)) {
+        slotw = NB_BINOP(Py_TYPE(w)->tp_as_number, op_slot);
         if (slotw == slotv)
             slotw = NULL;
     }
     if (slotv) {
-        if (slotw && PyType_IsSubtype(w->ob_type, v->ob_type)) {
+        if (slotw && PyType_IsSubtype(Py_TYPE(w), Py_TYPE(v))) {
             x = slotw(v, w);
             if (x != Py_NotImplemented)
                 return x;
@@ -959,7 +959,7 @@ binary_op1(PyObject *v, PyObject *w, const int op_slot)
             return NULL;
         }
         if (err == 0) {
-            PyNumberMethods *mv = v->ob_type->tp_as_number;
+            PyNumberMethods *mv = Py_TYPE(v)->tp_as_number;
             if (mv) {
                 binaryfunc slot;
                 slot = NB_BINOP(mv, op_slot);
@@ -986,8 +986,8 @@ binop_type_error(PyObject *v, PyObject *w, const char *op_name)
                  "unsupported operand type(s) for %.100s: "
                  "'%.100s' and '%.100s'",
                  op_name,
-                 v->ob_type->tp_name,
-                 w->ob_type->tp_name);
+                 Py_TYPE(v)->tp_name,
+                 Py_TYPE(w)->tp_name);
     return NULL;
 }
 
@@ -1044,18 +1044,18 @@ ternary_op(PyObject *v,
     ternaryfunc slotw = NULL;
     ternaryfunc slotz = NULL;
 
-    mv = v->ob_type->tp_as_number;
-    mw = w->ob_type->tp_as_number;
+    mv = Py_TYPE(v)->tp_as_number;
+    mw = Py_TYPE(w)->tp_as_number;
     if (mv != NULL && NEW_STYLE_NUMBER(v))
         slotv = NB_TERNOP(mv, op_slot);
-    if (w->ob_type != v->ob_type &&
+    if (Py_TYPE(w) != Py_TYPE(v) &&
         mw != NULL && NEW_STYLE_NUMBER(w)) {
         slotw = NB_TERNOP(mw, op_slot);
         if (slotw == slotv)
             slotw = NULL;
     }
     if (slotv) {
-        if (slotw && PyType_IsSubtype(w->ob_type, v->ob_type)) {
+        if (slotw && PyType_IsSubtype(Py_TYPE(w), Py_TYPE(v))) {
             x = slotw(v, w, z);
             if (x != Py_NotImplemented)
                 return x;
@@ -1073,7 +1073,7 @@ ternary_op(PyObject *v,
             return x;
         Py_DECREF(x); /* can't do it */
     }
-    mz = z->ob_type->tp_as_number;
+    mz = Py_TYPE(z)->tp_as_number;
     if (mz != NULL && NEW_STYLE_NUMBER(z)) {
         slotz = NB_TERNOP(mz, op_slot);
         if (slotz == slotv || slotz == slotw)
@@ -1099,8 +1099,8 @@ ternary_op(PyObject *v,
         /* Special case: if the third argument is None, it is
            treated as absent argument and not coerced. */
         if (z == Py_None) {
-            if (v->ob_type->tp_as_number) {
-                slotz = NB_TERNOP(v->ob_type->tp_as_number,
+            if (Py_TYPE(v)->tp_as_number) {
+                slotz = NB_TERNOP(Py_TYPE(v)->tp_as_number,
                                   op_slot);
                 if (slotz)
                     x = slotz(v, w, z);
@@ -1122,8 +1122,8 @@ ternary_op(PyObject *v,
         if (c != 0)
             goto error1;
 
-        if (v1->ob_type->tp_as_number != NULL) {
-            slotv = NB_TERNOP(v1->ob_type->tp_as_number,
+        if (Py_TYPE(v1)->tp_as_number != NULL) {
+            slotv = NB_TERNOP(Py_TYPE(v1)->tp_as_number,
                               op_slot);
             if (slotv)
                 x = slotv(v1, w2, z2);
@@ -1151,16 +1151,16 @@ ternary_op(PyObject *v,
             PyExc_TypeError,
             "unsupported operand type(s) for ** or pow(): "
             "'%.100s' and '%.100s'",
-            v->ob_type->tp_name,
-            w->ob_type->tp_name);
+            Py_TYPE(v)->tp_name,
+            Py_TYPE(w)->tp_name);
     else
         PyErr_Format(
             PyExc_TypeError,
             "unsupported operand type(s) for pow(): "
             "'%.100s', '%.100s', '%.100s'",
-            v->ob_type->tp_name,
-            w->ob_type->tp_name,
-            z->ob_type->tp_name);
+            Py_TYPE(v)->tp_name,
+            Py_TYPE(w)->tp_name,
+            Py_TYPE(z)->tp_name);
     return NULL;
 }
 
@@ -1184,7 +1184,7 @@ PyNumber_Add(PyObject *v, PyObject *w)
 {
     PyObject *result = binary_op1(v, w, NB_SLOT(nb_add));
     if (result == Py_NotImplemented) {
-        PySequenceMethods *m = v->ob_type->tp_as_sequence;
+        PySequenceMethods *m = Py_TYPE(v)->tp_as_sequence;
         Py_DECREF(result);
         if (m && m->sq_concat) {
             return (*m->sq_concat)(v, w);
@@ -1215,8 +1215,8 @@ PyNumber_Multiply(PyObject *v, PyObject *w)
 {
     PyObject *result = binary_op1(v, w, NB_SLOT(nb_multiply));
     if (result == Py_NotImplemented) {
-        PySequenceMethods *mv = v->ob_type->tp_as_sequence;
-        PySequenceMethods *mw = w->ob_type->tp_as_sequence;
+        PySequenceMethods *mv = Py_TYPE(v)->tp_as_sequence;
+        PySequenceMethods *mw = Py_TYPE(w)->tp_as_sequence;
         Py_DECREF(result);
         if  (mv && mv->sq_repeat) {
             return sequence_repeat(mv->sq_repeat, v, w);
@@ -1272,12 +1272,12 @@ PyNumber_Power(PyObject *v, PyObject *w, PyObject *z)
    */
 
 #define HASINPLACE(t) \
-    PyType_HasFeature((t)->ob_type, Py_TPFLAGS_HAVE_INPLACEOPS)
+    PyType_HasFeature(Py_TYPE((t)), Py_TPFLAGS_HAVE_INPLACEOPS)
 
 static PyObject *
 binary_iop1(PyObject *v, PyObject *w, const int iop_slot, const int op_slot)
 {
-    PyNumberMethods *mv = v->ob_type->tp_as_number;
+    PyNumberMethods *mv = Py_TYPE(v)->tp_as_number;
     if (mv != NULL && HASINPLACE(v)) {
         binaryfunc slot = NB_BINOP(mv, iop_slot);
         if (slot) {
@@ -1339,7 +1339,7 @@ PyNumber_InPlaceAdd(PyObject *v, PyObject *w)
     PyObject *result = binary_iop1(v, w, NB_SLOT(nb_inplace_add),
                                    NB_SLOT(nb_add));
     if (result == Py_NotImplemented) {
-        PySequenceMethods *m = v->ob_type->tp_as_sequence;
+        PySequenceMethods *m = Py_TYPE(v)->tp_as_sequence;
         Py_DECREF(result);
         if (m != NULL) {
             binaryfunc f = NULL;
@@ -1362,8 +1362,8 @@ PyNumber_InPlaceMultiply(PyObject *v, PyObject *w)
                                    NB_SLOT(nb_multiply));
     if (result == Py_NotImplemented) {
         ssizeargfunc f = NULL;
-        PySequenceMethods *mv = v->ob_type->tp_as_sequence;
-        PySequenceMethods *mw = w->ob_type->tp_as_sequence;
+        PySequenceMethods *mv = Py_TYPE(v)->tp_as_sequence;
+        PySequenceMethods *mw = Py_TYPE(w)->tp_as_sequence;
         Py_DECREF(result);
         if (mv != NULL) {
             if (HASINPLACE(v))
@@ -1395,8 +1395,8 @@ PyNumber_InPlaceRemainder(PyObject *v, PyObject *w)
 PyObject *
 PyNumber_InPlacePower(PyObject *v, PyObject *w, PyObject *z)
 {
-    if (HASINPLACE(v) && v->ob_type->tp_as_number &&
-        v->ob_type->tp_as_number->nb_inplace_power != NULL) {
+    if (HASINPLACE(v) && Py_TYPE(v)->tp_as_number &&
+        Py_TYPE(v)->tp_as_number->nb_inplace_power != NULL) {
         return ternary_op(v, w, z, NB_SLOT(nb_inplace_power), "**=");
     }
     else {
@@ -1414,7 +1414,7 @@ PyNumber_Negative(PyObject *o)
 
     if (o == NULL)
         return null_error();
-    m = o->ob_type->tp_as_number;
+    m = Py_TYPE(o)->tp_as_number;
     if (m && m->nb_negative)
         return (*m->nb_negative)(o);
 
@@ -1428,7 +1428,7 @@ PyNumber_Positive(PyObject *o)
 
     if (o == NULL)
         return null_error();
-    m = o->ob_type->tp_as_number;
+    m = Py_TYPE(o)->tp_as_number;
     if (m && m->nb_positive)
         return (*m->nb_positive)(o);
 
@@ -1442,7 +1442,7 @@ PyNumber_Invert(PyObject *o)
 
     if (o == NULL)
         return null_error();
-    m = o->ob_type->tp_as_number;
+    m = Py_TYPE(o)->tp_as_number;
     if (m && m->nb_invert)
         return (*m->nb_invert)(o);
 
@@ -1456,7 +1456,7 @@ PyNumber_Absolute(PyObject *o)
 
     if (o == NULL)
         return null_error();
-    m = o->ob_type->tp_as_number;
+    m = Py_TYPE(o)->tp_as_number;
     if (m && m->nb_absolute)
         return m->nb_absolute(o);
 
@@ -1497,13 +1497,13 @@ PyNumber_Index(PyObject *item)
         return item;
     }
     if (PyIndex_Check(item)) {
-        result = item->ob_type->tp_as_number->nb_index(item);
+        result = Py_TYPE(item)->tp_as_number->nb_index(item);
         if (result &&
             !PyInt_Check(result) && !PyLong_Check(result)) {
             PyErr_Format(PyExc_TypeError,
                          "__index__ returned non-(int,long) " \
                          "(type %.200s)",
-                         result->ob_type->tp_name);
+                         Py_TYPE(result)->tp_name);
             Py_DECREF(result);
             return NULL;
         }
@@ -1511,7 +1511,7 @@ PyNumber_Index(PyObject *item)
     else {
         PyErr_Format(PyExc_TypeError,
                      "'%.200s' object cannot be interpreted "
-                     "as an index", item->ob_type->tp_name);
+                     "as an index", Py_TYPE(item)->tp_name);
     }
     return result;
 }
@@ -1554,7 +1554,7 @@ PyNumber_AsSsize_t(PyObject *item, PyObject *err)
         /* Otherwise replace the error with caller's error object. */
         PyErr_Format(err,
                      "cannot fit '%.200s' into an index-sized integer",
-                     item->ob_type->tp_name);
+                     Py_TYPE(item)->tp_name);
     }
 
  finish:
@@ -1599,7 +1599,7 @@ non_integral_error:
                                        ->in_class->cl_name);
     }
     else {
-        type_name = integral->ob_type->tp_name;
+        type_name = Py_TYPE(integral)->tp_name;
     }
     PyErr_Format(PyExc_TypeError, error_format, type_name);
     Py_DECREF(integral);
@@ -1628,22 +1628,21 @@ PyNumber_Int(PyObject *o)
         Py_INCREF(o);
         return o;
     }
-    m = o->ob_type->tp_as_number;
+    m = Py_TYPE(o)->tp_as_number;
     if (m && m->nb_int) { /* This should include subclasses of int */
         /* Classic classes always take this branch. */
         PyObject *res = m->nb_int(o);
         if (res && (!PyInt_Check(res) && !PyLong_Check(res))) {
             PyErr_Format(PyExc_TypeError,
                          "__int__ returned non-int (type %.200s)",
-                         res->ob_type->tp_name);
+                         Py_TYPE(res)->tp_name);
             Py_DECREF(res);
             return NULL;
         }
         return res;
     }
     if (PyInt_Check(o)) { /* A int subclass without nb_int */
-        PyIntObject *io = (PyIntObject*)o;
-        return PyInt_FromLong(io->ob_ival);
+        return PyInt_FromLong(PyInt_AS_LONG(o));
     }
     trunc_func = PyObject_GetAttr(o, trunc_name);
     if (trunc_func) {
@@ -1709,7 +1708,7 @@ PyNumber_Long(PyObject *o)
 
     if (o == NULL)
         return null_error();
-    m = o->ob_type->tp_as_number;
+    m = Py_TYPE(o)->tp_as_number;
     if (m && m->nb_long) { /* This should include subclasses of long */
         /* Classic classes always take this branch. */
         PyObject *res = m->nb_long(o);
@@ -1723,7 +1722,7 @@ PyNumber_Long(PyObject *o)
         else if (!PyLong_Check(res)) {
             PyErr_Format(PyExc_TypeError,
                          "__long__ returned non-long (type %.200s)",
-                         res->ob_type->tp_name);
+                         Py_TYPE(res)->tp_name);
             Py_DECREF(res);
             return NULL;
         }
@@ -1779,13 +1778,13 @@ PyNumber_Float(PyObject *o)
 
     if (o == NULL)
         return null_error();
-    m = o->ob_type->tp_as_number;
+    m = Py_TYPE(o)->tp_as_number;
     if (m && m->nb_float) { /* This should include subclasses of float */
         PyObject *res = m->nb_float(o);
         if (res && !PyFloat_Check(res)) {
             PyErr_Format(PyExc_TypeError,
               "__float__ returned non-float (type %.200s)",
-              res->ob_type->tp_name);
+              Py_TYPE(res)->tp_name);
             Py_DECREF(res);
             return NULL;
         }
@@ -1832,8 +1831,8 @@ PySequence_Check(PyObject *s)
         return PyObject_HasAttrString(s, "__getitem__");
     if (PyDict_Check(s))
         return 0;
-    return  s->ob_type->tp_as_sequence &&
-        s->ob_type->tp_as_sequence->sq_item != NULL;
+    return  Py_TYPE(s)->tp_as_sequence &&
+        Py_TYPE(s)->tp_as_sequence->sq_item != NULL;
 }
 
 Py_ssize_t
@@ -1846,7 +1845,7 @@ PySequence_Size(PyObject *s)
         return -1;
     }
 
-    m = s->ob_type->tp_as_sequence;
+    m = Py_TYPE(s)->tp_as_sequence;
     if (m && m->sq_length)
         return m->sq_length(s);
 
@@ -1870,7 +1869,7 @@ PySequence_Concat(PyObject *s, PyObject *o)
     if (s == NULL || o == NULL)
         return null_error();
 
-    m = s->ob_type->tp_as_sequence;
+    m = Py_TYPE(s)->tp_as_sequence;
     if (m && m->sq_concat)
         return m->sq_concat(s, o);
 
@@ -1894,7 +1893,7 @@ PySequence_Repeat(PyObject *o, Py_ssize_t count)
     if (o == NULL)
         return null_error();
 
-    m = o->ob_type->tp_as_sequence;
+    m = Py_TYPE(o)->tp_as_sequence;
     if (m && m->sq_repeat)
         return m->sq_repeat(o, count);
 
@@ -1923,7 +1922,7 @@ PySequence_InPlaceConcat(PyObject *s, PyObject *o)
     if (s == NULL || o == NULL)
         return null_error();
 
-    m = s->ob_type->tp_as_sequence;
+    m = Py_TYPE(s)->tp_as_sequence;
     if (m && HASINPLACE(s) && m->sq_inplace_concat)
         return m->sq_inplace_concat(s, o);
     if (m && m->sq_concat)
@@ -1947,7 +1946,7 @@ PySequence_InPlaceRepeat(PyObject *o, Py_ssize_t count)
     if (o == NULL)
         return null_error();
 
-    m = o->ob_type->tp_as_sequence;
+    m = Py_TYPE(o)->tp_as_sequence;
     if (m && HASINPLACE(o) && m->sq_inplace_repeat)
         return m->sq_inplace_repeat(o, count);
     if (m && m->sq_repeat)
@@ -1976,7 +1975,7 @@ PySequence_GetItem(PyObject *s, Py_ssize_t i)
     if (s == NULL)
         return null_error();
 
-    m = s->ob_type->tp_as_sequence;
+    m = Py_TYPE(s)->tp_as_sequence;
     if (m && m->sq_item) {
         if (i < 0) {
             if (m->sq_length) {
@@ -2000,7 +1999,7 @@ PySequence_GetSlice(PyObject *s, Py_ssize_t i1, Py_ssize_t i2)
 
     if (!s) return null_error();
 
-    m = s->ob_type->tp_as_sequence;
+    m = Py_TYPE(s)->tp_as_sequence;
     if (m && m->sq_slice) {
         if (i1 < 0 || i2 < 0) {
             if (m->sq_length) {
@@ -2014,7 +2013,7 @@ PySequence_GetSlice(PyObject *s, Py_ssize_t i1, Py_ssize_t i2)
             }
         }
         return m->sq_slice(s, i1, i2);
-    } else if ((mp = s->ob_type->tp_as_mapping) && mp->mp_subscript) {
+    } else if ((mp = Py_TYPE(s)->tp_as_mapping) && mp->mp_subscript) {
         PyObject *res;
         PyObject *slice = _PySlice_FromIndices(i1, i2);
         if (!slice)
@@ -2037,7 +2036,7 @@ PySequence_SetItem(PyObject *s, Py_ssize_t i, PyObject *o)
         return -1;
     }
 
-    m = s->ob_type->tp_as_sequence;
+    m = Py_TYPE(s)->tp_as_sequence;
     if (m && m->sq_ass_item) {
         if (i < 0) {
             if (m->sq_length) {
@@ -2064,7 +2063,7 @@ PySequence_DelItem(PyObject *s, Py_ssize_t i)
         return -1;
     }
 
-    m = s->ob_type->tp_as_sequence;
+    m = Py_TYPE(s)->tp_as_sequence;
     if (m && m->sq_ass_item) {
         if (i < 0) {
             if (m->sq_length) {
@@ -2092,7 +2091,7 @@ PySequence_SetSlice(PyObject *s, Py_ssize_t i1, Py_ssize_t i2, PyObject *o)
         return -1;
     }
 
-    m = s->ob_type->tp_as_sequence;
+    m = Py_TYPE(s)->tp_as_sequence;
     if (m && m->sq_ass_slice) {
         if (i1 < 0 || i2 < 0) {
             if (m->sq_length) {
@@ -2106,7 +2105,7 @@ PySequence_SetSlice(PyObject *s, Py_ssize_t i1, Py_ssize_t i2, PyObject *o)
             }
         }
         return m->sq_ass_slice(s, i1, i2, o);
-    } else if ((mp = s->ob_type->tp_as_mapping) && mp->mp_ass_subscript) {
+    } else if ((mp = Py_TYPE(s)->tp_as_mapping) && mp->mp_ass_subscript) {
         int res;
         PyObject *slice = _PySlice_FromIndices(i1, i2);
         if (!slice)
@@ -2130,7 +2129,7 @@ PySequence_DelSlice(PyObject *s, Py_ssize_t i1, Py_ssize_t i2)
         return -1;
     }
 
-    m = s->ob_type->tp_as_sequence;
+    m = Py_TYPE(s)->tp_as_sequence;
     if (m && m->sq_ass_slice) {
         if (i1 < 0 || i2 < 0) {
             if (m->sq_length) {
@@ -2381,8 +2380,8 @@ int
 PySequence_Contains(PyObject *seq, PyObject *ob)
 {
     Py_ssize_t result;
-    if (PyType_HasFeature(seq->ob_type, Py_TPFLAGS_HAVE_SEQUENCE_IN)) {
-        PySequenceMethods *sqm = seq->ob_type->tp_as_sequence;
+    if (PyType_HasFeature(Py_TYPE(seq), Py_TPFLAGS_HAVE_SEQUENCE_IN)) {
+        PySequenceMethods *sqm = Py_TYPE(seq)->tp_as_sequence;
         if (sqm != NULL && sqm->sq_contains != NULL)
             return (*sqm->sq_contains)(seq, ob);
     }
@@ -2412,10 +2411,10 @@ PyMapping_Check(PyObject *o)
     if (o && PyInstance_Check(o))
         return PyObject_HasAttrString(o, "__getitem__");
 
-    return  o && o->ob_type->tp_as_mapping &&
-        o->ob_type->tp_as_mapping->mp_subscript &&
-        !(o->ob_type->tp_as_sequence &&
-          o->ob_type->tp_as_sequence->sq_slice);
+    return  o && Py_TYPE(o)->tp_as_mapping &&
+        Py_TYPE(o)->tp_as_mapping->mp_subscript &&
+        !(Py_TYPE(o)->tp_as_sequence &&
+          Py_TYPE(o)->tp_as_sequence->sq_slice);
 }
 
 Py_ssize_t
@@ -2428,7 +2427,7 @@ PyMapping_Size(PyObject *o)
         return -1;
     }
 
-    m = o->ob_type->tp_as_mapping;
+    m = Py_TYPE(o)->tp_as_mapping;
     if (m && m->mp_length)
         return m->mp_length(o);
 
@@ -2522,7 +2521,7 @@ PyObject_Call(PyObject *func, PyObject *arg, PyObject *kw)
 {
     ternaryfunc call;
 
-    if ((call = func->ob_type->tp_call) != NULL) {
+    if ((call = Py_TYPE(func)->tp_call) != NULL) {
         PyObject *result;
         if (Py_EnterRecursiveCall(" while calling a Python object"))
             return NULL;
@@ -2535,7 +2534,7 @@ PyObject_Call(PyObject *func, PyObject *arg, PyObject *kw)
         return result;
     }
     PyErr_Format(PyExc_TypeError, "'%.200s' object is not callable",
-                 func->ob_type->tp_name);
+                 Py_TYPE(func)->tp_name);
     return NULL;
 }
 
@@ -2894,7 +2893,7 @@ recursive_isinstance(PyObject *inst, PyObject *cls)
                 PyErr_Clear();
             }
             else {
-                if (c != (PyObject *)(inst->ob_type) &&
+                if (c != (PyObject *)(Py_TYPE(inst)) &&
                     PyType_Check(c))
                     retval = PyType_IsSubtype(
                         (PyTypeObject *)c,
@@ -3070,7 +3069,7 @@ _PyObject_RealIsSubclass(PyObject *derived, PyObject *cls)
 PyObject *
 PyObject_GetIter(PyObject *o)
 {
-    PyTypeObject *t = o->ob_type;
+    PyTypeObject *t = Py_TYPE(o);
     getiterfunc f = NULL;
     if (PyType_HasFeature(t, Py_TPFLAGS_HAVE_ITER))
         f = t->tp_iter;
@@ -3085,7 +3084,7 @@ PyObject_GetIter(PyObject *o)
             PyErr_Format(PyExc_TypeError,
                          "iter() returned non-iterator "
                          "of type '%.100s'",
-                         res->ob_type->tp_name);
+                         Py_TYPE(res)->tp_name);
             Py_DECREF(res);
             res = NULL;
         }
@@ -3103,8 +3102,13 @@ PyObject_GetIter(PyObject *o)
 PyObject *
 PyIter_Next(PyObject *iter)
 {
+    PyThreadState *tstate = PyThreadState_GET();
+    struct _frame *outer = tstate->iternext_frame;
     PyObject *result;
-    result = (*iter->ob_type->tp_iternext)(iter);
+
+    tstate->iternext_frame = tstate->frame;
+    result = (*Py_TYPE(iter)->tp_iternext)(iter);
+    tstate->iternext_frame = outer;
     if (result == NULL &&
         PyErr_Occurred() &&
         PyErr_ExceptionMatches(PyExc_StopIteration))
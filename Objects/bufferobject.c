@@ -34,7 +34,7 @@ get_buf(PyBufferObject *self, void **ptr, Py_ssize_t *size,
     else {
         Py_ssize_t count, offset;
         readbufferproc proc = 0;
-        PyBufferProcs *bp = self->b_base->ob_type->tp_as_buffer;
+        PyBufferProcs *bp = Py_TYPE(self->b_base)->tp_as_buffer;
         if ((*bp->bf_getsegcount)(self->b_base, NULL) != 1) {
             PyErr_SetString(PyExc_TypeError,
                 "single-segment buffer object expected");
@@ -47,7 +47,7 @@ get_buf(PyBufferObject *self, void **ptr, Py_ssize_t *size,
             (buffer_type == ANY_BUFFER))
             proc = (readbufferproc)bp->bf_getwritebuffer;
         else if (buffer_type == CHAR_BUFFER) {
-            if (!PyType_HasFeature(self->ob_type,
+            if (!PyType_HasFeature(Py_TYPE(self),
                         Py_TPFLAGS_HAVE_GETCHARBUFFER)) {
             PyErr_SetString(PyExc_TypeError,
                 "Py_TPFLAGS_HAVE_GETCHARBUFFER needed");
@@ -155,7 +155,7 @@ buffer_from_object(PyObject *base, Py_ssize_t size, Py_ssize_t offset, int reado
 PyObject *
 PyBuffer_FromObject(PyObject *base, Py_ssize_t offset, Py_ssize_t size)
 {
-    PyBufferProcs *pb = base->ob_type->tp_as_buffer;
+    PyBufferProcs *pb = Py_TYPE(base)->tp_as_buffer;
 
     if ( pb == NULL ||
          pb->bf_getreadbuffer == NULL ||
@@ -171,7 +171,7 @@ PyBuffer_FromObject(PyObject *base, Py_ssize_t offset, Py_ssize_t size)
 PyObject *
 PyBuffer_FromReadWriteObject(PyObject *base, Py_ssize_t offset, Py_ssize_t size)
 {
-    PyBufferProcs *pb = base->ob_type->tp_as_buffer;
+    PyBufferProcs *pb = Py_TYPE(base)->tp_as_buffer;
 
     if ( pb == NULL ||
          pb->bf_getwritebuffer == NULL ||
@@ -379,7 +379,7 @@ buffer_length(PyBufferObject *self)
 static PyObject *
 buffer_concat(PyBufferObject *self, PyObject *other)
 {
-    PyBufferProcs *pb = other->ob_type->tp_as_buffer;
+    PyBufferProcs *pb = Py_TYPE(other)->tp_as_buffer;
     void *ptr1, *ptr2;
     char *p;
     PyObject *ob;
@@ -572,7 +572,7 @@ buffer_ass_item(PyBufferObject *self, Py_ssize_t idx, PyObject *other)
         return -1;
     }
 
-    pb = other ? other->ob_type->tp_as_buffer : NULL;
+    pb = other ? Py_TYPE(other)->tp_as_buffer : NULL;
     if ( pb == NULL ||
          pb->bf_getreadbuffer == NULL ||
          pb->bf_getsegcount == NULL )
@@ -615,7 +615,7 @@ buffer_ass_slice(PyBufferObject *self, Py_ssize_t left, Py_ssize_t right, PyObje
         return -1;
     }
 
-    pb = other ? other->ob_type->tp_as_buffer : NULL;
+    pb = other ? Py_TYPE(other)->tp_as_buffer : NULL;
     if ( pb == NULL ||
          pb->bf_getreadbuffer == NULL ||
          pb->bf_getsegcount == NULL )
@@ -672,7 +672,7 @@ buffer_ass_subscript(PyBufferObject *self, PyObject *item, PyObject *value)
         return -1;
     }
 
-    pb = value ? value->ob_type->tp_as_buffer : NULL;
+    pb = value ? Py_TYPE(value)->tp_as_buffer : NULL;
     if ( pb == NULL ||
          pb->bf_getreadbuffer == NULL ||
          pb->bf_getsegcount == NULL )
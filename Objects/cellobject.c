@@ -76,7 +76,7 @@ cell_repr(PyCellObject *op)
         return PyString_FromFormat("<cell at %p: empty>", op);
 
     return PyString_FromFormat("<cell at %p: %.80s object at %p>",
-                               op, op->ob_ref->ob_type->tp_name,
+                               op, Py_TYPE(op->ob_ref)->tp_name,
                                op->ob_ref);
 }
 
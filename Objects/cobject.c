@@ -69,7 +69,7 @@ PyCObject_AsVoidPtr(PyObject *self)
             const char *name = PyCapsule_GetName(self);
             return (void *)PyCapsule_GetPointer(self, name);
         }
-        if (self->ob_type == &PyCObject_Type)
+        if (Py_TYPE(self) == &PyCObject_Type)
             return ((PyCObject *)self)->cobject;
         PyErr_SetString(PyExc_TypeError,
                         "PyCObject_AsVoidPtr with non-C-object");
@@ -84,7 +84,7 @@ void *
 PyCObject_GetDesc(PyObject *self)
 {
     if (self) {
-        if (self->ob_type == &PyCObject_Type)
+        if (Py_TYPE(self) == &PyCObject_Type)
             return ((PyCObject *)self)->desc;
         PyErr_SetString(PyExc_TypeError,
                         "PyCObject_GetDesc with non-C-object");
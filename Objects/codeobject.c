@@ -103,6 +103,7 @@ PyCode_New(int argcount, int nlocals, int stacksize, int flags,
         Py_INCREF(lnotab);
         co->co_lnotab = lnotab;
         co->co_zombieframe = NULL;
+        co->co_quickened = NULL;
         co->co_weakreflist = NULL;
     }
     return co;
@@ -200,7 +201,7 @@ validate_and_copy_tuple(PyObject *tup)
                 PyExc_TypeError,
                 "name tuples must contain only "
                 "strings, not '%.500s'",
-                item->ob_type->tp_name);
+                Py_TYPE(item)->tp_name);
             Py_DECREF(newtuple);
             return NULL;
         }
@@ -315,6 +316,8 @@ code_dealloc(PyCodeObject *co)
     Py_XDECREF(co->co_lnotab);
     if (co->co_zombieframe != NULL)
         PyObject_GC_Del(co->co_zombieframe);
+    if (co->co_quickened != NULL)
+        PyMem_FREE(co->co_quickened);
     if (co->co_weakreflist != NULL)
         PyObject_ClearWeakRefs((PyObject*)co);
     PyObject_DEL(co);
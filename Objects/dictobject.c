@@ -135,16 +135,248 @@ practice, this probably won't make a lick of difference for many years (at
 which point everyone will have terabytes of RAM on 64-bit boxes).
 */
 
-/* Object used as dummy key to fill deleted entries */
-static PyObject *dummy = NULL; /* Initialized by first call to newPyDictObject() */
+/* The values of the slots of the indices that hold no entry */
+#define DKIX_EMPTY (-1)
+#define DKIX_DUMMY (-2)
 
-#ifdef Py_REF_DEBUG
-PyObject *
-_PyDict_Dummy(void)
+/* The number of entries that a table of n slots has room for:  the load of
+   the indices is kept under 2/3.
+*/
+#define USABLE_FRACTION(n) (((n) << 1) / 3)
+
+/* The indices shared by all the empty dicts:  a dict has no entries until
+   the first key is inserted.
+*/
+static signed char empty_indices[PyDict_MINSIZE] = {
+    DKIX_EMPTY, DKIX_EMPTY, DKIX_EMPTY, DKIX_EMPTY,
+    DKIX_EMPTY, DKIX_EMPTY, DKIX_EMPTY, DKIX_EMPTY
+};
+
+/* The number of entries the tables of mp have room for */
+#define DICT_USABLE(mp) \
+    ((mp)->ma_indices == (void *)empty_indices ? 0 : \
+     USABLE_FRACTION((mp)->ma_mask + 1))
+
+/* What the lookup functions return for a key that is not in the dict */
+static PyDictEntry missing_entry = {0, NULL, NULL};
+
+/* The width of the indices of a table of `size` slots:  the narrowest
+   integer type that can hold the index of any of its entries.
+*/
+static size_t
+index_width(Py_ssize_t size)
+{
+    if (size <= 0x80)
+        return sizeof(signed char);
+    if (size <= 0x8000)
+        return sizeof(short);
+#if SIZEOF_SIZE_T > SIZEOF_INT
+    if (size <= (Py_ssize_t)INT_MAX + 1)
+        return sizeof(int);
+#endif
+    return sizeof(Py_ssize_t);
+}
+
+/* Return the index held by slot i of the indices of mp */
+Py_LOCAL_INLINE(Py_ssize_t)
+get_index(PyDictObject *mp, size_t i)
 {
-    return dummy;
+    Py_ssize_t size = mp->ma_mask + 1;
+
+    if (size <= 0x80)
+        return ((signed char *)mp->ma_indices)[i];
+    if (size <= 0x8000)
+        return ((short *)mp->ma_indices)[i];
+#if SIZEOF_SIZE_T > SIZEOF_INT
+    if (size <= (Py_ssize_t)INT_MAX + 1)
+        return ((int *)mp->ma_indices)[i];
+#endif
+    return ((Py_ssize_t *)mp->ma_indices)[i];
 }
+
+/* Store ix in slot i of the indices of mp */
+Py_LOCAL_INLINE(void)
+set_index(PyDictObject *mp, size_t i, Py_ssize_t ix)
+{
+    Py_ssize_t size = mp->ma_mask + 1;
+
+    if (size <= 0x80)
+        ((signed char *)mp->ma_indices)[i] = (signed char)ix;
+    else if (size <= 0x8000)
+        ((short *)mp->ma_indices)[i] = (short)ix;
+#if SIZEOF_SIZE_T > SIZEOF_INT
+    else if (size <= (Py_ssize_t)INT_MAX + 1)
+        ((int *)mp->ma_indices)[i] = (int)ix;
+#endif
+    else
+        ((Py_ssize_t *)mp->ma_indices)[i] = ix;
+}
+
+/* The size in bytes of the block holding the tables of `size` slots */
+#define TABLES_SIZE(size) \
+    ((size) * index_width(size) + USABLE_FRACTION(size) * sizeof(PyDictEntry))
+
+/* The smallest tables are reused, to save calls to malloc and free.  The
+   free blocks are linked via their first word, and bounded in number like
+   the free dicts. */
+#ifndef PyDict_MAXFREELIST
+#define PyDict_MAXFREELIST 80
 #endif
+static void *tables_free_list = NULL;
+static Py_ssize_t numfreetables = 0;
+
+_PyFreeList _PyDict_FreeList = {"dict", PyDict_MAXFREELIST, 0, 0, 0};
+
+/* Allocate the block holding the tables of `size` slots, with all the
+   indices empty.  Return NULL, with an exception set, on failure.
+*/
+static void *
+new_tables(Py_ssize_t size)
+{
+    void *indices;
+
+    if (size == PyDict_MINSIZE && tables_free_list != NULL) {
+        indices = tables_free_list;
+        tables_free_list = *(void **)indices;
+        numfreetables--;
+    }
+    else {
+        if ((size_t)size > PY_SSIZE_T_MAX / (sizeof(Py_ssize_t) +
+                                             sizeof(PyDictEntry))) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+        indices = PyObject_MALLOC(TABLES_SIZE(size));
+        if (indices == NULL) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+    }
+    /* DKIX_EMPTY is -1, whatever the width of the indices */
+    memset(indices, 0xff, size * index_width(size));
+    return indices;
+}
+
+static void
+free_tables(void *indices, Py_ssize_t size)
+{
+    if (indices == (void *)empty_indices)
+        return;
+    if (size == PyDict_MINSIZE &&
+        numfreetables < _PyDict_FreeList.maxfree) {
+        *(void **)indices = tables_free_list;
+        tables_free_list = indices;
+        numfreetables++;
+    }
+    else
+        PyObject_FREE(indices);
+}
+
+/* The keys shared by the split dicts of the instances of a class.  This
+   header is followed, in the same block, by indices and entries laid out as
+   the tables of a dict, whose me_value is unused.  Keys are appended to the
+   tables as instances get new attributes, but never deleted, so the tables
+   are never resized.
+*/
+struct _dictkeysobject {
+    Py_ssize_t dk_refcnt;
+    Py_ssize_t dk_size;
+    Py_ssize_t dk_nentries;
+};
+
+#define DK_INDICES(dk) ((void *)((dk) + 1))
+#define DK_ENTRIES(dk) \
+    ((PyDictEntry *)((char *)DK_INDICES(dk) + \
+                     (dk)->dk_size * index_width((dk)->dk_size)))
+
+/* The shared keys of the split dict mp */
+#define DICT_KEYS(mp) ((PyDictKeysObject *)(mp)->ma_indices - 1)
+
+/* The shared keys of the instance dicts of tp, or NULL */
+#define CACHED_KEYS(tp) \
+    (PyType_HasFeature((tp), Py_TPFLAGS_HEAPTYPE) ? \
+     ((PyHeapTypeObject *)(tp))->ht_cached_keys : NULL)
+
+/* The value of entry i of mp */
+#define ENTRY_VALUE(mp, i) \
+    ((mp)->ma_values != NULL ? (mp)->ma_values[i] : (mp)->ma_table[i].me_value)
+
+/* The address of the value of ep, an entry returned by a lookup in mp */
+Py_LOCAL_INLINE(PyObject **)
+value_addr(PyDictObject *mp, PyDictEntry *ep)
+{
+    if (mp->ma_values == NULL || ep == &missing_entry)
+        return &ep->me_value;
+    return &mp->ma_values[ep - mp->ma_table];
+}
+
+static PyDictKeysObject *
+new_keys_object(Py_ssize_t size)
+{
+    PyDictKeysObject *keys;
+
+    assert(size >= PyDict_MINSIZE);
+    if ((size_t)size > (PY_SSIZE_T_MAX - sizeof(PyDictKeysObject)) /
+                       (sizeof(Py_ssize_t) + sizeof(PyDictEntry))) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    keys = PyObject_MALLOC(sizeof(PyDictKeysObject) + TABLES_SIZE(size));
+    if (keys == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    keys->dk_refcnt = 1;
+    keys->dk_size = size;
+    keys->dk_nentries = 0;
+    memset(DK_INDICES(keys), 0xff, size * index_width(size));
+    return keys;
+}
+
+PyDictKeysObject *
+_PyDict_NewKeysForClass(void)
+{
+    return new_keys_object(PyDict_MINSIZE);
+}
+
+void
+_PyDictKeys_DecRef(PyDictKeysObject *keys)
+{
+    PyDictEntry *ep;
+    Py_ssize_t n;
+
+    assert(keys->dk_refcnt > 0);
+    if (--keys->dk_refcnt > 0)
+        return;
+    ep = DK_ENTRIES(keys);
+    for (n = keys->dk_nentries; n > 0; ep++, n--)
+        Py_DECREF(ep->me_key);
+    PyObject_FREE(keys);
+}
+
+/* Make mp, an empty dict, split over keys, with room for as many values as
+   keys can hold.
+*/
+static int
+share_keys(PyDictObject *mp, PyDictKeysObject *keys)
+{
+    size_t usable = USABLE_FRACTION(keys->dk_size);
+    PyObject **values;
+
+    assert(mp->ma_used == 0 && mp->ma_indices == (void *)empty_indices);
+    values = PyObject_MALLOC(usable * sizeof(PyObject *));
+    if (values == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    memset(values, 0, usable * sizeof(PyObject *));
+    keys->dk_refcnt++;
+    mp->ma_indices = DK_INDICES(keys);
+    mp->ma_table = DK_ENTRIES(keys);
+    mp->ma_mask = keys->dk_size - 1;
+    mp->ma_values = values;
+    return 0;
+}
 
 /* forward declarations */
 static PyDictEntry *
@@ -199,53 +431,55 @@ show_track(void)
 #endif
 
 
-/* Initialization macros.
+/* Initialization macro.
    There are two ways to create a dict:  PyDict_New() is the main C API
-   function, and the tp_new slot maps to dict_new().  In the latter case we
-   can save a little time over what PyDict_New does because it's guaranteed
-   that the PyDictObject struct is already zeroed out.
-   Everyone except dict_new() should use EMPTY_TO_MINSIZE (unless they have
-   an excellent reason not to).
+   function, and the tp_new slot maps to dict_new().  Both start with the
+   shared empty tables, which EMPTY_TO_MINSIZE sets without freeing the
+   current ones.
 */
 
-#define INIT_NONZERO_DICT_SLOTS(mp) do {                                \
-    (mp)->ma_table = (mp)->ma_smalltable;                               \
+#define EMPTY_TO_MINSIZE(mp) do {                                       \
+    (mp)->ma_indices = (void *)empty_indices;                           \
+    (mp)->ma_table = NULL;                                              \
+    (mp)->ma_values = NULL;                                             \
     (mp)->ma_mask = PyDict_MINSIZE - 1;                                 \
+    (mp)->ma_used = (mp)->ma_fill = (mp)->ma_nentries = 0;              \
     } while(0)
 
-#define EMPTY_TO_MINSIZE(mp) do {                                       \
-    memset((mp)->ma_smalltable, 0, sizeof((mp)->ma_smalltable));        \
-    (mp)->ma_used = (mp)->ma_fill = 0;                                  \
-    INIT_NONZERO_DICT_SLOTS(mp);                                        \
-    } while(0)
-
-/* Dictionary reuse scheme to save calls to malloc, free, and memset */
-#ifndef PyDict_MAXFREELIST
-#define PyDict_MAXFREELIST 80
-#endif
-static PyDictObject *free_list[PyDict_MAXFREELIST];
-static int numfree = 0;
+/* Dictionary reuse scheme to save calls to malloc and free.  The free
+   dicts are linked via their ma_indices members. */
+static PyDictObject *free_list = NULL;
 
 void
 PyDict_Fini(void)
 {
     PyDictObject *op;
+    void *indices;
 
-    while (numfree) {
-        op = free_list[--numfree];
+    while (free_list != NULL) {
+        op = free_list;
+        free_list = (PyDictObject *)op->ma_indices;
         assert(PyDict_CheckExact(op));
         PyObject_GC_Del(op);
     }
+    _PyDict_FreeList.numfree = 0;
+    while (tables_free_list != NULL) {
+        indices = tables_free_list;
+        tables_free_list = *(void **)indices;
+        PyObject_FREE(indices);
+    }
+    numfreetables = 0;
 }
 
 PyObject *
 PyDict_New(void)
 {
     register PyDictObject *mp;
-    if (dummy == NULL) { /* Auto-initialize dummy */
-        dummy = PyString_FromString("<dummy key>");
-        if (dummy == NULL)
-            return NULL;
+#if defined(SHOW_CONVERSION_COUNTS) || defined(SHOW_ALLOC_COUNT) || \
+    defined(SHOW_TRACK_COUNT)
+    static int initialized = 0;
+    if (!initialized) {
+        initialized = 1;
 #ifdef SHOW_CONVERSION_COUNTS
         Py_AtExit(show_counts);
 #endif
@@ -256,21 +490,14 @@ PyDict_New(void)
         Py_AtExit(show_track);
 #endif
     }
-    if (numfree) {
-        mp = free_list[--numfree];
-        assert (mp != NULL);
+#endif
+    if (free_list != NULL) {
+        mp = free_list;
+        free_list = (PyDictObject *)mp->ma_indices;
+        _PyDict_FreeList.numfree--;
+        _PyFreeList_HIT(_PyDict_FreeList);
         assert (Py_TYPE(mp) == &PyDict_Type);
         _Py_NewReference((PyObject *)mp);
-        if (mp->ma_fill) {
-            EMPTY_TO_MINSIZE(mp);
-        } else {
-            /* At least set ma_table and ma_mask; these are wrong
-               if an empty but presized dict is added to freelist */
-            INIT_NONZERO_DICT_SLOTS(mp);
-        }
-        assert (mp->ma_used == 0);
-        assert (mp->ma_table == mp->ma_smalltable);
-        assert (mp->ma_mask == PyDict_MINSIZE - 1);
 #ifdef SHOW_ALLOC_COUNT
         count_reuse++;
 #endif
@@ -278,11 +505,12 @@ PyDict_New(void)
         mp = PyObject_GC_New(PyDictObject, &PyDict_Type);
         if (mp == NULL)
             return NULL;
-        EMPTY_TO_MINSIZE(mp);
+        _PyFreeList_MISS(_PyDict_FreeList);
 #ifdef SHOW_ALLOC_COUNT
         count_alloc++;
 #endif
     }
+    EMPTY_TO_MINSIZE(mp);
     mp->ma_lookup = lookdict_string;
 #ifdef _SYMBEX_DICT_HASHES
     mp->ma_flat = 0;
@@ -303,7 +531,8 @@ Open addressing is preferred over chaining since the link overhead for
 chaining would be substantial (100% with typical malloc overhead).
 
 The initial probe index is computed as hash mod the table size. Subsequent
-probe indices are computed as explained earlier.
+probe indices are computed as explained earlier.  The probe sequence visits
+the slots of the indices; the slots that hold an entry lead to its key.
 
 All arithmetic on hash should ignore overflow.
 
@@ -316,84 +545,58 @@ comparison raises an exception (this was new in Python 2.5).
 lookdict_string() below is specialized to string keys, comparison of which can
 never raise an exception; that function can never return NULL.  For both, when
 the key isn't found a PyDictEntry* is returned for which the me_value field is
-NULL; this is the slot in the dict at which the key would have been found, and
-the caller can (if it wishes) add the <key, value> pair to the returned
-PyDictEntry*.
+NULL; it is not part of the dict, and the caller must insert the key with
+insertdict_clean() instead.  The entries of a split dict are those of its
+shared keys, and value_addr() gives the address of their values.
 */
 static PyDictEntry *
 lookdict(PyDictObject *mp, PyObject *key, register long hash)
 {
     register size_t i;
     register size_t perturb;
-    register PyDictEntry *freeslot;
-    register size_t mask = (size_t)mp->ma_mask;
-    PyDictEntry *ep0 = mp->ma_table;
+    register size_t mask;
+    PyDictEntry *ep0;
     register PyDictEntry *ep;
+    register Py_ssize_t ix;
     register int cmp;
     PyObject *startkey;
 
+  top:
+    mask = (size_t)mp->ma_mask;
+    ep0 = mp->ma_table;
     i = (size_t)hash & mask;
-    ep = &ep0[i];
-    if (ep->me_key == NULL || ep->me_key == key)
-        return ep;
-
-    if (ep->me_key == dummy)
-        freeslot = ep;
-    else {
-        if (ep->me_hash == hash) {
-            startkey = ep->me_key;
-            Py_INCREF(startkey);
-            cmp = PyObject_RichCompareBool(startkey, key, Py_EQ);
-            Py_DECREF(startkey);
-            if (cmp < 0)
-                return NULL;
-            if (ep0 == mp->ma_table && ep->me_key == startkey) {
-                if (cmp > 0)
-                    return ep;
-            }
-            else {
-                /* The compare did major nasty stuff to the
-                 * dict:  start over.
-                 * XXX A clever adversary could prevent this
-                 * XXX from terminating.
-                 */
-                return lookdict(mp, key, hash);
-            }
-        }
-        freeslot = NULL;
-    }
-
-    /* In the loop, me_key == dummy is by far (factor of 100s) the
-       least likely outcome, so test for that last. */
     for (perturb = hash; ; perturb >>= PERTURB_SHIFT) {
-        i = (i << 2) + i + perturb + 1;
-        ep = &ep0[i & mask];
-        if (ep->me_key == NULL)
-            return freeslot == NULL ? ep : freeslot;
-        if (ep->me_key == key)
-            return ep;
-        if (ep->me_hash == hash && ep->me_key != dummy) {
-            startkey = ep->me_key;
-            Py_INCREF(startkey);
-            cmp = PyObject_RichCompareBool(startkey, key, Py_EQ);
-            Py_DECREF(startkey);
-            if (cmp < 0)
-                return NULL;
-            if (ep0 == mp->ma_table && ep->me_key == startkey) {
-                if (cmp > 0)
-                    return ep;
-            }
-            else {
-                /* The compare did major nasty stuff to the
-                 * dict:  start over.
-                 * XXX A clever adversary could prevent this
-                 * XXX from terminating.
-                 */
-                return lookdict(mp, key, hash);
+        ix = get_index(mp, i);
+        if (ix == DKIX_EMPTY)
+            return &missing_entry;
+        /* Dummy slots are by far (factor of 100s) the least likely
+           outcome, so test for them last. */
+        if (ix >= 0) {
+            ep = &ep0[ix];
+            if (ep->me_key == key)
+                return ep;
+            if (ep->me_hash == hash) {
+                startkey = ep->me_key;
+                Py_INCREF(startkey);
+                cmp = PyObject_RichCompareBool(startkey, key, Py_EQ);
+                Py_DECREF(startkey);
+                if (cmp < 0)
+                    return NULL;
+                if (ep0 == mp->ma_table && ep->me_key == startkey) {
+                    if (cmp > 0)
+                        return ep;
+                }
+                else {
+                    /* The compare did major nasty stuff to the
+                     * dict:  start over.
+                     * XXX A clever adversary could prevent this
+                     * XXX from terminating.
+                     */
+                    goto top;
+                }
             }
         }
-        else if (ep->me_key == dummy && freeslot == NULL)
-            freeslot = ep;
+        i = ((i << 2) + i + perturb + 1) & mask;
     }
     assert(0);          /* NOT REACHED */
     return 0;
@@ -413,10 +616,10 @@ lookdict_string(PyDictObject *mp, PyObject *key, register long hash)
 {
     register size_t i;
     register size_t perturb;
-    register PyDictEntry *freeslot;
     register size_t mask = (size_t)mp->ma_mask;
     PyDictEntry *ep0 = mp->ma_table;
     register PyDictEntry *ep;
+    register Py_ssize_t ix;
 
     /* Make sure this function doesn't have to handle non-string keys,
        including subclasses of str; e.g., one reason to subclass
@@ -430,36 +633,57 @@ lookdict_string(PyDictObject *mp, PyObject *key, register long hash)
         return lookdict(mp, key, hash);
     }
     i = hash & mask;
-    ep = &ep0[i];
-    if (ep->me_key == NULL || ep->me_key == key)
-        return ep;
-    if (ep->me_key == dummy)
-        freeslot = ep;
-    else {
-        if (ep->me_hash == hash && _PyString_Eq(ep->me_key, key))
-            return ep;
-        freeslot = NULL;
-    }
-
-    /* In the loop, me_key == dummy is by far (factor of 100s) the
-       least likely outcome, so test for that last. */
     for (perturb = hash; ; perturb >>= PERTURB_SHIFT) {
-        i = (i << 2) + i + perturb + 1;
-        ep = &ep0[i & mask];
-        if (ep->me_key == NULL)
-            return freeslot == NULL ? ep : freeslot;
-        if (ep->me_key == key
-            || (ep->me_hash == hash
-            && ep->me_key != dummy
-            && _PyString_Eq(ep->me_key, key)))
-            return ep;
-        if (ep->me_key == dummy && freeslot == NULL)
-            freeslot = ep;
+        ix = get_index(mp, i);
+        if (ix == DKIX_EMPTY)
+            return &missing_entry;
+        if (ix >= 0) {
+            ep = &ep0[ix];
+            if (ep->me_key == key
+                || (ep->me_hash == hash && _PyString_Eq(ep->me_key, key)))
+                return ep;
+        }
+        i = ((i << 2) + i + perturb + 1) & mask;
     }
     assert(0);          /* NOT REACHED */
     return 0;
 }
 
+/* Return the first empty slot of the indices in the probe sequence of
+   hash, where a key known to be absent can be inserted.
+*/
+static size_t
+find_empty_slot(PyDictObject *mp, long hash)
+{
+    register size_t i;
+    register size_t perturb;
+    register size_t mask = (size_t)mp->ma_mask;
+
+    i = (size_t)hash & mask;
+    for (perturb = hash; get_index(mp, i) != DKIX_EMPTY;
+         perturb >>= PERTURB_SHIFT)
+        i = ((i << 2) + i + perturb + 1) & mask;
+    return i;
+}
+
+/* Return the slot of the indices that holds ix, the index of an entry whose
+   hash is hash.
+*/
+static size_t
+find_index_slot(PyDictObject *mp, long hash, Py_ssize_t ix)
+{
+    register size_t i;
+    register size_t perturb;
+    register size_t mask = (size_t)mp->ma_mask;
+
+    i = (size_t)hash & mask;
+    for (perturb = hash; get_index(mp, i) != ix; perturb >>= PERTURB_SHIFT) {
+        assert(get_index(mp, i) != DKIX_EMPTY);
+        i = ((i << 2) + i + perturb + 1) & mask;
+    }
+    return i;
+}
+
 #ifdef SHOW_TRACK_COUNT
 #define INCREASE_TRACK_COUNT \
     (count_tracked++, count_untracked--);
@@ -486,7 +710,7 @@ _PyDict_MaybeUntrack(PyObject *op)
 {
     PyDictObject *mp;
     PyObject *value;
-    Py_ssize_t mask, i;
+    Py_ssize_t n, i;
     PyDictEntry *ep;
 
     if (!PyDict_CheckExact(op) || !_PyObject_GC_IS_TRACKED(op))
@@ -494,9 +718,9 @@ _PyDict_MaybeUntrack(PyObject *op)
 
     mp = (PyDictObject *) op;
     ep = mp->ma_table;
-    mask = mp->ma_mask;
-    for (i = 0; i <= mask; i++) {
-        if ((value = ep[i].me_value) == NULL)
+    n = mp->ma_nentries;
+    for (i = 0; i < n; i++) {
+        if ((value = ENTRY_VALUE(mp, i)) == NULL)
             continue;
         if (_PyObject_GC_MAY_BE_TRACKED(value) ||
             _PyObject_GC_MAY_BE_TRACKED(ep[i].me_key))
@@ -506,10 +730,76 @@ _PyDict_MaybeUntrack(PyObject *op)
     _PyObject_GC_UNTRACK(op);
 }
 
+static int dictresize(PyDictObject *mp, Py_ssize_t minused);
+
+/*
+Internal routine used to insert an item which is known to be absent from
+the dict, when there is room for it:  the entry is appended to the table, and
+its index is stored in the first empty slot of its probe sequence.
+Note that no refcounts are changed by this routine; if needed, the caller
+is responsible for incref'ing `key` and `value`.
+*/
+static void
+insertdict_clean(register PyDictObject *mp, PyObject *key, long hash,
+                 PyObject *value)
+{
+    register PyDictEntry *ep;
+
+    assert(mp->ma_fill < DICT_USABLE(mp));
+    MAINTAIN_TRACKING(mp, key, value);
+    set_index(mp, find_empty_slot(mp, hash), mp->ma_nentries);
+    ep = &mp->ma_table[mp->ma_nentries];
+    ep->me_key = key;
+    ep->me_hash = (Py_ssize_t)hash;
+    ep->me_value = value;
+    mp->ma_nentries++;
+    mp->ma_fill++;
+    mp->ma_used++;
+}
+
+/*
+Internal routine to insert an item that is not in mp, a split dict, whose
+lookup returned ep.  The values of a split dict must stay in the order of
+the shared keys, so the key must be the next of the shared keys, or a new
+string key to append to them when mp has all the others.  Returns 0, after
+eating the references to key and value, if it could insert the item, else
+-1, without setting an exception.
+*/
+static int
+insertdict_split(PyDictObject *mp, PyDictEntry *ep, PyObject *key, long hash,
+                 PyObject *value)
+{
+    PyDictKeysObject *keys = DICT_KEYS(mp);
+    Py_ssize_t ix = mp->ma_used;
+
+    if (ep == &missing_entry) {
+        if (keys->dk_nentries != ix ||
+            ix >= USABLE_FRACTION(keys->dk_size) ||
+            !PyString_CheckExact(key))
+            return -1;
+        /* The keys take the reference to key */
+        set_index(mp, find_empty_slot(mp, hash), ix);
+        ep = &mp->ma_table[ix];
+        ep->me_key = key;
+        ep->me_hash = (Py_ssize_t)hash;
+        ep->me_value = NULL;
+        keys->dk_nentries++;
+    }
+    else if (ep - mp->ma_table == ix)
+        Py_DECREF(key);
+    else
+        return -1;
+    MAINTAIN_TRACKING(mp, ep->me_key, value);
+    mp->ma_values[ix] = value;
+    mp->ma_nentries++;
+    mp->ma_fill++;
+    mp->ma_used++;
+    return 0;
+}
 
 /*
 Internal routine to insert a new item into the table.
-Used both by the internal resize routine and by the public insert routine.
+Used by the public insert routine and by the merges.
 Eats a reference to key and one to value.
 Returns -1 if an error occurred, or 0 on success.
 */
@@ -517,8 +807,9 @@ static int
 insertdict(register PyDictObject *mp, PyObject *key, long hash, PyObject *value)
 {
     PyObject *old_value;
+    PyObject **value_ptr;
     register PyDictEntry *ep;
-    typedef PyDictEntry *(*lookupfunc)(PyDictObject *, PyObject *, long);
+    Py_ssize_t n_used;
 
     assert(mp->ma_lookup != NULL);
     ep = mp->ma_lookup(mp, key, hash);
@@ -527,74 +818,65 @@ insertdict(register PyDictObject *mp, PyObject *key, long hash, PyObject *value)
         Py_DECREF(value);
         return -1;
     }
-    MAINTAIN_TRACKING(mp, key, value);
-    if (ep->me_value != NULL) {
-        old_value = ep->me_value;
-        ep->me_value = value;
+    value_ptr = value_addr(mp, ep);
+    if (*value_ptr != NULL) {
+        MAINTAIN_TRACKING(mp, key, value);
+        old_value = *value_ptr;
+        *value_ptr = value;
         Py_DECREF(old_value); /* which **CAN** re-enter */
         Py_DECREF(key);
+        return 0;
     }
-    else {
-        if (ep->me_key == NULL)
-            mp->ma_fill++;
-        else {
-            assert(ep->me_key == dummy);
-            Py_DECREF(dummy);
+    if (mp->ma_values != NULL) {
+        if (insertdict_split(mp, ep, key, hash, value) == 0)
+            return 0;
+        /* The dict no longer follows the shared keys:  give it tables of
+         * its own, which must grow as if the shared ones were full.
+         */
+        n_used = mp->ma_used + 1;
+        if (dictresize(mp, (n_used > 50000 ? 2 : 4) * n_used) != 0) {
+            Py_DECREF(key);
+            Py_DECREF(value);
+            return -1;
         }
-        ep->me_key = key;
-        ep->me_hash = (Py_ssize_t)hash;
-        ep->me_value = value;
-        mp->ma_used++;
     }
-    return 0;
-}
-
-/*
-Internal routine used by dictresize() to insert an item which is
-known to be absent from the dict.  This routine also assumes that
-the dict contains no deleted entries.  Besides the performance benefit,
-using insertdict() in dictresize() is dangerous (SF bug #1456209).
-Note that no refcounts are changed by this routine; if needed, the caller
-is responsible for incref'ing `key` and `value`.
-*/
-static void
-insertdict_clean(register PyDictObject *mp, PyObject *key, long hash,
-                 PyObject *value)
-{
-    register size_t i;
-    register size_t perturb;
-    register size_t mask = (size_t)mp->ma_mask;
-    PyDictEntry *ep0 = mp->ma_table;
-    register PyDictEntry *ep;
-
-    MAINTAIN_TRACKING(mp, key, value);
-    i = hash & mask;
-    ep = &ep0[i];
-    for (perturb = hash; ep->me_key != NULL; perturb >>= PERTURB_SHIFT) {
-        i = (i << 2) + i + perturb + 1;
-        ep = &ep0[i & mask];
+    /* If the tables are full, resize them before adding the key.
+     * Normally, this doubles or quadruples their size, but it's also
+     * possible for them to shrink (if ma_fill is much larger than
+     * ma_used, meaning a lot of dict keys have been deleted).
+     *
+     * Quadrupling the size improves average dictionary sparseness
+     * (reducing collisions) at the cost of some memory.  It also halves
+     * the number of expensive resize operations in a growing dictionary.
+     *
+     * Very large dictionaries (over 50K items) use doubling instead.
+     * This may help applications with severe memory constraints.
+     */
+    if (mp->ma_fill >= DICT_USABLE(mp)) {
+        n_used = mp->ma_used + 1;
+        if (dictresize(mp, (n_used > 50000 ? 2 : 4) * n_used) != 0) {
+            Py_DECREF(key);
+            Py_DECREF(value);
+            return -1;
+        }
     }
-    assert(ep->me_value == NULL);
-    mp->ma_fill++;
-    ep->me_key = key;
-    ep->me_hash = (Py_ssize_t)hash;
-    ep->me_value = value;
-    mp->ma_used++;
+    insertdict_clean(mp, key, hash, value);
+    return 0;
 }
 
 /*
-Restructure the table by allocating a new table and reinserting all
-items again.  When entries have been deleted, the new table may
-actually be smaller than the old one.
+Restructure the dict by allocating new tables and copying the live entries
+over, in order.  When entries have been deleted, the new tables may actually
+be smaller than the old ones.  A split dict gets tables of its own, and stops
+sharing its keys.
 */
 static int
 dictresize(PyDictObject *mp, Py_ssize_t minused)
 {
-    Py_ssize_t newsize;
-    PyDictEntry *oldtable, *newtable, *ep;
-    Py_ssize_t i;
-    int is_oldtable_malloced;
-    PyDictEntry small_copy[PyDict_MINSIZE];
+    Py_ssize_t newsize, oldsize, n, i, j;
+    void *oldindices, *newindices;
+    PyDictEntry *oldtable, *newtable;
+    PyObject **oldvalues;
 
     assert(minused >= 0);
 
@@ -607,75 +889,118 @@ dictresize(PyDictObject *mp, Py_ssize_t minused)
         PyErr_NoMemory();
         return -1;
     }
+    assert(USABLE_FRACTION(newsize) >= mp->ma_used);
+
+    /* Get space for the new tables. */
+    newindices = new_tables(newsize);
+    if (newindices == NULL)
+        return -1;
+    newtable = (PyDictEntry *)((char *)newindices +
+                               newsize * index_width(newsize));
 
-    /* Get space for a new table. */
+    /* Copy the live entries over; this is refcount-neutral */
+    oldindices = mp->ma_indices;
     oldtable = mp->ma_table;
-    assert(oldtable != NULL);
-    is_oldtable_malloced = oldtable != mp->ma_smalltable;
-
-    if (newsize == PyDict_MINSIZE) {
-        /* A large table is shrinking, or we can't get any smaller. */
-        newtable = mp->ma_smalltable;
-        if (newtable == oldtable) {
-            if (mp->ma_fill == mp->ma_used) {
-                /* No dummies, so no point doing anything. */
-                return 0;
-            }
-            /* We're not going to resize it, but rebuild the
-               table anyway to purge old dummy entries.
-               Subtle:  This is *necessary* if fill==size,
-               as lookdict needs at least one virgin slot to
-               terminate failing searches.  If fill < size, it's
-               merely desirable, as dummies slow searches. */
-            assert(mp->ma_fill > mp->ma_used);
-            memcpy(small_copy, oldtable, sizeof(small_copy));
-            oldtable = small_copy;
+    oldvalues = mp->ma_values;
+    oldsize = mp->ma_mask + 1;
+    n = mp->ma_nentries;
+    if (oldvalues != NULL) {
+        for (i = 0; i < n; i++) {
+            newtable[i].me_hash = oldtable[i].me_hash;
+            newtable[i].me_key = oldtable[i].me_key;
+            Py_INCREF(newtable[i].me_key);
+            newtable[i].me_value = oldvalues[i];
         }
     }
+    else if (n == mp->ma_used) {
+        if (n > 0)
+            memcpy(newtable, oldtable, n * sizeof(PyDictEntry));
+    }
     else {
-        newtable = PyMem_NEW(PyDictEntry, newsize);
-        if (newtable == NULL) {
-            PyErr_NoMemory();
-            return -1;
+        for (i = 0, j = 0; i < n; i++) {
+            if (oldtable[i].me_value != NULL)
+                newtable[j++] = oldtable[i];
         }
+        assert(j == mp->ma_used);
     }
 
-    /* Make the dict empty, using the new table. */
-    assert(newtable != oldtable);
+    /* Index them in the new tables */
+    mp->ma_indices = newindices;
     mp->ma_table = newtable;
+    mp->ma_values = NULL;
     mp->ma_mask = newsize - 1;
-    memset(newtable, 0, sizeof(PyDictEntry) * newsize);
-    mp->ma_used = 0;
-    i = mp->ma_fill;
-    mp->ma_fill = 0;
-
-    /* Copy the data over; this is refcount-neutral for active entries;
-       dummy entries aren't copied over, of course */
-    for (ep = oldtable; i > 0; ep++) {
-        if (ep->me_value != NULL) {             /* active entry */
-            --i;
+    mp->ma_nentries = mp->ma_fill = n = mp->ma_used;
+    for (i = 0; i < n; i++) {
 #ifdef _SYMBEX_DICT_HASHES
-            insertdict_clean(mp, ep->me_key,
-            		         mp->ma_flat ? _SYMBEX_HASH_VALUE : (long)ep->me_hash,
-            		         ep->me_value);
-#else
-            insertdict_clean(mp, ep->me_key, (long)ep->me_hash,
-                             ep->me_value);
+        if (mp->ma_flat)
+            newtable[i].me_hash = _SYMBEX_HASH_VALUE;
 #endif
-        }
-        else if (ep->me_key != NULL) {          /* dummy entry */
-            --i;
-            assert(ep->me_key == dummy);
-            Py_DECREF(ep->me_key);
-        }
-        /* else key == value == NULL:  nothing to do */
+        set_index(mp, find_empty_slot(mp, (long)newtable[i].me_hash), i);
     }
 
-    if (is_oldtable_malloced)
-        PyMem_DEL(oldtable);
+    if (oldvalues != NULL) {
+        PyObject_FREE(oldvalues);
+        _PyDictKeys_DecRef((PyDictKeysObject *)oldindices - 1);
+    }
+    else
+        free_tables(oldindices, oldsize);
     return 0;
 }
 
+/* Make mp, an empty dict, a copy of other, which has no deleted entries, by
+   copying its tables at once.
+*/
+static int
+clone_tables(PyDictObject *mp, PyDictObject *other)
+{
+    Py_ssize_t size = other->ma_mask + 1;
+    Py_ssize_t n = other->ma_nentries;
+    Py_ssize_t i;
+    void *indices;
+    PyDictEntry *ep;
+
+    assert(mp->ma_used == 0 && mp->ma_indices == (void *)empty_indices);
+    assert(other->ma_used == n && other->ma_values == NULL);
+    indices = new_tables(size);
+    if (indices == NULL)
+        return -1;
+    memcpy(indices, other->ma_indices, TABLES_SIZE(size));
+    ep = (PyDictEntry *)((char *)indices + size * index_width(size));
+    for (i = 0; i < n; i++) {
+        Py_INCREF(ep[i].me_key);
+        Py_INCREF(ep[i].me_value);
+    }
+    mp->ma_indices = indices;
+    mp->ma_table = ep;
+    mp->ma_mask = other->ma_mask;
+    mp->ma_nentries = mp->ma_fill = mp->ma_used = n;
+    mp->ma_lookup = other->ma_lookup;
+    if (_PyObject_GC_IS_TRACKED(other) && !_PyObject_GC_IS_TRACKED(mp)) {
+        _PyObject_GC_TRACK(mp);
+        INCREASE_TRACK_COUNT
+    }
+    return 0;
+}
+
+/* Remove the entry ep from mp, giving the references to its key and value
+   to *pkey and *pvalue.
+*/
+static void
+delete_entry(PyDictObject *mp, PyDictEntry *ep,
+             PyObject **pkey, PyObject **pvalue)
+{
+    Py_ssize_t ix = ep - mp->ma_table;
+
+    assert(mp->ma_values == NULL);
+    assert(ix >= 0 && ix < mp->ma_nentries && ep->me_value != NULL);
+    set_index(mp, find_index_slot(mp, (long)ep->me_hash, ix), DKIX_DUMMY);
+    *pkey = ep->me_key;
+    *pvalue = ep->me_value;
+    ep->me_key = NULL;
+    ep->me_value = NULL;
+    mp->ma_used--;
+}
+
 /* Create a new dictionary pre-sized to hold an estimated number of elements.
    Underestimates are okay because the dictionary will resize as necessary.
    Overestimates just mean the dictionary will be more sparse than usual.
@@ -686,7 +1011,8 @@ _PyDict_NewPresized(Py_ssize_t minused)
 {
     PyObject *op = PyDict_New();
 
-    if (minused>5 && op != NULL && dictresize((PyDictObject *)op, minused) == -1) {
+    if (minused>5 && op != NULL &&
+        dictresize((PyDictObject *)op, (minused * 3) / 2) == -1) {
         Py_DECREF(op);
         return NULL;
     }
@@ -759,7 +1085,7 @@ PyDict_GetItem(PyObject *op, PyObject *key)
             return NULL;
         }
     }
-    return ep->me_value;
+    return *value_addr(mp, ep);
 }
 
 /* CAUTION: PyDict_SetItem() must guarantee that it won't resize the
@@ -777,7 +1103,6 @@ PyDict_SetItem(register PyObject *op, PyObject *key, PyObject *value)
 #else
     register long hash;
 #endif
-    register Py_ssize_t n_used;
 
     if (!PyDict_Check(op)) {
         PyErr_BadInternalCall();
@@ -811,28 +1136,9 @@ PyDict_SetItem(register PyObject *op, PyObject *key, PyObject *value)
     }
 #endif
     assert(mp->ma_fill <= mp->ma_mask);  /* at least one empty slot */
-    n_used = mp->ma_used;
     Py_INCREF(value);
     Py_INCREF(key);
-    if (insertdict(mp, key, hash, value) != 0)
-        return -1;
-    /* If we added a key, we can safely resize.  Otherwise just return!
-     * If fill >= 2/3 size, adjust size.  Normally, this doubles or
-     * quaduples the size, but it's also possible for the dict to shrink
-     * (if ma_fill is much larger than ma_used, meaning a lot of dict
-     * keys have been * deleted).
-     *
-     * Quadrupling the size improves average dictionary sparseness
-     * (reducing collisions) at the cost of some memory and iteration
-     * speed (which loops over every possible entry).  It also halves
-     * the number of expensive resize operations in a growing dictionary.
-     *
-     * Very large dictionaries (over 50K items) use doubling instead.
-     * This may help applications with severe memory constraints.
-     */
-    if (!(mp->ma_used > n_used && mp->ma_fill*3 >= (mp->ma_mask+1)*2))
-        return 0;
-    return dictresize(mp, (mp->ma_used > 50000 ? 2 : 4) * mp->ma_used);
+    return insertdict(mp, key, hash, value);
 }
 
 int
@@ -876,16 +1182,19 @@ PyDict_DelItem(PyObject *op, PyObject *key)
     ep = (mp->ma_lookup)(mp, key, hash);
     if (ep == NULL)
         return -1;
-    if (ep->me_value == NULL) {
+    if (*value_addr(mp, ep) == NULL) {
         set_key_error(key);
         return -1;
     }
-    old_key = ep->me_key;
-    Py_INCREF(dummy);
-    ep->me_key = dummy;
-    old_value = ep->me_value;
-    ep->me_value = NULL;
-    mp->ma_used--;
+    if (mp->ma_values != NULL) {
+        /* Only dicts with keys of their own can delete them */
+        if (dictresize(mp, (mp->ma_used * 3) / 2) < 0)
+            return -1;
+        ep = (mp->ma_lookup)(mp, key, hash);
+        if (ep == NULL)
+            return -1;
+    }
+    delete_entry(mp, ep, &old_key, &old_value);
     Py_DECREF(old_value);
     Py_DECREF(old_key);
     return 0;
@@ -896,68 +1205,50 @@ PyDict_Clear(PyObject *op)
 {
     PyDictObject *mp;
     PyDictEntry *ep, *table;
-    int table_is_malloced;
-    Py_ssize_t fill;
-    PyDictEntry small_copy[PyDict_MINSIZE];
-#ifdef Py_DEBUG
-    Py_ssize_t i, n;
-#endif
+    PyObject **values;
+    void *indices;
+    Py_ssize_t n, size;
 
     if (!PyDict_Check(op))
         return;
     mp = (PyDictObject *)op;
-#ifdef Py_DEBUG
-    n = mp->ma_mask + 1;
-    i = 0;
-#endif
-
-    table = mp->ma_table;
-    assert(table != NULL);
-    table_is_malloced = table != mp->ma_smalltable;
 
     /* This is delicate.  During the process of clearing the dict,
      * decrefs can cause the dict to mutate.  To avoid fatal confusion
      * (voice of experience), we have to make the dict empty before
-     * clearing the slots, and never refer to anything via mp->xxx while
+     * clearing the entries, and never refer to anything via mp->xxx while
      * clearing.
      */
-    fill = mp->ma_fill;
-    if (table_is_malloced)
-        EMPTY_TO_MINSIZE(mp);
-
-    else if (fill > 0) {
-        /* It's a small table with something that needs to be cleared.
-         * Afraid the only safe way is to copy the dict entries into
-         * another small table first.
-         */
-        memcpy(small_copy, table, sizeof(small_copy));
-        table = small_copy;
-        EMPTY_TO_MINSIZE(mp);
+    indices = mp->ma_indices;
+    table = mp->ma_table;
+    values = mp->ma_values;
+    n = mp->ma_nentries;
+    size = mp->ma_mask + 1;
+    EMPTY_TO_MINSIZE(mp);
+
+    if (values != NULL) {
+        for (; n > 0; n--)
+            Py_DECREF(values[n - 1]);
+        PyObject_FREE(values);
+        _PyDictKeys_DecRef((PyDictKeysObject *)indices - 1);
+        return;
     }
-    /* else it's a small table that's already empty */
 
     /* Now we can finally clear things.  If C had refcounts, we could
      * assert that the refcount on table is 1 now, i.e. that this function
      * has unique access to it, so decref side-effects can't alter it.
      */
-    for (ep = table; fill > 0; ++ep) {
-#ifdef Py_DEBUG
-        assert(i < n);
-        ++i;
-#endif
+    for (ep = table; n > 0; ep++, n--) {
         if (ep->me_key) {
-            --fill;
             Py_DECREF(ep->me_key);
-            Py_XDECREF(ep->me_value);
+            Py_DECREF(ep->me_value);
         }
 #ifdef Py_DEBUG
         else
             assert(ep->me_value == NULL);
 #endif
     }
-
-    if (table_is_malloced)
-        PyMem_DEL(table);
+    free_tables(indices, size);
 }
 
 /*
@@ -979,25 +1270,27 @@ int
 PyDict_Next(PyObject *op, Py_ssize_t *ppos, PyObject **pkey, PyObject **pvalue)
 {
     register Py_ssize_t i;
-    register Py_ssize_t mask;
+    register Py_ssize_t n;
     register PyDictEntry *ep;
+    PyDictObject *mp;
 
     if (!PyDict_Check(op))
         return 0;
     i = *ppos;
     if (i < 0)
         return 0;
-    ep = ((PyDictObject *)op)->ma_table;
-    mask = ((PyDictObject *)op)->ma_mask;
-    while (i <= mask && ep[i].me_value == NULL)
+    mp = (PyDictObject *)op;
+    ep = mp->ma_table;
+    n = mp->ma_nentries;
+    while (i < n && ENTRY_VALUE(mp, i) == NULL)
         i++;
     *ppos = i+1;
-    if (i > mask)
+    if (i >= n)
         return 0;
     if (pkey)
         *pkey = ep[i].me_key;
     if (pvalue)
-        *pvalue = ep[i].me_value;
+        *pvalue = ENTRY_VALUE(mp, i);
     return 1;
 }
 
@@ -1006,26 +1299,28 @@ int
 _PyDict_Next(PyObject *op, Py_ssize_t *ppos, PyObject **pkey, PyObject **pvalue, long *phash)
 {
     register Py_ssize_t i;
-    register Py_ssize_t mask;
+    register Py_ssize_t n;
     register PyDictEntry *ep;
+    PyDictObject *mp;
 
     if (!PyDict_Check(op))
         return 0;
     i = *ppos;
     if (i < 0)
         return 0;
-    ep = ((PyDictObject *)op)->ma_table;
-    mask = ((PyDictObject *)op)->ma_mask;
-    while (i <= mask && ep[i].me_value == NULL)
+    mp = (PyDictObject *)op;
+    ep = mp->ma_table;
+    n = mp->ma_nentries;
+    while (i < n && ENTRY_VALUE(mp, i) == NULL)
         i++;
     *ppos = i+1;
-    if (i > mask)
+    if (i >= n)
         return 0;
     *phash = (long)(ep[i].me_hash);
     if (pkey)
         *pkey = ep[i].me_key;
     if (pvalue)
-        *pvalue = ep[i].me_value;
+        *pvalue = ENTRY_VALUE(mp, i);
     return 1;
 }
 
@@ -1035,20 +1330,28 @@ static void
 dict_dealloc(register PyDictObject *mp)
 {
     register PyDictEntry *ep;
-    Py_ssize_t fill = mp->ma_fill;
+    Py_ssize_t n = mp->ma_nentries;
     PyObject_GC_UnTrack(mp);
     Py_TRASHCAN_SAFE_BEGIN(mp)
-    for (ep = mp->ma_table; fill > 0; ep++) {
-        if (ep->me_key) {
-            --fill;
-            Py_DECREF(ep->me_key);
+    if (mp->ma_values != NULL) {
+        for (; n > 0; n--)
+            Py_DECREF(mp->ma_values[n - 1]);
+        PyObject_FREE(mp->ma_values);
+        _PyDictKeys_DecRef(DICT_KEYS(mp));
+    }
+    else {
+        for (ep = mp->ma_table; n > 0; ep++, n--) {
+            Py_XDECREF(ep->me_key);
             Py_XDECREF(ep->me_value);
         }
+        free_tables(mp->ma_indices, mp->ma_mask + 1);
+    }
+    if (_PyDict_FreeList.numfree < _PyDict_FreeList.maxfree &&
+        Py_TYPE(mp) == &PyDict_Type) {
+        mp->ma_indices = (void *)free_list;
+        free_list = mp;
+        _PyDict_FreeList.numfree++;
     }
-    if (mp->ma_table != mp->ma_smalltable)
-        PyMem_DEL(mp->ma_table);
-    if (numfree < PyDict_MAXFREELIST && Py_TYPE(mp) == &PyDict_Type)
-        free_list[numfree++] = mp;
     else
         Py_TYPE(mp)->tp_free((PyObject *)mp);
     Py_TRASHCAN_SAFE_END(mp)
@@ -1075,9 +1378,9 @@ dict_print(register PyDictObject *mp, register FILE *fp, register int flags)
     fprintf(fp, "{");
     Py_END_ALLOW_THREADS
     any = 0;
-    for (i = 0; i <= mp->ma_mask; i++) {
+    for (i = 0; i < mp->ma_nentries; i++) {
         PyDictEntry *ep = mp->ma_table + i;
-        PyObject *pvalue = ep->me_value;
+        PyObject *pvalue = ENTRY_VALUE(mp, i);
         if (pvalue != NULL) {
             /* Prevent PyObject_Repr from deleting value during
                key format */
@@ -1114,79 +1417,56 @@ static PyObject *
 dict_repr(PyDictObject *mp)
 {
     Py_ssize_t i;
-    PyObject *s, *temp, *colon = NULL;
-    PyObject *pieces = NULL, *result = NULL;
-    PyObject *key, *value;
+    PyObject *s, *key, *value;
+    _PyStringWriter writer;
+    int status, first = 1;
 
     i = Py_ReprEnter((PyObject *)mp);
     if (i != 0) {
         return i > 0 ? PyString_FromString("{...}") : NULL;
     }
 
-    if (mp->ma_used == 0) {
-        result = PyString_FromString("{}");
-        goto Done;
-    }
-
-    pieces = PyList_New(0);
-    if (pieces == NULL)
-        goto Done;
-
-    colon = PyString_FromString(": ");
-    if (colon == NULL)
-        goto Done;
+    _PyStringWriter_Init(&writer, NULL, 0);
+    if (_PyStringWriter_Write(&writer, "{", 1) < 0)
+        goto Error;
 
-    /* Do repr() on each key+value pair, and insert ": " between them.
-       Note that repr may mutate the dict. */
+    /* Do repr() on each key+value pair, with ": " between them and ", "
+       between pairs.  Note that repr may mutate the dict. */
     i = 0;
     while (PyDict_Next((PyObject *)mp, &i, &key, &value)) {
-        int status;
+        if (!first && _PyStringWriter_Write(&writer, ", ", 2) < 0)
+            goto Error;
+        first = 0;
         /* Prevent repr from deleting value during key format. */
         Py_INCREF(value);
         s = PyObject_Repr(key);
-        PyString_Concat(&s, colon);
-        PyString_ConcatAndDel(&s, PyObject_Repr(value));
+        if (s != NULL) {
+            status = _PyStringWriter_Write(&writer, PyString_AS_STRING(s),
+                                           PyString_GET_SIZE(s));
+            Py_DECREF(s);
+            if (status == 0)
+                status = _PyStringWriter_Write(&writer, ": ", 2);
+            s = status == 0 ? PyObject_Repr(value) : NULL;
+        }
         Py_DECREF(value);
         if (s == NULL)
-            goto Done;
-        status = PyList_Append(pieces, s);
-        Py_DECREF(s);  /* append created a new ref */
+            goto Error;
+        status = _PyStringWriter_Write(&writer, PyString_AS_STRING(s),
+                                       PyString_GET_SIZE(s));
+        Py_DECREF(s);
         if (status < 0)
-            goto Done;
-    }
-
-    /* Add "{}" decorations to the first and last items. */
-    assert(PyList_GET_SIZE(pieces) > 0);
-    s = PyString_FromString("{");
-    if (s == NULL)
-        goto Done;
-    temp = PyList_GET_ITEM(pieces, 0);
-    PyString_ConcatAndDel(&s, temp);
-    PyList_SET_ITEM(pieces, 0, s);
-    if (s == NULL)
-        goto Done;
-
-    s = PyString_FromString("}");
-    if (s == NULL)
-        goto Done;
-    temp = PyList_GET_ITEM(pieces, PyList_GET_SIZE(pieces) - 1);
-    PyString_ConcatAndDel(&temp, s);
-    PyList_SET_ITEM(pieces, PyList_GET_SIZE(pieces) - 1, temp);
-    if (temp == NULL)
-        goto Done;
-
-    /* Paste them all together with ", " between. */
-    s = PyString_FromString(", ");
-    if (s == NULL)
-        goto Done;
-    result = _PyString_Join(s, pieces);
-    Py_DECREF(s);
-
-Done:
-    Py_XDECREF(pieces);
-    Py_XDECREF(colon);
+            goto Error;
+    }
+
+    if (_PyStringWriter_Write(&writer, "}", 1) < 0)
+        goto Error;
     Py_ReprLeave((PyObject *)mp);
-    return result;
+    return _PyStringWriter_Finish(&writer);
+
+Error:
+    _PyStringWriter_Dealloc(&writer);
+    Py_ReprLeave((PyObject *)mp);
+    return NULL;
 }
 
 static Py_ssize_t
@@ -1201,7 +1481,7 @@ dict_subscript(PyDictObject *mp, register PyObject *key)
     PyObject *v;
     long hash;
     PyDictEntry *ep;
-    assert(mp->ma_table != NULL);
+    assert(mp->ma_indices != NULL);
 #ifdef _SYMBEX_DICT_HASHES
     if (mp->ma_flat) {
     	hash = _SYMBEX_HASH_VALUE;
@@ -1225,7 +1505,7 @@ dict_subscript(PyDictObject *mp, register PyObject *key)
     ep = (mp->ma_lookup)(mp, key, hash);
     if (ep == NULL)
         return NULL;
-    v = ep->me_value;
+    v = *value_addr(mp, ep);
     if (v == NULL) {
         if (!PyDict_CheckExact(mp)) {
             /* Look up __missing__ method if we're a subclass. */
@@ -1272,7 +1552,7 @@ dict_keys(register PyDictObject *mp)
     register PyObject *v;
     register Py_ssize_t i, j;
     PyDictEntry *ep;
-    Py_ssize_t mask, n;
+    Py_ssize_t nentries, n;
 
   again:
     n = mp->ma_used;
@@ -1287,9 +1567,9 @@ dict_keys(register PyDictObject *mp)
         goto again;
     }
     ep = mp->ma_table;
-    mask = mp->ma_mask;
-    for (i = 0, j = 0; i <= mask; i++) {
-        if (ep[i].me_value != NULL) {
+    nentries = mp->ma_nentries;
+    for (i = 0, j = 0; i < nentries; i++) {
+        if (ENTRY_VALUE(mp, i) != NULL) {
             PyObject *key = ep[i].me_key;
             Py_INCREF(key);
             PyList_SET_ITEM(v, j, key);
@@ -1305,8 +1585,7 @@ dict_values(register PyDictObject *mp)
 {
     register PyObject *v;
     register Py_ssize_t i, j;
-    PyDictEntry *ep;
-    Py_ssize_t mask, n;
+    Py_ssize_t nentries, n;
 
   again:
     n = mp->ma_used;
@@ -1320,11 +1599,10 @@ dict_values(register PyDictObject *mp)
         Py_DECREF(v);
         goto again;
     }
-    ep = mp->ma_table;
-    mask = mp->ma_mask;
-    for (i = 0, j = 0; i <= mask; i++) {
-        if (ep[i].me_value != NULL) {
-            PyObject *value = ep[i].me_value;
+    nentries = mp->ma_nentries;
+    for (i = 0, j = 0; i < nentries; i++) {
+        PyObject *value = ENTRY_VALUE(mp, i);
+        if (value != NULL) {
             Py_INCREF(value);
             PyList_SET_ITEM(v, j, value);
             j++;
@@ -1339,7 +1617,7 @@ dict_items(register PyDictObject *mp)
 {
     register PyObject *v;
     register Py_ssize_t i, j, n;
-    Py_ssize_t mask;
+    Py_ssize_t nentries;
     PyObject *item, *key, *value;
     PyDictEntry *ep;
 
@@ -1369,9 +1647,9 @@ dict_items(register PyDictObject *mp)
     }
     /* Nothing we do below makes any function calls. */
     ep = mp->ma_table;
-    mask = mp->ma_mask;
-    for (i = 0, j = 0; i <= mask; i++) {
-        if ((value=ep[i].me_value) != NULL) {
+    nentries = mp->ma_nentries;
+    for (i = 0, j = 0; i < nentries; i++) {
+        if ((value=ENTRY_VALUE(mp, i)) != NULL) {
             key = ep[i].me_key;
             item = PyList_GET_ITEM(v, j);
             Py_INCREF(key);
@@ -1409,7 +1687,7 @@ dict_fromkeys(PyObject *cls, PyObject *args)
         PyObject *key;
         long hash;
 
-        if (dictresize(mp, Py_SIZE(seq))) {
+        if (dictresize(mp, (((PyDictObject *)seq)->ma_used * 3) / 2)) {
             Py_DECREF(d);
             return NULL;
         }
@@ -1431,7 +1709,7 @@ dict_fromkeys(PyObject *cls, PyObject *args)
         PyObject *key;
         long hash;
 
-        if (dictresize(mp, PySet_GET_SIZE(seq))) {
+        if (dictresize(mp, (PySet_GET_SIZE(seq) * 3) / 2)) {
             Py_DECREF(d);
             return NULL;
         }
@@ -1600,6 +1878,7 @@ PyDict_Merge(PyObject *a, PyObject *b, int override)
     register PyDictObject *mp, *other;
     register Py_ssize_t i;
     PyDictEntry *entry;
+    PyObject *value;
 
     /* We accept for the argument either a concrete dictionary object,
      * or an abstract "mapping" object.  For the former, we can do
@@ -1616,30 +1895,43 @@ PyDict_Merge(PyObject *a, PyObject *b, int override)
         if (other == mp || other->ma_used == 0)
             /* a.update(a) or a.update({}); nothing to do */
             return 0;
-        if (mp->ma_used == 0)
+        if (mp->ma_used == 0) {
             /* Since the target dict is empty, PyDict_GetItem()
              * always returns NULL.  Setting override to 1
              * skips the unnecessary test.
              */
             override = 1;
+            /* If other has no deleted entries, copy its tables as they
+             * are, rather than inserting its items one by one.
+             */
+            if (mp->ma_indices == (void *)empty_indices &&
+                other->ma_used == other->ma_nentries &&
+                other->ma_values == NULL
+#ifdef _SYMBEX_DICT_HASHES
+                && mp->ma_flat == other->ma_flat
+#endif
+                )
+                return clone_tables(mp, other);
+        }
         /* Do one big resize at the start, rather than
          * incrementally resizing as we insert new items.  Expect
          * that there will be no (or few) overlapping keys.
          */
-        if ((mp->ma_fill + other->ma_used)*3 >= (mp->ma_mask+1)*2) {
+        if (mp->ma_fill + other->ma_used > DICT_USABLE(mp)) {
            if (dictresize(mp, (mp->ma_used + other->ma_used)*2) != 0)
                return -1;
         }
-        for (i = 0; i <= other->ma_mask; i++) {
+        for (i = 0; i < other->ma_nentries; i++) {
             entry = &other->ma_table[i];
-            if (entry->me_value != NULL &&
+            value = ENTRY_VALUE(other, i);
+            if (value != NULL &&
                 (override ||
                  PyDict_GetItem(a, entry->me_key) == NULL)) {
                 Py_INCREF(entry->me_key);
-                Py_INCREF(entry->me_value);
+                Py_INCREF(value);
                 if (insertdict(mp, entry->me_key,
                                (long)entry->me_hash,
-                               entry->me_value) != 0)
+                               value) != 0)
                     return -1;
             }
         }
@@ -1648,7 +1940,7 @@ PyDict_Merge(PyObject *a, PyObject *b, int override)
         /* Do it the generic, slower way */
         PyObject *keys = PyMapping_Keys(b);
         PyObject *iter;
-        PyObject *key, *value;
+        PyObject *key;
         int status;
 
         if (keys == NULL)
@@ -1771,9 +2063,9 @@ characterize(PyDictObject *a, PyDictObject *b, PyObject **pval)
     Py_ssize_t i;
     int cmp;
 
-    for (i = 0; i <= a->ma_mask; i++) {
+    for (i = 0; i < a->ma_nentries; i++) {
         PyObject *thiskey, *thisaval, *thisbval;
-        if (a->ma_table[i].me_value == NULL)
+        if (ENTRY_VALUE(a, i) == NULL)
             continue;
         thiskey = a->ma_table[i].me_key;
         Py_INCREF(thiskey);  /* keep alive across compares */
@@ -1784,8 +2076,8 @@ characterize(PyDictObject *a, PyDictObject *b, PyObject **pval)
                 goto Fail;
             }
             if (cmp > 0 ||
-                i > a->ma_mask ||
-                a->ma_table[i].me_value == NULL)
+                i >= a->ma_nentries ||
+                ENTRY_VALUE(a, i) == NULL)
             {
                 /* Not the *smallest* a key; or maybe it is
                  * but the compare shrunk the dict so we can't
@@ -1799,7 +2091,7 @@ characterize(PyDictObject *a, PyDictObject *b, PyObject **pval)
         }
 
         /* Compare a[thiskey] to b[thiskey]; cmp <- true iff equal. */
-        thisaval = a->ma_table[i].me_value;
+        thisaval = ENTRY_VALUE(a, i);
         assert(thisaval);
         Py_INCREF(thisaval);   /* keep alive */
         thisbval = PyDict_GetItem((PyObject *)b, thiskey);
@@ -1899,8 +2191,8 @@ dict_equal(PyDictObject *a, PyDictObject *b)
         return 0;
 
     /* Same # of entries -- check all of 'em.  Exit early on any diff. */
-    for (i = 0; i <= a->ma_mask; i++) {
-        PyObject *aval = a->ma_table[i].me_value;
+    for (i = 0; i < a->ma_nentries; i++) {
+        PyObject *aval = ENTRY_VALUE(a, i);
         if (aval != NULL) {
             int cmp;
             PyObject *bval;
@@ -1981,7 +2273,7 @@ dict_contains(register PyDictObject *mp, PyObject *key)
     ep = (mp->ma_lookup)(mp, key, hash);
     if (ep == NULL)
         return NULL;
-    return PyBool_FromLong(ep->me_value != NULL);
+    return PyBool_FromLong(*value_addr(mp, ep) != NULL);
 }
 
 static PyObject *
@@ -2028,7 +2320,7 @@ dict_get(register PyDictObject *mp, PyObject *args)
     ep = (mp->ma_lookup)(mp, key, hash);
     if (ep == NULL)
         return NULL;
-    val = ep->me_value;
+    val = *value_addr(mp, ep);
     if (val == NULL)
         val = failobj;
     Py_INCREF(val);
@@ -2071,7 +2363,7 @@ dict_setdefault(register PyDictObject *mp, PyObject *args)
     ep = (mp->ma_lookup)(mp, key, hash);
     if (ep == NULL)
         return NULL;
-    val = ep->me_value;
+    val = *value_addr(mp, ep);
     if (val == NULL) {
         val = failobj;
         if (PyDict_SetItem((PyObject*)mp, key, failobj))
@@ -2130,7 +2422,7 @@ dict_pop(PyDictObject *mp, PyObject *args)
     ep = (mp->ma_lookup)(mp, key, hash);
     if (ep == NULL)
         return NULL;
-    if (ep->me_value == NULL) {
+    if (*value_addr(mp, ep) == NULL) {
         if (deflt) {
             Py_INCREF(deflt);
             return deflt;
@@ -2138,12 +2430,15 @@ dict_pop(PyDictObject *mp, PyObject *args)
         set_key_error(key);
         return NULL;
     }
-    old_key = ep->me_key;
-    Py_INCREF(dummy);
-    ep->me_key = dummy;
-    old_value = ep->me_value;
-    ep->me_value = NULL;
-    mp->ma_used--;
+    if (mp->ma_values != NULL) {
+        /* Only dicts with keys of their own can delete them */
+        if (dictresize(mp, (mp->ma_used * 3) / 2) < 0)
+            return NULL;
+        ep = (mp->ma_lookup)(mp, key, hash);
+        if (ep == NULL)
+            return NULL;
+    }
+    delete_entry(mp, ep, &old_key, &old_value);
     Py_DECREF(old_key);
     return old_value;
 }
@@ -2151,9 +2446,9 @@ dict_pop(PyDictObject *mp, PyObject *args)
 static PyObject *
 dict_popitem(PyDictObject *mp)
 {
-    Py_ssize_t i = 0;
+    Py_ssize_t i;
     PyDictEntry *ep;
-    PyObject *res;
+    PyObject *res, *key, *value;
 
     /* Allocate the result tuple before checking the size.  Believe it
      * or not, this allocation could trigger a garbage collection which
@@ -2173,36 +2468,29 @@ dict_popitem(PyDictObject *mp)
                         "popitem(): dictionary is empty");
         return NULL;
     }
-    /* Set ep to "the first" dict entry with a value.  We abuse the hash
-     * field of slot 0 to hold a search finger:
-     * If slot 0 has a value, use slot 0.
-     * Else slot 0 is being used to hold a search finger,
-     * and we use its hash value as the first index to look.
+    if (mp->ma_values != NULL) {
+        /* The last value of a split dict goes, and its key stays shared */
+        i = mp->ma_used - 1;
+        key = mp->ma_table[i].me_key;
+        Py_INCREF(key);
+        value = mp->ma_values[i];
+        mp->ma_values[i] = NULL;
+        mp->ma_nentries = mp->ma_fill = mp->ma_used = i;
+        PyTuple_SET_ITEM(res, 0, key);
+        PyTuple_SET_ITEM(res, 1, value);
+        return res;
+    }
+    /* Pop the last entry:  its room in the table can be reused, though the
+     * slot of its index can't.
      */
-    ep = &mp->ma_table[0];
-    if (ep->me_value == NULL) {
-        i = ep->me_hash;
-        /* The hash field may be a real hash value, or it may be a
-         * legit search finger, or it may be a once-legit search
-         * finger that's out of bounds now because it wrapped around
-         * or the table shrunk -- simply make sure it's in bounds now.
-         */
-        if (i > mp->ma_mask || i < 1)
-            i = 1;              /* skip slot 0 */
-        while ((ep = &mp->ma_table[i])->me_value == NULL) {
-            i++;
-            if (i > mp->ma_mask)
-                i = 1;
-        }
-    }
-    PyTuple_SET_ITEM(res, 0, ep->me_key);
-    PyTuple_SET_ITEM(res, 1, ep->me_value);
-    Py_INCREF(dummy);
-    ep->me_key = dummy;
-    ep->me_value = NULL;
-    mp->ma_used--;
-    assert(mp->ma_table[0].me_value == NULL);
-    mp->ma_table[0].me_hash = i + 1;  /* next place to start */
+    i = mp->ma_nentries - 1;
+    while (mp->ma_table[i].me_value == NULL)
+        i--;
+    ep = &mp->ma_table[i];
+    delete_entry(mp, ep, &key, &value);
+    mp->ma_nentries = i;
+    PyTuple_SET_ITEM(res, 0, key);
+    PyTuple_SET_ITEM(res, 1, value);
     return res;
 }
 
@@ -2257,8 +2545,11 @@ dict_sizeof(PyDictObject *mp)
     Py_ssize_t res;
 
     res = sizeof(PyDictObject);
-    if (mp->ma_table != mp->ma_smalltable)
-        res = res + (mp->ma_mask + 1) * sizeof(PyDictEntry);
+    if (mp->ma_values != NULL)
+        /* The shared keys belong to the class */
+        res += USABLE_FRACTION(mp->ma_mask + 1) * sizeof(PyObject *);
+    else if (mp->ma_indices != (void *)empty_indices)
+        res = res + TABLES_SIZE(mp->ma_mask + 1);
     return PyInt_FromSsize_t(res);
 }
 
@@ -2408,7 +2699,7 @@ PyDict_Contains(PyObject *op, PyObject *key)
     }
 #endif
     ep = (mp->ma_lookup)(mp, key, hash);
-    return ep == NULL ? -1 : (ep->me_value != NULL);
+    return ep == NULL ? -1 : (*value_addr(mp, ep) != NULL);
 }
 
 /* Internal version of PyDict_Contains used when the hash value is already known */
@@ -2419,7 +2710,7 @@ _PyDict_Contains(PyObject *op, PyObject *key, long hash)
     PyDictEntry *ep;
 
     ep = (mp->ma_lookup)(mp, key, hash);
-    return ep == NULL ? -1 : (ep->me_value != NULL);
+    return ep == NULL ? -1 : (*value_addr(mp, ep) != NULL);
 }
 
 /* Hack to implement "key in dict" */
@@ -2450,7 +2741,7 @@ dict_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 #ifdef _SYMBEX_DICT_HASHES
         assert(d->ma_flat == 0);
 #endif
-        INIT_NONZERO_DICT_SLOTS(d);
+        EMPTY_TO_MINSIZE(d);
         d->ma_lookup = lookdict_string;
         /* The object has been implicitly tracked by tp_alloc */
         if (type == &PyDict_Type)
@@ -2575,6 +2866,122 @@ PyDict_DelItemString(PyObject *v, const char *key)
     return err;
 }
 
+/* Return a new dict for an instance of tp:  it is split over the keys the
+   instances of tp share, if any.
+*/
+PyObject *
+_PyObjectDict_New(PyTypeObject *tp)
+{
+    PyDictKeysObject *keys = CACHED_KEYS(tp);
+    PyObject *dict = PyDict_New();
+
+    if (dict != NULL && keys != NULL &&
+        share_keys((PyDictObject *)dict, keys) < 0) {
+        Py_DECREF(dict);
+        return NULL;
+    }
+    return dict;
+}
+
+/* Move the keys of mp, a dict with only string keys and no deleted entries,
+   to new shared keys with room for more, and split mp over them.  Return
+   the keys, with a reference for the caller, or NULL if mp can't be split.
+*/
+static PyDictKeysObject *
+make_keys_shared(PyDictObject *mp)
+{
+    PyDictKeysObject *keys;
+    PyDictEntry *oldtable;
+    PyObject **values;
+    void *oldindices;
+    Py_ssize_t oldsize, size, i, n = mp->ma_used;
+
+    if (mp->ma_values != NULL || mp->ma_nentries != n ||
+        mp->ma_lookup != lookdict_string
+#ifdef _SYMBEX_DICT_HASHES
+        || mp->ma_flat
+#endif
+        )
+        return NULL;
+    for (size = PyDict_MINSIZE; USABLE_FRACTION(size) <= n; size <<= 1)
+        ;
+    keys = new_keys_object(size);
+    values = PyObject_MALLOC(USABLE_FRACTION(size) * sizeof(PyObject *));
+    if (keys == NULL || values == NULL) {
+        /* Not sharing the keys only costs memory */
+        PyErr_Clear();
+        if (keys != NULL)
+            PyObject_FREE(keys);
+        if (values != NULL)
+            PyObject_FREE(values);
+        return NULL;
+    }
+    memset(values, 0, USABLE_FRACTION(size) * sizeof(PyObject *));
+
+    /* The keys take the references to the keys of the entries */
+    oldindices = mp->ma_indices;
+    oldtable = mp->ma_table;
+    oldsize = mp->ma_mask + 1;
+    mp->ma_indices = DK_INDICES(keys);
+    mp->ma_table = DK_ENTRIES(keys);
+    mp->ma_mask = size - 1;
+    mp->ma_values = values;
+    for (i = 0; i < n; i++) {
+        mp->ma_table[i].me_hash = oldtable[i].me_hash;
+        mp->ma_table[i].me_key = oldtable[i].me_key;
+        mp->ma_table[i].me_value = NULL;
+        values[i] = oldtable[i].me_value;
+        set_index(mp, find_empty_slot(mp, (long)oldtable[i].me_hash), i);
+    }
+    mp->ma_fill = n;
+    keys->dk_nentries = n;
+    keys->dk_refcnt++;
+    free_tables(oldindices, oldsize);
+    return keys;
+}
+
+/* Set, or delete if value is NULL, the attribute key in *dictptr, the dict
+   of an instance of tp, which is created if needed.  While a single instance
+   uses the keys shared by the instances of tp, these grow with the
+   attributes of that instance, which typically is the first one.
+*/
+int
+_PyObjectDict_SetItem(PyTypeObject *tp, PyObject **dictptr,
+                      PyObject *key, PyObject *value)
+{
+    PyObject *dict = *dictptr;
+    PyDictKeysObject *cached = CACHED_KEYS(tp);
+    PyDictKeysObject *keys;
+    int was_split, res;
+
+    if (dict == NULL) {
+        dict = _PyObjectDict_New(tp);
+        if (dict == NULL)
+            return -1;
+        *dictptr = dict;
+    }
+    was_split = (cached != NULL &&
+                 ((PyDictObject *)dict)->ma_values != NULL &&
+                 DICT_KEYS((PyDictObject *)dict) == cached);
+    Py_INCREF(dict);
+    if (value == NULL)
+        res = PyDict_DelItem(dict, key);
+    else
+        res = PyDict_SetItem(dict, key, value);
+    if (res == 0 && was_split && cached == CACHED_KEYS(tp) &&
+        cached->dk_refcnt == 1) {
+        /* The dict got keys of its own, and no other dict uses those of
+           the class:  they can be replaced by the keys of the dict. */
+        keys = make_keys_shared((PyDictObject *)dict);
+        if (keys != NULL) {
+            ((PyHeapTypeObject *)tp)->ht_cached_keys = keys;
+            _PyDictKeys_DecRef(cached);
+        }
+    }
+    Py_DECREF(dict);
+    return res;
+}
+
 /* Dictionary iterator types */
 
 typedef struct {
@@ -2652,7 +3059,7 @@ static PyMethodDef dictiter_methods[] = {
 static PyObject *dictiter_iternextkey(dictiterobject *di)
 {
     PyObject *key;
-    register Py_ssize_t i, mask;
+    register Py_ssize_t i, n;
     register PyDictEntry *ep;
     PyDictObject *d = di->di_dict;
 
@@ -2675,11 +3082,11 @@ static PyObject *dictiter_iternextkey(dictiterobject *di)
     if (i < 0)
         goto fail;
     ep = d->ma_table;
-    mask = d->ma_mask;
-    while (i <= mask && ep[i].me_value == NULL)
+    n = d->ma_nentries;
+    while (i < n && ENTRY_VALUE(d, i) == NULL)
         i++;
     di->di_pos = i+1;
-    if (i > mask)
+    if (i >= n)
         goto fail;
     di->len--;
     key = ep[i].me_key;
@@ -2728,8 +3135,7 @@ PyTypeObject PyDictIterKey_Type = {
 static PyObject *dictiter_iternextvalue(dictiterobject *di)
 {
     PyObject *value;
-    register Py_ssize_t i, mask;
-    register PyDictEntry *ep;
+    register Py_ssize_t i, n;
     PyDictObject *d = di->di_dict;
 
     if (d == NULL)
@@ -2748,13 +3154,12 @@ static PyObject *dictiter_iternextvalue(dictiterobject *di)
     }
 
     i = di->di_pos;
-    mask = d->ma_mask;
-    if (i < 0 || i > mask)
+    n = d->ma_nentries;
+    if (i < 0 || i >= n)
         goto fail;
-    ep = d->ma_table;
-    while ((value=ep[i].me_value) == NULL) {
+    while ((value=ENTRY_VALUE(d, i)) == NULL) {
         i++;
-        if (i > mask)
+        if (i >= n)
             goto fail;
     }
     di->di_pos = i+1;
@@ -2804,7 +3209,7 @@ PyTypeObject PyDictIterValue_Type = {
 static PyObject *dictiter_iternextitem(dictiterobject *di)
 {
     PyObject *key, *value, *result = di->di_result;
-    register Py_ssize_t i, mask;
+    register Py_ssize_t i, n;
     register PyDictEntry *ep;
     PyDictObject *d = di->di_dict;
 
@@ -2827,14 +3232,14 @@ static PyObject *dictiter_iternextitem(dictiterobject *di)
     if (i < 0)
         goto fail;
     ep = d->ma_table;
-    mask = d->ma_mask;
-    while (i <= mask && ep[i].me_value == NULL)
+    n = d->ma_nentries;
+    while (i < n && ENTRY_VALUE(d, i) == NULL)
         i++;
     di->di_pos = i+1;
-    if (i > mask)
+    if (i >= n)
         goto fail;
 
-    if (result->ob_refcnt == 1) {
+    if (Py_REFCNT(result) == 1) {
         Py_INCREF(result);
         Py_DECREF(PyTuple_GET_ITEM(result, 0));
         Py_DECREF(PyTuple_GET_ITEM(result, 1));
@@ -2845,7 +3250,7 @@ static PyObject *dictiter_iternextitem(dictiterobject *di)
     }
     di->len--;
     key = ep[i].me_key;
-    value = ep[i].me_value;
+    value = ENTRY_VALUE(d, i);
     Py_INCREF(key);
     Py_INCREF(value);
     PyTuple_SET_ITEM(result, 0, key);
@@ -2938,7 +3343,7 @@ dictview_new(PyObject *dict, PyTypeObject *type)
         /* XXX Get rid of this restriction later */
         PyErr_Format(PyExc_TypeError,
                      "%s() requires a dict argument, not '%s'",
-                     type->tp_name, dict->ob_type->tp_name);
+                     type->tp_name, Py_TYPE(dict)->tp_name);
         return NULL;
     }
     dv = PyObject_GC_New(dictviewobject, type);
@@ -9,6 +9,9 @@
 
 #include <ctype.h>
 #include <float.h>
+#ifdef HAVE_MALLOC_TRIM
+#include <malloc.h>
+#endif
 
 #undef MAX
 #undef MIN
@@ -25,6 +28,11 @@ extern int finite(double);
 #define BHEAD_SIZE      8       /* Enough for a 64-bit pointer */
 #define N_FLOATOBJECTS  ((BLOCK_SIZE - BHEAD_SIZE) / sizeof(PyFloatObject))
 
+#ifndef PyFloat_MAXFREELIST
+#define PyFloat_MAXFREELIST 10000
+#endif
+#define TRIM_BLOCKS     1024
+
 struct _floatblock {
     struct _floatblock *next;
     PyFloatObject objects[N_FLOATOBJECTS];
@@ -34,6 +42,21 @@ typedef struct _floatblock PyFloatBlock;
 
 static PyFloatBlock *block_list = NULL;
 static PyFloatObject *free_list = NULL;
+static Py_ssize_t numblocks = 0;
+/* Free the empty blocks when numfree exceeds this */
+static Py_ssize_t clear_threshold = PyFloat_MAXFREELIST;
+
+_PyFreeList _PyFloat_FreeList = {"float", PyFloat_MAXFREELIST, 0, 0, 0};
+
+static void
+set_clear_threshold(void)
+{
+    Py_ssize_t n = numblocks * N_FLOATOBJECTS / 2;
+
+    if (n < _PyFloat_FreeList.maxfree)
+        n = _PyFloat_FreeList.maxfree;
+    clear_threshold = _PyFloat_FreeList.numfree + n;
+}
 
 static PyFloatObject *
 fill_free_list(void)
@@ -45,6 +68,9 @@ fill_free_list(void)
         return (PyFloatObject *) PyErr_NoMemory();
     ((PyFloatBlock *)p)->next = block_list;
     block_list = (PyFloatBlock *)p;
+    numblocks++;
+    _PyFloat_FreeList.numfree += N_FLOATOBJECTS;
+    set_clear_threshold();
     p = &((PyFloatBlock *)p)->objects[0];
     q = p + N_FLOATOBJECTS;
     while (--q > p)
@@ -145,10 +171,14 @@ PyFloat_FromDouble(double fval)
     if (free_list == NULL) {
         if ((free_list = fill_free_list()) == NULL)
             return NULL;
+        _PyFreeList_MISS(_PyFloat_FreeList);
     }
+    else
+        _PyFreeList_HIT(_PyFloat_FreeList);
     /* Inline PyObject_New */
     op = free_list;
     free_list = (PyFloatObject *)Py_TYPE(op);
+    _PyFloat_FreeList.numfree--;
     PyObject_INIT(op, &PyFloat_Type);
     op->ob_fval = fval;
     return (PyObject *) op;
@@ -242,6 +272,8 @@ float_dealloc(PyFloatObject *op)
     if (PyFloat_CheckExact(op)) {
         Py_TYPE(op) = (struct _typeobject *)free_list;
         free_list = op;
+        if (++_PyFloat_FreeList.numfree > clear_threshold)
+            (void)PyFloat_ClearFreeList();
     }
     else
         Py_TYPE(op)->tp_free((PyObject *)op);
@@ -2200,10 +2232,12 @@ PyFloat_ClearFreeList(void)
     int i;
     int u;                      /* remaining unfreed ints per block */
     int freelist_size = 0;
+    Py_ssize_t freed = 0;       /* blocks given back */
 
     list = block_list;
     block_list = NULL;
     free_list = NULL;
+    numblocks = 0;
     while (list != NULL) {
         u = 0;
         for (i = 0, p = &list->objects[0];
@@ -2216,6 +2250,7 @@ PyFloat_ClearFreeList(void)
         if (u) {
             list->next = block_list;
             block_list = list;
+            numblocks++;
             for (i = 0, p = &list->objects[0];
                  i < N_FLOATOBJECTS;
                  i++, p++) {
@@ -2229,10 +2264,17 @@ PyFloat_ClearFreeList(void)
         }
         else {
             PyMem_FREE(list);
+            freed++;
         }
         freelist_size += u;
         list = next;
     }
+    _PyFloat_FreeList.numfree = numblocks * N_FLOATOBJECTS - freelist_size;
+    set_clear_threshold();
+#ifdef HAVE_MALLOC_TRIM
+    if (freed >= TRIM_BLOCKS)
+        malloc_trim(0);
+#endif
     return freelist_size;
 }
 
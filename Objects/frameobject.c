@@ -406,11 +406,15 @@ static PyGetSetDef frame_getsetlist[] = {
    realloc required when using a free_list frame that isn't the
    correct size. It also saves some field initialisation.
 
-   In zombie mode, no field of PyFrameObject holds a reference, but
-   the following fields are still valid:
+   The first heap frame created for a code object becomes its zombie
+   for good; while that frame is in use, f_tstate is set and the zombie
+   cannot be reanimated.  In zombie mode, no field of PyFrameObject
+   holds a reference, but the following fields are still valid:
 
      * ob_type, ob_size, f_code, f_valuestack;
 
+     * f_tstate is NULL;
+
      * f_locals, f_trace,
        f_exc_type, f_exc_value, f_exc_traceback are NULL;
 
@@ -437,12 +441,195 @@ static PyGetSetDef frame_getsetlist[] = {
    Later, PyFrame_MAXFREELIST was added to bound the # of frames saved on
    free_list.  Else programs creating lots of cyclic trash involving
    frames could provoke free_list into growing without bound.
+
+   3. Neither of the above helps recursion, where the zombie is in use
+   by the outer call and the free list hands out frames scattered over
+   the heap.  So when the zombie is busy, frames for ordinary code
+   objects are carved from a per-thread arena instead: a stack of large
+   chunks from which frames are bump-allocated in call order.  Frames
+   usually die in reverse order of creation, and a released frame on top
+   of its chunk simply moves the chunk's top back.  A frame that outlives
+   its callers -- because a traceback or sys._getframe() captured it --
+   stays where it is; its slot and the released slots below it are
+   reclaimed once it dies too.  Frames of generator code are known to
+   outlive the call that creates them and never come from the arena.
+
+   Arena frames are not counted as GC allocations; apart from that they
+   are ordinary frame objects.  f_chunk identifies them.
 */
 
 static PyFrameObject *free_list = NULL;
-static int numfree = 0;         /* number of frames currently in free_list */
-/* max value for numfree */
+/* Default for the most frames kept on free_list */
+#ifndef PyFrame_MAXFREELIST
 #define PyFrame_MAXFREELIST 200
+#endif
+
+_PyFreeList _PyFrame_FreeList = {"frame", PyFrame_MAXFREELIST, 0, 0, 0};
+
+/* Each arena frame is preceded by a slot header linking it to the slot
+   carved before it.  The union keeps what follows the header aligned for
+   the frame's GC header. */
+typedef union _frameslot {
+    struct {
+        union _frameslot *prev;         /* slot carved before, or NULL */
+        int released;                   /* frame is dead, slot reusable */
+    } s;
+    PyGC_Head dummy;
+} FrameSlot;
+
+typedef struct _framechunk {
+    struct _framechunk *fc_older;       /* next chunk down the stack */
+    struct _framechunk *fc_newer;       /* drained chunk kept as a spare */
+    PyThreadState *fc_owner;            /* NULL once the thread is gone */
+    FrameSlot *fc_last;                 /* slot carved last, or NULL */
+    char *fc_top;                       /* first free byte */
+    char *fc_limit;                     /* end of the chunk */
+    Py_ssize_t fc_nframes;              /* frames not released yet */
+} FrameChunk;
+
+#define FRAME_CHUNK_SIZE (64 * 1024)
+/* Larger frames (huge co_stacksize or many locals) go to the heap */
+#define FRAME_ARENA_MAXFRAME (FRAME_CHUNK_SIZE / 8)
+
+#define FRAME_ALIGN(n) \
+    (((n) + sizeof(FrameSlot) - 1) / sizeof(FrameSlot) * sizeof(FrameSlot))
+#define FRAME_CHUNK_START(c) ((char *)(c) + FRAME_ALIGN(sizeof(FrameChunk)))
+
+static FrameChunk *
+arena_push_chunk(PyThreadState *tstate)
+{
+    FrameChunk *current = tstate->frame_chunk;
+    FrameChunk *chunk;
+
+    if (current != NULL && current->fc_newer != NULL)
+        chunk = current->fc_newer;
+    else {
+        chunk = (FrameChunk *)PyMem_MALLOC(FRAME_CHUNK_SIZE);
+        if (chunk == NULL)
+            return NULL;
+        chunk->fc_older = current;
+        chunk->fc_newer = NULL;
+        chunk->fc_owner = tstate;
+        chunk->fc_limit = (char *)chunk + FRAME_CHUNK_SIZE;
+        if (current != NULL)
+            current->fc_newer = chunk;
+    }
+    chunk->fc_last = NULL;
+    chunk->fc_top = FRAME_CHUNK_START(chunk);
+    chunk->fc_nframes = 0;
+    tstate->frame_chunk = chunk;
+    return chunk;
+}
+
+/* Carve a frame for code from the arena of tstate, initialised like a
+   reanimated zombie.  Return NULL, without setting an exception, if the
+   frame must come from the heap instead. */
+static PyFrameObject *
+arena_new_frame(PyThreadState *tstate, PyCodeObject *code)
+{
+    FrameChunk *chunk = tstate->frame_chunk;
+    FrameSlot *slot;
+    PyGC_Head *g;
+    PyFrameObject *f;
+    Py_ssize_t i, nlocals;
+    size_t size;
+
+    if (code->co_flags & CO_GENERATOR)
+        return NULL;
+    nlocals = code->co_nlocals + PyTuple_GET_SIZE(code->co_cellvars) +
+        PyTuple_GET_SIZE(code->co_freevars);
+    size = FRAME_ALIGN(sizeof(FrameSlot) + sizeof(PyGC_Head) +
+                       _PyObject_VAR_SIZE(&PyFrame_Type,
+                                          nlocals + code->co_stacksize));
+    if (size > FRAME_ARENA_MAXFRAME)
+        return NULL;
+    if (chunk == NULL || (size_t)(chunk->fc_limit - chunk->fc_top) < size) {
+        chunk = arena_push_chunk(tstate);
+        if (chunk == NULL)
+            return NULL;
+    }
+    slot = (FrameSlot *)chunk->fc_top;
+    slot->s.prev = chunk->fc_last;
+    slot->s.released = 0;
+    chunk->fc_last = slot;
+    chunk->fc_top += size;
+    chunk->fc_nframes++;
+
+    g = (PyGC_Head *)(slot + 1);
+    g->gc.gc_refs = _PyGC_REFS_UNTRACKED;
+    f = (PyFrameObject *)(g + 1);
+    PyObject_INIT_VAR(f, &PyFrame_Type, nlocals + code->co_stacksize);
+    f->f_chunk = chunk;
+    f->f_code = code;
+    f->f_valuestack = f->f_localsplus + nlocals;
+    for (i = 0; i < nlocals; i++)
+        f->f_localsplus[i] = NULL;
+    f->f_locals = NULL;
+    f->f_trace = NULL;
+    f->f_exc_type = f->f_exc_value = f->f_exc_traceback = NULL;
+    return f;
+}
+
+/* Reclaim released slots from the top of chunk, stepping down to older
+   chunks of the owner as the current one drains. */
+static void
+arena_pop(FrameChunk *chunk)
+{
+    PyThreadState *tstate = chunk->fc_owner;
+
+    for (;;) {
+        while (chunk->fc_last != NULL && chunk->fc_last->s.released) {
+            chunk->fc_top = (char *)chunk->fc_last;
+            chunk->fc_last = chunk->fc_last->s.prev;
+        }
+        if (chunk->fc_last != NULL || chunk != tstate->frame_chunk ||
+            chunk->fc_older == NULL)
+            return;
+        /* Keep the drained chunk as the spare, but only one. */
+        if (chunk->fc_newer != NULL) {
+            PyMem_FREE(chunk->fc_newer);
+            chunk->fc_newer = NULL;
+        }
+        chunk = chunk->fc_older;
+        tstate->frame_chunk = chunk;
+    }
+}
+
+static void
+arena_release_frame(PyFrameObject *f)
+{
+    FrameChunk *chunk = f->f_chunk;
+    FrameSlot *slot = (FrameSlot *)((PyGC_Head *)f - 1) - 1;
+
+    slot->s.released = 1;
+    chunk->fc_nframes--;
+    if (chunk->fc_owner != NULL)
+        arena_pop(chunk);
+    else if (chunk->fc_nframes == 0)
+        PyMem_FREE(chunk);
+}
+
+void
+_PyFrame_DeleteArena(PyThreadState *tstate)
+{
+    FrameChunk *chunk = tstate->frame_chunk;
+    FrameChunk *older;
+
+    if (chunk == NULL)
+        return;
+    if (chunk->fc_newer != NULL)
+        PyMem_FREE(chunk->fc_newer);
+    /* Frames captured from this thread may still be alive; their chunks
+       are freed when the last of them is released. */
+    for (; chunk != NULL; chunk = older) {
+        older = chunk->fc_older;
+        if (chunk->fc_nframes == 0)
+            PyMem_FREE(chunk);
+        else
+            chunk->fc_owner = NULL;
+    }
+    tstate->frame_chunk = NULL;
+}
 
 static void
 frame_dealloc(PyFrameObject *f)
@@ -473,10 +660,12 @@ frame_dealloc(PyFrameObject *f)
     Py_CLEAR(f->f_exc_traceback);
 
     co = f->f_code;
-    if (co->co_zombieframe == NULL)
-        co->co_zombieframe = f;
-    else if (numfree < PyFrame_MAXFREELIST) {
-        ++numfree;
+    if (co->co_zombieframe == f)
+        f->f_tstate = NULL;
+    else if (f->f_chunk != NULL)
+        arena_release_frame(f);
+    else if (_PyFrame_FreeList.numfree < _PyFrame_FreeList.maxfree) {
+        ++_PyFrame_FreeList.numfree;
         f->f_back = free_list;
         free_list = f;
     }
@@ -664,12 +853,15 @@ PyFrame_New(PyThreadState *tstate, PyCodeObject *code, PyObject *globals,
         assert(builtins != NULL && PyDict_Check(builtins));
         Py_INCREF(builtins);
     }
-    if (code->co_zombieframe != NULL) {
-        f = code->co_zombieframe;
-        code->co_zombieframe = NULL;
+    f = (PyFrameObject *)code->co_zombieframe;
+    if (f != NULL && f->f_tstate == NULL) {
+        /* Mark the zombie busy before anything can reenter */
+        f->f_tstate = tstate;
         _Py_NewReference((PyObject *)f);
         assert(f->f_code == code);
     }
+    else if (f != NULL && (f = arena_new_frame(tstate, code)) != NULL)
+        ;
     else {
         Py_ssize_t extras, ncells, nfrees;
         ncells = PyTuple_GET_SIZE(code->co_cellvars);
@@ -683,10 +875,12 @@ PyFrame_New(PyThreadState *tstate, PyCodeObject *code, PyObject *globals,
                 Py_DECREF(builtins);
                 return NULL;
             }
+            _PyFreeList_MISS(_PyFrame_FreeList);
         }
         else {
-            assert(numfree > 0);
-            --numfree;
+            assert(_PyFrame_FreeList.numfree > 0);
+            --_PyFrame_FreeList.numfree;
+            _PyFreeList_HIT(_PyFrame_FreeList);
             f = free_list;
             free_list = free_list->f_back;
             if (Py_SIZE(f) < extras) {
@@ -700,6 +894,10 @@ PyFrame_New(PyThreadState *tstate, PyCodeObject *code, PyObject *globals,
         }
 
         f->f_code = code;
+        f->f_chunk = NULL;
+        f->f_tstate = tstate;
+        if (code->co_zombieframe == NULL)
+            code->co_zombieframe = f;
         extras = code->co_nlocals + ncells + nfrees;
         f->f_valuestack = f->f_localsplus + extras;
         for (i=0; i<extras; i++)
@@ -961,15 +1159,15 @@ PyFrame_LocalsToFast(PyFrameObject *f, int clear)
 int
 PyFrame_ClearFreeList(void)
 {
-    int freelist_size = numfree;
+    int freelist_size = (int)_PyFrame_FreeList.numfree;
 
     while (free_list != NULL) {
         PyFrameObject *f = free_list;
         free_list = free_list->f_back;
         PyObject_GC_Del(f);
-        --numfree;
+        --_PyFrame_FreeList.numfree;
     }
-    assert(numfree == 0);
+    assert(_PyFrame_FreeList.numfree == 0);
     return freelist_size;
 }
 
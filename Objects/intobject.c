@@ -6,6 +6,9 @@
 
 #include <ctype.h>
 #include <float.h>
+#ifdef HAVE_MALLOC_TRIM
+#include <malloc.h>
+#endif
 
 static PyObject *int_int(PyIntObject *v);
 
@@ -17,25 +20,41 @@ PyInt_GetMax(void)
 
 /* Integers are quite normal objects, to make object handling uniform.
    (Using odd pointers to represent integers would save much space
-   but require extra checks for this special case throughout the code.)
+   but require extra checks for this special case throughout the code:
+   building with Py_TAGGED_INTS does that, see object.h and intobject.h,
+   and then only ints too big for a tagged pointer are allocated here.)
    Since a typical Python program spends much of its time allocating
    and deallocating integers, these operations should be very fast.
    Therefore we use a dedicated allocation scheme with a much lower
    overhead (in space and time) than straight malloc(): a simple
    dedicated free list, filled when necessary with memory from malloc().
 
-   block_list is a singly-linked list of all PyIntBlocks ever allocated,
-   linked via their next members.  PyIntBlocks are never returned to the
-   system before shutdown (PyInt_Fini).
+   block_list is a singly-linked list of all PyIntBlocks allocated,
+   linked via their next members.
 
    free_list is a singly-linked list of available PyIntObjects, linked
    via abuse of their ob_type members.
+
+   Once more than half of the ints of the blocks are free, and more than
+   PYTHONFREELISTS allows, PyInt_ClearFreeList gives the blocks that hold
+   no live int back to the system.  As it has to scan all the blocks, it is
+   run again only after as many more ints were freed, so that a burst of
+   integer work doesn't pin its blocks for the life of the process, yet
+   freeing ints stays cheap.
 */
 
 #define BLOCK_SIZE      1000    /* 1K less typical malloc overhead */
 #define BHEAD_SIZE      8       /* Enough for a 64-bit pointer */
 #define N_INTOBJECTS    ((BLOCK_SIZE - BHEAD_SIZE) / sizeof(PyIntObject))
 
+#ifndef PyInt_MAXFREELIST
+#define PyInt_MAXFREELIST 10000
+#endif
+
+/* Ask malloc to give memory back to the system after freeing this many
+   blocks at once:  it may otherwise keep them, in the middle of its heap. */
+#define TRIM_BLOCKS     1024
+
 struct _intblock {
     struct _intblock *next;
     PyIntObject objects[N_INTOBJECTS];
@@ -45,6 +64,21 @@ typedef struct _intblock PyIntBlock;
 
 static PyIntBlock *block_list = NULL;
 static PyIntObject *free_list = NULL;
+static Py_ssize_t numblocks = 0;
+/* Free the empty blocks when numfree exceeds this */
+static Py_ssize_t clear_threshold = PyInt_MAXFREELIST;
+
+_PyFreeList _PyInt_FreeList = {"int", PyInt_MAXFREELIST, 0, 0, 0};
+
+static void
+set_clear_threshold(void)
+{
+    Py_ssize_t n = numblocks * N_INTOBJECTS / 2;
+
+    if (n < _PyInt_FreeList.maxfree)
+        n = _PyInt_FreeList.maxfree;
+    clear_threshold = _PyInt_FreeList.numfree + n;
+}
 
 static PyIntObject *
 fill_free_list(void)
@@ -56,6 +90,9 @@ fill_free_list(void)
         return (PyIntObject *) PyErr_NoMemory();
     ((PyIntBlock *)p)->next = block_list;
     block_list = (PyIntBlock *)p;
+    numblocks++;
+    _PyInt_FreeList.numfree += N_INTOBJECTS;
+    set_clear_threshold();
     /* Link the int objects together, from rear to front, then return
        the address of the last int object in the block. */
     p = &((PyIntBlock *)p)->objects[0];
@@ -66,7 +103,13 @@ fill_free_list(void)
     return p + N_INTOBJECTS - 1;
 }
 
-#ifndef _SYMBEX_INTERNED
+#ifdef Py_TAGGED_INTS
+/* Small ints are tagged, so there is nothing to cache */
+#undef NSMALLPOSINTS
+#undef NSMALLNEGINTS
+#define NSMALLPOSINTS           0
+#define NSMALLNEGINTS           0
+#elif !defined(_SYMBEX_INTERNED)
 #ifndef NSMALLPOSINTS
 #define NSMALLPOSINTS           257
 #endif
@@ -75,27 +118,47 @@ fill_free_list(void)
 #endif
 #endif /* ifndef _SYMBEX_INTERNED */
 
+/* Bounds of the cache of small ints:  PYTHONSMALLINTS can change them */
+#define MAX_SMALLINTS           (1L << 20)
+
+_PyFreeList _PyInt_SmallInts = {"smallint", 0, 0, 0, 0};
+
 #if NSMALLNEGINTS + NSMALLPOSINTS > 0
 /* References to small integers are saved in this array so that they
    can be shared.
    The integers that are saved are those in the range
-   -NSMALLNEGINTS (inclusive) to NSMALLPOSINTS (not inclusive).
+   -nsmallnegints (inclusive) to nsmallposints (not inclusive), by default
+   -NSMALLNEGINTS to NSMALLPOSINTS.  Until _PyInt_Init allocates the
+   array, the range is empty.
 */
-static PyIntObject *small_ints[NSMALLNEGINTS + NSMALLPOSINTS];
+static PyIntObject **small_ints = NULL;
+static long nsmallnegints = 0;
+static long nsmallposints = 0;
 #endif
 #ifdef COUNT_ALLOCS
 Py_ssize_t quick_int_allocs;
 Py_ssize_t quick_neg_int_allocs;
 #endif
 
+#ifdef Py_TAGGED_INTS
+PyTypeObject *_Py_TaggedIntType = &PyInt_Type;
+/* Big enough that no code takes a tagged int for an object it owns alone */
+Py_ssize_t _Py_TaggedIntRefcnt = PY_SSIZE_T_MAX / 2;
+#endif
+
 PyObject *
 PyInt_FromLong(long ival)
 {
     register PyIntObject *v;
+#ifdef Py_TAGGED_INTS
+    if (_PyInt_CAN_TAG(ival))
+        return _PyInt_TAG(ival);
+#endif
 #if NSMALLNEGINTS + NSMALLPOSINTS > 0
-    if (-NSMALLNEGINTS <= ival && ival < NSMALLPOSINTS) {
-        v = small_ints[ival + NSMALLNEGINTS];
+    if (-nsmallnegints <= ival && ival < nsmallposints) {
+        v = small_ints[ival + nsmallnegints];
         Py_INCREF(v);
+        _PyFreeList_HIT(_PyInt_SmallInts);
 #ifdef COUNT_ALLOCS
         if (ival >= 0)
             quick_int_allocs++;
@@ -104,19 +167,55 @@ PyInt_FromLong(long ival)
 #endif
         return (PyObject *) v;
     }
+    _PyFreeList_MISS(_PyInt_SmallInts);
 #endif
     if (free_list == NULL) {
         if ((free_list = fill_free_list()) == NULL)
             return NULL;
+        _PyFreeList_MISS(_PyInt_FreeList);
     }
+    else
+        _PyFreeList_HIT(_PyInt_FreeList);
     /* Inline PyObject_New */
     v = free_list;
     free_list = (PyIntObject *)Py_TYPE(v);
+    _PyInt_FreeList.numfree--;
+    PyObject_INIT(v, &PyInt_Type);
+    v->ob_ival = ival;
+    return (PyObject *) v;
+}
+
+/* PyInt_FromLong, but never tagged */
+
+static PyObject *
+int_alloc(long ival)
+{
+    register PyIntObject *v;
+
+    if (free_list == NULL) {
+        if ((free_list = fill_free_list()) == NULL)
+            return NULL;
+        _PyFreeList_MISS(_PyInt_FreeList);
+    }
+    else
+        _PyFreeList_HIT(_PyInt_FreeList);
+    v = free_list;
+    free_list = (PyIntObject *)Py_TYPE(v);
+    _PyInt_FreeList.numfree--;
     PyObject_INIT(v, &PyInt_Type);
     v->ob_ival = ival;
     return (PyObject *) v;
 }
 
+PyObject *
+PyInt_Box(PyObject *op)
+{
+    if (_Py_IsTagged(op))
+        return int_alloc(PyInt_AS_LONG(op));
+    Py_INCREF(op);
+    return op;
+}
+
 PyObject *
 PyInt_FromSize_t(size_t ival)
 {
@@ -134,21 +233,21 @@ PyInt_FromSsize_t(Py_ssize_t ival)
 }
 
 static void
-int_dealloc(PyIntObject *v)
+int_free(PyIntObject *v)
 {
-    if (PyInt_CheckExact(v)) {
-        Py_TYPE(v) = (struct _typeobject *)free_list;
-        free_list = v;
-    }
-    else
-        Py_TYPE(v)->tp_free((PyObject *)v);
+    Py_TYPE(v) = (struct _typeobject *)free_list;
+    free_list = v;
+    if (++_PyInt_FreeList.numfree > clear_threshold)
+        (void)PyInt_ClearFreeList();
 }
 
 static void
-int_free(PyIntObject *v)
+int_dealloc(PyIntObject *v)
 {
-    Py_TYPE(v) = (struct _typeobject *)free_list;
-    free_list = v;
+    if (PyInt_CheckExact(v))
+        int_free(v);
+    else
+        Py_TYPE(v)->tp_free((PyObject *)v);
 }
 
 long
@@ -434,7 +533,7 @@ static int
 int_print(PyIntObject *v, FILE *fp, int flags)
      /* flags -- not used but required by interface */
 {
-    long int_val = v->ob_ival;
+    long int_val = PyInt_AS_LONG(v);
     Py_BEGIN_ALLOW_THREADS
     fprintf(fp, "%ld", int_val);
     Py_END_ALLOW_THREADS
@@ -444,8 +543,8 @@ int_print(PyIntObject *v, FILE *fp, int flags)
 static int
 int_compare(PyIntObject *v, PyIntObject *w)
 {
-    register long i = v->ob_ival;
-    register long j = w->ob_ival;
+    register long i = PyInt_AS_LONG(v);
+    register long j = PyInt_AS_LONG(w);
     return (i < j) ? -1 : (i > j) ? 1 : 0;
 }
 
@@ -454,7 +553,7 @@ int_hash(PyIntObject *v)
 {
     /* XXX If this is changed, you also need to change the way
        Python's long, float and complex types are hashed. */
-    long x = v -> ob_ival;
+    long x = PyInt_AS_LONG(v);
     if (x == -1)
         x = -2;
     return x;
@@ -806,7 +905,7 @@ static PyObject *
 int_neg(PyIntObject *v)
 {
     register long a;
-    a = v->ob_ival;
+    a = PyInt_AS_LONG(v);
     /* check for overflow */
     if (UNARY_NEG_WOULD_OVERFLOW(a)) {
         PyObject *o = PyLong_FromLong(a);
@@ -823,7 +922,7 @@ int_neg(PyIntObject *v)
 static PyObject *
 int_abs(PyIntObject *v)
 {
-    if (v->ob_ival >= 0)
+    if (PyInt_AS_LONG(v) >= 0)
         return int_int(v);
     else
         return int_neg(v);
@@ -832,13 +931,13 @@ int_abs(PyIntObject *v)
 static int
 int_nonzero(PyIntObject *v)
 {
-    return v->ob_ival != 0;
+    return PyInt_AS_LONG(v) != 0;
 }
 
 static PyObject *
 int_invert(PyIntObject *v)
 {
-    return PyInt_FromLong(~v->ob_ival);
+    return PyInt_FromLong(~PyInt_AS_LONG(v));
 }
 
 static PyObject *
@@ -957,14 +1056,14 @@ int_int(PyIntObject *v)
     if (PyInt_CheckExact(v))
         Py_INCREF(v);
     else
-        v = (PyIntObject *)PyInt_FromLong(v->ob_ival);
+        v = (PyIntObject *)PyInt_FromLong(PyInt_AS_LONG(v));
     return (PyObject *)v;
 }
 
 static PyObject *
 int_long(PyIntObject *v)
 {
-    return PyLong_FromLong((v -> ob_ival));
+    return PyLong_FromLong(PyInt_AS_LONG(v));
 }
 
 static const unsigned char BitLengthTable[32] = {
@@ -990,7 +1089,7 @@ bits_in_ulong(unsigned long d)
 static PyObject *
 int_float(PyIntObject *v)
 {
-    return PyFloat_FromDouble((double)(v -> ob_ival));
+    return PyFloat_FromDouble((double)(PyInt_AS_LONG(v)));
 }
 
 #else
@@ -1004,13 +1103,13 @@ int_float(PyIntObject *v)
     unsigned long abs_ival, lsb;
     int round_up;
 
-    if (v->ob_ival < 0)
-        abs_ival = 0U-(unsigned long)v->ob_ival;
+    if (PyInt_AS_LONG(v) < 0)
+        abs_ival = 0U-(unsigned long)PyInt_AS_LONG(v);
     else
-        abs_ival = (unsigned long)v->ob_ival;
+        abs_ival = (unsigned long)PyInt_AS_LONG(v);
     if (abs_ival < (1L << DBL_MANT_DIG))
         /* small integer;  no need to round */
-        return PyFloat_FromDouble((double)v->ob_ival);
+        return PyFloat_FromDouble((double)PyInt_AS_LONG(v));
 
     /* Round abs_ival to MANT_DIG significant bits, using the
        round-half-to-even rule.  abs_ival & lsb picks out the 'rounding'
@@ -1032,7 +1131,7 @@ int_float(PyIntObject *v)
     abs_ival &= -2*lsb;
     if (round_up)
         abs_ival += 2*lsb;
-    return PyFloat_FromDouble(v->ob_ival < 0 ?
+    return PyFloat_FromDouble(PyInt_AS_LONG(v) < 0 ?
                               -(double)abs_ival :
                   (double)abs_ival);
 }
@@ -1122,7 +1221,7 @@ int_subtype_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
             return NULL;
         }
     } else {
-        ival = ((PyIntObject *)tmp)->ob_ival;
+        ival = PyInt_AS_LONG(tmp);
     }
 
     newobj = type->tp_alloc(type, 0);
@@ -1138,7 +1237,7 @@ int_subtype_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 static PyObject *
 int_getnewargs(PyIntObject *v)
 {
-    return Py_BuildValue("(l)", v->ob_ival);
+    return Py_BuildValue("(l)", PyInt_AS_LONG(v));
 }
 
 static PyObject *
@@ -1158,7 +1257,7 @@ int_get1(PyIntObject *v, void *context) {
 static PyObject *
 int_to_decimal_string(PyIntObject *v) {
     char buf[sizeof(long)*CHAR_BIT/3+6], *p, *bufend;
-    long n = v->ob_ival;
+    long n = PyInt_AS_LONG(v);
     unsigned long absn;
     p = bufend = buf + sizeof(buf);
     absn = n < 0 ? 0UL - n : n;
@@ -1180,7 +1279,7 @@ _PyInt_Format(PyIntObject *v, int base, int newstyle)
 {
     /* There are no doubt many, many ways to optimize this, using code
        similar to _PyLong_Format */
-    long n = v->ob_ival;
+    long n = PyInt_AS_LONG(v);
     int  negative = n < 0;
     int is_zero = n == 0;
 
@@ -1278,11 +1377,11 @@ int_bit_length(PyIntObject *v)
 {
     unsigned long n;
 
-    if (v->ob_ival < 0)
-        /* avoid undefined behaviour when v->ob_ival == -LONG_MAX-1 */
-        n = 0U-(unsigned long)v->ob_ival;
+    if (PyInt_AS_LONG(v) < 0)
+        /* avoid undefined behaviour when PyInt_AS_LONG(v) == -LONG_MAX-1 */
+        n = 0U-(unsigned long)PyInt_AS_LONG(v);
     else
-        n = (unsigned long)v->ob_ival;
+        n = (unsigned long)PyInt_AS_LONG(v);
 
     return PyInt_FromLong(bits_in_ulong(n));
 }
@@ -1436,22 +1535,75 @@ PyTypeObject PyInt_Type = {
     (freefunc)int_free,                         /* tp_free */
 };
 
+#if NSMALLNEGINTS + NSMALLPOSINTS > 0
+/* Read the range of the small int cache from PYTHONSMALLINTS, "low,high"
+ * for low <= i < high.  Ranges that don't parse or hold 0 are ignored.
+ */
+static void
+smallints_getenv(long *neg, long *pos)
+{
+    char *s = Py_GETENV("PYTHONSMALLINTS");
+    char *end;
+    long low, high;
+
+    if (s == NULL || *s == '\0')
+        return;
+    low = strtol(s, &end, 10);
+    if (end == s || *end != ',')
+        return;
+    s = end + 1;
+    high = strtol(s, &end, 10);
+    if (end == s || *end != '\0')
+        return;
+    if (low > 0 || high < 0 || low < -MAX_SMALLINTS || high > MAX_SMALLINTS)
+        return;
+    *neg = -low;
+    *pos = high;
+}
+#endif
+
 int
 _PyInt_Init(void)
 {
-    PyIntObject *v;
-    int ival;
 #if NSMALLNEGINTS + NSMALLPOSINTS > 0
-    for (ival = -NSMALLNEGINTS; ival < NSMALLPOSINTS; ival++) {
-          if (!free_list && (free_list = fill_free_list()) == NULL)
-                    return 0;
+    PyIntObject *v;
+    long ival, neg, pos;
+
+    if (small_ints == NULL) {
+        neg = NSMALLNEGINTS;
+        pos = NSMALLPOSINTS;
+        smallints_getenv(&neg, &pos);
+        if (neg + pos > 0) {
+            small_ints = PyMem_New(PyIntObject *, neg + pos);
+            if (small_ints == NULL)
+                return 0;
+            memset(small_ints, 0, (neg + pos) * sizeof(PyIntObject *));
+        }
+    }
+    else {
+        /* Initialized again after PyInt_Fini */
+        neg = nsmallnegints;
+        pos = nsmallposints;
+    }
+    for (ival = -neg; ival < pos; ival++) {
+        if (small_ints[ival + neg] != NULL)
+            continue;
+        if (!free_list && (free_list = fill_free_list()) == NULL)
+            return 0;
         /* PyObject_New is inlined */
         v = free_list;
         free_list = (PyIntObject *)Py_TYPE(v);
+        _PyInt_FreeList.numfree--;
         PyObject_INIT(v, &PyInt_Type);
         v->ob_ival = ival;
-        small_ints[ival + NSMALLNEGINTS] = v;
+        small_ints[ival + neg] = v;
+#ifdef Py_IMMORTAL_OBJECTS
+        _Py_SetImmortal((PyObject *)v);
+#endif
     }
+    nsmallnegints = neg;
+    nsmallposints = pos;
+    _PyInt_SmallInts.maxfree = _PyInt_SmallInts.numfree = neg + pos;
 #endif
     return 1;
 }
@@ -1464,49 +1616,59 @@ PyInt_ClearFreeList(void)
     int i;
     int u;                      /* remaining unfreed ints per block */
     int freelist_size = 0;
+    Py_ssize_t freed = 0;       /* blocks given back */
 
     list = block_list;
     block_list = NULL;
     free_list = NULL;
+    numblocks = 0;
     while (list != NULL) {
         u = 0;
         for (i = 0, p = &list->objects[0];
              i < N_INTOBJECTS;
              i++, p++) {
-            if (PyInt_CheckExact(p) && p->ob_refcnt != 0)
+            if (PyInt_CheckExact(p) && Py_REFCNT(p) != 0)
                 u++;
         }
         next = list->next;
         if (u) {
             list->next = block_list;
             block_list = list;
+            numblocks++;
             for (i = 0, p = &list->objects[0];
                  i < N_INTOBJECTS;
                  i++, p++) {
                 if (!PyInt_CheckExact(p) ||
-                    p->ob_refcnt == 0) {
+                    Py_REFCNT(p) == 0) {
                     Py_TYPE(p) = (struct _typeobject *)
                         free_list;
                     free_list = p;
                 }
 #if NSMALLNEGINTS + NSMALLPOSINTS > 0
-                else if (-NSMALLNEGINTS <= p->ob_ival &&
-                         p->ob_ival < NSMALLPOSINTS &&
-                         small_ints[p->ob_ival +
-                                    NSMALLNEGINTS] == NULL) {
+                else if (-nsmallnegints <= PyInt_AS_LONG(p) &&
+                         PyInt_AS_LONG(p) < nsmallposints &&
+                         small_ints[PyInt_AS_LONG(p) +
+                                    nsmallnegints] == NULL) {
                     Py_INCREF(p);
-                    small_ints[p->ob_ival +
-                               NSMALLNEGINTS] = p;
+                    small_ints[PyInt_AS_LONG(p) +
+                               nsmallnegints] = p;
                 }
 #endif
             }
         }
         else {
             PyMem_FREE(list);
+            freed++;
         }
         freelist_size += u;
         list = next;
     }
+    _PyInt_FreeList.numfree = numblocks * N_INTOBJECTS - freelist_size;
+    set_clear_threshold();
+#ifdef HAVE_MALLOC_TRIM
+    if (freed >= TRIM_BLOCKS)
+        malloc_trim(0);
+#endif
 
     return freelist_size;
 }
@@ -1522,7 +1684,7 @@ PyInt_Fini(void)
 #if NSMALLNEGINTS + NSMALLPOSINTS > 0
     PyIntObject **q;
 
-    i = NSMALLNEGINTS + NSMALLPOSINTS;
+    i = nsmallnegints + nsmallposints;
     q = small_ints;
     while (--i >= 0) {
         Py_XDECREF(*q);
@@ -1547,15 +1709,15 @@ PyInt_Fini(void)
             for (i = 0, p = &list->objects[0];
                  i < N_INTOBJECTS;
                  i++, p++) {
-                if (PyInt_CheckExact(p) && p->ob_refcnt != 0)
+                if (PyInt_CheckExact(p) && Py_REFCNT(p) != 0)
                     /* XXX(twouters) cast refcount to
                        long until %zd is universally
                        available
                      */
                     fprintf(stderr,
                 "#   <int at %p, refcnt=%ld, val=%ld>\n",
-                                p, (long)p->ob_refcnt,
-                                p->ob_ival);
+                                p, (long)Py_REFCNT(p),
+                                PyInt_AS_LONG(p));
             }
             list = list->next;
         }
@@ -90,23 +90,27 @@ show_alloc(void)
 }
 #endif
 
-/* Empty list reuse scheme to save calls to malloc and free */
+/* Empty list reuse scheme to save calls to malloc and free.  The free
+   lists are linked via their ob_item members. */
 #ifndef PyList_MAXFREELIST
 #define PyList_MAXFREELIST 80
 #endif
-static PyListObject *free_list[PyList_MAXFREELIST];
-static int numfree = 0;
+static PyListObject *free_list = NULL;
+
+_PyFreeList _PyList_FreeList = {"list", PyList_MAXFREELIST, 0, 0, 0};
 
 void
 PyList_Fini(void)
 {
     PyListObject *op;
 
-    while (numfree) {
-        op = free_list[--numfree];
+    while (free_list != NULL) {
+        op = free_list;
+        free_list = (PyListObject *)op->ob_item;
         assert(PyList_CheckExact(op));
         PyObject_GC_Del(op);
     }
+    _PyList_FreeList.numfree = 0;
 }
 
 PyObject *
@@ -131,9 +135,11 @@ PyList_New(Py_ssize_t size)
     if ((size_t)size > PY_SIZE_MAX / sizeof(PyObject *))
         return PyErr_NoMemory();
     nbytes = size * sizeof(PyObject *);
-    if (numfree) {
-        numfree--;
-        op = free_list[numfree];
+    if (free_list != NULL) {
+        op = free_list;
+        free_list = (PyListObject *)op->ob_item;
+        _PyList_FreeList.numfree--;
+        _PyFreeList_HIT(_PyList_FreeList);
         _Py_NewReference((PyObject *)op);
 #ifdef SHOW_ALLOC_COUNT
         count_reuse++;
@@ -142,6 +148,7 @@ PyList_New(Py_ssize_t size)
         op = PyObject_GC_New(PyListObject, &PyList_Type);
         if (op == NULL)
             return NULL;
+        _PyFreeList_MISS(_PyList_FreeList);
 #ifdef SHOW_ALLOC_COUNT
         count_alloc++;
 #endif
@@ -310,8 +317,12 @@ list_dealloc(PyListObject *op)
         }
         PyMem_FREE(op->ob_item);
     }
-    if (numfree < PyList_MAXFREELIST && PyList_CheckExact(op))
-        free_list[numfree++] = op;
+    if (_PyList_FreeList.numfree < _PyList_FreeList.maxfree &&
+        PyList_CheckExact(op)) {
+        op->ob_item = (PyObject **)free_list;
+        free_list = op;
+        _PyList_FreeList.numfree++;
+    }
     else
         Py_TYPE(op)->tp_free((PyObject *)op);
     Py_TRASHCAN_SAFE_END(op)
@@ -362,70 +373,49 @@ static PyObject *
 list_repr(PyListObject *v)
 {
     Py_ssize_t i;
-    PyObject *s, *temp;
-    PyObject *pieces = NULL, *result = NULL;
+    PyObject *s;
+    _PyStringWriter writer;
+    int status;
 
     i = Py_ReprEnter((PyObject*)v);
     if (i != 0) {
         return i > 0 ? PyString_FromString("[...]") : NULL;
     }
 
-    if (Py_SIZE(v) == 0) {
-        result = PyString_FromString("[]");
-        goto Done;
-    }
-
-    pieces = PyList_New(0);
-    if (pieces == NULL)
-        goto Done;
+    /* No stack buffer:  the reprs of nested containers recurse, and each
+       level would hold one. */
+    _PyStringWriter_Init(&writer, NULL, 0);
+    if (_PyStringWriter_Write(&writer, "[", 1) < 0)
+        goto Error;
 
-    /* Do repr() on each element.  Note that this may mutate the list,
-       so must refetch the list size on each iteration. */
+    /* Do repr() on each element, and paste them together with ", "
+       between.  Note that repr() may mutate the list, so must refetch
+       the list size on each iteration. */
     for (i = 0; i < Py_SIZE(v); ++i) {
-        int status;
+        if (i > 0 && _PyStringWriter_Write(&writer, ", ", 2) < 0)
+            goto Error;
         if (Py_EnterRecursiveCall(" while getting the repr of a list"))
-            goto Done;
+            goto Error;
         s = PyObject_Repr(v->ob_item[i]);
         Py_LeaveRecursiveCall();
         if (s == NULL)
-            goto Done;
-        status = PyList_Append(pieces, s);
-        Py_DECREF(s);  /* append created a new ref */
+            goto Error;
+        status = _PyStringWriter_Write(&writer, PyString_AS_STRING(s),
+                                       PyString_GET_SIZE(s));
+        Py_DECREF(s);
         if (status < 0)
-            goto Done;
-    }
-
-    /* Add "[]" decorations to the first and last items. */
-    assert(PyList_GET_SIZE(pieces) > 0);
-    s = PyString_FromString("[");
-    if (s == NULL)
-        goto Done;
-    temp = PyList_GET_ITEM(pieces, 0);
-    PyString_ConcatAndDel(&s, temp);
-    PyList_SET_ITEM(pieces, 0, s);
-    if (s == NULL)
-        goto Done;
-
-    s = PyString_FromString("]");
-    if (s == NULL)
-        goto Done;
-    temp = PyList_GET_ITEM(pieces, PyList_GET_SIZE(pieces) - 1);
-    PyString_ConcatAndDel(&temp, s);
-    PyList_SET_ITEM(pieces, PyList_GET_SIZE(pieces) - 1, temp);
-    if (temp == NULL)
-        goto Done;
-
-    /* Paste them all together with ", " between. */
-    s = PyString_FromString(", ");
-    if (s == NULL)
-        goto Done;
-    result = _PyString_Join(s, pieces);
-    Py_DECREF(s);
-
-Done:
-    Py_XDECREF(pieces);
+            goto Error;
+    }
+
+    if (_PyStringWriter_Write(&writer, "]", 1) < 0)
+        goto Error;
     Py_ReprLeave((PyObject *)v);
-    return result;
+    return _PyStringWriter_Finish(&writer);
+
+Error:
+    _PyStringWriter_Dealloc(&writer);
+    Py_ReprLeave((PyObject *)v);
+    return NULL;
 }
 
 static Py_ssize_t
@@ -512,7 +502,7 @@ list_concat(PyListObject *a, PyObject *bb)
     if (!PyList_Check(bb)) {
         PyErr_Format(PyExc_TypeError,
                   "can only concatenate list (not \"%.200s\") to list",
-                  bb->ob_type->tp_name);
+                  Py_TYPE(bb)->tp_name);
         return NULL;
     }
 #define b ((PyListObject *)bb)
@@ -845,7 +835,7 @@ listextend(PyListObject *self, PyObject *b)
     it = PyObject_GetIter(b);
     if (it == NULL)
         return NULL;
-    iternext = *it->ob_type->tp_iternext;
+    iternext = *Py_TYPE(it)->tp_iternext;
 
     /* Guess a result list size. */
     n = _PyObject_LengthHint(b, 8);
@@ -1012,7 +1002,7 @@ islt(PyObject *x, PyObject *y, PyObject *compare)
     if (!PyInt_Check(res)) {
         PyErr_Format(PyExc_TypeError,
                      "comparison function must return int, not %.200s",
-                     res->ob_type->tp_name);
+                     Py_TYPE(res)->tp_name);
         Py_DECREF(res);
         return -1;
     }
@@ -2588,7 +2578,7 @@ list_subscript(PyListObject* self, PyObject* item)
     else {
         PyErr_Format(PyExc_TypeError,
                      "list indices must be integers, not %.200s",
-                     item->ob_type->tp_name);
+                     Py_TYPE(item)->tp_name);
         return NULL;
     }
 }
@@ -2751,7 +2741,7 @@ list_ass_subscript(PyListObject* self, PyObject* item, PyObject* value)
     else {
         PyErr_Format(PyExc_TypeError,
                      "list indices must be integers, not %.200s",
-                     item->ob_type->tp_name);
+                     Py_TYPE(item)->tp_name);
         return -1;
     }
 }
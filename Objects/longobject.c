@@ -17,6 +17,28 @@
 #define KARATSUBA_CUTOFF 70
 #define KARATSUBA_SQUARE_CUTOFF (2 * KARATSUBA_CUTOFF)
 
+/* Above TOOM3_CUTOFF digits (TOOM3_SQUARE_CUTOFF for squares), k_mul splits
+ * its operands in three pieces rather than two (Toom-Cook), and above
+ * NTT_CUTOFF digits it multiplies them with number-theoretic transforms.
+ */
+#define TOOM3_CUTOFF 400
+#define TOOM3_SQUARE_CUTOFF 600
+#define NTT_CUTOFF 20000
+
+/* Longs of more than DECIMAL_DC_CUTOFF digits are converted to decimal, and
+ * strings of more than STR_DC_CUTOFF characters in bases that are not
+ * powers of 2 are converted to longs, by splitting them at powers of the
+ * base into pieces of DECIMAL_DC_LEAF or STR_DC_LEAF characters, which
+ * are converted by the quadratic algorithms.  RECIPROCAL_CUTOFF is the
+ * number of bits above which reciprocals used to split longs are computed
+ * by Newton's method rather than by long division.
+ */
+#define DECIMAL_DC_CUTOFF (80000 / PyLong_SHIFT)
+#define DECIMAL_DC_LEAF 2000
+#define STR_DC_CUTOFF 10000
+#define STR_DC_LEAF 2000
+#define RECIPROCAL_CUTOFF (4 * KARATSUBA_CUTOFF * PyLong_SHIFT)
+
 /* For exponentiation, use the binary left-to-right algorithm
  * unless the exponent contains more than FIVEARY_CUTOFF digits.
  * In that case, do 5 bits at a time.  The potential drawback is that
@@ -24,6 +46,12 @@
  */
 #define FIVEARY_CUTOFF 8
 
+/* Modular exponentiation reduces its intermediate results by multiplying
+ * them by a reciprocal of the modulus (Barrett's reduction) rather than by
+ * long division if the modulus contains more than BARRETT_CUTOFF digits.
+ */
+#define BARRETT_CUTOFF 100
+
 #define ABS(x) ((x) < 0 ? -(x) : (x))
 
 #undef MIN
@@ -250,7 +278,7 @@ PyLong_AsLongAndOverflow(PyObject *vv, int *overflow)
 
     if (!PyLong_Check(vv)) {
         PyNumberMethods *nb;
-        nb = vv->ob_type->tp_as_number;
+        nb = Py_TYPE(vv)->tp_as_number;
         if (nb == NULL || nb->nb_int == NULL) {
             PyErr_SetString(PyExc_TypeError,
                             "an integer is required");
@@ -933,7 +961,7 @@ PyLong_AsLongLong(PyObject *vv)
         PyObject *io;
         if (PyInt_Check(vv))
             return (PY_LONG_LONG)PyInt_AsLong(vv);
-        if ((nb = vv->ob_type->tp_as_number) == NULL ||
+        if ((nb = Py_TYPE(vv)->tp_as_number) == NULL ||
             nb->nb_int == NULL) {
             PyErr_SetString(PyExc_TypeError, "an integer is required");
             return -1;
@@ -1050,7 +1078,7 @@ PyLong_AsLongLongAndOverflow(PyObject *vv, int *overflow)
 
     if (!PyLong_Check(vv)) {
         PyNumberMethods *nb;
-        nb = vv->ob_type->tp_as_number;
+        nb = Py_TYPE(vv)->tp_as_number;
         if (nb == NULL || nb->nb_int == NULL) {
             PyErr_SetString(PyExc_TypeError,
                             "an integer is required");
@@ -1311,27 +1339,19 @@ divrem1(PyLongObject *a, digit n, digit *prem)
     return long_normalize(z);
 }
 
-/* Convert a long integer to a base 10 string.  Returns a new non-shared
-   string.  (Return value is non-shared so that callers can modify the
-   returned value if necessary.) */
+/* Convert the absolute value of a long integer to base _PyLong_DECIMAL_BASE,
+   following Knuth (TAOCP, Volume 2 (3rd edn), section 4.4, Method 1b).  The
+   result is a long object used as a digit array, least significant first,
+   with at least one digit. */
 
-static PyObject *
-long_to_decimal_string(PyObject *aa, int addL)
+static PyLongObject *
+long_to_decimal_base(PyLongObject *a)
 {
-    PyLongObject *scratch, *a;
-    PyObject *str;
-    Py_ssize_t size, strlen, size_a, i, j;
-    digit *pout, *pin, rem, tenpow;
-    char *p;
-    int negative;
+    PyLongObject *scratch;
+    Py_ssize_t size, size_a, i, j;
+    digit *pout, *pin;
 
-    a = (PyLongObject *)aa;
-    if (a == NULL || !PyLong_Check(a)) {
-        PyErr_BadInternalCall();
-        return NULL;
-    }
     size_a = ABS(Py_SIZE(a));
-    negative = Py_SIZE(a) < 0;
 
     /* quick and dirty upper bound for the number of digits
        required to express a in base _PyLong_DECIMAL_BASE:
@@ -1354,8 +1374,7 @@ long_to_decimal_string(PyObject *aa, int addL)
         return NULL;
 
     /* convert array of base _PyLong_BASE digits in pin to an array of
-       base _PyLong_DECIMAL_BASE digits in pout, following Knuth (TAOCP,
-       Volume 2 (3rd edn), section 4.4, Method 1b). */
+       base _PyLong_DECIMAL_BASE digits in pout */
     pin = a->ob_digit;
     pout = scratch->ob_digit;
     size = 0;
@@ -1381,27 +1400,41 @@ long_to_decimal_string(PyObject *aa, int addL)
        works correctly */
     if (size == 0)
         pout[size++] = 0;
+    Py_SIZE(scratch) = size;
+    return scratch;
+}
 
-    /* calculate exact length of output string, and allocate */
-    strlen = (addL != 0) + negative +
-        1 + (size - 1) * _PyLong_DECIMAL_SHIFT;
+/* The number of decimal digits of a number in base _PyLong_DECIMAL_BASE,
+   as returned by long_to_decimal_base. */
+
+static Py_ssize_t
+decimal_base_strlen(PyLongObject *scratch)
+{
+    Py_ssize_t size = Py_SIZE(scratch), strlen;
+    digit rem, tenpow;
+
+    strlen = 1 + (size - 1) * _PyLong_DECIMAL_SHIFT;
     tenpow = 10;
-    rem = pout[size-1];
+    rem = scratch->ob_digit[size-1];
     while (rem >= tenpow) {
         tenpow *= 10;
         strlen++;
     }
-    str = PyString_FromStringAndSize(NULL, strlen);
-    if (str == NULL) {
-        Py_DECREF(scratch);
-        return NULL;
-    }
+    return strlen;
+}
+
+/* Write the decimal digits of scratch right-to-left, ending just before p,
+   with leading zeros up to width digits in all.  Returns the position of
+   the first digit. */
+
+static char *
+decimal_base_fill(char *p, PyLongObject *scratch, Py_ssize_t width)
+{
+    Py_ssize_t size = Py_SIZE(scratch), i, j;
+    digit *pout = scratch->ob_digit;
+    char *end = p;
+    digit rem;
 
-    /* fill the string right-to-left */
-    p = PyString_AS_STRING(str) + strlen;
-    *p = '\0';
-    if (addL)
-        *--p = 'L';
     /* pout[0] through pout[size-2] contribute exactly
        _PyLong_DECIMAL_SHIFT digits each */
     for (i=0; i < size - 1; i++) {
@@ -1418,6 +1451,57 @@ long_to_decimal_string(PyObject *aa, int addL)
         rem /= 10;
     } while (rem != 0);
 
+    while (end - p < width)
+        *--p = '0';
+    return p;
+}
+
+/* forward */
+static PyObject *long_to_decimal_string_dc(PyLongObject *a, int addL);
+static PyLongObject *long_from_string_dc(char *str, Py_ssize_t len,
+                                         int base);
+
+/* Convert a long integer to a base 10 string.  Returns a new non-shared
+   string.  (Return value is non-shared so that callers can modify the
+   returned value if necessary.) */
+
+static PyObject *
+long_to_decimal_string(PyObject *aa, int addL)
+{
+    PyLongObject *scratch, *a;
+    PyObject *str;
+    Py_ssize_t strlen;
+    char *p;
+    int negative;
+
+    a = (PyLongObject *)aa;
+    if (a == NULL || !PyLong_Check(a)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    if (ABS(Py_SIZE(a)) > DECIMAL_DC_CUTOFF)
+        return long_to_decimal_string_dc(a, addL);
+    negative = Py_SIZE(a) < 0;
+
+    scratch = long_to_decimal_base(a);
+    if (scratch == NULL)
+        return NULL;
+
+    /* calculate exact length of output string, and allocate */
+    strlen = (addL != 0) + negative + decimal_base_strlen(scratch);
+    str = PyString_FromStringAndSize(NULL, strlen);
+    if (str == NULL) {
+        Py_DECREF(scratch);
+        return NULL;
+    }
+
+    /* fill the string right-to-left */
+    p = PyString_AS_STRING(str) + strlen;
+    *p = '\0';
+    if (addL)
+        *--p = 'L';
+    p = decimal_base_fill(p, scratch, 0);
+
     /* and sign */
     if (negative)
         *--p = '-';
@@ -1693,62 +1777,11 @@ long_from_binary_base(char **str, int base)
     return long_normalize(z);
 }
 
-PyObject *
-PyLong_FromString(char *str, char **pend, int base)
-{
-    int sign = 1;
-    char *start, *orig_str = str;
-    PyLongObject *z;
-    PyObject *strobj, *strrepr;
-    Py_ssize_t slen;
-
-    if ((base != 0 && base < 2) || base > 36) {
-        PyErr_SetString(PyExc_ValueError,
-                        "long() arg 2 must be >= 2 and <= 36");
-        return NULL;
-    }
-    while (*str != '\0' && isspace(Py_CHARMASK(*str)))
-        str++;
-    if (*str == '+')
-        ++str;
-    else if (*str == '-') {
-        ++str;
-        sign = -1;
-    }
-    while (*str != '\0' && isspace(Py_CHARMASK(*str)))
-        str++;
-    if (base == 0) {
-        /* No base given.  Deduce the base from the contents
-           of the string */
-        if (str[0] != '0')
-            base = 10;
-        else if (str[1] == 'x' || str[1] == 'X')
-            base = 16;
-        else if (str[1] == 'o' || str[1] == 'O')
-            base = 8;
-        else if (str[1] == 'b' || str[1] == 'B')
-            base = 2;
-        else
-            /* "old" (C-style) octal literal, still valid in
-               2.x, although illegal in 3.x */
-            base = 8;
-    }
-    /* Whether or not we were deducing the base, skip leading chars
-       as needed */
-    if (str[0] == '0' &&
-        ((base == 16 && (str[1] == 'x' || str[1] == 'X')) ||
-         (base == 8  && (str[1] == 'o' || str[1] == 'O')) ||
-         (base == 2  && (str[1] == 'b' || str[1] == 'B'))))
-        str += 2;
-
-    start = str;
-    if ((base & (base - 1)) == 0)
-        z = long_from_binary_base(&str, base);
-    else {
 /***
 Binary bases can be converted in time linear in the number of digits, because
 Python's representation base is binary.  Other bases (including decimal!) use
 the simple quadratic-time algorithm below, complicated by some speed tricks.
+Long strings are first split into pieces for it by long_from_string_dc().
 
 First some math:  the largest integer that can be expressed in N base-B digits
 is B**N-1.  Consequently, if we have an N-digit input in base B, the worst-
@@ -1787,7 +1820,7 @@ case
 
 where `N` is the number of input digits in base `B`.  This is computed via
 
-    size_z = (Py_ssize_t)((scan - str) * log_base_PyLong_BASE[base]) + 1;
+    size_z = (Py_ssize_t)(len * log_base_PyLong_BASE[base]) + 1;
 
 below.  Two numeric concerns are how much space this can waste, and whether
 the computed result can be too small.  To be concrete, assume PyLong_BASE =
@@ -1832,116 +1865,182 @@ that triggers it(!).  Instead the code was tested by artificially allocating
 just 1 digit at the start, so that the copying code was exercised for every
 digit beyond the first.
 ***/
-        register twodigits c;           /* current input character */
-        Py_ssize_t size_z;
-        int i;
-        int convwidth;
-        twodigits convmultmax, convmult;
-        digit *pz, *pzstop;
-        char* scan;
-
-        static double log_base_PyLong_BASE[37] = {0.0e0,};
-        static int convwidth_base[37] = {0,};
-        static twodigits convmultmax_base[37] = {0,};
-
-        if (log_base_PyLong_BASE[base] == 0.0) {
-            twodigits convmax = base;
-            int i = 1;
-
-            log_base_PyLong_BASE[base] = (log((double)base) /
-                                          log((double)PyLong_BASE));
-            for (;;) {
-                twodigits next = convmax * base;
-                if (next > PyLong_BASE)
-                    break;
-                convmax = next;
-                ++i;
-            }
-            convmultmax_base[base] = convmax;
-            assert(i > 0);
-            convwidth_base[base] = i;
+
+/* Convert the len digits in base base at str, which is not a power of 2. */
+
+static PyLongObject *
+long_from_non_binary_base(char *str, Py_ssize_t len, int base)
+{
+    register twodigits c;           /* current input character */
+    Py_ssize_t size_z;
+    int i;
+    int convwidth;
+    twodigits convmultmax, convmult;
+    digit *pz, *pzstop;
+    char *scan = str + len;
+    PyLongObject *z;
+
+    static double log_base_PyLong_BASE[37] = {0.0e0,};
+    static int convwidth_base[37] = {0,};
+    static twodigits convmultmax_base[37] = {0,};
+
+    if (log_base_PyLong_BASE[base] == 0.0) {
+        twodigits convmax = base;
+        int i = 1;
+
+        log_base_PyLong_BASE[base] = (log((double)base) /
+                                      log((double)PyLong_BASE));
+        for (;;) {
+            twodigits next = convmax * base;
+            if (next > PyLong_BASE)
+                break;
+            convmax = next;
+            ++i;
         }
+        convmultmax_base[base] = convmax;
+        assert(i > 0);
+        convwidth_base[base] = i;
+    }
 
-        /* Find length of the string of numeric characters. */
-        scan = str;
-        while (_PyLong_DigitValue[Py_CHARMASK(*scan)] < base)
-            ++scan;
+    /* Create a long object that can contain the largest possible
+     * integer with this base and length.  Note that there's no
+     * need to initialize z->ob_digit -- no slot is read up before
+     * being stored into.
+     */
+    size_z = (Py_ssize_t)(len * log_base_PyLong_BASE[base]) + 1;
+    /* Uncomment next line to test exceedingly rare copy code */
+    /* size_z = 1; */
+    assert(size_z > 0);
+    z = _PyLong_New(size_z);
+    if (z == NULL)
+        return NULL;
+    Py_SIZE(z) = 0;
 
-        /* Create a long object that can contain the largest possible
-         * integer with this base and length.  Note that there's no
-         * need to initialize z->ob_digit -- no slot is read up before
-         * being stored into.
-         */
-        size_z = (Py_ssize_t)((scan - str) * log_base_PyLong_BASE[base]) + 1;
-        /* Uncomment next line to test exceedingly rare copy code */
-        /* size_z = 1; */
-        assert(size_z > 0);
-        z = _PyLong_New(size_z);
-        if (z == NULL)
-            return NULL;
-        Py_SIZE(z) = 0;
+    /* `convwidth` consecutive input digits are treated as a single
+     * digit in base `convmultmax`.
+     */
+    convwidth = convwidth_base[base];
+    convmultmax = convmultmax_base[base];
+
+    /* Work ;-) */
+    while (str < scan) {
+        /* grab up to convwidth digits from the input string */
+        c = (digit)_PyLong_DigitValue[Py_CHARMASK(*str++)];
+        for (i = 1; i < convwidth && str != scan; ++i, ++str) {
+            c = (twodigits)(c *  base +
+                            _PyLong_DigitValue[Py_CHARMASK(*str)]);
+            assert(c < PyLong_BASE);
+        }
 
-        /* `convwidth` consecutive input digits are treated as a single
-         * digit in base `convmultmax`.
+        convmult = convmultmax;
+        /* Calculate the shift only if we couldn't get
+         * convwidth digits.
          */
-        convwidth = convwidth_base[base];
-        convmultmax = convmultmax_base[base];
-
-        /* Work ;-) */
-        while (str < scan) {
-            /* grab up to convwidth digits from the input string */
-            c = (digit)_PyLong_DigitValue[Py_CHARMASK(*str++)];
-            for (i = 1; i < convwidth && str != scan; ++i, ++str) {
-                c = (twodigits)(c *  base +
-                                _PyLong_DigitValue[Py_CHARMASK(*str)]);
-                assert(c < PyLong_BASE);
-            }
-
-            convmult = convmultmax;
-            /* Calculate the shift only if we couldn't get
-             * convwidth digits.
-             */
-            if (i != convwidth) {
-                convmult = base;
-                for ( ; i > 1; --i)
-                    convmult *= base;
-            }
+        if (i != convwidth) {
+            convmult = base;
+            for ( ; i > 1; --i)
+                convmult *= base;
+        }
 
-            /* Multiply z by convmult, and add c. */
-            pz = z->ob_digit;
-            pzstop = pz + Py_SIZE(z);
-            for (; pz < pzstop; ++pz) {
-                c += (twodigits)*pz * convmult;
-                *pz = (digit)(c & PyLong_MASK);
-                c >>= PyLong_SHIFT;
+        /* Multiply z by convmult, and add c. */
+        pz = z->ob_digit;
+        pzstop = pz + Py_SIZE(z);
+        for (; pz < pzstop; ++pz) {
+            c += (twodigits)*pz * convmult;
+            *pz = (digit)(c & PyLong_MASK);
+            c >>= PyLong_SHIFT;
+        }
+        /* carry off the current end? */
+        if (c) {
+            assert(c < PyLong_BASE);
+            if (Py_SIZE(z) < size_z) {
+                *pz = (digit)c;
+                ++Py_SIZE(z);
             }
-            /* carry off the current end? */
-            if (c) {
-                assert(c < PyLong_BASE);
-                if (Py_SIZE(z) < size_z) {
-                    *pz = (digit)c;
-                    ++Py_SIZE(z);
-                }
-                else {
-                    PyLongObject *tmp;
-                    /* Extremely rare.  Get more space. */
-                    assert(Py_SIZE(z) == size_z);
-                    tmp = _PyLong_New(size_z + 1);
-                    if (tmp == NULL) {
-                        Py_DECREF(z);
-                        return NULL;
-                    }
-                    memcpy(tmp->ob_digit,
-                           z->ob_digit,
-                           sizeof(digit) * size_z);
+            else {
+                PyLongObject *tmp;
+                /* Extremely rare.  Get more space. */
+                assert(Py_SIZE(z) == size_z);
+                tmp = _PyLong_New(size_z + 1);
+                if (tmp == NULL) {
                     Py_DECREF(z);
-                    z = tmp;
-                    z->ob_digit[size_z] = (digit)c;
-                    ++size_z;
+                    return NULL;
                 }
+                memcpy(tmp->ob_digit,
+                       z->ob_digit,
+                       sizeof(digit) * size_z);
+                Py_DECREF(z);
+                z = tmp;
+                z->ob_digit[size_z] = (digit)c;
+                ++size_z;
             }
         }
     }
+    return z;
+}
+
+PyObject *
+PyLong_FromString(char *str, char **pend, int base)
+{
+    int sign = 1;
+    char *start, *orig_str = str;
+    PyLongObject *z;
+    PyObject *strobj, *strrepr;
+    Py_ssize_t slen;
+
+    if ((base != 0 && base < 2) || base > 36) {
+        PyErr_SetString(PyExc_ValueError,
+                        "long() arg 2 must be >= 2 and <= 36");
+        return NULL;
+    }
+    while (*str != '\0' && isspace(Py_CHARMASK(*str)))
+        str++;
+    if (*str == '+')
+        ++str;
+    else if (*str == '-') {
+        ++str;
+        sign = -1;
+    }
+    while (*str != '\0' && isspace(Py_CHARMASK(*str)))
+        str++;
+    if (base == 0) {
+        /* No base given.  Deduce the base from the contents
+           of the string */
+        if (str[0] != '0')
+            base = 10;
+        else if (str[1] == 'x' || str[1] == 'X')
+            base = 16;
+        else if (str[1] == 'o' || str[1] == 'O')
+            base = 8;
+        else if (str[1] == 'b' || str[1] == 'B')
+            base = 2;
+        else
+            /* "old" (C-style) octal literal, still valid in
+               2.x, although illegal in 3.x */
+            base = 8;
+    }
+    /* Whether or not we were deducing the base, skip leading chars
+       as needed */
+    if (str[0] == '0' &&
+        ((base == 16 && (str[1] == 'x' || str[1] == 'X')) ||
+         (base == 8  && (str[1] == 'o' || str[1] == 'O')) ||
+         (base == 2  && (str[1] == 'b' || str[1] == 'B'))))
+        str += 2;
+
+    start = str;
+    if ((base & (base - 1)) == 0)
+        z = long_from_binary_base(&str, base);
+    else {
+        /* Find length of the string of numeric characters. */
+        char *scan = str;
+        while (_PyLong_DigitValue[Py_CHARMASK(*scan)] < base)
+            ++scan;
+        if (scan - str > STR_DC_CUTOFF)
+            z = long_from_string_dc(str, scan - str, base);
+        else
+            z = long_from_non_binary_base(str, scan - str, base);
+        str = scan;
+    }
     if (z == NULL)
         return NULL;
     if (str == start)
@@ -2671,6 +2770,459 @@ kmul_split(PyLongObject *n,
     return 0;
 }
 
+static PyLongObject *k_mul(PyLongObject *a, PyLongObject *b);
+static PyLongObject *long_shift(PyLongObject *a, Py_ssize_t n);
+
+/* The signed product of a and b, by k_mul (which squares when a == b). */
+
+static PyLongObject *
+k_mul_signed(PyLongObject *a, PyLongObject *b)
+{
+    PyLongObject *z = k_mul(a, b);
+
+    if (z != NULL && (Py_SIZE(a) ^ Py_SIZE(b)) < 0)
+        Py_SIZE(z) = -Py_SIZE(z);
+    return z;
+}
+
+/* Replace *slot with value, unless value is NULL, in which case return -1
+   and leave *slot alone. */
+
+static int
+long_replace(PyLongObject **slot, PyLongObject *value)
+{
+    if (value == NULL)
+        return -1;
+    Py_DECREF(*slot);
+    *slot = value;
+    return 0;
+}
+
+/* a / 3, for a multiple a of 3 of either sign. */
+
+static PyLongObject *
+divexact3(PyLongObject *a)
+{
+    PyLongObject *z;
+    digit rem;
+
+    z = divrem1(a, 3, &rem);
+    assert(z == NULL || rem == 0);
+    if (z != NULL && Py_SIZE(a) < 0)
+        Py_SIZE(z) = -Py_SIZE(z);
+    return z;
+}
+
+/* Set e[0:5] to the values at 0, 1, -1, -2 and infinity of the polynomial
+   x2*X**2 + x1*X + x0, where abs(n) = x2 * B**(2*size) + x1 * B**size + x0
+   and B is PyLong_BASE.  Returns 0 on success, -1 on failure. */
+
+static int
+toom3_evaluate(PyLongObject *n, Py_ssize_t size, PyLongObject *e[5])
+{
+    PyLongObject *x0 = NULL, *x1 = NULL, *x2 = NULL, *hi = NULL, *t = NULL;
+    int i;
+
+    for (i = 0; i < 5; i++)
+        e[i] = NULL;
+    if (kmul_split(n, 2 * size, &x2, &hi) < 0)
+        return -1;
+    if (kmul_split(hi, size, &x1, &x0) < 0)
+        goto fail;
+    Py_CLEAR(hi);
+
+    /* e[0] = x0, e[4] = x2, e[1] = x0 + x1 + x2, e[2] = x0 - x1 + x2 */
+    if ((t = (PyLongObject *)long_add(x0, x2)) == NULL ||
+        (e[1] = (PyLongObject *)long_add(t, x1)) == NULL ||
+        (e[2] = (PyLongObject *)long_sub(t, x1)) == NULL)
+        goto fail;
+    Py_CLEAR(t);
+
+    /* e[3] = 2*(e[2] + x2) - x0 */
+    if ((t = (PyLongObject *)long_add(e[2], x2)) == NULL ||
+        (hi = long_shift(t, 1)) == NULL ||
+        (e[3] = (PyLongObject *)long_sub(hi, x0)) == NULL)
+        goto fail;
+    Py_DECREF(t);
+    Py_DECREF(hi);
+    Py_DECREF(x1);
+    e[0] = x0;
+    e[4] = x2;
+    return 0;
+
+  fail:
+    Py_XDECREF(x0);
+    Py_XDECREF(x1);
+    Py_XDECREF(x2);
+    Py_XDECREF(hi);
+    Py_XDECREF(t);
+    for (i = 0; i < 5; i++)
+        Py_CLEAR(e[i]);
+    return -1;
+}
+
+/* Toom-Cook 3-way multiplication.  Ignores the input signs, and returns the
+ * absolute value of the product (or NULL if error).  b is the larger input,
+ * and a has more than two thirds of its digits.
+ *
+ * Both inputs are split into three pieces of shift digits and read as
+ * polynomials of degree 2 in X = PyLong_BASE**shift.  Their product, of
+ * degree 4, is found from its values at 0, 1, -1, -2 and infinity, which
+ * takes 5 multiplications of numbers a third of the size, where
+ * schoolbook polynomial multiplication would take 9.  The interpolation
+ * is the sequence of Marco Bodrato, "Towards Optimal Toom-Cook
+ * Multiplication for Univariate and Multivariate Polynomials in
+ * Characteristic 2 and 0" (2007).
+ */
+static PyLongObject *
+toom3_mul(PyLongObject *a, PyLongObject *b)
+{
+    Py_ssize_t shift = (ABS(Py_SIZE(b)) + 2) / 3;
+    PyLongObject *ea[5], *eb[5], *r[5], *t = NULL, *z = NULL;
+    int i;
+
+    for (i = 0; i < 5; i++)
+        eb[i] = r[i] = NULL;
+    if (toom3_evaluate(a, shift, ea) < 0)
+        return NULL;
+    if (a != b && toom3_evaluate(b, shift, eb) < 0)
+        goto done;
+
+    /* r[i] = ea[i] * eb[i]; for a square the evaluations are shared */
+    for (i = 0; i < 5; i++) {
+        r[i] = k_mul_signed(ea[i], a == b ? ea[i] : eb[i]);
+        if (r[i] == NULL)
+            goto done;
+    }
+
+    /* interpolate, leaving the coefficient of X**i in r[i]:
+         r3 = (r(-2) - r(1)) / 3
+         r1 = (r(1) - r(-1)) / 2
+         r2 = r(-1) - r(0)
+         r3 = (r2 - r3) / 2 + 2*r(inf)
+         r2 = r2 + r1 - r(inf)
+         r1 = r1 - r3 */
+    if (long_replace(&r[3], (PyLongObject *)long_sub(r[3], r[1])) < 0 ||
+        long_replace(&r[3], divexact3(r[3])) < 0 ||
+        long_replace(&r[1], (PyLongObject *)long_sub(r[1], r[2])) < 0 ||
+        long_replace(&r[1], long_shift(r[1], -1)) < 0 ||
+        long_replace(&r[2], (PyLongObject *)long_sub(r[2], r[0])) < 0 ||
+        long_replace(&r[3], (PyLongObject *)long_sub(r[2], r[3])) < 0 ||
+        long_replace(&r[3], long_shift(r[3], -1)) < 0 ||
+        (t = long_shift(r[4], 1)) == NULL ||
+        long_replace(&r[3], (PyLongObject *)long_add(r[3], t)) < 0 ||
+        long_replace(&r[2], (PyLongObject *)long_add(r[2], r[1])) < 0 ||
+        long_replace(&r[2], (PyLongObject *)long_sub(r[2], r[4])) < 0 ||
+        long_replace(&r[1], (PyLongObject *)long_sub(r[1], r[3])) < 0)
+        goto done;
+    Py_CLEAR(t);
+
+    /* z = (((r4*X + r3)*X + r2)*X + r1)*X + r0 */
+    z = r[4];
+    Py_INCREF(z);
+    for (i = 3; i >= 0; i--) {
+        t = long_shift(z, shift * PyLong_SHIFT);
+        Py_CLEAR(z);
+        if (t == NULL)
+            goto done;
+        z = (PyLongObject *)long_add(t, r[i]);
+        Py_CLEAR(t);
+        if (z == NULL)
+            goto done;
+    }
+    assert(Py_SIZE(z) >= 0);
+
+  done:
+    Py_XDECREF(t);
+    for (i = 0; i < 5; i++) {
+        Py_XDECREF(ea[i]);
+        Py_XDECREF(eb[i]);
+        Py_XDECREF(r[i]);
+    }
+    return z;
+}
+
+#if defined(HAVE_UINT32_T) && defined(HAVE_UINT64_T)
+
+/* Multiplication by number-theoretic transforms (NTT).
+ *
+ * The inputs are cut into coefficients of NTT_COEF_BITS bits, and their
+ * coefficients are convolved modulo three primes p = c * 2**k + 1 below
+ * 2**31, with transforms of a length n = 2**j, n <= 2**k.  Each
+ * coefficient of the product is below n * 2**(2 * NTT_COEF_BITS), which
+ * for j <= NTT_MAX_LOG2 is less than the product of the primes, so the
+ * Chinese remainder theorem gives it back from its three residues.
+ *
+ * Residues are multiplied in Montgomery's representation with R = 2**32:
+ * ntt_mont_mul(a, b) is a * b / R modulo p.  The roots of unity are kept
+ * multiplied by R, so that multiplying a residue by one needs a single
+ * ntt_mont_mul.  The forward transforms are decimations in frequency,
+ * which leave their output in bit-reversed order, and the inverse one a
+ * decimation in time that takes it in that order, so no reordering is
+ * ever needed.
+ */
+
+#define NTT_COEF_BITS 30
+#define NTT_DIGITS_PER_COEF (NTT_COEF_BITS / PyLong_SHIFT)
+#define NTT_MAX_LOG2 26
+
+typedef struct {
+    PY_UINT32_T p;      /* the prime */
+    PY_UINT32_T g;      /* a generator of the multiplicative group */
+    PY_UINT32_T pinv;   /* -1/p modulo 2**32 */
+    PY_UINT32_T r1;     /* R modulo p */
+    PY_UINT32_T r2;     /* R**2 modulo p */
+} ntt_prime;
+
+static ntt_prime ntt_primes[3] = {
+    {2013265921U, 31},  /* 15 * 2**27 + 1 */
+    {1811939329U, 13},  /* 27 * 2**26 + 1 */
+    {469762049U, 3},    /* 7 * 2**26 + 1 */
+};
+
+Py_LOCAL_INLINE(PY_UINT32_T)
+ntt_mont_mul(PY_UINT32_T a, PY_UINT32_T b, const ntt_prime *np)
+{
+    PY_UINT64_T t = (PY_UINT64_T)a * b;
+    PY_UINT32_T m = (PY_UINT32_T)t * np->pinv;
+    PY_UINT32_T u = (PY_UINT32_T)((t + (PY_UINT64_T)m * np->p) >> 32);
+
+    return u >= np->p ? u - np->p : u;
+}
+
+/* b**e modulo p, without Montgomery's representation */
+static PY_UINT32_T
+ntt_pow(PY_UINT32_T b, PY_UINT32_T e, PY_UINT32_T p)
+{
+    PY_UINT64_T x = b % p, r = 1;
+
+    for (; e; e >>= 1) {
+        if (e & 1)
+            r = r * x % p;
+        x = x * x % p;
+    }
+    return (PY_UINT32_T)r;
+}
+
+static void
+ntt_init_primes(void)
+{
+    int i, j;
+
+    for (i = 0; i < 3; i++) {
+        ntt_prime *np = &ntt_primes[i];
+        PY_UINT32_T inv = np->p;
+
+        if (np->pinv != 0)
+            continue;
+        /* Newton's iteration doubles the number of correct low bits */
+        for (j = 0; j < 5; j++)
+            inv *= 2 - np->p * inv;
+        np->r1 = (PY_UINT32_T)(((PY_UINT64_T)1 << 32) % np->p);
+        np->r2 = (PY_UINT32_T)((PY_UINT64_T)np->r1 * np->r1 % np->p);
+        np->pinv = -inv;
+    }
+}
+
+/* Set roots[m + j] to w**(j * n / (2*m)) times R, for each power of two
+   m < n and 0 <= j < m, where w is a primitive n-th root of unity. */
+
+static void
+ntt_roots(PY_UINT32_T *roots, Py_ssize_t n, PY_UINT32_T w,
+          const ntt_prime *np)
+{
+    Py_ssize_t half = n / 2, m, j;
+
+    w = ntt_mont_mul(w, np->r2, np);
+    roots[half] = np->r1;
+    for (j = 1; j < half; j++)
+        roots[half + j] = ntt_mont_mul(roots[half + j - 1], w, np);
+    for (m = half / 2; m >= 1; m /= 2)
+        for (j = 0; j < m; j++)
+            roots[m + j] = roots[2*m + 2*j];
+}
+
+static void
+ntt_forward(PY_UINT32_T *x, Py_ssize_t n, const PY_UINT32_T *roots,
+            const ntt_prime *np)
+{
+    const PY_UINT32_T p = np->p;
+    Py_ssize_t m, i, j;
+
+    for (m = n / 2; m >= 1; m /= 2) {
+        for (i = 0; i < n; i += 2 * m) {
+            PY_UINT32_T *x0 = x + i, *x1 = x + i + m;
+            for (j = 0; j < m; j++) {
+                PY_UINT32_T u = x0[j], v = x1[j], s = u + v;
+                x0[j] = s >= p ? s - p : s;
+                x1[j] = ntt_mont_mul(u >= v ? u - v : u + p - v,
+                                     roots[m + j], np);
+            }
+        }
+    }
+}
+
+static void
+ntt_inverse(PY_UINT32_T *x, Py_ssize_t n, const PY_UINT32_T *roots,
+            const ntt_prime *np)
+{
+    const PY_UINT32_T p = np->p;
+    Py_ssize_t m, i, j;
+
+    for (m = 1; m < n; m *= 2) {
+        for (i = 0; i < n; i += 2 * m) {
+            PY_UINT32_T *x0 = x + i, *x1 = x + i + m;
+            for (j = 0; j < m; j++) {
+                PY_UINT32_T u = x0[j], v, s;
+                v = ntt_mont_mul(x1[j], roots[m + j], np);
+                s = u + v;
+                x0[j] = s >= p ? s - p : s;
+                x1[j] = u >= v ? u - v : u + p - v;
+            }
+        }
+    }
+}
+
+/* Set x[0:n] to the coefficients of abs(a) modulo p, padded with zeros. */
+
+static void
+ntt_load(PY_UINT32_T *x, Py_ssize_t n, PyLongObject *a, PY_UINT32_T p)
+{
+    Py_ssize_t size = ABS(Py_SIZE(a)), i, j;
+
+    for (i = 0; i * NTT_DIGITS_PER_COEF < size; i++) {
+        PY_UINT32_T c = 0;
+        for (j = NTT_DIGITS_PER_COEF; --j >= 0; )
+            if (i * NTT_DIGITS_PER_COEF + j < size)
+                c = (c << PyLong_SHIFT) |
+                    a->ob_digit[i * NTT_DIGITS_PER_COEF + j];
+        x[i] = c % p;
+    }
+    for (; i < n; i++)
+        x[i] = 0;
+}
+
+/* NTT multiplication.  Ignores the input signs, and returns the absolute
+ * value of the product (or NULL if error).  The product must have at most
+ * 2**NTT_MAX_LOG2 coefficients.
+ */
+static PyLongObject *
+ntt_mul(PyLongObject *a, PyLongObject *b)
+{
+    const PY_UINT32_T mask = ((PY_UINT32_T)1 << NTT_COEF_BITS) - 1;
+    const ntt_prime *p0 = &ntt_primes[0], *p1 = &ntt_primes[1];
+    const ntt_prime *p2 = &ntt_primes[2];
+    Py_ssize_t na, nb, nz, n, i, j;
+    PY_UINT32_T *res, *tmp, *roots, *iroots, inv01, inv012, p01_2;
+    PY_UINT64_T p01, carry;
+    PyLongObject *z;
+    int k;
+
+    na = (ABS(Py_SIZE(a)) + NTT_DIGITS_PER_COEF - 1) / NTT_DIGITS_PER_COEF;
+    nb = (ABS(Py_SIZE(b)) + NTT_DIGITS_PER_COEF - 1) / NTT_DIGITS_PER_COEF;
+    nz = na + nb - 1;
+    for (n = 2; n < nz; n *= 2)
+        ;
+    assert(n <= (Py_ssize_t)1 << NTT_MAX_LOG2);
+
+    z = _PyLong_New((na + nb) * NTT_DIGITS_PER_COEF);
+    if (z == NULL)
+        return NULL;
+    /* three residues of the product, the second input and the roots */
+    res = PyMem_New(PY_UINT32_T, 3 * n);
+    tmp = a == b ? NULL : PyMem_New(PY_UINT32_T, n);
+    roots = PyMem_New(PY_UINT32_T, n);
+    iroots = PyMem_New(PY_UINT32_T, n);
+    if (res == NULL || (tmp == NULL && a != b) ||
+        roots == NULL || iroots == NULL) {
+        PyErr_NoMemory();
+        Py_CLEAR(z);
+        goto done;
+    }
+
+    ntt_init_primes();
+    for (k = 0; k < 3; k++) {
+        const ntt_prime *np = &ntt_primes[k];
+        PY_UINT32_T *x = res + k * n, w, scale;
+
+        w = ntt_pow(np->g, (np->p - 1) / (PY_UINT32_T)n, np->p);
+        ntt_roots(roots, n, w, np);
+        ntt_roots(iroots, n, ntt_pow(w, np->p - 2, np->p), np);
+
+        ntt_load(x, n, a, np->p);
+        ntt_forward(x, n, roots, np);
+        if (a == b) {
+            for (i = 0; i < n; i++)
+                x[i] = ntt_mont_mul(x[i], x[i], np);
+        }
+        else {
+            ntt_load(tmp, n, b, np->p);
+            ntt_forward(tmp, n, roots, np);
+            for (i = 0; i < n; i++)
+                x[i] = ntt_mont_mul(x[i], tmp[i], np);
+        }
+        ntt_inverse(x, n, iroots, np);
+
+        /* the products lost a factor R, and the inverse transform
+           multiplied by n: multiply by R**2 / n to undo both */
+        scale = ntt_pow((PY_UINT32_T)n, np->p - 2, np->p);
+        scale = (PY_UINT32_T)((PY_UINT64_T)scale * np->r2 % np->p);
+        for (i = 0; i < nz; i++)
+            x[i] = ntt_mont_mul(x[i], scale, np);
+
+        SIGCHECK({
+                Py_CLEAR(z);
+                goto done;
+            });
+    }
+
+    /* Garner's algorithm: the coefficient with residues r0, r1, r2 is
+       r0 + p0*t1 + p0*p1*t2, for t1 < p1 and t2 < p2 */
+    inv01 = ntt_pow(p0->p % p1->p, p1->p - 2, p1->p);
+    p01 = (PY_UINT64_T)p0->p * p1->p;
+    p01_2 = (PY_UINT32_T)(p01 % p2->p);
+    inv012 = ntt_pow(p01_2, p2->p - 2, p2->p);
+    carry = 0;
+    for (i = 0; i < na + nb; i++) {
+        PY_UINT64_T lo = 0, mid = 0, hi = 0, c;
+
+        if (i < nz) {
+            PY_UINT32_T r0 = res[i], r1 = res[n + i], r2 = res[2*n + i];
+            PY_UINT64_T t1, t2, x01;
+
+            t1 = (PY_UINT64_T)((r1 + p1->p - r0 % p1->p) % p1->p) *
+                inv01 % p1->p;
+            x01 = r0 + p0->p * t1;
+            t2 = (r2 + p2->p - x01 % p2->p) % p2->p * inv012 % p2->p;
+            /* x01 + p01*t2 is lo + mid * 2**30 + hi * 2**60 */
+            lo = x01 + t2 * (p01 & mask);
+            mid = (lo >> NTT_COEF_BITS) + t2 * (p01 >> NTT_COEF_BITS);
+            lo &= mask;
+            hi = mid >> NTT_COEF_BITS;
+            mid &= mask;
+        }
+        /* add the carry, which stays below 2**57 */
+        c = lo + (carry & mask);
+        carry = mid + (carry >> NTT_COEF_BITS) + (c >> NTT_COEF_BITS) +
+            (hi << NTT_COEF_BITS);
+        for (j = 0; j < NTT_DIGITS_PER_COEF; j++) {
+            z->ob_digit[i * NTT_DIGITS_PER_COEF + j] = (digit)(c & PyLong_MASK);
+            c >>= PyLong_SHIFT;
+        }
+    }
+    assert(carry == 0);
+    z = long_normalize(z);
+
+  done:
+    PyMem_Free(res);
+    PyMem_Free(tmp);
+    PyMem_Free(roots);
+    PyMem_Free(iroots);
+    return z;
+}
+
+#endif /* HAVE_UINT32_T && HAVE_UINT64_T */
+
 static PyLongObject *k_lopsided_mul(PyLongObject *a, PyLongObject *b);
 
 /* Karatsuba multiplication.  Ignores the input signs, and returns the
@@ -2721,6 +3273,15 @@ k_mul(PyLongObject *a, PyLongObject *b)
             return x_mul(a, b);
     }
 
+#if defined(HAVE_UINT32_T) && defined(HAVE_UINT64_T)
+    /* Big numbers are multiplied by transforms, which don't mind
+     * unbalanced sizes, unless the product is too long for them.
+     */
+    if (asize > NTT_CUTOFF && (asize + bsize) / NTT_DIGITS_PER_COEF <
+        (Py_ssize_t)1 << NTT_MAX_LOG2)
+        return ntt_mul(a, b);
+#endif
+
     /* If a is small compared to b, splitting on b gives a degenerate
      * case with ah==0, and Karatsuba may be (even much) less efficient
      * than "grade school" then.  However, we can still win, by viewing
@@ -2730,6 +3291,11 @@ k_mul(PyLongObject *a, PyLongObject *b)
     if (2 * asize <= bsize)
         return k_lopsided_mul(a, b);
 
+    /* Toom-Cook needs a to fill more than two of the three pieces of b. */
+    i = a == b ? TOOM3_SQUARE_CUTOFF : TOOM3_CUTOFF;
+    if (asize > i && 3 * asize > 2 * bsize)
+        return toom3_mul(a, b);
+
     /* Split a & b into hi & lo pieces. */
     shift = bsize >> 1;
     if (kmul_split(a, shift, &ah, &al) < 0) goto fail;
@@ -2971,6 +3537,411 @@ long_mul(PyLongObject *v, PyLongObject *w)
     return (PyObject *)z;
 }
 
+/* Subquadratic conversion between longs and strings in bases that are not
+   powers of 2.  The number is split in halves at a power base**(n * 2**i)
+   of the base, n being the number of characters converted at once by the
+   quadratic code, and both halves are converted recursively.  Joining the
+   halves of a string takes a multiplication by the power; splitting a long
+   takes a division, done as a multiplication by a precomputed reciprocal of
+   the power (Barrett reduction).  Either way, each level of the recursion
+   costs a few multiplications, which k_mul() does in subquadratic time. */
+
+#define LONG_DC_MAX_LEVELS (8 * SIZEOF_SIZE_T)
+
+/* the powers base**(n * 2**i) for 0 <= i < levels, and, for splitting, their
+   bit lengths and reciprocals */
+typedef struct {
+    int levels;
+    PyLongObject *pow[LONG_DC_MAX_LEVELS];
+    PyLongObject *inv[LONG_DC_MAX_LEVELS];
+    Py_ssize_t bits[LONG_DC_MAX_LEVELS];
+} long_dc_powers;
+
+/* forward */
+static PyObject *long_rshift(PyLongObject *, PyLongObject *);
+static PyObject *long_lshift(PyObject *, PyObject *);
+static PyObject *long_pow(PyObject *, PyObject *, PyObject *);
+static int l_divmod(PyLongObject *, PyLongObject *,
+                    PyLongObject **, PyLongObject **);
+
+/* Return a shifted left by n bits, or right by -n bits. */
+
+static PyLongObject *
+long_shift(PyLongObject *a, Py_ssize_t n)
+{
+    PyObject *count, *z;
+
+    count = PyLong_FromSsize_t(n < 0 ? -n : n);
+    if (count == NULL)
+        return NULL;
+    if (n < 0)
+        z = long_rshift(a, (PyLongObject *)count);
+    else
+        z = long_lshift((PyObject *)a, count);
+    Py_DECREF(count);
+    return (PyLongObject *)z;
+}
+
+/* Replace *pa with *pa + n * b, or with *pa + n if b is NULL.  On error,
+   *pa is cleared and -1 is returned. */
+
+static int
+long_inplace_addmul(PyLongObject **pa, PyLongObject *b, long n)
+{
+    PyLongObject *t, *z;
+
+    t = (PyLongObject *)PyLong_FromLong(n);
+    if (t == NULL)
+        goto error;
+    if (b != NULL) {
+        z = (PyLongObject *)long_mul(t, b);
+        Py_DECREF(t);
+        if (z == NULL)
+            goto error;
+        t = z;
+    }
+    z = (PyLongObject *)long_add(*pa, t);
+    Py_DECREF(t);
+    if (z == NULL)
+        goto error;
+    Py_DECREF(*pa);
+    *pa = z;
+    return 0;
+
+  error:
+    Py_CLEAR(*pa);
+    return -1;
+}
+
+/* Return floor(2**(2*k) / p), where p has exactly k bits, give or take a
+   few units.  Above RECIPROCAL_CUTOFF bits, y = long_reciprocal(ph, h) for
+   the leading h bits ph of p gives x = y << (k - h) with a relative error
+   around 2**-h, which one step of Newton's method squares:
+
+     x += x * (2**(2*k) - p*x) >> (2*k)
+        = y * (2**(k+h) - p*y) >> (2*h)
+
+   Only the leading bits of 2**(k+h) - p*y, which has about k bits, are
+   needed for that. */
+
+static PyLongObject *
+long_reciprocal(PyLongObject *p, Py_ssize_t k)
+{
+    PyLongObject *x = NULL, *y = NULL, *t = NULL, *e = NULL;
+    Py_ssize_t h;
+
+    t = (PyLongObject *)PyLong_FromLong(1L);
+    if (t == NULL)
+        return NULL;
+    if (k <= RECIPROCAL_CUTOFF) {
+        e = long_shift(t, 2 * k);
+        Py_DECREF(t);
+        if (e == NULL)
+            return NULL;
+        if (l_divmod(e, p, &x, NULL) < 0)
+            x = NULL;
+        Py_DECREF(e);
+        return x;
+    }
+
+    h = k / 2 + 16;
+    e = long_shift(t, k + h);
+    Py_CLEAR(t);
+    if (e == NULL)
+        goto error;
+    t = long_shift(p, h - k);
+    if (t == NULL)
+        goto error;
+    y = long_reciprocal(t, h);
+    Py_CLEAR(t);
+    if (y == NULL)
+        goto error;
+    t = (PyLongObject *)long_mul(p, y);
+    if (t == NULL || long_inplace_addmul(&e, t, -1L) < 0)
+        goto error;
+    Py_CLEAR(t);
+    t = long_shift(e, h - k);
+    Py_CLEAR(e);
+    if (t == NULL)
+        goto error;
+    e = (PyLongObject *)long_mul(y, t);
+    Py_CLEAR(t);
+    if (e == NULL)
+        goto error;
+    t = long_shift(e, k - 3 * h);
+    Py_CLEAR(e);
+    if (t == NULL)
+        goto error;
+    x = long_shift(y, k - h);
+    if (x == NULL || long_inplace_addmul(&x, t, 1L) < 0)
+        goto error;
+    Py_DECREF(t);
+    Py_DECREF(y);
+    return x;
+
+  error:
+    Py_XDECREF(t);
+    Py_XDECREF(e);
+    Py_XDECREF(y);
+    Py_XDECREF(x);
+    return NULL;
+}
+
+/* Set *pq, *pr to divmod(a, p), for 0 <= a < p**2, where p has k bits
+   and inv = long_reciprocal(p, k) (Barrett's reduction).  pq may be NULL
+   if the quotient isn't wanted. */
+
+static int
+long_divmod_reciprocal(PyLongObject *a, PyLongObject *p, PyLongObject *inv,
+                       Py_ssize_t k, PyLongObject **pq, PyLongObject **pr)
+{
+    PyLongObject *q, *r, *t;
+
+    /* q = ((a >> (k - 1)) * inv) >> (k + 1) is within a few units of the
+       quotient; for an exact inv, it would be at most 2 too small */
+    t = long_shift(a, 1 - k);
+    if (t == NULL)
+        return -1;
+    q = (PyLongObject *)long_mul(t, inv);
+    Py_DECREF(t);
+    if (q == NULL)
+        return -1;
+    t = long_shift(q, -1 - k);
+    Py_DECREF(q);
+    if (t == NULL)
+        return -1;
+    q = t;
+    t = (PyLongObject *)long_mul(q, p);
+    if (t == NULL) {
+        Py_DECREF(q);
+        return -1;
+    }
+    r = (PyLongObject *)long_sub(a, t);
+    Py_DECREF(t);
+    if (r == NULL) {
+        Py_DECREF(q);
+        return -1;
+    }
+    while (Py_SIZE(r) < 0) {
+        if (long_inplace_addmul(&q, NULL, -1L) < 0 ||
+            long_inplace_addmul(&r, p, 1L) < 0)
+            goto error;
+    }
+    while (long_compare(r, p) >= 0) {
+        if (long_inplace_addmul(&q, NULL, 1L) < 0 ||
+            long_inplace_addmul(&r, p, -1L) < 0)
+            goto error;
+    }
+    if (pq != NULL)
+        *pq = q;
+    else
+        Py_DECREF(q);
+    *pr = r;
+    return 0;
+
+  error:
+    Py_XDECREF(q);
+    Py_XDECREF(r);
+    return -1;
+}
+
+static void
+long_dc_powers_clear(long_dc_powers *pw)
+{
+    int i;
+
+    for (i = 0; i < pw->levels; i++) {
+        Py_XDECREF(pw->pow[i]);
+        Py_XDECREF(pw->inv[i]);
+    }
+    pw->levels = 0;
+}
+
+/* Fill in pw with the first levels powers base**(n * 2**i), and their
+   reciprocals if split is true. */
+
+static int
+long_dc_powers_init(long_dc_powers *pw, int base, Py_ssize_t n,
+                    int levels, int split)
+{
+    PyObject *b, *e;
+    int i;
+
+    assert(levels <= LONG_DC_MAX_LEVELS);
+    pw->levels = 0;
+    b = PyLong_FromLong(base);
+    e = PyLong_FromSsize_t(n);
+    for (i = 0; i < levels; i++) {
+        pw->pow[i] = pw->inv[i] = NULL;
+        pw->levels = i + 1;
+        if (i == 0) {
+            if (b == NULL || e == NULL)
+                goto error;
+            pw->pow[i] = (PyLongObject *)long_pow(b, e, Py_None);
+        }
+        else
+            pw->pow[i] = (PyLongObject *)long_mul(pw->pow[i-1],
+                                                  pw->pow[i-1]);
+        if (pw->pow[i] == NULL)
+            goto error;
+        if (split) {
+            pw->bits[i] = (Py_ssize_t)_PyLong_NumBits((PyObject *)pw->pow[i]);
+            if (pw->bits[i] == -1)
+                goto error;
+            pw->inv[i] = long_reciprocal(pw->pow[i], pw->bits[i]);
+            if (pw->inv[i] == NULL)
+                goto error;
+        }
+    }
+    Py_XDECREF(b);
+    Py_XDECREF(e);
+    return 0;
+
+  error:
+    Py_XDECREF(b);
+    Py_XDECREF(e);
+    long_dc_powers_clear(pw);
+    return -1;
+}
+
+/* Write the decimal digits of a, 0 <= a < 10**(DECIMAL_DC_LEAF * 2**i),
+   at *pp and advance it.  If pad is true, a is written with leading zeros
+   to exactly DECIMAL_DC_LEAF * 2**i digits. */
+
+static int
+long_to_decimal_dc_fill(PyLongObject *a, long_dc_powers *pw, int i,
+                        int pad, char **pp)
+{
+    PyLongObject *q, *r;
+    int res;
+
+    if (i == 0) {
+        PyLongObject *scratch = long_to_decimal_base(a);
+        Py_ssize_t width;
+
+        if (scratch == NULL)
+            return -1;
+        width = pad ? DECIMAL_DC_LEAF : decimal_base_strlen(scratch);
+        *pp += width;
+        decimal_base_fill(*pp, scratch, width);
+        Py_DECREF(scratch);
+        return 0;
+    }
+    if (!pad && long_compare(a, pw->pow[i-1]) < 0)
+        return long_to_decimal_dc_fill(a, pw, i - 1, 0, pp);
+    if (long_divmod_reciprocal(a, pw->pow[i-1], pw->inv[i-1],
+                               pw->bits[i-1], &q, &r) < 0)
+        return -1;
+    res = long_to_decimal_dc_fill(q, pw, i - 1, pad, pp);
+    if (res == 0)
+        res = long_to_decimal_dc_fill(r, pw, i - 1, 1, pp);
+    Py_DECREF(q);
+    Py_DECREF(r);
+    return res;
+}
+
+static PyObject *
+long_to_decimal_string_dc(PyLongObject *a, int addL)
+{
+    PyLongObject *abs_a;
+    PyObject *str;
+    long_dc_powers pw;
+    size_t nbits;
+    Py_ssize_t ndigits;
+    int levels, negative = Py_SIZE(a) < 0;
+    char *p;
+
+    nbits = _PyLong_NumBits((PyObject *)a);
+    if (nbits == (size_t)-1 && PyErr_Occurred())
+        return NULL;
+    /* a < 2**nbits <= 10**ndigits */
+    if (nbits / 3 > PY_SSIZE_T_MAX - 4) {
+        PyErr_SetString(PyExc_OverflowError,
+                        "long is too large to format");
+        return NULL;
+    }
+    ndigits = (Py_ssize_t)(nbits * 0.30103) + 1;
+    levels = 0;
+    while (((Py_ssize_t)DECIMAL_DC_LEAF << levels) < ndigits)
+        levels++;
+
+    abs_a = (PyLongObject *)_PyLong_Copy(a);
+    if (abs_a == NULL)
+        return NULL;
+    Py_SIZE(abs_a) = ABS(Py_SIZE(abs_a));
+    str = PyString_FromStringAndSize(NULL, negative + ndigits + 1);
+    if (str == NULL ||
+        long_dc_powers_init(&pw, 10, DECIMAL_DC_LEAF, levels, 1) < 0) {
+        Py_XDECREF(str);
+        Py_DECREF(abs_a);
+        return NULL;
+    }
+
+    p = PyString_AS_STRING(str);
+    if (negative)
+        *p++ = '-';
+    if (long_to_decimal_dc_fill(abs_a, &pw, levels, 0, &p) < 0)
+        Py_CLEAR(str);
+    else {
+        if (addL)
+            *p++ = 'L';
+        _PyString_Resize(&str, p - PyString_AS_STRING(str));
+    }
+    long_dc_powers_clear(&pw);
+    Py_DECREF(abs_a);
+    return str;
+}
+
+/* Convert the len digits at str, in base base, where
+   len <= STR_DC_LEAF * 2**i. */
+
+static PyLongObject *
+long_from_string_dc_part(char *str, Py_ssize_t len, int base,
+                         long_dc_powers *pw, int i)
+{
+    PyLongObject *hi, *lo, *z;
+    Py_ssize_t lolen;
+
+    if (i == 0)
+        return long_from_non_binary_base(str, len, base);
+    lolen = (Py_ssize_t)STR_DC_LEAF << (i - 1);
+    if (len <= lolen)
+        return long_from_string_dc_part(str, len, base, pw, i - 1);
+    hi = long_from_string_dc_part(str, len - lolen, base, pw, i - 1);
+    if (hi == NULL)
+        return NULL;
+    z = (PyLongObject *)long_mul(hi, pw->pow[i-1]);
+    Py_DECREF(hi);
+    if (z == NULL)
+        return NULL;
+    lo = long_from_string_dc_part(str + len - lolen, lolen, base, pw, i - 1);
+    if (lo == NULL) {
+        Py_DECREF(z);
+        return NULL;
+    }
+    hi = z;
+    z = (PyLongObject *)long_add(hi, lo);
+    Py_DECREF(hi);
+    Py_DECREF(lo);
+    return z;
+}
+
+static PyLongObject *
+long_from_string_dc(char *str, Py_ssize_t len, int base)
+{
+    PyLongObject *z;
+    long_dc_powers pw;
+    int levels = 0;
+
+    while (((Py_ssize_t)STR_DC_LEAF << levels) < len)
+        levels++;
+    if (long_dc_powers_init(&pw, base, STR_DC_LEAF, levels, 0) < 0)
+        return NULL;
+    z = long_from_string_dc_part(str, len, base, &pw, levels);
+    long_dc_powers_clear(&pw);
+    return z;
+}
+
 /* The / and % operators are now defined in terms of divmod().
    The expression a mod b has the value a - b*floor(a/b).
    The long_divrem function gives the remainder after division of
@@ -3384,6 +4355,10 @@ long_pow(PyObject *v, PyObject *w, PyObject *x)
     Py_ssize_t i, j, k;             /* counters */
     PyLongObject *temp = NULL;
 
+    /* Reciprocal of a big modulus, and its number of bits. */
+    PyLongObject *cinv = NULL;
+    Py_ssize_t cbits = 0;
+
     /* 5-ary values.  If the exponent is large enough, table is
      * precomputed so that table[i] == a**i % c for i in range(32).
      */
@@ -3456,16 +4431,27 @@ long_pow(PyObject *v, PyObject *w, PyObject *x)
             goto Done;
         }
 
-        /* if base < 0:
+        /* if base < 0 or base >= modulus:
                base = base % modulus
-           Having the base positive just makes things easier. */
-        if (Py_SIZE(a) < 0) {
+           Having the base positive and reduced just makes things easier. */
+        if (Py_SIZE(a) < 0 || long_compare(a, c) >= 0) {
             if (l_divmod(a, c, NULL, &temp) < 0)
                 goto Error;
             Py_DECREF(a);
             a = temp;
             temp = NULL;
         }
+
+        /* Products of reduced values are below modulus**2, which is all
+           Barrett's reduction needs. */
+        if (Py_SIZE(c) > BARRETT_CUTOFF) {
+            cbits = (Py_ssize_t)_PyLong_NumBits((PyObject *)c);
+            if (cbits == -1)
+                goto Error;
+            cinv = long_reciprocal(c, cbits);
+            if (cinv == NULL)
+                goto Error;
+        }
     }
 
     /* At this point a, b, and c are guaranteed non-negative UNLESS
@@ -3481,7 +4467,10 @@ long_pow(PyObject *v, PyObject *w, PyObject *x)
 #define REDUCE(X)                                       \
     do {                                                \
         if (c != NULL) {                                \
-            if (l_divmod(X, c, NULL, &temp) < 0)        \
+            if (cinv != NULL ?                          \
+                long_divmod_reciprocal(X, c, cinv,      \
+                    cbits, NULL, &temp) < 0 :           \
+                l_divmod(X, c, NULL, &temp) < 0)        \
                 goto Error;                             \
             Py_XDECREF(X);                              \
             X = temp;                                   \
@@ -3559,6 +4548,7 @@ long_pow(PyObject *v, PyObject *w, PyObject *x)
     Py_DECREF(a);
     Py_DECREF(b);
     Py_XDECREF(c);
+    Py_XDECREF(cinv);
     Py_XDECREF(temp);
     return (PyObject *)z;
 }
@@ -4106,7 +5096,7 @@ long_sizeof(PyLongObject *v)
 {
     Py_ssize_t res;
 
-    res = v->ob_type->tp_basicsize + ABS(Py_SIZE(v))*sizeof(digit);
+    res = Py_TYPE(v)->tp_basicsize + ABS(Py_SIZE(v))*sizeof(digit);
     return PyInt_FromSsize_t(res);
 }
 
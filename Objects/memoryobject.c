@@ -617,7 +617,7 @@ memory_subscript(PyMemoryViewObject *self, PyObject *key)
     }
     PyErr_Format(PyExc_TypeError,
         "cannot index memory using \"%.200s\"", 
-        key->ob_type->tp_name);
+        Py_TYPE(key)->tp_name);
     return NULL;
 }
 
@@ -674,7 +674,7 @@ memory_ass_sub(PyMemoryViewObject *self, PyObject *key, PyObject *value)
     else {
         PyErr_Format(PyExc_TypeError,
             "cannot index memory using \"%.200s\"", 
-            key->ob_type->tp_name);
+            Py_TYPE(key)->tp_name);
         return -1;
     }
     if (PyObject_GetBuffer(value, &srcview, PyBUF_CONTIG_RO) == -1) {
@@ -686,7 +686,7 @@ memory_ass_sub(PyMemoryViewObject *self, PyObject *key, PyObject *value)
     if (srcview.itemsize != view->itemsize) {
         PyErr_Format(PyExc_TypeError,
             "mismatching item sizes for \"%.200s\" and \"%.200s\"", 
-            view->obj->ob_type->tp_name, srcview.obj->ob_type->tp_name);
+            Py_TYPE(view->obj)->tp_name, Py_TYPE(srcview.obj)->tp_name);
         goto _error;
     }
     bytelen = len * view->itemsize;
@@ -206,7 +206,7 @@ meth_repr(PyCFunctionObject *m)
                                    m->m_ml->ml_name);
     return PyString_FromFormat("<built-in method %s of %s object at %p>",
                                m->m_ml->ml_name,
-                               m->m_self->ob_type->tp_name,
+                               Py_TYPE(m->m_self)->tp_name,
                                m->m_self);
 }
 
@@ -359,7 +359,7 @@ Py_FindMethodInChain(PyMethodChain *chain, PyObject *self, const char *name)
             return listmethodchain(chain);
         }
         if (strcmp(name, "__doc__") == 0) {
-            const char *doc = self->ob_type->tp_doc;
+            const char *doc = Py_TYPE(self)->tp_doc;
             if (doc != NULL)
                 return PyString_FromString(doc);
         }
@@ -17,15 +17,12 @@ _Py_GetRefTotal(void)
 {
     PyObject *o;
     Py_ssize_t total = _Py_RefTotal;
-    /* ignore the references to the dummy object of the dicts and sets
+    /* ignore the references to the dummy object of the sets
        because they are not reliable and not useful (now that the
        hash table code is well-tested) */
-    o = _PyDict_Dummy();
-    if (o != NULL)
-        total -= o->ob_refcnt;
     o = _PySet_Dummy();
     if (o != NULL)
-        total -= o->ob_refcnt;
+        total -= Py_REFCNT(o);
     return total;
 }
 #endif /* Py_REF_DEBUG */
@@ -197,7 +194,7 @@ _Py_NegativeRefcount(const char *fname, int lineno, PyObject *op)
     PyOS_snprintf(buf, sizeof(buf),
                   "%s:%i object at %p has negative ref count "
                   "%" PY_FORMAT_SIZE_T "d",
-                  fname, lineno, op, op->ob_refcnt);
+                  fname, lineno, op, Py_REFCNT(op));
     Py_FatalError(buf);
 }
 
@@ -291,12 +288,12 @@ internal_print(PyObject *op, FILE *fp, int flags, int nesting)
         Py_END_ALLOW_THREADS
     }
     else {
-        if (op->ob_refcnt <= 0)
+        if (Py_REFCNT(op) <= 0)
             /* XXX(twouters) cast refcount to long until %zd is
                universally available */
             Py_BEGIN_ALLOW_THREADS
             fprintf(fp, "<refcnt %ld at %p>",
-                (long)op->ob_refcnt, op);
+                (long)Py_REFCNT(op), op);
             Py_END_ALLOW_THREADS
         else if (Py_TYPE(op)->tp_print == NULL) {
             PyObject *s;
@@ -356,7 +353,7 @@ void _PyObject_Dump(PyObject* op)
             "refcount: %ld\n"
             "address : %p\n",
             Py_TYPE(op)==NULL ? "NULL" : Py_TYPE(op)->tp_name,
-            (long)op->ob_refcnt,
+            (long)Py_REFCNT(op),
             op);
     }
 }
@@ -606,21 +603,21 @@ try_rich_compare(PyObject *v, PyObject *w, int op)
     richcmpfunc f;
     PyObject *res;
 
-    if (v->ob_type != w->ob_type &&
-        PyType_IsSubtype(w->ob_type, v->ob_type) &&
-        (f = RICHCOMPARE(w->ob_type)) != NULL) {
+    if (Py_TYPE(v) != Py_TYPE(w) &&
+        PyType_IsSubtype(Py_TYPE(w), Py_TYPE(v)) &&
+        (f = RICHCOMPARE(Py_TYPE(w))) != NULL) {
         res = (*f)(w, v, _Py_SwappedOp[op]);
         if (res != Py_NotImplemented)
             return res;
         Py_DECREF(res);
     }
-    if ((f = RICHCOMPARE(v->ob_type)) != NULL) {
+    if ((f = RICHCOMPARE(Py_TYPE(v))) != NULL) {
         res = (*f)(v, w, op);
         if (res != Py_NotImplemented)
             return res;
         Py_DECREF(res);
     }
-    if ((f = RICHCOMPARE(w->ob_type)) != NULL) {
+    if ((f = RICHCOMPARE(Py_TYPE(w))) != NULL) {
         return (*f)(w, v, _Py_SwappedOp[op]);
     }
     res = Py_NotImplemented;
@@ -641,7 +638,7 @@ try_rich_compare_bool(PyObject *v, PyObject *w, int op)
     PyObject *res;
     int ok;
 
-    if (RICHCOMPARE(v->ob_type) == NULL && RICHCOMPARE(w->ob_type) == NULL)
+    if (RICHCOMPARE(Py_TYPE(v)) == NULL && RICHCOMPARE(Py_TYPE(w)) == NULL)
         return 2; /* Shortcut, avoid INCREF+DECREF */
     res = try_rich_compare(v, w, op);
     if (res == NULL)
@@ -673,7 +670,7 @@ try_rich_to_3way_compare(PyObject *v, PyObject *w)
     };
     int i;
 
-    if (RICHCOMPARE(v->ob_type) == NULL && RICHCOMPARE(w->ob_type) == NULL)
+    if (RICHCOMPARE(Py_TYPE(v)) == NULL && RICHCOMPARE(Py_TYPE(w)) == NULL)
         return 2; /* Shortcut */
 
     for (i = 0; i < 3; i++) {
@@ -704,21 +701,21 @@ try_3way_compare(PyObject *v, PyObject *w)
     /* Comparisons involving instances are given to instance_compare,
        which has the same return conventions as this function. */
 
-    f = v->ob_type->tp_compare;
+    f = Py_TYPE(v)->tp_compare;
     if (PyInstance_Check(v))
         return (*f)(v, w);
     if (PyInstance_Check(w))
-        return (*w->ob_type->tp_compare)(v, w);
+        return (*Py_TYPE(w)->tp_compare)(v, w);
 
     /* If both have the same (non-NULL) tp_compare, use it. */
-    if (f != NULL && f == w->ob_type->tp_compare) {
+    if (f != NULL && f == Py_TYPE(w)->tp_compare) {
         c = (*f)(v, w);
         return adjust_tp_compare(c);
     }
 
     /* If either tp_compare is _PyObject_SlotCompare, that's safe. */
     if (f == _PyObject_SlotCompare ||
-        w->ob_type->tp_compare == _PyObject_SlotCompare)
+        Py_TYPE(w)->tp_compare == _PyObject_SlotCompare)
         return _PyObject_SlotCompare(v, w);
 
     /* If we're here, v and w,
@@ -735,8 +732,8 @@ try_3way_compare(PyObject *v, PyObject *w)
         return -2;
     if (c > 0)
         return 2;
-    f = v->ob_type->tp_compare;
-    if (f != NULL && f == w->ob_type->tp_compare) {
+    f = Py_TYPE(v)->tp_compare;
+    if (f != NULL && f == Py_TYPE(w)->tp_compare) {
         c = (*f)(v, w);
         Py_DECREF(v);
         Py_DECREF(w);
@@ -761,7 +758,7 @@ default_3way_compare(PyObject *v, PyObject *w)
     int c;
     const char *vname, *wname;
 
-    if (v->ob_type == w->ob_type) {
+    if (Py_TYPE(v) == Py_TYPE(w)) {
         /* When comparing these pointers, they must be cast to
          * integer types (i.e. Py_uintptr_t, our spelling of C9X's
          * uintptr_t).  ANSI specifies that pointer compares other
@@ -782,19 +779,19 @@ default_3way_compare(PyObject *v, PyObject *w)
     if (PyNumber_Check(v))
         vname = "";
     else
-        vname = v->ob_type->tp_name;
+        vname = Py_TYPE(v)->tp_name;
     if (PyNumber_Check(w))
         wname = "";
     else
-        wname = w->ob_type->tp_name;
+        wname = Py_TYPE(w)->tp_name;
     c = strcmp(vname, wname);
     if (c < 0)
         return -1;
     if (c > 0)
         return 1;
     /* Same type name, or (more likely) incomparable numeric types */
-    return ((Py_uintptr_t)(v->ob_type) < (
-        Py_uintptr_t)(w->ob_type)) ? -1 : 1;
+    return ((Py_uintptr_t)(Py_TYPE(v)) < (
+        Py_uintptr_t)(Py_TYPE(w))) ? -1 : 1;
 }
 
 /* Do a 3-way comparison, by hook or by crook.  Return:
@@ -811,8 +808,8 @@ do_cmp(PyObject *v, PyObject *w)
     int c;
     cmpfunc f;
 
-    if (v->ob_type == w->ob_type
-        && (f = v->ob_type->tp_compare) != NULL) {
+    if (Py_TYPE(v) == Py_TYPE(w)
+        && (f = Py_TYPE(v)->tp_compare) != NULL) {
         c = (*f)(v, w);
         if (PyInstance_Check(v)) {
             /* Instance tp_compare has a different signature.
@@ -898,7 +895,7 @@ try_3way_to_rich_compare(PyObject *v, PyObject *w, int op)
 
         /* Py3K warning if types are not equal and comparison isn't == or !=  */
         if (Py_Py3kWarningFlag &&
-            v->ob_type != w->ob_type && op != Py_EQ && op != Py_NE &&
+            Py_TYPE(v) != Py_TYPE(w) && op != Py_EQ && op != Py_NE &&
             PyErr_WarnEx(PyExc_DeprecationWarning,
                        "comparing unequal types not supported "
                        "in 3.x", 1) < 0) {
@@ -947,9 +944,9 @@ PyObject_RichCompare(PyObject *v, PyObject *w, int op)
 
     /* If the types are equal, and not old-style instances, try to
        get out cheap (don't bother with coercions etc.). */
-    if (v->ob_type == w->ob_type && !PyInstance_Check(v)) {
+    if (Py_TYPE(v) == Py_TYPE(w) && !PyInstance_Check(v)) {
         cmpfunc fcmp;
-        richcmpfunc frich = RICHCOMPARE(v->ob_type);
+        richcmpfunc frich = RICHCOMPARE(Py_TYPE(v));
         /* If the type has richcmp, try it first.  try_rich_compare
            tries it two-sided, which is not needed since we've a
            single type only. */
@@ -961,7 +958,7 @@ PyObject_RichCompare(PyObject *v, PyObject *w, int op)
         }
         /* No richcmp, or this particular richmp not implemented.
            Try 3-way cmp. */
-        fcmp = v->ob_type->tp_compare;
+        fcmp = Py_TYPE(v)->tp_compare;
         if (fcmp != NULL) {
             int c = (*fcmp)(v, w);
             c = adjust_tp_compare(c);
@@ -1091,7 +1088,7 @@ long
 PyObject_HashNotImplemented(PyObject *self)
 {
     PyErr_Format(PyExc_TypeError, "unhashable type: '%.200s'",
-                 self->ob_type->tp_name);
+                 Py_TYPE(self)->tp_name);
     return -1;
 }
 
@@ -1100,7 +1097,7 @@ _Py_HashSecret_t _Py_HashSecret;
 long
 PyObject_Hash(PyObject *v)
 {
-    PyTypeObject *tp = v->ob_type;
+    PyTypeObject *tp = Py_TYPE(v);
     if (tp->tp_hash != NULL)
 #ifdef _SYMBEX_GLOBAL_HASHES
     	return ((*tp->tp_hash)(v) == -1) ? -1 : _SYMBEX_HASH_VALUE;
@@ -1401,10 +1398,10 @@ _PyObject_GenericGetAttrWithDict(PyObject *obj, PyObject *name, PyObject *dict)
 
     f = NULL;
     if (descr != NULL &&
-        PyType_HasFeature(descr->ob_type, Py_TPFLAGS_HAVE_CLASS)) {
-        f = descr->ob_type->tp_descr_get;
+        PyType_HasFeature(Py_TYPE(descr), Py_TPFLAGS_HAVE_CLASS)) {
+        f = Py_TYPE(descr)->tp_descr_get;
         if (f != NULL && PyDescr_IsData(descr)) {
-            res = f(descr, obj, (PyObject *)obj->ob_type);
+            res = f(descr, obj, (PyObject *)Py_TYPE(obj));
             Py_DECREF(descr);
             goto done;
         }
@@ -1509,8 +1506,8 @@ _PyObject_GenericSetAttrWithDict(PyObject *obj, PyObject *name,
     descr = _PyType_Lookup(tp, name);
     f = NULL;
     if (descr != NULL &&
-        PyType_HasFeature(descr->ob_type, Py_TPFLAGS_HAVE_CLASS)) {
-        f = descr->ob_type->tp_descr_set;
+        PyType_HasFeature(Py_TYPE(descr), Py_TPFLAGS_HAVE_CLASS)) {
+        f = Py_TYPE(descr)->tp_descr_set;
         if (f != NULL && PyDescr_IsData(descr)) {
             res = f(descr, obj, value);
             goto done;
@@ -1519,17 +1516,14 @@ _PyObject_GenericSetAttrWithDict(PyObject *obj, PyObject *name,
 
     if (dict == NULL) {
         dictptr = _PyObject_GetDictPtr(obj);
-        if (dictptr != NULL) {
-            dict = *dictptr;
-            if (dict == NULL && value != NULL) {
-                dict = PyDict_New();
-                if (dict == NULL)
-                    goto done;
-                *dictptr = dict;
-            }
+        if (dictptr != NULL && (*dictptr != NULL || value != NULL)) {
+            res = _PyObjectDict_SetItem(tp, dictptr, name, value);
+            if (res < 0 && PyErr_ExceptionMatches(PyExc_KeyError))
+                PyErr_SetObject(PyExc_AttributeError, name);
+            goto done;
         }
     }
-    if (dict != NULL) {
+    else {
         Py_INCREF(dict);
         if (value == NULL)
             res = PyDict_DelItem(dict, name);
@@ -1581,15 +1575,15 @@ PyObject_IsTrue(PyObject *v)
         return 0;
     if (v == Py_None)
         return 0;
-    else if (v->ob_type->tp_as_number != NULL &&
-             v->ob_type->tp_as_number->nb_nonzero != NULL)
-        res = (*v->ob_type->tp_as_number->nb_nonzero)(v);
-    else if (v->ob_type->tp_as_mapping != NULL &&
-             v->ob_type->tp_as_mapping->mp_length != NULL)
-        res = (*v->ob_type->tp_as_mapping->mp_length)(v);
-    else if (v->ob_type->tp_as_sequence != NULL &&
-             v->ob_type->tp_as_sequence->sq_length != NULL)
-        res = (*v->ob_type->tp_as_sequence->sq_length)(v);
+    else if (Py_TYPE(v)->tp_as_number != NULL &&
+             Py_TYPE(v)->tp_as_number->nb_nonzero != NULL)
+        res = (*Py_TYPE(v)->tp_as_number->nb_nonzero)(v);
+    else if (Py_TYPE(v)->tp_as_mapping != NULL &&
+             Py_TYPE(v)->tp_as_mapping->mp_length != NULL)
+        res = (*Py_TYPE(v)->tp_as_mapping->mp_length)(v);
+    else if (Py_TYPE(v)->tp_as_sequence != NULL &&
+             Py_TYPE(v)->tp_as_sequence->sq_length != NULL)
+        res = (*Py_TYPE(v)->tp_as_sequence->sq_length)(v);
     else
         return 1;
     /* if it is negative, it should be either -1 or -2 */
@@ -1624,20 +1618,20 @@ PyNumber_CoerceEx(PyObject **pv, PyObject **pw)
     int res;
 
     /* Shortcut only for old-style types */
-    if (v->ob_type == w->ob_type &&
-        !PyType_HasFeature(v->ob_type, Py_TPFLAGS_CHECKTYPES))
+    if (Py_TYPE(v) == Py_TYPE(w) &&
+        !PyType_HasFeature(Py_TYPE(v), Py_TPFLAGS_CHECKTYPES))
     {
         Py_INCREF(v);
         Py_INCREF(w);
         return 0;
     }
-    if (v->ob_type->tp_as_number && v->ob_type->tp_as_number->nb_coerce) {
-        res = (*v->ob_type->tp_as_number->nb_coerce)(pv, pw);
+    if (Py_TYPE(v)->tp_as_number && Py_TYPE(v)->tp_as_number->nb_coerce) {
+        res = (*Py_TYPE(v)->tp_as_number->nb_coerce)(pv, pw);
         if (res <= 0)
             return res;
     }
-    if (w->ob_type->tp_as_number && w->ob_type->tp_as_number->nb_coerce) {
-        res = (*w->ob_type->tp_as_number->nb_coerce)(pw, pv);
+    if (Py_TYPE(w)->tp_as_number && Py_TYPE(w)->tp_as_number->nb_coerce) {
+        res = (*Py_TYPE(w)->tp_as_number->nb_coerce)(pw, pv);
         if (res <= 0)
             return res;
     }
@@ -1679,7 +1673,7 @@ PyCallable_Check(PyObject *x)
         return 1;
     }
     else {
-        return x->ob_type->tp_call != NULL;
+        return Py_TYPE(x)->tp_call != NULL;
     }
 }
 
@@ -1897,7 +1891,7 @@ _generic_dir(PyObject *obj)
     /* Merge in attrs reachable from its class. */
     itsclass = PyObject_GetAttrString(obj, "__class__");
     if (itsclass == NULL)
-        /* XXX(tomer): Perhaps fall back to obj->ob_type if no
+        /* XXX(tomer): Perhaps fall back to Py_TYPE(obj) if no
                        __class__ exists? */
         PyErr_Clear();
     else {
@@ -2073,6 +2067,66 @@ PyObject _Py_NotImplementedStruct = {
     1, &PyNotImplemented_Type
 };
 
+#ifdef Py_IMMORTAL_OBJECTS
+void
+_Py_SetImmortal(PyObject *op)
+{
+#ifdef Py_REF_DEBUG
+    /* Its references won't be given back */
+    if (!_Py_IsImmortal(op))
+        _Py_RefTotal -= Py_REFCNT(op);
+#endif
+    Py_REFCNT(op) = _Py_IMMORTAL_REFCNT;
+}
+#endif
+
+_PyFreeList *_PyFreeLists[] = {
+    &_PyInt_FreeList,
+    &_PyInt_SmallInts,
+    &_PyFloat_FreeList,
+    &_PyTuple_FreeList,
+    &_PyList_FreeList,
+    &_PyDict_FreeList,
+    &_PyFrame_FreeList,
+    NULL
+};
+
+/* Set the sizes of the free lists from PYTHONFREELISTS, a comma-separated
+ * list of name=size items.  Items that don't parse are ignored.  This runs
+ * before the first objects are allocated.
+ */
+void
+_PyFreeLists_Init(void)
+{
+    char *s = Py_GETENV("PYTHONFREELISTS");
+    char *end;
+    size_t len;
+    long size;
+    _PyFreeList **fl;
+
+    if (s == NULL)
+        return;
+    while (*s != '\0') {
+        len = strcspn(s, "=,");
+        if (s[len] != '=') {
+            s += len + (s[len] == ',');
+            continue;
+        }
+        size = strtol(s + len + 1, &end, 10);
+        if (end != s + len + 1 && (*end == ',' || *end == '\0') &&
+            size >= 0) {
+            for (fl = _PyFreeLists; *fl != NULL; fl++) {
+                if (strlen((*fl)->name) == len &&
+                    strncmp((*fl)->name, s, len) == 0)
+                    (*fl)->maxfree = size;
+            }
+        }
+        s = end + strcspn(end, ",");
+        if (*s == ',')
+            s++;
+    }
+}
+
 void
 _Py_ReadyTypes(void)
 {
@@ -2209,6 +2263,14 @@ _Py_ReadyTypes(void)
 
     if (PyType_Ready(&PyFile_Type) < 0)
         Py_FatalError("Can't initialize file type");
+
+#ifdef Py_IMMORTAL_OBJECTS
+    _Py_SetImmortal(Py_None);
+    _Py_SetImmortal(Py_True);
+    _Py_SetImmortal(Py_False);
+    _Py_SetImmortal(Py_Ellipsis);
+    _Py_SetImmortal(Py_NotImplemented);
+#endif
 }
 
 
@@ -2218,7 +2280,7 @@ void
 _Py_NewReference(PyObject *op)
 {
     _Py_INC_REFTOTAL;
-    op->ob_refcnt = 1;
+    Py_REFCNT(op) = 1;
     _Py_AddToAllObjects(op, 1);
     _Py_INC_TPALLOCS(op);
 }
@@ -2229,7 +2291,7 @@ _Py_ForgetReference(register PyObject *op)
 #ifdef SLOW_UNREF_CHECK
     register PyObject *p;
 #endif
-    if (op->ob_refcnt < 0)
+    if (Py_REFCNT(op) < 0)
         Py_FatalError("UNREF negative refcnt");
     if (op == &refchain ||
         op->_ob_prev->_ob_next != op || op->_ob_next->_ob_prev != op)
@@ -2265,7 +2327,7 @@ _Py_PrintReferences(FILE *fp)
     PyObject *op;
     fprintf(fp, "Remaining objects:\n");
     for (op = refchain._ob_next; op != &refchain; op = op->_ob_next) {
-        fprintf(fp, "%p [%" PY_FORMAT_SIZE_T "d] ", op, op->ob_refcnt);
+        fprintf(fp, "%p [%" PY_FORMAT_SIZE_T "d] ", op, Py_REFCNT(op));
         if (PyObject_Print(op, fp, 0) != 0)
             PyErr_Clear();
         putc('\n', fp);
@@ -2282,7 +2344,7 @@ _Py_PrintReferenceAddresses(FILE *fp)
     fprintf(fp, "Remaining object addresses:\n");
     for (op = refchain._ob_next; op != &refchain; op = op->_ob_next)
         fprintf(fp, "%p [%" PY_FORMAT_SIZE_T "d] %s\n", op,
-            op->ob_refcnt, Py_TYPE(op)->tp_name);
+            Py_REFCNT(op), Py_TYPE(op)->tp_name);
 }
 
 PyObject *
@@ -2440,7 +2502,7 @@ _PyTrash_deposit_object(PyObject *op)
 {
     assert(PyObject_IS_GC(op));
     assert(_Py_AS_GC(op)->gc.gc_refs == _PyGC_REFS_UNTRACKED);
-    assert(op->ob_refcnt == 0);
+    assert(Py_REFCNT(op) == 0);
     _Py_AS_GC(op)->gc.gc_prev = (PyGC_Head *)_PyTrash_delete_later;
     _PyTrash_delete_later = op;
 }
@@ -2464,7 +2526,7 @@ _PyTrash_destroy_chain(void)
          * assorted non-release builds calling Py_DECREF again ends
          * up distorting allocation statistics.
          */
-        assert(op->ob_refcnt == 0);
+        assert(Py_REFCNT(op) == 0);
         ++_PyTrash_delete_nesting;
         (*dealloc)(op);
         --_PyTrash_delete_nesting;
@@ -1,24 +1,50 @@
 #include "Python.h"
 
-#ifdef WITH_PYMALLOC
-
-#ifdef WITH_VALGRIND
-#include <valgrind/valgrind.h>
-
 /* If we're using GCC, use __builtin_expect() to reduce overhead of
-   the valgrind checks */
+   the valgrind and tracing checks */
 #if defined(__GNUC__) && (__GNUC__ > 2) && defined(__OPTIMIZE__)
 #  define UNLIKELY(value) __builtin_expect((value), 0)
 #else
 #  define UNLIKELY(value) (value)
 #endif
 
+/* Allocation tracing.  While hooks are set by _PyObject_SetTraceHooks(),
+   PyObject_Malloc(), PyObject_Realloc() and PyObject_Free() hand over to
+   the traced_*() functions at the end of the allocator. */
+static _PyObject_TraceHooks *trace_hooks = NULL;
+/* Bytes to allocate before the next block is sampled */
+static Py_ssize_t trace_countdown = 0;
+
+static void *traced_malloc(size_t nbytes);
+static void *traced_realloc(void *p, size_t nbytes);
+static void traced_free(void *p);
+
+#ifdef WITH_PYMALLOC
+
+#ifdef WITH_VALGRIND
+#include <valgrind/valgrind.h>
+
 /* -1 indicates that we haven't checked that we're running on valgrind yet. */
 static int running_on_valgrind = -1;
 #endif
 
 #include "symbex.h"
 
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+/* Arenas are mapped straight from the VMM where mmap() is available. */
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#include <sys/mman.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifdef MAP_ANONYMOUS
+#define ARENAS_USE_MMAP
+#endif
+#endif
+
 
 /* An object allocator for Python.
 
@@ -186,8 +212,32 @@ static int running_on_valgrind = -1;
  * Therefore, allocating arenas with malloc is not optimal, because there is
  * some address space wastage, but this is the most portable way to request
  * memory from the system across various platforms.
+ *
+ * Where mmap() is available, arenas are mapped directly instead, aligned on
+ * their own size.  That wastes no pool to alignment, lets the arena be backed
+ * by transparent huge pages, and allows the memory of empty pools to be
+ * handed back to the system while the arena stays mapped.
+ *
+ * The arena size is fixed when the first arena is allocated, from the
+ * PYTHONMALLOCARENASIZE environment variable (in KiB) if set.  It is a power
+ * of 2 between MIN_ARENA_SIZE and MAX_ARENA_SIZE.
+ */
+#define DEFAULT_ARENA_SIZE      (256 << 10)     /* 256KB */
+#ifdef ARENAS_USE_MMAP
+#define DEFAULT_MMAP_ARENA_SIZE (1 << 20)       /* 1MB */
+#endif
+#define MIN_ARENA_SIZE          (64 << 10)      /* 64KB */
+#define MAX_ARENA_SIZE          (256 << 20)     /* 256MB */
+
+/*
+ * Size requested for arenas that should be backed by transparent huge pages
+ * (PYTHONMALLOCHUGEPAGES).  It is the huge page size on x86-64 and a
+ * multiple of it on most other platforms.
  */
-#define ARENA_SIZE              (256 << 10)     /* 256KB */
+#define HUGE_PAGE_ARENA_SIZE    (2 << 20)       /* 2MB */
+
+static size_t arena_size = DEFAULT_ARENA_SIZE;
+#define ARENA_SIZE              arena_size
 
 #ifdef WITH_MEMORY_LIMITS
 #define MAX_ARENAS              (SMALL_MEMORY_LIMIT / ARENA_SIZE)
@@ -195,10 +245,27 @@ static int running_on_valgrind = -1;
 
 /*
  * Size of the pools used for small blocks. Should be a power of 2,
- * between 1K and SYSTEM_PAGE_SIZE, that is: 1k, 2k, 4k.
+ * between 1K and SYSTEM_PAGE_SIZE, that is: 1k, 2k, 4k.  Like the arena
+ * size, it can be set with PYTHONMALLOCPOOLSIZE (in KiB) before the first
+ * arena is allocated, up to the native page size (see arena_configure()).
+ * Only page-sized pools can be handed back to the system when empty.
+ */
+#define DEFAULT_POOL_SIZE       SYSTEM_PAGE_SIZE        /* must be 2^N */
+#define MIN_POOL_SIZE           (1 << 10)               /* 1KB */
+
+static uint pool_size = DEFAULT_POOL_SIZE;
+#define POOL_SIZE               pool_size
+#define POOL_SIZE_MASK          (pool_size - 1)
+
+/*
+ * An arena keeps up to MAX_CACHED_POOLS empty pools on its freepools list.
+ * Beyond that, all but KEPT_CACHED_POOLS of them are handed back to the
+ * system with madvise(MADV_DONTNEED), if the arena is mapped and pools are
+ * page-sized.  The gap between the two keeps programs that repeatedly fill
+ * and empty a few pools from paying a system call and a page fault each time.
  */
-#define POOL_SIZE               SYSTEM_PAGE_SIZE        /* must be 2^N */
-#define POOL_SIZE_MASK          SYSTEM_PAGE_SIZE_MASK
+#define MAX_CACHED_POOLS        32
+#define KEPT_CACHED_POOLS       8
 
 /*
  * -- End of tunable settings section --
@@ -284,8 +351,18 @@ struct arena_object {
     /* The total number of pools in the arena, whether or not available. */
     uint ntotalpools;
 
-    /* Singly-linked list of available pools. */
+    /* Singly-linked list of available pools, and its length. */
     struct pool_header* freepools;
+    uint ncachedpools;
+
+    /* Empty pools whose memory was handed back to the system, so their
+     * headers are gone (see release_pools()).  This is a stack of their
+     * offsets from `address`, with nreleasedpools entries; it is NULL
+     * until the arena first releases a pool.  Released pools count in
+     * nfreepools.
+     */
+    uint *releasedpools;
+    uint nreleasedpools;
 
     /* Whenever this arena_object is not associated with an allocated
      * arena, the nextarena member is used to link all unassociated
@@ -518,6 +595,180 @@ static size_t ntimes_arena_allocated = 0;
 static size_t narenas_highwater = 0;
 #endif
 
+/* Where arenas come from, set up by arena_configure(). */
+#ifdef ARENAS_USE_MMAP
+static int arenas_use_mmap = 0;         /* else malloc() them */
+static int arenas_use_huge_pages = 0;   /* madvise(MADV_HUGEPAGE) them */
+#endif
+static int arenas_release_pools = 0;    /* see release_pools() */
+
+#ifdef PYMALLOC_DEBUG
+/* Total number of times an empty pool was handed back to the system. */
+static size_t ntimes_pool_released = 0;
+#endif
+
+/* Return the power of 2 at most the size in KiB given by the environment
+ * variable `name`, clamped to [lo, hi].  Return 0 if it isn't set or valid.
+ */
+static size_t
+arena_getenv_size(const char *name, size_t lo, size_t hi)
+{
+    char *s = Py_GETENV(name);
+    char *end;
+    unsigned long kb;
+    size_t size;
+
+    if (s == NULL || *s == '\0')
+        return 0;
+    kb = strtoul(s, &end, 10);
+    if (*end != '\0' || kb == 0)
+        return 0;
+    if (kb >= hi >> 10)
+        return hi;
+    for (size = lo; size << 1 <= (size_t)kb << 10; size <<= 1)
+        ;
+    return size;
+}
+
+/* Choose the arena backend and the arena and pool sizes.  This happens once,
+ * before the first arena is allocated, as changing sizes afterwards would
+ * break the address arithmetic on the pools already carved.
+ */
+static void
+arena_configure(void)
+{
+    size_t pagesize = SYSTEM_PAGE_SIZE;
+    size_t size;
+
+#if defined(HAVE_SYSCONF) && defined(_SC_PAGESIZE)
+    {
+        long n = sysconf(_SC_PAGESIZE);
+        if (n >= MIN_POOL_SIZE && (n & (n - 1)) == 0)
+            pagesize = (size_t)n;
+    }
+#endif
+    /* A pool must not be larger than a page:  Py_ADDRESS_IN_RANGE reads
+     * the would-be pool header of addresses pymalloc doesn't own, which
+     * could then lie on an unmapped page.
+     */
+    size = arena_getenv_size("PYTHONMALLOCPOOLSIZE", MIN_POOL_SIZE,
+                             pagesize);
+    if (size != 0)
+        pool_size = (uint)size;
+
+#ifdef ARENAS_USE_MMAP
+    arenas_use_mmap = 1;
+    arena_size = DEFAULT_MMAP_ARENA_SIZE;
+#ifdef MADV_HUGEPAGE
+    {
+        char *s = Py_GETENV("PYTHONMALLOCHUGEPAGES");
+        arenas_use_huge_pages = s != NULL && *s != '\0';
+    }
+#endif
+#endif
+    size = arena_getenv_size("PYTHONMALLOCARENASIZE", MIN_ARENA_SIZE,
+                             MAX_ARENA_SIZE);
+    if (size != 0)
+        arena_size = size;
+#ifdef ARENAS_USE_MMAP
+    if (arenas_use_huge_pages && arena_size < HUGE_PAGE_ARENA_SIZE)
+        arena_size = HUGE_PAGE_ARENA_SIZE;
+#ifdef MADV_DONTNEED
+    /* Releasing a pool would split the huge page holding it. */
+    arenas_release_pools = !arenas_use_huge_pages &&
+                           POOL_SIZE % pagesize == 0;
+#endif
+#endif
+    if (arena_size < POOL_SIZE)
+        arena_size = POOL_SIZE;
+}
+
+/* Get the memory for an arena of ARENA_SIZE bytes.  Return 0 on failure. */
+static uptr
+arena_map(void)
+{
+#ifdef ARENAS_USE_MMAP
+    if (arenas_use_mmap) {
+        /* Map twice the size and trim both ends, so that the arena is
+         * aligned on its own size.
+         */
+        uchar *p, *base;
+        size_t lead;
+
+        p = (uchar *)mmap(NULL, 2 * ARENA_SIZE, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == (uchar *)MAP_FAILED)
+            return 0;
+        base = (uchar *)(((uptr)p + ARENA_SIZE - 1) &
+                         ~(uptr)(ARENA_SIZE - 1));
+        lead = base - p;
+        if (lead != 0)
+            munmap(p, lead);
+        munmap(base + ARENA_SIZE, ARENA_SIZE - lead);
+#ifdef MADV_HUGEPAGE
+        if (arenas_use_huge_pages)
+            (void)madvise(base, ARENA_SIZE, MADV_HUGEPAGE);
+#endif
+        return (uptr)base;
+    }
+#endif
+    return (uptr)malloc(ARENA_SIZE);
+}
+
+/* Give the memory of an arena from arena_map() back to the system. */
+static void
+arena_unmap(uptr address)
+{
+#ifdef ARENAS_USE_MMAP
+    if (arenas_use_mmap) {
+        munmap((void *)address, ARENA_SIZE);
+        return;
+    }
+#endif
+    free((void *)address);
+}
+
+/* Hand the memory of all but the first KEPT_CACHED_POOLS pools on the
+ * freepools list of `ao` back to the system.  The arena keeps the address
+ * range, and the pages fill with zeroes again when next touched.  As the
+ * pool headers are lost too, the pools are remembered in ao->releasedpools.
+ * The list's head pools, freed last, are the most likely to still be in a
+ * cache, so they're kept.
+ */
+static void
+release_pools(struct arena_object *ao)
+{
+#if defined(ARENAS_USE_MMAP) && defined(MADV_DONTNEED)
+    poolp *plink = &ao->freepools;
+    poolp pool;
+    uint i;
+
+    assert(arenas_release_pools);
+    if (ao->releasedpools == NULL) {
+        ao->releasedpools = (uint *)malloc(ao->ntotalpools * sizeof(uint));
+        if (ao->releasedpools == NULL)
+            return;             /* keep caching them, no harm done */
+    }
+    for (i = 0; i < KEPT_CACHED_POOLS; ++i)
+        plink = &(*plink)->nextpool;
+    pool = *plink;
+    *plink = NULL;
+    while (pool != NULL) {
+        poolp next = pool->nextpool;
+        (void)madvise(pool, POOL_SIZE, MADV_DONTNEED);
+        assert(ao->nreleasedpools < ao->ntotalpools);
+        ao->releasedpools[ao->nreleasedpools++] =
+            (uint)((uptr)pool - ao->address);
+        --ao->ncachedpools;
+#ifdef PYMALLOC_DEBUG
+        ++ntimes_pool_released;
+#endif
+        pool = next;
+    }
+    assert(ao->ncachedpools == KEPT_CACHED_POOLS);
+#endif
+}
+
 /* Allocate a new arena.  If we run out of memory, return NULL.  Else
  * allocate a new arena, and return the address of an arena_object
  * describing the new arena.  It's expected that the caller will set
@@ -541,6 +792,8 @@ new_arena(void)
         /* Double the number of arena objects on each allocation.
          * Note that it's possible for `numarenas` to overflow.
          */
+        if (maxarenas == 0)
+            arena_configure();
         numarenas = maxarenas ? maxarenas << 1 : INITIAL_ARENA_OBJECTS;
         if (numarenas <= maxarenas)
             return NULL;                /* overflow */
@@ -580,7 +833,7 @@ new_arena(void)
     arenaobj = unused_arena_objects;
     unused_arena_objects = arenaobj->nextarena;
     assert(arenaobj->address == 0);
-    arenaobj->address = (uptr)malloc(ARENA_SIZE);
+    arenaobj->address = arena_map();
     if (arenaobj->address == 0) {
         /* The allocation failed: return NULL after putting the
          * arenaobj back.
@@ -597,6 +850,9 @@ new_arena(void)
         narenas_highwater = narenas_currently_allocated;
 #endif
     arenaobj->freepools = NULL;
+    arenaobj->ncachedpools = 0;
+    arenaobj->releasedpools = NULL;
+    arenaobj->nreleasedpools = 0;
     /* pool_address <- first pool-aligned address in the arena
        nfreepools <- number of whole pools that fit after alignment */
     arenaobj->pool_address = (block*)arenaobj->address;
@@ -754,6 +1010,9 @@ PyObject_Malloc(size_t nbytes)
     poolp next;
     uint size;
 
+    if (UNLIKELY(trace_hooks != NULL))
+        return traced_malloc(nbytes);
+
 #ifdef _SYMBEX_ALLOC
     PREPARE_ALLOC(nbytes);
 #endif
@@ -843,6 +1102,7 @@ PyObject_Malloc(size_t nbytes)
         if (pool != NULL) {
             /* Unlink from cached pools. */
             usable_arenas->freepools = pool->nextpool;
+            --usable_arenas->ncachedpools;
 
             /* This arena already had the smallest nfreepools
              * value, so decreasing nfreepools doesn't change
@@ -872,6 +1132,7 @@ PyObject_Malloc(size_t nbytes)
                  * time.
                  */
                 assert(usable_arenas->freepools != NULL ||
+                       usable_arenas->nreleasedpools > 0 ||
                        usable_arenas->pool_address <=
                        (block*)usable_arenas->address +
                            ARENA_SIZE - POOL_SIZE);
@@ -910,16 +1171,24 @@ PyObject_Malloc(size_t nbytes)
             return (void *)bp;
         }
 
-        /* Carve off a new pool. */
+        /* Carve off a new pool, preferring one that was released, as
+         * it's below the arena's high water mark.
+         */
         assert(usable_arenas->nfreepools > 0);
         assert(usable_arenas->freepools == NULL);
-        pool = (poolp)usable_arenas->pool_address;
-        assert((block*)pool <= (block*)usable_arenas->address +
-                               ARENA_SIZE - POOL_SIZE);
+        if (usable_arenas->nreleasedpools > 0) {
+            pool = (poolp)(usable_arenas->address +
+                usable_arenas->releasedpools[--usable_arenas->nreleasedpools]);
+        }
+        else {
+            pool = (poolp)usable_arenas->pool_address;
+            assert((block*)pool <= (block*)usable_arenas->address +
+                                   ARENA_SIZE - POOL_SIZE);
+            usable_arenas->pool_address += POOL_SIZE;
+        }
         pool->arenaindex = usable_arenas - arenas;
         assert(&arenas[pool->arenaindex] == usable_arenas);
         pool->szidx = DUMMY_SIZE_IDX;
-        usable_arenas->pool_address += POOL_SIZE;
         --usable_arenas->nfreepools;
 
         if (usable_arenas->nfreepools == 0) {
@@ -967,6 +1236,11 @@ PyObject_Free(void *p)
     if (p == NULL)      /* free(NULL) has no effect */
         return;
 
+    if (UNLIKELY(trace_hooks != NULL)) {
+        traced_free(p);
+        return;
+    }
+
 #ifdef WITH_VALGRIND
     if (UNLIKELY(running_on_valgrind > 0))
         goto redirect;
@@ -1013,12 +1287,13 @@ PyObject_Free(void *p)
             ao = &arenas[pool->arenaindex];
             pool->nextpool = ao->freepools;
             ao->freepools = pool;
+            ++ao->ncachedpools;
             nf = ++ao->nfreepools;
 
             /* All the rest is arena management.  We just freed
              * a pool, and there are 4 cases for arena mgmt:
              * 1. If all the pools are free, return the arena to
-             *    the system free().
+             *    the system.
              * 2. If this is the only free pool in the arena,
              *    add the arena back to the `usable_arenas` list.
              * 3. If the "next" arena has a smaller count of free
@@ -1061,13 +1336,23 @@ PyObject_Free(void *p)
                 unused_arena_objects = ao;
 
                 /* Free the entire arena. */
-                free((void *)ao->address);
+                arena_unmap(ao->address);
                 ao->address = 0;                        /* mark unassociated */
+                if (ao->releasedpools != NULL) {
+                    free(ao->releasedpools);
+                    ao->releasedpools = NULL;
+                }
                 --narenas_currently_allocated;
 
                 UNLOCK();
                 return;
             }
+            /* Too many empty pools hold on to memory:  give some
+             * of it back.  This doesn't change nf.
+             */
+            if (ao->ncachedpools > MAX_CACHED_POOLS &&
+                arenas_release_pools)
+                release_pools(ao);
             if (nf == 1) {
                 /* Case 2.  Put ao at the head of
                  * usable_arenas.  Note that because
@@ -1189,6 +1474,9 @@ PyObject_Realloc(void *p, size_t nbytes)
     uint arenaindex_temp;
 #endif
 
+    if (UNLIKELY(trace_hooks != NULL))
+        return traced_realloc(p, nbytes);
+
 #ifdef _SYMBEX_ALLOC
     PREPARE_ALLOC(nbytes);
 #endif
@@ -1272,6 +1560,8 @@ PyObject_Realloc(void *p, size_t nbytes)
 void *
 PyObject_Malloc(size_t n)
 {
+    if (UNLIKELY(trace_hooks != NULL))
+        return traced_malloc(n);
 #ifdef _SYMBEX_ALLOC
     s2e_get_example(&n, sizeof(n));
 #endif
@@ -1281,6 +1571,8 @@ PyObject_Malloc(size_t n)
 void *
 PyObject_Realloc(void *p, size_t n)
 {
+    if (UNLIKELY(trace_hooks != NULL))
+        return traced_realloc(p, n);
 #ifdef _SYMBEX_ALLOC
     s2e_get_example(&n, sizeof(n));
 #endif
@@ -1290,10 +1582,73 @@ PyObject_Realloc(void *p, size_t n)
 void
 PyObject_Free(void *p)
 {
+    if (UNLIKELY(trace_hooks != NULL) && p != NULL) {
+        traced_free(p);
+        return;
+    }
     PyMem_FREE(p);
 }
 #endif /* WITH_PYMALLOC */
 
+/*==========================================================================*/
+/* Allocation tracing.  Tracing is suspended while the hooks run, both so
+ * that they can allocate memory and so that PyObject_Realloc() doesn't
+ * report the PyObject_Malloc() and PyObject_Free() calls it makes.
+ */
+
+void
+_PyObject_SetTraceHooks(_PyObject_TraceHooks *hooks, Py_ssize_t countdown)
+{
+    trace_hooks = hooks;
+    trace_countdown = countdown;
+}
+
+static void *
+traced_malloc(size_t nbytes)
+{
+    _PyObject_TraceHooks *hooks = trace_hooks;
+    void *p;
+
+    trace_hooks = NULL;
+    p = PyObject_Malloc(nbytes);
+    if (p != NULL && (trace_countdown -= (Py_ssize_t)nbytes) <= 0)
+        trace_countdown = hooks->sample(p, nbytes);
+    trace_hooks = hooks;
+    return p;
+}
+
+static void *
+traced_realloc(void *p, size_t nbytes)
+{
+    _PyObject_TraceHooks *hooks = trace_hooks;
+    void *q;
+
+    trace_hooks = NULL;
+    q = PyObject_Realloc(p, nbytes);
+    if (q != NULL) {
+        /* The block was moved, or resized in place:  either way it's
+         * a new allocation of nbytes.
+         */
+        if (p != NULL)
+            hooks->forget(p);
+        if ((trace_countdown -= (Py_ssize_t)nbytes) <= 0)
+            trace_countdown = hooks->sample(q, nbytes);
+    }
+    trace_hooks = hooks;
+    return q;
+}
+
+static void
+traced_free(void *p)
+{
+    _PyObject_TraceHooks *hooks = trace_hooks;
+
+    trace_hooks = NULL;
+    hooks->forget(p);
+    PyObject_Free(p);
+    trace_hooks = hooks;
+}
+
 #ifdef PYMALLOC_DEBUG
 /*==========================================================================*/
 /* A x-platform debugging allocator.  This doesn't manage memory directly,
@@ -1376,8 +1731,21 @@ pool_is_in_list(const poolp target, poolp list)
     return 0;
 }
 
+/* Was target's memory handed back to the system by release_pools()? */
+static int
+pool_is_released(const poolp target, struct arena_object *ao)
+{
+    uint i;
+    for (i = 0; i < ao->nreleasedpools; ++i) {
+        if ((uptr)target - ao->address == ao->releasedpools[i])
+            return 1;
+    }
+    return 0;
+}
+
 #else
 #define pool_is_in_list(X, Y) 1
+#define pool_is_released(X, Y) 1
 
 #endif  /* Py_DEBUG */
 
@@ -1786,6 +2154,8 @@ _PyObject_DebugMallocStats(void)
     size_t available_bytes = 0;
     /* # of free pools + pools not yet carved out of current arena */
     uint numfreepools = 0;
+    /* # of free pools whose memory was handed back to the system */
+    uint numreleasedpools = 0;
     /* # of bytes for arena alignment padding */
     size_t arena_alignment = 0;
     /* # of bytes in used and full pools used for pool_headers */
@@ -1821,6 +2191,7 @@ _PyObject_DebugMallocStats(void)
         narenas += 1;
 
         numfreepools += arenas[i].nfreepools;
+        numreleasedpools += arenas[i].nreleasedpools;
 
         /* round up to pool alignment */
         if (base & (uptr)POOL_SIZE_MASK) {
@@ -1839,8 +2210,9 @@ _PyObject_DebugMallocStats(void)
             uint freeblocks;
 
             if (p->ref.count == 0) {
-                /* currently unused */
-                assert(pool_is_in_list(p, arenas[i].freepools));
+                /* currently unused, or released */
+                assert(pool_is_in_list(p, arenas[i].freepools) ||
+                       pool_is_released(p, &arenas[i]));
                 continue;
             }
             ++numpools[sz];
@@ -1886,9 +2258,10 @@ _PyObject_DebugMallocStats(void)
     (void)printone("# arenas reclaimed", ntimes_arena_allocated - narenas);
     (void)printone("# arenas highwater mark", narenas_highwater);
     (void)printone("# arenas allocated current", narenas);
+    (void)printone("# pools released", ntimes_pool_released);
 
     PyOS_snprintf(buf, sizeof(buf),
-        "%" PY_FORMAT_SIZE_T "u arenas * %d bytes/arena",
+        "%" PY_FORMAT_SIZE_T "u arenas * %" PY_FORMAT_SIZE_T "u bytes/arena",
         narenas, ARENA_SIZE);
     (void)printone(buf, narenas * ARENA_SIZE);
 
@@ -1898,8 +2271,10 @@ _PyObject_DebugMallocStats(void)
     total += printone("# bytes in available blocks", available_bytes);
 
     PyOS_snprintf(buf, sizeof(buf),
-        "%u unused pools * %d bytes", numfreepools, POOL_SIZE);
+        "%u unused pools * %u bytes", numfreepools, POOL_SIZE);
     total += printone(buf, (size_t)numfreepools * POOL_SIZE);
+    (void)printone("# bytes in unused pools released",
+                   (size_t)numreleasedpools * POOL_SIZE);
 
     total += printone("# bytes lost to pool headers", pool_header_bytes);
     total += printone("# bytes lost to quantization", quantization);
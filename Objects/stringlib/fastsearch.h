@@ -5,7 +5,15 @@
 
 /* fast search/count implementation, based on a mix between boyer-
    moore and horspool, with a few more bells and whistles on the top.
-   for some more background, see: http://effbot.org/zone/stringlib.htm */
+   for some more background, see: http://effbot.org/zone/stringlib.htm
+
+   horspool is quick on ordinary text but quadratic on unlucky inputs
+   (think "a"*99+"b" in "a"*100000), so a search that does too much work
+   comparing candidates hands the rest of the haystack over to the
+   two-way algorithm of Crochemore and Perrin, which runs in linear time
+   and constant space.  see "Two-way string-matching", JACM 38(3), 1991,
+   and the memmem() of glibc, which this follows.  the reverse search
+   runs two-way on the mirror images of the needle and the haystack. */
 
 /* note: fastsearch may access s[n], which isn't a problem when using
    Python's ordinary string types, but may cause problems if you're
@@ -33,6 +41,244 @@
 #define STRINGLIB_BLOOM(mask, ch)     \
     ((mask &  (1UL << ((ch) & (STRINGLIB_BLOOM_WIDTH -1)))))
 
+/* the two-way shift table is indexed by the low byte of a character */
+#define STRINGLIB_SHIFT_SIZE 256
+#define STRINGLIB_SHIFT_MASK (STRINGLIB_SHIFT_SIZE - 1)
+
+/* horspool gets to compare this many characters, and four for each one
+   it has passed, before the search switches to two-way */
+#define STRINGLIB_TWO_WAY_SLACK 2000
+
+#endif
+
+/* the kernels are named by STRINGLIB(F) when that's defined, so that a
+   file can include this once per character width (see ucs1lib.h) */
+
+#ifdef STRINGLIB
+#define FASTSEARCH(F) STRINGLIB(F)
+#define fastsearch STRINGLIB(fastsearch)
+#else
+#define FASTSEARCH(F) F
+#endif
+
+/* a needle prepared for two_way_find(), or, mirrored, for two_way_rfind() */
+typedef struct {
+    const STRINGLIB_CHAR *needle;
+    Py_ssize_t m;
+    Py_ssize_t cut;         /* the critical factorization is needle[:cut],
+                               needle[cut:] */
+    Py_ssize_t period;
+    int periodic;           /* needle[:cut] repeats in needle[cut:] */
+    Py_ssize_t shift[STRINGLIB_SHIFT_SIZE];
+} FASTSEARCH(two_way_needle);
+
+/* Return the start of the maximal suffix of needle, under the normal
+   order of characters or the reverse one, and its period in *period.
+   If mirror is set, work on the needle read backwards. */
+Py_LOCAL(Py_ssize_t)
+FASTSEARCH(maximal_suffix)(const STRINGLIB_CHAR *needle, Py_ssize_t m,
+                           Py_ssize_t *period, int reverse, int mirror)
+{
+    Py_ssize_t suffix = 0;      /* start of the best suffix so far */
+    Py_ssize_t candidate = 1;   /* start of the suffix compared with it */
+    Py_ssize_t k = 0;           /* characters of the two that are equal */
+    Py_ssize_t p = 1;
+
+    while (candidate + k < m) {
+        STRINGLIB_CHAR a = mirror ? needle[m - 1 - (candidate + k)]
+                                  : needle[candidate + k];
+        STRINGLIB_CHAR b = mirror ? needle[m - 1 - (suffix + k)]
+                                  : needle[suffix + k];
+        if (reverse ? a > b : a < b) {
+            /* candidate loses; nothing before its mismatch can win */
+            candidate += k + 1;
+            k = 0;
+            p = candidate - suffix;
+        }
+        else if (a == b) {
+            if (k + 1 != p)
+                k++;
+            else {
+                /* matched a whole period */
+                candidate += p;
+                k = 0;
+            }
+        }
+        else {
+            /* candidate wins */
+            suffix = candidate;
+            candidate++;
+            k = 0;
+            p = 1;
+        }
+    }
+    *period = p;
+    return suffix;
+}
+
+/* Prepare needle for two_way_find(), or for two_way_rfind() if mirror is
+   set:  the indices in tw then count from the end of the needle. */
+Py_LOCAL(void)
+FASTSEARCH(two_way_prepare)(FASTSEARCH(two_way_needle) *tw,
+                            const STRINGLIB_CHAR *needle, Py_ssize_t m,
+                            int mirror)
+{
+    Py_ssize_t cut, period, cut2, period2, i;
+
+    /* the later of the two maximal suffixes gives a critical
+       factorization */
+    cut = FASTSEARCH(maximal_suffix)(needle, m, &period, 0, mirror);
+    cut2 = FASTSEARCH(maximal_suffix)(needle, m, &period2, 1, mirror);
+    if (cut2 >= cut) {
+        cut = cut2;
+        period = period2;
+    }
+
+    tw->needle = needle;
+    tw->m = m;
+    tw->cut = cut;
+    if (mirror)
+        tw->periodic = memcmp(needle + m - cut, needle + m - cut - period,
+                              cut * sizeof(STRINGLIB_CHAR)) == 0;
+    else
+        tw->periodic = memcmp(needle, needle + period,
+                              cut * sizeof(STRINGLIB_CHAR)) == 0;
+    if (tw->periodic)
+        tw->period = period;
+    else
+        /* a safe shift when the left half mismatches */
+        tw->period = (cut > m - cut ? cut : m - cut) + 1;
+
+    /* horspool's shift on the last character; characters with the same
+       low byte share an entry, which keeps the smallest of their shifts */
+    for (i = 0; i < STRINGLIB_SHIFT_SIZE; i++)
+        tw->shift[i] = m;
+    if (mirror) {
+        /* the mirror's last character is needle[0] */
+        for (i = m - 1; i > 0; i--)
+            tw->shift[needle[i] & STRINGLIB_SHIFT_MASK] = i;
+        tw->shift[needle[0] & STRINGLIB_SHIFT_MASK] = 0;
+    }
+    else {
+        for (i = 0; i < m - 1; i++)
+            tw->shift[needle[i] & STRINGLIB_SHIFT_MASK] = m - 1 - i;
+        tw->shift[needle[m - 1] & STRINGLIB_SHIFT_MASK] = 0;
+    }
+}
+
+/* Return the index of the first match of the needle in s[:n], or -1. */
+Py_LOCAL(Py_ssize_t)
+FASTSEARCH(two_way_find)(const STRINGLIB_CHAR *s, Py_ssize_t n,
+                         FASTSEARCH(two_way_needle) *tw)
+{
+    const STRINGLIB_CHAR *p = tw->needle;
+    const Py_ssize_t m = tw->m, cut = tw->cut, period = tw->period;
+    Py_ssize_t i, j, shift, memory = 0;
+
+    for (j = 0; j <= n - m;) {
+        /* the last character is checked first, as in horspool */
+        shift = tw->shift[s[j + m - 1] & STRINGLIB_SHIFT_MASK];
+        if (shift > 0) {
+            if (memory && shift < period)
+                /* the needle is periodic but the last period has a
+                   character out of place, so skip past it */
+                shift = m - period;
+            memory = 0;
+            j += shift;
+            continue;
+        }
+        /* compare the right half, then the left half; shift entries are
+           shared, so the last character is compared too */
+        i = cut > memory ? cut : memory;
+        while (i < m && p[i] == s[j + i])
+            i++;
+        if (i < m) {
+            j += i - cut + 1;
+            memory = 0;
+            continue;
+        }
+        i = cut - 1;
+        while (i >= memory && p[i] == s[j + i])
+            i--;
+        if (i < memory)
+            return j;
+        j += period;
+        if (tw->periodic)
+            /* the part of the needle we shifted over is known to match */
+            memory = m - period;
+    }
+    return -1;
+}
+
+/* Return the index of the last match of the needle in s[:n], or -1.  This
+   is two_way_find() on the mirror images of s[:n] and of the needle, which
+   tw was prepared for:  character k of a mirror image is n - 1 - k, or
+   m - 1 - k, of the original. */
+Py_LOCAL(Py_ssize_t)
+FASTSEARCH(two_way_rfind)(const STRINGLIB_CHAR *s, Py_ssize_t n,
+                          FASTSEARCH(two_way_needle) *tw)
+{
+    const STRINGLIB_CHAR *p = tw->needle + tw->m - 1;
+    const STRINGLIB_CHAR *t = s + n - 1;
+    const Py_ssize_t m = tw->m, cut = tw->cut, period = tw->period;
+    Py_ssize_t i, j, shift, memory = 0;
+
+    for (j = 0; j <= n - m;) {
+        shift = tw->shift[t[-(j + m - 1)] & STRINGLIB_SHIFT_MASK];
+        if (shift > 0) {
+            if (memory && shift < period)
+                shift = m - period;
+            memory = 0;
+            j += shift;
+            continue;
+        }
+        i = cut > memory ? cut : memory;
+        while (i < m && p[-i] == t[-(j + i)])
+            i++;
+        if (i < m) {
+            j += i - cut + 1;
+            memory = 0;
+            continue;
+        }
+        i = cut - 1;
+        while (i >= memory && p[-i] == t[-(j + i)])
+            i--;
+        if (i < memory)
+            return n - m - j;
+        j += period;
+        if (tw->periodic)
+            memory = m - period;
+    }
+    return -1;
+}
+
+/* Finish a forward search or count, from s[0], with two-way.  count holds
+   the matches found so far. */
+Py_LOCAL(Py_ssize_t)
+FASTSEARCH(two_way_search)(const STRINGLIB_CHAR *s, Py_ssize_t n,
+                           const STRINGLIB_CHAR *p, Py_ssize_t m,
+                           Py_ssize_t maxcount, int mode, Py_ssize_t count)
+{
+    FASTSEARCH(two_way_needle) tw;
+    Py_ssize_t i = 0, pos;
+
+    FASTSEARCH(two_way_prepare)(&tw, p, m, 0);
+    for (;;) {
+        pos = FASTSEARCH(two_way_find)(s + i, n - i, &tw);
+        if (pos < 0)
+            break;
+        if (mode != FAST_COUNT)
+            return i + pos;
+        count++;
+        if (count == maxcount)
+            return maxcount;
+        i += pos + m;
+    }
+    if (mode != FAST_COUNT)
+        return -1;
+    return count;
+}
+
 Py_LOCAL_INLINE(Py_ssize_t)
 fastsearch(const STRINGLIB_CHAR* s, Py_ssize_t n,
            const STRINGLIB_CHAR* p, Py_ssize_t m,
@@ -40,7 +286,7 @@ fastsearch(const STRINGLIB_CHAR* s, Py_ssize_t n,
 {
     unsigned long mask;
     Py_ssize_t skip, count = 0;
-    Py_ssize_t i, j, mlast, w;
+    Py_ssize_t i, j, mlast, w, work;
 
     w = n - m;
 
@@ -61,6 +307,11 @@ fastsearch(const STRINGLIB_CHAR* s, Py_ssize_t n,
                 }
             return count;
         } else if (mode == FAST_SEARCH) {
+            if (sizeof(STRINGLIB_CHAR) == 1) {
+                /* the C library scans a word at a time */
+                const void *hit = memchr(s, p[0], n);
+                return hit ? (const STRINGLIB_CHAR *)hit - s : -1;
+            }
             for (i = 0; i < n; i++)
                 if (s[i] == p[0])
                     return i;
@@ -89,7 +340,38 @@ fastsearch(const STRINGLIB_CHAR* s, Py_ssize_t n,
         /* process pattern[-1] outside the loop */
         STRINGLIB_BLOOM_ADD(mask, p[mlast]);
 
-        for (i = 0; i <= w; i++) {
+        i = 0;
+        work = 0;
+        if (sizeof(STRINGLIB_CHAR) == 1) {
+            /* while the first character is rare, memchr() finds the
+               candidates faster than the loop below skips to them */
+            Py_ssize_t hits = 0;
+            while (i <= w) {
+                const STRINGLIB_CHAR *hit = memchr(s + i, p[0], w - i + 1);
+                if (hit == NULL)
+                    return mode == FAST_COUNT ? count : -1;
+                i = hit - s;
+                if (memcmp(s + i + 1, p + 1, mlast) == 0) {
+                    if (mode != FAST_COUNT)
+                        return i;
+                    count++;
+                    if (count == maxcount)
+                        return maxcount;
+                    i += m;
+                    continue;
+                }
+                i++;
+                /* too many candidates, or too long a memcmp() on them */
+                hits++;
+                work += m;
+                if (hits > (i >> 4) + 64 ||
+                    work > 4 * i + STRINGLIB_TWO_WAY_SLACK)
+                    break;
+            }
+            work = 0;
+        }
+
+        for (; i <= w; i++) {
             /* note: using mlast in the skip path slows things down on x86 */
             if (s[i+m-1] == p[m-1]) {
                 /* candidate match */
@@ -106,6 +388,15 @@ fastsearch(const STRINGLIB_CHAR* s, Py_ssize_t n,
                     i = i + mlast;
                     continue;
                 }
+                /* too many near misses: go linear */
+                work += j;
+                if (work > 4 * i + STRINGLIB_TWO_WAY_SLACK) {
+                    j = FASTSEARCH(two_way_search)(s + i, n - i, p, m,
+                                                   maxcount, mode, count);
+                    if (mode != FAST_COUNT && j >= 0)
+                        j += i;
+                    return j;
+                }
                 /* miss: check if next character is part of pattern */
                 if (!STRINGLIB_BLOOM(mask, s[i+m]))
                     i = i + m;
@@ -130,6 +421,7 @@ fastsearch(const STRINGLIB_CHAR* s, Py_ssize_t n,
                 skip = i - 1;
         }
 
+        work = 0;
         for (i = w; i >= 0; i--) {
             if (s[i] == p[0]) {
                 /* candidate match */
@@ -139,6 +431,14 @@ fastsearch(const STRINGLIB_CHAR* s, Py_ssize_t n,
                 if (j == 0)
                     /* got a match! */
                     return i;
+                /* too many near misses: go linear on s[:i+m], which
+                   holds the candidates left */
+                work += m - j;
+                if (work > 4 * (w - i) + STRINGLIB_TWO_WAY_SLACK) {
+                    FASTSEARCH(two_way_needle) tw;
+                    FASTSEARCH(two_way_prepare)(&tw, p, m, 1);
+                    return FASTSEARCH(two_way_rfind)(s, i + m, &tw);
+                }
                 /* miss: check if previous character is part of pattern */
                 if (i > 0 && !STRINGLIB_BLOOM(mask, s[i-1]))
                     i = i - m;
@@ -157,4 +457,7 @@ fastsearch(const STRINGLIB_CHAR* s, Py_ssize_t n,
     return count;
 }
 
+#undef FASTSEARCH
+#ifdef STRINGLIB
+#undef fastsearch
 #endif
@@ -11,11 +11,6 @@
 #define PyLong_FromSsize_t _PyLong_FromSsize_t
 #endif
 
-/* Defines for more efficiently reallocating the string buffer */
-#define INITIAL_SIZE_INCREMENT 100
-#define SIZE_MULTIPLIER 2
-#define MAX_SIZE_INCREMENT  3200
-
 
 /************************************************************************/
 /***********   Global data structures and forward declarations  *********/
@@ -124,68 +119,20 @@ autonumber_state_error(AutoNumberState state, int field_name_is_empty)
 /***********    Output string management functions       ****************/
 /************************************************************************/
 
-typedef struct {
-    STRINGLIB_CHAR *ptr;
-    STRINGLIB_CHAR *end;
-    PyObject *obj;
-    Py_ssize_t size_increment;
-} OutputString;
-
-/* initialize an OutputString object, reserving size characters */
-static int
-output_initialize(OutputString *output, Py_ssize_t size)
-{
-    output->obj = STRINGLIB_NEW(NULL, size);
-    if (output->obj == NULL)
-        return 0;
-
-    output->ptr = STRINGLIB_STR(output->obj);
-    output->end = STRINGLIB_LEN(output->obj) + output->ptr;
-    output->size_increment = INITIAL_SIZE_INCREMENT;
-
-    return 1;
-}
-
-/*
-    output_extend reallocates the output string buffer.
-    It returns a status:  0 for a failed reallocation,
-    1 for success.
-*/
-
-static int
-output_extend(OutputString *output, Py_ssize_t count)
-{
-    STRINGLIB_CHAR *startptr = STRINGLIB_STR(output->obj);
-    Py_ssize_t curlen = output->ptr - startptr;
-    Py_ssize_t maxlen = curlen + count + output->size_increment;
-
-    if (STRINGLIB_RESIZE(&output->obj, maxlen) < 0)
-        return 0;
-    startptr = STRINGLIB_STR(output->obj);
-    output->ptr = startptr + curlen;
-    output->end = startptr + maxlen;
-    if (output->size_increment < MAX_SIZE_INCREMENT)
-        output->size_increment *= SIZE_MULTIPLIER;
-    return 1;
-}
+/* the output goes to a STRINGLIB_WRITER, which overallocates it */
+typedef STRINGLIB_WRITER OutputString;
 
 /*
     output_data dumps characters into our output string
     buffer.
 
-    In some cases, it has to reallocate the string.
-
     It returns a status:  0 for a failed reallocation,
     1 for success.
 */
 static int
 output_data(OutputString *output, const STRINGLIB_CHAR *s, Py_ssize_t count)
 {
-    if ((count > output->end - output->ptr) && !output_extend(output, count))
-        return 0;
-    memcpy(output->ptr, s, count * sizeof(STRINGLIB_CHAR));
-    output->ptr += count;
-    return 1;
+    return STRINGLIB_WRITER_WRITE(output, s, count) == 0;
 }
 
 /************************************************************************/
@@ -975,7 +922,7 @@ do_markup(SubString *input, PyObject *args, PyObject *kwargs,
 
 
 /*
-    build_string allocates the output string and then
+    build_string sets up the output string and then
     calls do_markup to do the heavy lifting.
 */
 static PyObject *
@@ -984,9 +931,8 @@ build_string(SubString *input, PyObject *args, PyObject *kwargs,
 {
     OutputString output;
     PyObject *result = NULL;
-    Py_ssize_t count;
 
-    output.obj = NULL; /* needed so cleanup code always works */
+    STRINGLIB_WRITER_INIT(&output); /* needed so cleanup code always works */
 
     /* check the recursion level */
     if (recursion_depth <= 0) {
@@ -995,29 +941,15 @@ build_string(SubString *input, PyObject *args, PyObject *kwargs,
         goto done;
     }
 
-    /* initial size is the length of the format string, plus the size
-       increment.  seems like a reasonable default */
-    if (!output_initialize(&output,
-                           input->end - input->ptr +
-                           INITIAL_SIZE_INCREMENT))
-        goto done;
-
     if (!do_markup(input, args, kwargs, &output, recursion_depth,
                    auto_number)) {
         goto done;
     }
 
-    count = output.ptr - STRINGLIB_STR(output.obj);
-    if (STRINGLIB_RESIZE(&output.obj, count) < 0) {
-        goto done;
-    }
-
-    /* transfer ownership to result */
-    result = output.obj;
-    output.obj = NULL;
+    result = STRINGLIB_WRITER_FINISH(&output);
 
 done:
-    Py_XDECREF(output.obj);
+    STRINGLIB_WRITER_DEALLOC(&output);
     return result;
 }
 
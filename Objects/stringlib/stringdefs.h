@@ -22,6 +22,11 @@
 #define STRINGLIB_LEN            PyString_GET_SIZE
 #define STRINGLIB_NEW            PyString_FromStringAndSize
 #define STRINGLIB_RESIZE         _PyString_Resize
+#define STRINGLIB_WRITER         _PyStringWriter
+#define STRINGLIB_WRITER_INIT(writer) _PyStringWriter_Init((writer), NULL, 0)
+#define STRINGLIB_WRITER_WRITE   _PyStringWriter_Write
+#define STRINGLIB_WRITER_FINISH  _PyStringWriter_Finish
+#define STRINGLIB_WRITER_DEALLOC _PyStringWriter_Dealloc
 #define STRINGLIB_CHECK          PyString_Check
 #define STRINGLIB_CHECK_EXACT    PyString_CheckExact
 #define STRINGLIB_TOSTR          PyObject_Str
@@ -0,0 +1,6 @@
+/* stringlib: kernels for the one-byte characters of compact unicode
+   objects.  Include this before a kernel and "stringlib/undef.h" after
+   it; the kernels get a ucs1lib_ prefix. */
+
+#define STRINGLIB_CHAR           Py_UCS1
+#define STRINGLIB(F)             ucs1lib_##F
@@ -0,0 +1,6 @@
+/* stringlib: kernels for the two-byte characters of compact unicode
+   objects in UCS4 builds.  Include this before a kernel and
+   "stringlib/undef.h" after it; the kernels get a ucs2lib_ prefix. */
+
+#define STRINGLIB_CHAR           Py_UCS2
+#define STRINGLIB(F)             ucs2lib_##F
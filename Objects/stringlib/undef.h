@@ -0,0 +1,4 @@
+/* stringlib: forget the definitions made by ucs1lib.h or ucs2lib.h */
+
+#undef STRINGLIB_CHAR
+#undef STRINGLIB
@@ -22,6 +22,11 @@
 #define STRINGLIB_LEN            PyUnicode_GET_SIZE
 #define STRINGLIB_NEW            PyUnicode_FromUnicode
 #define STRINGLIB_RESIZE         PyUnicode_Resize
+#define STRINGLIB_WRITER         _PyUnicodeWriter
+#define STRINGLIB_WRITER_INIT    _PyUnicodeWriter_Init
+#define STRINGLIB_WRITER_WRITE   _PyUnicodeWriter_Write
+#define STRINGLIB_WRITER_FINISH  _PyUnicodeWriter_Finish
+#define STRINGLIB_WRITER_DEALLOC _PyUnicodeWriter_Dealloc
 #define STRINGLIB_CHECK          PyUnicode_Check
 #define STRINGLIB_CHECK_EXACT    PyUnicode_CheckExact
 #define STRINGLIB_GROUPING       _PyUnicode_InsertThousandsGrouping
@@ -32,6 +37,4 @@
 #define STRINGLIB_TOSTR          PyObject_Str
 #endif
 
-#define STRINGLIB_WANT_CONTAINS_OBJ 1
-
 #endif /* !STRINGLIB_UNICODEDEFS_H */
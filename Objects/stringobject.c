@@ -21,7 +21,7 @@ static PyStringObject *nullstring;
    function will delete the reference from this dictionary.
 
    Another way to look at this is that to say that the actual reference
-   count of a string is:  s->ob_refcnt + (s->ob_sstate?2:0)
+   count of a string is:  Py_REFCNT(s) + (s->ob_sstate?2:0)
 */
 static PyObject *interned;
 
@@ -1648,6 +1648,120 @@ PyDoc_STRVAR(join__doc__,
 Return a string which is the concatenation of the strings in the\n\
 iterable.  The separator between elements is S.");
 
+#ifdef Py_USING_UNICODE
+/* Finish join() over an iterator with PyUnicode_Join(), once item, the
+   i-th, turns out to be unicode; writer holds the items before it. */
+static PyObject *
+string_join_unicode(PyStringObject *self, _PyStringWriter *writer,
+                    Py_ssize_t i, PyObject *item, PyObject *it)
+{
+    PyObject *rest, *joined, *result;
+    Py_ssize_t k;
+
+    rest = PySequence_List(it);
+    if (rest == NULL)
+        return NULL;
+    /* PyUnicode_Join() gets the items before this one as a single
+       string, so report a bad item with its index here */
+    for (k = 0; k < PyList_GET_SIZE(rest); k++) {
+        PyObject *v = PyList_GET_ITEM(rest, k);
+        if (!PyString_Check(v) && !PyUnicode_Check(v)) {
+            PyErr_Format(PyExc_TypeError,
+                         "sequence item %zd: expected string or Unicode,"
+                         " %.80s found",
+                         i + 1 + k, Py_TYPE(v)->tp_name);
+            Py_DECREF(rest);
+            return NULL;
+        }
+    }
+    if (PyList_Insert(rest, 0, item) < 0) {
+        Py_DECREF(rest);
+        return NULL;
+    }
+    if (i > 0) {
+        joined = _PyStringWriter_Finish(writer);
+        if (joined == NULL || PyList_Insert(rest, 0, joined) < 0) {
+            Py_XDECREF(joined);
+            Py_DECREF(rest);
+            return NULL;
+        }
+        Py_DECREF(joined);
+    }
+    result = PyUnicode_Join((PyObject *)self, rest);
+    Py_DECREF(rest);
+    return result;
+}
+#endif
+
+/* join() over an iterable that isn't a list or a tuple: write the items
+   as they come rather than make a list of them first. */
+static PyObject *
+string_join_iterable(PyStringObject *self, PyObject *orig)
+{
+    char *sep = PyString_AS_STRING(self);
+    const Py_ssize_t seplen = PyString_GET_SIZE(self);
+    _PyStringWriter writer;
+    char small_buffer[_PyStringWriter_SMALL];
+    PyObject *it, *item, *first = NULL, *result;
+    Py_ssize_t i;
+
+    it = PyObject_GetIter(orig);
+    if (it == NULL) {
+        if (PyErr_ExceptionMatches(PyExc_TypeError))
+            PyErr_SetString(PyExc_TypeError, "");
+        return NULL;
+    }
+    _PyStringWriter_Init(&writer, small_buffer, sizeof(small_buffer));
+    for (i = 0; (item = PyIter_Next(it)) != NULL; i++) {
+        if (!PyString_Check(item)) {
+#ifdef Py_USING_UNICODE
+            if (PyUnicode_Check(item)) {
+                result = string_join_unicode(self, &writer, i, item, it);
+                Py_DECREF(item);
+                goto done;
+            }
+#endif
+            PyErr_Format(PyExc_TypeError,
+                         "sequence item %zd: expected string,"
+                         " %.80s found",
+                         i, Py_TYPE(item)->tp_name);
+            Py_DECREF(item);
+            goto error;
+        }
+        if (i > 0 && _PyStringWriter_Write(&writer, sep, seplen) < 0)
+            goto error_item;
+        if (_PyStringWriter_Write(&writer, PyString_AS_STRING(item),
+                                  PyString_GET_SIZE(item)) < 0)
+            goto error_item;
+        /* a single exact string is returned as it is */
+        if (i == 0)
+            first = item;
+        else {
+            Py_CLEAR(first);
+            Py_DECREF(item);
+        }
+    }
+    if (PyErr_Occurred())
+        goto error;
+    if (first != NULL && PyString_CheckExact(first)) {
+        result = first;
+        first = NULL;
+    }
+    else
+        result = _PyStringWriter_Finish(&writer);
+    goto done;
+
+  error_item:
+    Py_DECREF(item);
+  error:
+    result = NULL;
+  done:
+    Py_XDECREF(first);
+    _PyStringWriter_Dealloc(&writer);
+    Py_DECREF(it);
+    return result;
+}
+
 static PyObject *
 string_join(PyStringObject *self, PyObject *orig)
 {
@@ -1660,6 +1774,11 @@ string_join(PyStringObject *self, PyObject *orig)
     Py_ssize_t i;
     PyObject *seq, *item;
 
+    /* the items of a list or a tuple are sized up before they are
+       copied; other iterables go through a _PyStringWriter */
+    if (!PyList_CheckExact(orig) && !PyTuple_CheckExact(orig))
+        return string_join_iterable(self, orig);
+
     seq = PySequence_Fast(orig, "");
     if (seq == NULL) {
         return NULL;
@@ -2406,23 +2525,6 @@ return_self(PyStringObject *self)
         PyString_GET_SIZE(self));
 }
 
-Py_LOCAL_INLINE(Py_ssize_t)
-countchar(const char *target, int target_len, char c, Py_ssize_t maxcount)
-{
-    Py_ssize_t count=0;
-    const char *start=target;
-    const char *end=target+target_len;
-
-    while ( (start=findchar(start, end-start, c)) != NULL ) {
-        count++;
-        if (count >= maxcount)
-            break;
-        start += 1;
-    }
-    return count;
-}
-
-
 /* Algorithms for different cases of string replacement */
 
 /* len(self)>=1, from="", len(to)>=1, maxcount>=1 */
@@ -2484,101 +2586,6 @@ replace_interleave(PyStringObject *self,
     return result;
 }
 
-/* Special case for deleting a single character */
-/* len(self)>=1, len(from)==1, to="", maxcount>=1 */
-Py_LOCAL(PyStringObject *)
-replace_delete_single_character(PyStringObject *self,
-                                char from_c, Py_ssize_t maxcount)
-{
-    char *self_s, *result_s;
-    char *start, *next, *end;
-    Py_ssize_t self_len, result_len;
-    Py_ssize_t count;
-    PyStringObject *result;
-
-    self_len = PyString_GET_SIZE(self);
-    self_s = PyString_AS_STRING(self);
-
-    count = countchar(self_s, self_len, from_c, maxcount);
-    if (count == 0) {
-        return return_self(self);
-    }
-
-    result_len = self_len - count;  /* from_len == 1 */
-    assert(result_len>=0);
-
-    if ( (result = (PyStringObject *)
-                    PyString_FromStringAndSize(NULL, result_len)) == NULL)
-        return NULL;
-    result_s = PyString_AS_STRING(result);
-
-    start = self_s;
-    end = self_s + self_len;
-    while (count-- > 0) {
-        next = findchar(start, end-start, from_c);
-        if (next == NULL)
-            break;
-        Py_MEMCPY(result_s, start, next-start);
-        result_s += (next-start);
-        start = next+1;
-    }
-    Py_MEMCPY(result_s, start, end-start);
-
-    return result;
-}
-
-/* len(self)>=1, len(from)>=2, to="", maxcount>=1 */
-
-Py_LOCAL(PyStringObject *)
-replace_delete_substring(PyStringObject *self,
-                         const char *from_s, Py_ssize_t from_len,
-                         Py_ssize_t maxcount) {
-    char *self_s, *result_s;
-    char *start, *next, *end;
-    Py_ssize_t self_len, result_len;
-    Py_ssize_t count, offset;
-    PyStringObject *result;
-
-    self_len = PyString_GET_SIZE(self);
-    self_s = PyString_AS_STRING(self);
-
-    count = stringlib_count(self_s, self_len,
-                            from_s, from_len,
-                            maxcount);
-
-    if (count == 0) {
-        /* no matches */
-        return return_self(self);
-    }
-
-    result_len = self_len - (count * from_len);
-    assert (result_len>=0);
-
-    if ( (result = (PyStringObject *)
-          PyString_FromStringAndSize(NULL, result_len)) == NULL )
-        return NULL;
-
-    result_s = PyString_AS_STRING(result);
-
-    start = self_s;
-    end = self_s + self_len;
-    while (count-- > 0) {
-        offset = stringlib_find(start, end-start,
-                                from_s, from_len,
-                                0);
-        if (offset == -1)
-            break;
-        next = start + offset;
-
-        Py_MEMCPY(result_s, start, next-start);
-
-        result_s += (next-start);
-        start = next+from_len;
-    }
-    Py_MEMCPY(result_s, start, end-start);
-    return result;
-}
-
 /* len(self)>=1, len(from)==len(to)==1, maxcount>=1 */
 Py_LOCAL(PyStringObject *)
 replace_single_character_in_place(PyStringObject *self,
@@ -2675,142 +2682,66 @@ replace_substring_in_place(PyStringObject *self,
     return result;
 }
 
-/* len(self)>=1, len(from)==1, len(to)>=2, maxcount>=1 */
-Py_LOCAL(PyStringObject *)
-replace_single_character(PyStringObject *self,
-                         char from_c,
-                         const char *to_s, Py_ssize_t to_len,
-                         Py_ssize_t maxcount)
+/* Return the first match of from_s in start[:end-start], or NULL */
+Py_LOCAL_INLINE(char *)
+find_next(char *start, char *end, const char *from_s, Py_ssize_t from_len)
 {
-    char *self_s, *result_s;
-    char *start, *next, *end;
-    Py_ssize_t self_len, result_len;
-    Py_ssize_t count, product;
-    PyStringObject *result;
+    Py_ssize_t offset;
 
-    self_s = PyString_AS_STRING(self);
-    self_len = PyString_GET_SIZE(self);
-
-    count = countchar(self_s, self_len, from_c, maxcount);
-    if (count == 0) {
-        /* no matches, return unchanged */
-        return return_self(self);
-    }
-
-    /* use the difference between current and new, hence the "-1" */
-    /*   result_len = self_len + count * (to_len-1)  */
-    product = count * (to_len-1);
-    if (product / (to_len-1) != count) {
-        PyErr_SetString(PyExc_OverflowError, "replace string is too long");
-        return NULL;
-    }
-    result_len = self_len + product;
-    if (result_len < 0) {
-        PyErr_SetString(PyExc_OverflowError, "replace string is too long");
-        return NULL;
-    }
-
-    if ( (result = (PyStringObject *)
-          PyString_FromStringAndSize(NULL, result_len)) == NULL)
-        return NULL;
-    result_s = PyString_AS_STRING(result);
-
-    start = self_s;
-    end = self_s + self_len;
-    while (count-- > 0) {
-        next = findchar(start, end-start, from_c);
-        if (next == NULL)
-            break;
-
-        if (next == start) {
-            /* replace with the 'to' */
-            Py_MEMCPY(result_s, to_s, to_len);
-            result_s += to_len;
-            start += 1;
-        } else {
-            /* copy the unchanged old then the 'to' */
-            Py_MEMCPY(result_s, start, next-start);
-            result_s += (next-start);
-            Py_MEMCPY(result_s, to_s, to_len);
-            result_s += to_len;
-            start = next+1;
-        }
-    }
-    /* Copy the remainder of the remaining string */
-    Py_MEMCPY(result_s, start, end-start);
-
-    return result;
+    if (from_len == 1)
+        return findchar(start, end-start, from_s[0]);
+    offset = stringlib_find(start, end-start, from_s, from_len, 0);
+    return offset == -1 ? NULL : start + offset;
 }
 
-/* len(self)>=1, len(from)>=2, len(to)>=2, maxcount>=1 */
+/* The general case, in one pass: the result goes to a _PyStringWriter
+   sized for self, which is all it needs when 'to' isn't longer than
+   'from' */
+/* len(self)>=1, len(from)>=1, len(from)!=len(to), maxcount>=1 */
 Py_LOCAL(PyStringObject *)
 replace_substring(PyStringObject *self,
                   const char *from_s, Py_ssize_t from_len,
                   const char *to_s, Py_ssize_t to_len,
-                  Py_ssize_t maxcount) {
-    char *self_s, *result_s;
+                  Py_ssize_t maxcount)
+{
     char *start, *next, *end;
-    Py_ssize_t self_len, result_len;
-    Py_ssize_t count, offset, product;
-    PyStringObject *result;
-
-    self_s = PyString_AS_STRING(self);
-    self_len = PyString_GET_SIZE(self);
+    _PyStringWriter writer;
+    char small_buffer[_PyStringWriter_SMALL];
 
-    count = stringlib_count(self_s, self_len,
-                            from_s, from_len,
-                            maxcount);
+    start = PyString_AS_STRING(self);
+    end = start + PyString_GET_SIZE(self);
 
-    if (count == 0) {
+    next = find_next(start, end, from_s, from_len);
+    if (next == NULL) {
         /* no matches, return unchanged */
         return return_self(self);
     }
 
-    /* Check for overflow */
-    /*    result_len = self_len + count * (to_len-from_len) */
-    product = count * (to_len-from_len);
-    if (product / (to_len-from_len) != count) {
-        PyErr_SetString(PyExc_OverflowError, "replace string is too long");
-        return NULL;
-    }
-    result_len = self_len + product;
-    if (result_len < 0) {
-        PyErr_SetString(PyExc_OverflowError, "replace string is too long");
-        return NULL;
-    }
-
-    if ( (result = (PyStringObject *)
-          PyString_FromStringAndSize(NULL, result_len)) == NULL)
-        return NULL;
-    result_s = PyString_AS_STRING(result);
-
-    start = self_s;
-    end = self_s + self_len;
-    while (count-- > 0) {
-        offset = stringlib_find(start, end-start,
-                                from_s, from_len,
-                                0);
-        if (offset == -1)
-            break;
-        next = start+offset;
-        if (next == start) {
-            /* replace with the 'to' */
-            Py_MEMCPY(result_s, to_s, to_len);
-            result_s += to_len;
-            start += from_len;
-        } else {
-            /* copy the unchanged old then the 'to' */
-            Py_MEMCPY(result_s, start, next-start);
-            result_s += (next-start);
-            Py_MEMCPY(result_s, to_s, to_len);
-            result_s += to_len;
-            start = next+from_len;
+    _PyStringWriter_Init(&writer, small_buffer, sizeof(small_buffer));
+    writer.overallocate = to_len > from_len;
+    if (_PyStringWriter_PREPARE(&writer, end-start) < 0)
+        goto error;
+    do {
+        /* copy the unchanged old then the 'to' */
+        if (next-start > PY_SSIZE_T_MAX - writer.pos - to_len) {
+            PyErr_SetString(PyExc_OverflowError,
+                            "replace string is too long");
+            goto error;
         }
-    }
+        if (_PyStringWriter_Write(&writer, start, next-start) < 0 ||
+            _PyStringWriter_Write(&writer, to_s, to_len) < 0)
+            goto error;
+        start = next+from_len;
+    } while (--maxcount > 0 &&
+             (next = find_next(start, end, from_s, from_len)) != NULL);
     /* Copy the remainder of the remaining string */
-    Py_MEMCPY(result_s, start, end-start);
+    if (_PyStringWriter_Write(&writer, start, end-start) < 0)
+        goto error;
+    return (PyStringObject *)_PyStringWriter_Finish(&writer);
 
-    return result;
+  error:
+    _PyStringWriter_Dealloc(&writer);
+    return NULL;
 }
 
 
@@ -2849,16 +2780,6 @@ replace(PyStringObject *self,
         return return_self(self);
     }
 
-    if (to_len == 0) {
-        /* delete all occurances of 'from' string */
-        if (from_len == 1) {
-            return replace_delete_single_character(
-                self, from_s[0], maxcount);
-        } else {
-            return replace_delete_substring(self, from_s, from_len, maxcount);
-        }
-    }
-
     /* Handle special case where both strings have the same length */
 
     if (from_len == to_len) {
@@ -2874,14 +2795,9 @@ replace(PyStringObject *self,
         }
     }
 
-    /* Otherwise use the more generic algorithms */
-    if (from_len == 1) {
-        return replace_single_character(self, from_s[0],
-                                        to_s, to_len, maxcount);
-    } else {
-        /* len('from')>=2, len('to')>=1 */
-        return replace_substring(self, from_s, from_len, to_s, to_len, maxcount);
-    }
+    /* Otherwise use the more generic algorithm; this deletes all
+       occurrences of 'from' too, when 'to' is empty */
+    return replace_substring(self, from_s, from_len, to_s, to_len, maxcount);
 }
 
 PyDoc_STRVAR(replace__doc__,
@@ -3996,6 +3912,86 @@ _PyString_Resize(PyObject **pv, Py_ssize_t newsize)
     return 0;
 }
 
+/* _PyStringWriter: see stringobject.h */
+
+void
+_PyStringWriter_Init(_PyStringWriter *writer, char *small_buffer,
+                     Py_ssize_t small_size)
+{
+    writer->str = small_buffer;
+    writer->pos = 0;
+    writer->size = small_size;
+    writer->buffer = NULL;
+    writer->overallocate = 1;
+}
+
+/* Make room for count more bytes; _PyStringWriter_PREPARE() calls this
+   when they don't fit already. */
+int
+_PyStringWriter_Grow(_PyStringWriter *writer, Py_ssize_t count)
+{
+    Py_ssize_t newsize;
+
+    if (count > PY_SSIZE_T_MAX - writer->pos) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    newsize = writer->pos + count;
+    if (newsize <= writer->size)
+        return 0;
+    if (writer->overallocate && newsize <= PY_SSIZE_T_MAX - newsize / 4)
+        newsize += newsize / 4;
+
+    if (writer->buffer == NULL) {
+        writer->buffer = PyString_FromStringAndSize(NULL, newsize);
+        if (writer->buffer == NULL)
+            return -1;
+        if (writer->pos > 0)
+            Py_MEMCPY(PyString_AS_STRING(writer->buffer),
+                      writer->str, writer->pos);
+    }
+    else if (_PyString_Resize(&writer->buffer, newsize) < 0) {
+        /* the buffer is gone; leave the writer empty */
+        _PyStringWriter_Init(writer, NULL, 0);
+        return -1;
+    }
+    writer->str = PyString_AS_STRING(writer->buffer);
+    writer->size = newsize;
+    return 0;
+}
+
+int
+_PyStringWriter_Write(_PyStringWriter *writer, const char *s,
+                      Py_ssize_t count)
+{
+    if (_PyStringWriter_PREPARE(writer, count) < 0)
+        return -1;
+    Py_MEMCPY(writer->str + writer->pos, s, count);
+    writer->pos += count;
+    return 0;
+}
+
+/* Return the string written so far, and leave the writer empty. */
+PyObject *
+_PyStringWriter_Finish(_PyStringWriter *writer)
+{
+    PyObject *result = writer->buffer;
+
+    if (result == NULL)
+        result = PyString_FromStringAndSize(writer->str, writer->pos);
+    else if (writer->pos != writer->size)
+        _PyString_Resize(&result, writer->pos);
+    _PyStringWriter_Init(writer, NULL, 0);
+    return result;
+}
+
+void
+_PyStringWriter_Dealloc(_PyStringWriter *writer)
+{
+    Py_XDECREF(writer->buffer);
+    _PyStringWriter_Init(writer, NULL, 0);
+}
+
 /* Helpers for formatstring */
 
 Py_LOCAL_INLINE(PyObject *)
@@ -4306,11 +4302,13 @@ PyString_Format(PyObject *format, PyObject *args)
 {
     char *fmt, *res;
     Py_ssize_t arglen, argidx;
-    Py_ssize_t reslen, rescnt, fmtcnt;
+    Py_ssize_t fmtcnt;
     int args_owned = 0;
-    PyObject *result, *orig_args;
+    _PyStringWriter writer;
+    char small_buffer[_PyStringWriter_SMALL];
+    PyObject *orig_args;
 #ifdef Py_USING_UNICODE
-    PyObject *v, *w;
+    PyObject *v, *w, *result;
 #endif
     PyObject *dict = NULL;
     if (format == NULL || !PyString_Check(format) || args == NULL) {
@@ -4320,11 +4318,7 @@ PyString_Format(PyObject *format, PyObject *args)
     orig_args = args;
     fmt = PyString_AS_STRING(format);
     fmtcnt = PyString_GET_SIZE(format);
-    reslen = rescnt = fmtcnt + 100;
-    result = PyString_FromStringAndSize((char *)NULL, reslen);
-    if (result == NULL)
-        return NULL;
-    res = PyString_AsString(result);
+    _PyStringWriter_Init(&writer, small_buffer, sizeof(small_buffer));
     if (PyTuple_Check(args)) {
         arglen = PyTuple_GET_SIZE(args);
         argidx = 0;
@@ -4338,16 +4332,13 @@ PyString_Format(PyObject *format, PyObject *args)
         dict = args;
     while (--fmtcnt >= 0) {
         if (*fmt != '%') {
-            if (--rescnt < 0) {
-                rescnt = fmtcnt + 100;
-                reslen += rescnt;
-                if (_PyString_Resize(&result, reslen))
-                    return NULL;
-                res = PyString_AS_STRING(result)
-                    + reslen - rescnt;
-                --rescnt;
-            }
-            *res++ = *fmt++;
+            /* copy the text up to the next '%' */
+            char *next = memchr(fmt, '%', fmtcnt + 1);
+            Py_ssize_t run = next != NULL ? next - fmt : fmtcnt + 1;
+            if (_PyStringWriter_Write(&writer, fmt, run) < 0)
+                goto error;
+            fmt += run;
+            fmtcnt -= run - 1;
         }
         else {
             /* Got a format specifier */
@@ -4659,26 +4650,20 @@ PyString_Format(PyObject *format, PyObject *args)
             }
             if (width < len)
                 width = len;
-            if (rescnt - (sign != 0) < width) {
-                reslen -= rescnt;
-                rescnt = width + fmtcnt + 100;
-                reslen += rescnt;
-                if (reslen < 0) {
-                    Py_DECREF(result);
-                    Py_XDECREF(temp);
-                    return PyErr_NoMemory();
-                }
-                if (_PyString_Resize(&result, reslen)) {
-                    Py_XDECREF(temp);
-                    return NULL;
-                }
-                res = PyString_AS_STRING(result)
-                    + reslen - rescnt;
+            /* the field, and maybe a sign */
+            if (width == PY_SSIZE_T_MAX) {
+                PyErr_NoMemory();
+                Py_XDECREF(temp);
+                goto error;
+            }
+            if (_PyStringWriter_PREPARE(&writer, width + 1) < 0) {
+                Py_XDECREF(temp);
+                goto error;
             }
+            res = writer.str + writer.pos;
             if (sign) {
                 if (fill != ' ')
                     *res++ = sign;
-                rescnt--;
                 if (width > len)
                     width--;
             }
@@ -4689,7 +4674,6 @@ PyString_Format(PyObject *format, PyObject *args)
                     *res++ = *pbuf++;
                     *res++ = *pbuf++;
                 }
-                rescnt -= 2;
                 width -= 2;
                 if (width < 0)
                     width = 0;
@@ -4697,7 +4681,6 @@ PyString_Format(PyObject *format, PyObject *args)
             }
             if (width > len && !(flags & F_LJUST)) {
                 do {
-                    --rescnt;
                     *res++ = fill;
                 } while (--width > len);
             }
@@ -4714,11 +4697,10 @@ PyString_Format(PyObject *format, PyObject *args)
             }
             Py_MEMCPY(res, pbuf, len);
             res += len;
-            rescnt -= len;
             while (--width >= len) {
-                --rescnt;
                 *res++ = ' ';
             }
+            writer.pos = res - writer.str;
             if (dict && (argidx < arglen) && c != '%') {
                 PyErr_SetString(PyExc_TypeError,
                            "not all arguments converted during string formatting");
@@ -4736,9 +4718,7 @@ PyString_Format(PyObject *format, PyObject *args)
     if (args_owned) {
         Py_DECREF(args);
     }
-    if (_PyString_Resize(&result, reslen - rescnt))
-        return NULL;
-    return result;
+    return _PyStringWriter_Finish(&writer);
 
 #ifdef Py_USING_UNICODE
  unicode:
@@ -4766,9 +4746,6 @@ PyString_Format(PyObject *format, PyObject *args)
     args_owned = 1;
     /* Take what we have of the result and let the Unicode formatting
        function format the rest of the input. */
-    rescnt = res - PyString_AS_STRING(result);
-    if (_PyString_Resize(&result, rescnt))
-        goto error;
     fmtcnt = PyString_GET_SIZE(format) - \
              (fmt - PyString_AS_STRING(format));
     format = PyUnicode_Decode(fmt, fmtcnt, NULL, NULL);
@@ -4778,17 +4755,22 @@ PyString_Format(PyObject *format, PyObject *args)
     Py_DECREF(format);
     if (v == NULL)
         goto error;
-    /* Paste what we have (result) to what the Unicode formatting
-       function returned (v) and return the result (or error) */
-    w = PyUnicode_Concat(result, v);
-    Py_DECREF(result);
+    /* Paste what we have to what the Unicode formatting function
+       returned (v) and return the result (or error) */
+    w = _PyStringWriter_Finish(&writer);
+    if (w == NULL) {
+        Py_DECREF(v);
+        goto error;
+    }
+    result = PyUnicode_Concat(w, v);
+    Py_DECREF(w);
     Py_DECREF(v);
     Py_DECREF(args);
-    return w;
+    return result;
 #endif /* Py_USING_UNICODE */
 
  error:
-    Py_DECREF(result);
+    _PyStringWriter_Dealloc(&writer);
     if (args_owned) {
         Py_DECREF(args);
     }
@@ -18,6 +18,9 @@
 static PyTupleObject *free_list[PyTuple_MAXSAVESIZE];
 static int numfree[PyTuple_MAXSAVESIZE];
 #endif
+
+/* maxfree is per size, numfree the total over all sizes */
+_PyFreeList _PyTuple_FreeList = {"tuple", PyTuple_MAXFREELIST, 0, 0, 0};
 #ifdef COUNT_ALLOCS
 Py_ssize_t fast_tuple_allocs;
 Py_ssize_t tuple_zero_allocs;
@@ -66,6 +69,8 @@ PyTuple_New(register Py_ssize_t size)
     if (size < PyTuple_MAXSAVESIZE && (op = free_list[size]) != NULL) {
         free_list[size] = (PyTupleObject *) op->ob_item[0];
         numfree[size]--;
+        _PyTuple_FreeList.numfree--;
+        _PyFreeList_HIT(_PyTuple_FreeList);
 #ifdef COUNT_ALLOCS
         fast_tuple_allocs++;
 #endif
@@ -90,6 +95,7 @@ PyTuple_New(register Py_ssize_t size)
         op = PyObject_GC_NewVar(PyTupleObject, &PyTuple_Type, size);
         if (op == NULL)
             return NULL;
+        _PyFreeList_MISS(_PyTuple_FreeList);
     }
     for (i=0; i < size; i++)
         op->ob_item[i] = NULL;
@@ -137,7 +143,7 @@ PyTuple_SetItem(register PyObject *op, register Py_ssize_t i, PyObject *newitem)
 {
     register PyObject *olditem;
     register PyObject **p;
-    if (!PyTuple_Check(op) || op->ob_refcnt != 1) {
+    if (!PyTuple_Check(op) || Py_REFCNT(op) != 1) {
         Py_XDECREF(newitem);
         PyErr_BadInternalCall();
         return -1;
@@ -220,11 +226,12 @@ tupledealloc(register PyTupleObject *op)
             Py_XDECREF(op->ob_item[i]);
 #if PyTuple_MAXSAVESIZE > 0
         if (len < PyTuple_MAXSAVESIZE &&
-            numfree[len] < PyTuple_MAXFREELIST &&
+            numfree[len] < _PyTuple_FreeList.maxfree &&
             Py_TYPE(op) == &PyTuple_Type)
         {
             op->ob_item[0] = (PyObject *) free_list[len];
             numfree[len]++;
+            _PyTuple_FreeList.numfree++;
             free_list[len] = op;
             goto done; /* return */
         }
@@ -264,8 +271,9 @@ static PyObject *
 tuplerepr(PyTupleObject *v)
 {
     Py_ssize_t i, n;
-    PyObject *s, *temp;
-    PyObject *pieces, *result = NULL;
+    PyObject *s;
+    _PyStringWriter writer;
+    int status;
 
     n = Py_SIZE(v);
     if (n == 0)
@@ -280,52 +288,38 @@ tuplerepr(PyTupleObject *v)
         return i > 0 ? PyString_FromString("(...)") : NULL;
     }
 
-    pieces = PyTuple_New(n);
-    if (pieces == NULL)
-        return NULL;
+    _PyStringWriter_Init(&writer, NULL, 0);
+    if (_PyStringWriter_Write(&writer, "(", 1) < 0)
+        goto Error;
 
-    /* Do repr() on each element. */
+    /* Do repr() on each element, and paste them together with ", "
+       between. */
     for (i = 0; i < n; ++i) {
+        if (i > 0 && _PyStringWriter_Write(&writer, ", ", 2) < 0)
+            goto Error;
         if (Py_EnterRecursiveCall(" while getting the repr of a tuple"))
-            goto Done;
+            goto Error;
         s = PyObject_Repr(v->ob_item[i]);
         Py_LeaveRecursiveCall();
         if (s == NULL)
-            goto Done;
-        PyTuple_SET_ITEM(pieces, i, s);
+            goto Error;
+        status = _PyStringWriter_Write(&writer, PyString_AS_STRING(s),
+                                       PyString_GET_SIZE(s));
+        Py_DECREF(s);
+        if (status < 0)
+            goto Error;
     }
 
-    /* Add "()" decorations to the first and last items. */
-    assert(n > 0);
-    s = PyString_FromString("(");
-    if (s == NULL)
-        goto Done;
-    temp = PyTuple_GET_ITEM(pieces, 0);
-    PyString_ConcatAndDel(&s, temp);
-    PyTuple_SET_ITEM(pieces, 0, s);
-    if (s == NULL)
-        goto Done;
-
-    s = PyString_FromString(n == 1 ? ",)" : ")");
-    if (s == NULL)
-        goto Done;
-    temp = PyTuple_GET_ITEM(pieces, n-1);
-    PyString_ConcatAndDel(&temp, s);
-    PyTuple_SET_ITEM(pieces, n-1, temp);
-    if (temp == NULL)
-        goto Done;
-
-    /* Paste them all together with ", " between. */
-    s = PyString_FromString(", ");
-    if (s == NULL)
-        goto Done;
-    result = _PyString_Join(s, pieces);
-    Py_DECREF(s);
-
-Done:
-    Py_DECREF(pieces);
+    if (n == 1 ? _PyStringWriter_Write(&writer, ",)", 2) < 0
+               : _PyStringWriter_Write(&writer, ")", 1) < 0)
+        goto Error;
     Py_ReprLeave((PyObject *)v);
-    return result;
+    return _PyStringWriter_Finish(&writer);
+
+Error:
+    _PyStringWriter_Dealloc(&writer);
+    Py_ReprLeave((PyObject *)v);
+    return NULL;
 }
 
 /* The addend 82520, was selected from the range(0, 1000000) for
@@ -916,6 +910,7 @@ PyTuple_ClearFreeList(void)
             PyObject_GC_Del(q);
         }
     }
+    _PyTuple_FreeList.numfree = 0;
 #endif
     return freelist_size;
 }
@@ -729,9 +729,9 @@ type_call(PyTypeObject *type, PyObject *args, PyObject *kwds)
             return obj;
         /* If the returned object is not an instance of type,
            it won't be initialized. */
-        if (!PyType_IsSubtype(obj->ob_type, type))
+        if (!PyType_IsSubtype(Py_TYPE(obj), type))
             return obj;
-        type = obj->ob_type;
+        type = Py_TYPE(obj);
         if (PyType_HasFeature(type, Py_TPFLAGS_HAVE_CLASS) &&
             type->tp_init != NULL &&
             type->tp_init(obj, args, kwds) < 0) {
@@ -906,7 +906,7 @@ subtype_dealloc(PyObject *self)
         /* Maybe call finalizer; exit early if resurrected */
         if (type->tp_del) {
             type->tp_del(self);
-            if (self->ob_refcnt > 0)
+            if (Py_REFCNT(self) > 0)
                 return;
         }
 
@@ -964,7 +964,7 @@ subtype_dealloc(PyObject *self)
     if (type->tp_del) {
         _PyObject_GC_TRACK(self);
         type->tp_del(self);
-        if (self->ob_refcnt > 0)
+        if (Py_REFCNT(self) > 0)
             goto endlabel;              /* resurrected */
         else
             _PyObject_GC_UNTRACK(self);
@@ -1815,7 +1815,7 @@ raise_dict_descr_error(PyObject *obj)
 {
     PyErr_Format(PyExc_TypeError,
                  "this __dict__ descriptor does not support "
-                 "'%.200s' objects", obj->ob_type->tp_name);
+                 "'%.200s' objects", Py_TYPE(obj)->tp_name);
 }
 
 static PyObject *
@@ -1825,7 +1825,7 @@ subtype_dict(PyObject *obj, void *context)
     PyObject *dict;
     PyTypeObject *base;
 
-    base = get_builtin_base_with_dict(obj->ob_type);
+    base = get_builtin_base_with_dict(Py_TYPE(obj));
     if (base != NULL) {
         descrgetfunc func;
         PyObject *descr = get_dict_descriptor(base);
@@ -1833,12 +1833,12 @@ subtype_dict(PyObject *obj, void *context)
             raise_dict_descr_error(obj);
             return NULL;
         }
-        func = descr->ob_type->tp_descr_get;
+        func = Py_TYPE(descr)->tp_descr_get;
         if (func == NULL) {
             raise_dict_descr_error(obj);
             return NULL;
         }
-        return func(descr, obj, (PyObject *)(obj->ob_type));
+        return func(descr, obj, (PyObject *)(Py_TYPE(obj)));
     }
 
     dictptr = _PyObject_GetDictPtr(obj);
@@ -1849,7 +1849,7 @@ subtype_dict(PyObject *obj, void *context)
     }
     dict = *dictptr;
     if (dict == NULL)
-        *dictptr = dict = PyDict_New();
+        *dictptr = dict = _PyObjectDict_New(Py_TYPE(obj));
     Py_XINCREF(dict);
     return dict;
 }
@@ -1861,7 +1861,7 @@ subtype_setdict(PyObject *obj, PyObject *value, void *context)
     PyObject *dict;
     PyTypeObject *base;
 
-    base = get_builtin_base_with_dict(obj->ob_type);
+    base = get_builtin_base_with_dict(Py_TYPE(obj));
     if (base != NULL) {
         descrsetfunc func;
         PyObject *descr = get_dict_descriptor(base);
@@ -1869,7 +1869,7 @@ subtype_setdict(PyObject *obj, PyObject *value, void *context)
             raise_dict_descr_error(obj);
             return -1;
         }
-        func = descr->ob_type->tp_descr_set;
+        func = Py_TYPE(descr)->tp_descr_set;
         if (func == NULL) {
             raise_dict_descr_error(obj);
             return -1;
@@ -2054,7 +2054,7 @@ type_new(PyTypeObject *metatype, PyObject *args, PyObject *kwds)
     assert(args != NULL && PyTuple_Check(args));
     assert(kwds == NULL || PyDict_Check(kwds));
 
-    /* Special case: type(x) should return x->ob_type */
+    /* Special case: type(x) should return Py_TYPE(x) */
     {
         const Py_ssize_t nargs = PyTuple_GET_SIZE(args);
         const Py_ssize_t nkwds = kwds == NULL ? 0 : PyDict_Size(kwds);
@@ -2090,7 +2090,7 @@ type_new(PyTypeObject *metatype, PyObject *args, PyObject *kwds)
     winner = metatype;
     for (i = 0; i < nbases; i++) {
         tmp = PyTuple_GET_ITEM(bases, i);
-        tmptype = tmp->ob_type;
+        tmptype = Py_TYPE(tmp);
         if (tmptype == &PyClass_Type)
             continue; /* Special case classic classes */
         if (PyType_IsSubtype(winner, tmptype))
@@ -2455,6 +2455,15 @@ type_new(PyTypeObject *metatype, PyObject *args, PyObject *kwds)
         return NULL;
     }
 
+    /* The dicts of the instances share their keys */
+    if (type->tp_dictoffset) {
+        et->ht_cached_keys = _PyDict_NewKeysForClass();
+        if (et->ht_cached_keys == NULL) {
+            Py_DECREF(type);
+            return NULL;
+        }
+    }
+
     /* Put the proper slots in place */
     fixup_slot_dispatchers(type);
 
@@ -2630,6 +2639,8 @@ type_dealloc(PyTypeObject *type)
     PyObject_Free((char *)type->tp_doc);
     Py_XDECREF(et->ht_name);
     Py_XDECREF(et->ht_slots);
+    if (et->ht_cached_keys != NULL)
+        _PyDictKeys_DecRef(et->ht_cached_keys);
     Py_TYPE(type)->tp_free((PyObject *)type);
 }
 
@@ -3478,10 +3489,10 @@ object_sizeof(PyObject *self, PyObject *args)
     Py_ssize_t res, isize;
 
     res = 0;
-    isize = self->ob_type->tp_itemsize;
+    isize = Py_TYPE(self)->tp_itemsize;
     if (isize > 0)
-        res = self->ob_type->ob_size * isize;
-    res += self->ob_type->tp_basicsize;
+        res = Py_TYPE(self)->ob_size * isize;
+    res += Py_TYPE(self)->tp_basicsize;
 
     return PyInt_FromSsize_t(res);
 }
@@ -4230,8 +4241,8 @@ wrap_binaryfunc_l(PyObject *self, PyObject *args, void *wrapped)
     if (!check_num_args(args, 1))
         return NULL;
     other = PyTuple_GET_ITEM(args, 0);
-    if (!(self->ob_type->tp_flags & Py_TPFLAGS_CHECKTYPES) &&
-        !PyType_IsSubtype(other->ob_type, self->ob_type)) {
+    if (!(Py_TYPE(self)->tp_flags & Py_TPFLAGS_CHECKTYPES) &&
+        !PyType_IsSubtype(Py_TYPE(other), Py_TYPE(self))) {
         Py_INCREF(Py_NotImplemented);
         return Py_NotImplemented;
     }
@@ -4247,8 +4258,8 @@ wrap_binaryfunc_r(PyObject *self, PyObject *args, void *wrapped)
     if (!check_num_args(args, 1))
         return NULL;
     other = PyTuple_GET_ITEM(args, 0);
-    if (!(self->ob_type->tp_flags & Py_TPFLAGS_CHECKTYPES) &&
-        !PyType_IsSubtype(other->ob_type, self->ob_type)) {
+    if (!(Py_TYPE(self)->tp_flags & Py_TPFLAGS_CHECKTYPES) &&
+        !PyType_IsSubtype(Py_TYPE(other), Py_TYPE(self))) {
         Py_INCREF(Py_NotImplemented);
         return Py_NotImplemented;
     }
@@ -5147,7 +5158,7 @@ slot_nb_nonzero(PyObject *self)
                              "bool or int, returned %s",
                              (using_len ? "__len__"
                                         : "__nonzero__"),
-                             temp->ob_type->tp_name);
+                             Py_TYPE(temp)->tp_name);
                 result = -1;
             }
             Py_DECREF(temp);
@@ -5179,8 +5190,8 @@ slot_nb_coerce(PyObject **a, PyObject **b)
     static PyObject *coerce_str;
     PyObject *self = *a, *other = *b;
 
-    if (self->ob_type->tp_as_number != NULL &&
-        self->ob_type->tp_as_number->nb_coerce == slot_nb_coerce) {
+    if (Py_TYPE(self)->tp_as_number != NULL &&
+        Py_TYPE(self)->tp_as_number->nb_coerce == slot_nb_coerce) {
         PyObject *r;
         r = call_maybe(
             self, "__coerce__", &coerce_str, "(O)", other);
@@ -5204,8 +5215,8 @@ slot_nb_coerce(PyObject **a, PyObject **b)
             return 0;
         }
     }
-    if (other->ob_type->tp_as_number != NULL &&
-        other->ob_type->tp_as_number->nb_coerce == slot_nb_coerce) {
+    if (Py_TYPE(other)->tp_as_number != NULL &&
+        Py_TYPE(other)->tp_as_number->nb_coerce == slot_nb_coerce) {
         PyObject *r;
         r = call_maybe(
             other, "__coerce__", &coerce_str, "(O)", self);
@@ -5603,6 +5614,24 @@ static PyObject *
 slot_tp_iternext(PyObject *self)
 {
     static PyObject *next_str;
+    PyObject *func;
+
+    if (next_str == NULL) {
+        next_str = PyString_InternFromString("next");
+        if (next_str == NULL)
+            return NULL;
+    }
+    /* For a plain Python method, skip the bound method and call the
+       function directly; a StopIteration it raises then reaches the
+       caller's FOR_ITER as cheaply as possible (see ceval.c). */
+    func = _PyType_Lookup(Py_TYPE(self), next_str);
+    if (func != NULL && PyFunction_Check(func)) {
+        PyObject *res;
+        Py_INCREF(func);
+        res = PyObject_CallFunctionObjArgs(func, self, NULL);
+        Py_DECREF(func);
+        return res;
+    }
     return call_method(self, "next", &next_str, "()");
 }
 
@@ -5717,8 +5746,8 @@ slot_tp_del(PyObject *self)
     PyObject *error_type, *error_value, *error_traceback;
 
     /* Temporarily resurrect the object. */
-    assert(self->ob_refcnt == 0);
-    self->ob_refcnt = 1;
+    assert(Py_REFCNT(self) == 0);
+    Py_REFCNT(self) = 1;
 
     /* Save the current exception, if any. */
     PyErr_Fetch(&error_type, &error_value, &error_traceback);
@@ -5740,17 +5769,17 @@ slot_tp_del(PyObject *self)
     /* Undo the temporary resurrection; can't use DECREF here, it would
      * cause a recursive call.
      */
-    assert(self->ob_refcnt > 0);
-    if (--self->ob_refcnt == 0)
+    assert(Py_REFCNT(self) > 0);
+    if (--Py_REFCNT(self) == 0)
         return;         /* this is the normal path out */
 
     /* __del__ resurrected it!  Make it look like the original Py_DECREF
      * never happened.
      */
     {
-        Py_ssize_t refcnt = self->ob_refcnt;
+        Py_ssize_t refcnt = Py_REFCNT(self);
         _Py_NewReference(self);
-        self->ob_refcnt = refcnt;
+        Py_REFCNT(self) = refcnt;
     }
     assert(!PyType_IS_GC(Py_TYPE(self)) ||
            _Py_AS_GC(self)->gc.gc_refs != _PyGC_REFS_UNTRACKED);
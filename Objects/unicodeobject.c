@@ -246,6 +246,298 @@ Py_LOCAL_INLINE(int) unicode_member(Py_UNICODE chr, Py_UNICODE* set, Py_ssize_t
 #define BLOOM_MEMBER(mask, chr, set, setlen)                    \
     BLOOM(mask, chr) && unicode_member(chr, set, setlen)
 
+/* --- Compact storage ----------------------------------------------------
+
+   In builds configured --with-compact-unicode, a string whose code units
+   all fit in one byte, or in UCS4 builds in two, may be kept in the
+   narrow buffer data instead, with str NULL and kind giving the bytes per
+   code unit.  Like str, data has room for a terminating zero.
+
+   PyUnicode_AS_UNICODE() builds the wide buffer when it is first asked
+   for, and the string stays wide from then on.  Hashing, comparison,
+   indexing, slicing, concatenation, searching and the UTF-8, ASCII and
+   Latin-1 encoders read the narrow buffer directly; split(), replace()
+   and friends read a temporary wide copy.  The decoders,
+   PyUnicode_FromUnicode() and join() make their results compact whenever
+   they fit.  Strings shorter than two characters are never compact, so
+   unicode_empty and the shared one-character strings are always wide.
+
+*/
+
+#ifdef Py_COMPACT_UNICODE
+
+typedef unsigned char Py_UCS1;
+typedef unsigned short Py_UCS2;
+
+/* The code unit at index i of the compact string u */
+#if Py_UNICODE_SIZE == 4
+#define COMPACT_READ(u, i)                                      \
+    ((u)->kind == 1 ? (Py_UNICODE)((Py_UCS1 *)(u)->data)[i] :   \
+     (Py_UNICODE)((Py_UCS2 *)(u)->data)[i])
+#else
+#define COMPACT_READ(u, i) ((Py_UNICODE)((Py_UCS1 *)(u)->data)[i])
+#endif
+
+/* The code unit at index i of any string, without widening it */
+#define UNICODE_READ(u, i) \
+    ((u)->str != NULL ? (u)->str[i] : COMPACT_READ(u, i))
+
+/* Return the bytes per code unit that the n code units at s need. */
+static int
+unicode_kind(const Py_UNICODE *s, Py_ssize_t n)
+{
+    Py_UCS4 bits = 0;
+    Py_ssize_t i;
+
+    /* Or-ing the code units bounds the largest, in a loop that vectorizes */
+    for (i = 0; i < n; i++)
+        bits |= s[i];
+    if (bits < 0x100)
+        return 1;
+#if Py_UNICODE_SIZE == 4
+    if (bits < 0x10000)
+        return 2;
+#endif
+    return Py_UNICODE_SIZE;
+}
+
+/* Copy n code units from the wide buffer src to the narrow buffer dest. */
+static void
+compact_narrow(void *dest, int kind, const Py_UNICODE *src, Py_ssize_t n)
+{
+    Py_ssize_t i;
+
+    if (kind == 1) {
+        Py_UCS1 *d = (Py_UCS1 *)dest;
+        for (i = 0; i < n; i++)
+            d[i] = (Py_UCS1)src[i];
+    }
+    else {
+        Py_UCS2 *d = (Py_UCS2 *)dest;
+        for (i = 0; i < n; i++)
+            d[i] = (Py_UCS2)src[i];
+    }
+}
+
+/* Copy n code units from the narrow buffer src to the wide buffer dest. */
+static void
+compact_widen(Py_UNICODE *dest, const void *src, int kind, Py_ssize_t n)
+{
+    Py_ssize_t i;
+
+    if (kind == 1) {
+        const Py_UCS1 *s = (const Py_UCS1 *)src;
+        for (i = 0; i < n; i++)
+            dest[i] = s[i];
+    }
+    else {
+        const Py_UCS2 *s = (const Py_UCS2 *)src;
+        for (i = 0; i < n; i++)
+            dest[i] = s[i];
+    }
+}
+
+/* Copy n code units of u, from index start, to the narrow buffer dest;
+   they must fit in its kind. */
+static void
+compact_copy(void *dest, int kind, PyUnicodeObject *u,
+             Py_ssize_t start, Py_ssize_t n)
+{
+    Py_ssize_t i;
+
+    if (u->str != NULL)
+        compact_narrow(dest, kind, u->str + start, n);
+    else if (u->kind == kind)
+        Py_MEMCPY(dest, (char *)u->data + start * kind, n * kind);
+    else if (kind == 2) {
+        const Py_UCS1 *s = (const Py_UCS1 *)u->data + start;
+        for (i = 0; i < n; i++)
+            ((Py_UCS2 *)dest)[i] = s[i];
+    }
+    else {
+        const Py_UCS2 *s = (const Py_UCS2 *)u->data + start;
+        for (i = 0; i < n; i++)
+            ((Py_UCS1 *)dest)[i] = (Py_UCS1)s[i];
+    }
+}
+
+/* Create a compact string of the given length and kind, for the caller
+   to fill in. */
+static PyUnicodeObject *
+compact_new(Py_ssize_t length, int kind)
+{
+    register PyUnicodeObject *unicode;
+
+    if (length > PY_SSIZE_T_MAX / kind - 1)
+        return (PyUnicodeObject *)PyErr_NoMemory();
+
+#ifndef _SYMBEX_INTERNED
+    if (free_list) {
+        unicode = free_list;
+        free_list = *(PyUnicodeObject **)unicode;
+        numfree--;
+        /* Drop the buffer kept alive for a wide string */
+        if (unicode->str) {
+            PyObject_DEL(unicode->str);
+            unicode->str = NULL;
+        }
+        PyObject_INIT(unicode, &PyUnicode_Type);
+    } else {
+#else
+    {
+#endif
+        unicode = PyObject_New(PyUnicodeObject, &PyUnicode_Type);
+        if (unicode == NULL)
+            return NULL;
+        unicode->str = NULL;
+    }
+
+    unicode->data = PyObject_MALLOC(kind * ((size_t)length + 1));
+    if (unicode->data == NULL) {
+        PyErr_NoMemory();
+        _Py_DEC_REFTOTAL;
+        _Py_ForgetReference((PyObject *)unicode);
+        PyObject_Del(unicode);
+        return NULL;
+    }
+    if (kind == 1)
+        ((Py_UCS1 *)unicode->data)[length] = 0;
+    else
+        ((Py_UCS2 *)unicode->data)[length] = 0;
+    unicode->kind = kind;
+    unicode->length = length;
+    unicode->hash = -1;
+    unicode->defenc = NULL;
+    return unicode;
+}
+
+/* Create a compact string of the size Latin-1 bytes at s. */
+static PyObject *
+compact_from_latin1(const char *s, Py_ssize_t size)
+{
+    PyUnicodeObject *unicode = compact_new(size, 1);
+
+    if (unicode != NULL)
+        Py_MEMCPY(unicode->data, s, size);
+    return (PyObject *)unicode;
+}
+
+/* Return u[start:start+n] for the compact string u. */
+static PyObject *
+compact_slice(PyUnicodeObject *u, Py_ssize_t start, Py_ssize_t n)
+{
+    PyUnicodeObject *w;
+    Py_UNICODE ch;
+
+    if (n < 2) {
+        /* Go through the cache of short strings */
+        ch = n ? COMPACT_READ(u, start) : 0;
+        return PyUnicode_FromUnicode(&ch, n);
+    }
+    w = compact_new(n, u->kind);
+    if (w != NULL)
+        Py_MEMCPY(w->data, (char *)u->data + start * u->kind, n * u->kind);
+    return (PyObject *)w;
+}
+
+/* Move the freshly built wide string unicode to compact storage if it
+   fits.  This only saves memory, so it quietly gives up if it can't.
+   Strings of one character or none are left alone, since those may be
+   shared. */
+static void
+unicode_compact(PyUnicodeObject *unicode)
+{
+    void *data;
+    int kind;
+
+    if (unicode->str == NULL || unicode->length < 2)
+        return;
+    kind = unicode_kind(unicode->str, unicode->length);
+    if (kind == Py_UNICODE_SIZE)
+        return;
+    data = PyObject_MALLOC(kind * ((size_t)unicode->length + 1));
+    if (data == NULL)
+        return;
+    compact_narrow(data, kind, unicode->str, unicode->length + 1);
+    PyObject_DEL(unicode->str);
+    unicode->str = NULL;
+    unicode->data = data;
+    unicode->kind = kind;
+}
+
+/* Give the compact string unicode its wide buffer, for good.  This is
+   what PyUnicode_AS_UNICODE() calls. */
+Py_UNICODE *
+_PyUnicode_Widen(PyUnicodeObject *unicode)
+{
+    Py_UNICODE *str;
+
+    assert(unicode->str == NULL);
+    if (unicode->length > ((PY_SSIZE_T_MAX / sizeof(Py_UNICODE)) - 1)) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    str = (Py_UNICODE *)PyObject_MALLOC(
+        sizeof(Py_UNICODE) * ((size_t)unicode->length + 1));
+    if (str == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    compact_widen(str, unicode->data, unicode->kind, unicode->length + 1);
+    PyObject_DEL(unicode->data);
+    unicode->data = NULL;
+    unicode->kind = Py_UNICODE_SIZE;
+    unicode->str = str;
+    return str;
+}
+
+/* Return the wide buffer of u, for code that only reads it.  A compact
+   string stays compact and lends a temporary copy instead, which
+   unicode_unborrow() frees. */
+static Py_UNICODE *
+unicode_borrow(PyUnicodeObject *u)
+{
+    Py_UNICODE *w;
+
+    if (u->str != NULL)
+        return u->str;
+    w = PyMem_New(Py_UNICODE, u->length + 1);
+    if (w == NULL)
+        return (Py_UNICODE *)PyErr_NoMemory();
+    compact_widen(w, u->data, u->kind, u->length + 1);
+    return w;
+}
+
+static void
+unicode_unborrow(PyUnicodeObject *u, Py_UNICODE *w)
+{
+    if (w != u->str)
+        PyMem_Free(w);
+}
+
+#else
+
+#define UNICODE_READ(u, i) ((u)->str[i])
+#define unicode_compact(unicode)
+#define unicode_borrow(u) ((u)->str)
+#define unicode_unborrow(u, w)
+
+#endif /* Py_COMPACT_UNICODE */
+
+/* Copy n code units of u, from index start, to the wide buffer dest. */
+static void
+unicode_copy(Py_UNICODE *dest, PyUnicodeObject *u,
+             Py_ssize_t start, Py_ssize_t n)
+{
+#ifdef Py_COMPACT_UNICODE
+    if (u->str == NULL) {
+        compact_widen(dest, (char *)u->data + start * u->kind, u->kind, n);
+        return;
+    }
+#endif
+    Py_UNICODE_COPY(dest, u->str + start, n);
+}
+
 /* --- Unicode Object ----------------------------------------------------- */
 
 static
@@ -258,6 +550,11 @@ int unicode_resize(register PyUnicodeObject *unicode,
     if (unicode->length == length)
         goto reset;
 
+#ifdef Py_COMPACT_UNICODE
+    if (unicode->str == NULL && _PyUnicode_Widen(unicode) == NULL)
+        return -1;
+#endif
+
     /* Resizing shared object (unicode_empty or single character
        objects) in-place is not allowed. Use PyUnicode_Resize()
        instead ! */
@@ -377,6 +674,10 @@ PyUnicodeObject *_PyUnicode_New(Py_ssize_t length)
      */
     unicode->str[0] = 0;
     unicode->str[length] = 0;
+#ifdef Py_COMPACT_UNICODE
+    unicode->data = NULL;
+    unicode->kind = Py_UNICODE_SIZE;
+#endif
 #ifdef _SYMBEX_VARSIZE
     unicode->length = sym_length;
 #else
@@ -406,6 +707,13 @@ void unicode_dealloc(register PyUnicodeObject *unicode)
             unicode->str = NULL;
             unicode->length = 0;
         }
+#ifdef Py_COMPACT_UNICODE
+        if (unicode->data) {
+            PyObject_DEL(unicode->data);
+            unicode->data = NULL;
+            unicode->length = 0;
+        }
+#endif
         if (unicode->defenc) {
             Py_CLEAR(unicode->defenc);
         }
@@ -419,6 +727,9 @@ void unicode_dealloc(register PyUnicodeObject *unicode)
     {
 #endif
         PyObject_DEL(unicode->str);
+#ifdef Py_COMPACT_UNICODE
+        PyObject_DEL(unicode->data);
+#endif
         Py_XDECREF(unicode->defenc);
         Py_TYPE(unicode)->tp_free((PyObject *)unicode);
     }
@@ -448,8 +759,8 @@ int _PyUnicode_Resize(PyUnicodeObject **unicode, Py_ssize_t length)
         PyUnicodeObject *w = _PyUnicode_New(length);
         if (w == NULL)
             return -1;
-        Py_UNICODE_COPY(w->str, v->str,
-                        length < v->length ? length : v->length);
+        unicode_copy(w->str, v, 0,
+                     length < v->length ? length : v->length);
         Py_DECREF(*unicode);
         *unicode = w;
         return 0;
@@ -465,6 +776,84 @@ int PyUnicode_Resize(PyObject **unicode, Py_ssize_t length)
     return _PyUnicode_Resize((PyUnicodeObject **)unicode, length);
 }
 
+/* _PyUnicodeWriter: see unicodeobject.h */
+
+void _PyUnicodeWriter_Init(_PyUnicodeWriter *writer)
+{
+    writer->str = writer->small_buffer;
+    writer->pos = 0;
+    writer->size = _PyUnicodeWriter_SMALL;
+    writer->buffer = NULL;
+    writer->overallocate = 1;
+}
+
+/* Make room for count more characters; _PyUnicodeWriter_PREPARE() calls
+   this when they don't fit already. */
+int _PyUnicodeWriter_Grow(_PyUnicodeWriter *writer, Py_ssize_t count)
+{
+    Py_ssize_t newsize;
+
+    if (count > PY_SSIZE_T_MAX - writer->pos) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    newsize = writer->pos + count;
+    if (newsize <= writer->size)
+        return 0;
+    if (writer->overallocate && newsize <= PY_SSIZE_T_MAX - newsize / 4)
+        newsize += newsize / 4;
+
+    if (writer->buffer == NULL) {
+        PyUnicodeObject *buffer = _PyUnicode_New(newsize);
+        if (buffer == NULL)
+            return -1;
+        Py_UNICODE_COPY(buffer->str, writer->small_buffer, writer->pos);
+        writer->buffer = (PyObject *)buffer;
+    }
+    else if (_PyUnicode_Resize((PyUnicodeObject **)&writer->buffer,
+                               newsize) < 0)
+        return -1;
+    writer->str = ((PyUnicodeObject *)writer->buffer)->str;
+    writer->size = newsize;
+    return 0;
+}
+
+int _PyUnicodeWriter_Write(_PyUnicodeWriter *writer,
+                           const Py_UNICODE *s, Py_ssize_t count)
+{
+    if (_PyUnicodeWriter_PREPARE(writer, count) < 0)
+        return -1;
+    Py_UNICODE_COPY(writer->str + writer->pos, s, count);
+    writer->pos += count;
+    return 0;
+}
+
+/* Return the Unicode object written so far, and leave the writer
+   empty. */
+PyObject *_PyUnicodeWriter_Finish(_PyUnicodeWriter *writer)
+{
+    PyUnicodeObject *result = (PyUnicodeObject *)writer->buffer;
+
+    if (result == NULL)
+        result = (PyUnicodeObject *)PyUnicode_FromUnicode(
+            writer->small_buffer, writer->pos);
+    else {
+        if (writer->pos != writer->size &&
+            _PyUnicode_Resize(&result, writer->pos) < 0)
+            Py_CLEAR(result);
+        if (result != NULL)
+            unicode_compact(result);
+    }
+    _PyUnicodeWriter_Init(writer);
+    return (PyObject *)result;
+}
+
+void _PyUnicodeWriter_Dealloc(_PyUnicodeWriter *writer)
+{
+    Py_XDECREF(writer->buffer);
+    _PyUnicodeWriter_Init(writer);
+}
+
 PyObject *PyUnicode_FromUnicode(const Py_UNICODE *u,
                                 Py_ssize_t size)
 {
@@ -496,6 +885,18 @@ PyObject *PyUnicode_FromUnicode(const Py_UNICODE *u,
             return (PyObject *)unicode;
         }
 #endif /* _SYMBEX_INTERNED */
+
+#ifdef Py_COMPACT_UNICODE
+        if (size > 1) {
+            int kind = unicode_kind(u, size);
+            if (kind != Py_UNICODE_SIZE) {
+                unicode = compact_new(size, kind);
+                if (unicode != NULL)
+                    compact_narrow(unicode->data, kind, u, size);
+                return (PyObject *)unicode;
+            }
+        }
+#endif
     }
 
     unicode = _PyUnicode_New(size);
@@ -1071,14 +1472,12 @@ Py_ssize_t PyUnicode_AsWideChar(PyUnicodeObject *unicode,
         size = PyUnicode_GET_SIZE(unicode) + 1;
 
 #ifdef HAVE_USABLE_WCHAR_T
-    memcpy(w, unicode->str, size * sizeof(wchar_t));
+    unicode_copy((Py_UNICODE *)w, unicode, 0, size);
 #else
     {
-        register Py_UNICODE *u;
         register Py_ssize_t i;
-        u = PyUnicode_AS_UNICODE(unicode);
-        for (i = size; i > 0; i--)
-            *w++ = *u++;
+        for (i = 0; i < size; i++)
+            *w++ = UNICODE_READ(unicode, i);
     }
 #endif
 
@@ -1884,6 +2283,106 @@ encode_char:
 #undef DECODE_DIRECT
 #undef ENCODE_DIRECT
 
+/* --- ASCII runs --------------------------------------------------------- */
+
+/* Text is mostly ASCII, so the UTF-8, ASCII and Latin-1 codecs convert runs
+   of ASCII characters in bulk.  The end of a run is found a machine word at
+   a time:  a word whose bytes, or whose code units, are all below 0x80 is
+   skipped in one test.  Words are only read at aligned addresses, so that
+   they never straddle the end of the buffer.  The run is then widened or
+   narrowed by a plain loop, which compilers turn into vector code. */
+
+#define WORD_ALIGN_MASK (SIZEOF_SIZE_T - 1)
+#define IS_WORD_ALIGNED(p) (((Py_uintptr_t)(p) & WORD_ALIGN_MASK) == 0)
+#define WORDS_END(end, type) \
+    ((type *)((Py_uintptr_t)(end) & ~(Py_uintptr_t)WORD_ALIGN_MASK))
+
+/* The high bit of each byte of a word */
+#define ASCII_CHAR_MASK ((size_t)-1 / 0xFF * 0x80)
+
+/* The bits of each Py_UNICODE of a word that are set in non-ASCII units */
+#define UNICODE_ASCII_WORDS (SIZEOF_SIZE_T >= Py_UNICODE_SIZE)
+#if Py_UNICODE_SIZE == 2
+#define UNICODE_ASCII_MASK ((size_t)-1 / 0xFFFFU * 0xFF80U)
+#else
+#define UNICODE_ASCII_MASK ((size_t)-1 / 0xFFFFFFFFU * 0xFFFFFF80U)
+#endif
+#define UNICODE_PER_WORD (SIZEOF_SIZE_T / Py_UNICODE_SIZE)
+
+/* Is there an aligned word of ASCII code units at p? */
+#if UNICODE_ASCII_WORDS
+#define UNICODE_ASCII_WORD_AT(p, end)                   \
+    (IS_WORD_ALIGNED(p) && (p) + UNICODE_PER_WORD <= (end) && \
+     !(*(const size_t *)(p) & UNICODE_ASCII_MASK))
+#else
+#define UNICODE_ASCII_WORD_AT(p, end) 0
+#endif
+
+/* Return the number of ASCII bytes at the start of [start, end). */
+Py_LOCAL_INLINE(Py_ssize_t)
+ascii_run(const char *start, const char *end)
+{
+    const char *p = start;
+    const char *words_end = WORDS_END(end, const char);
+
+    while (p < end) {
+        if (IS_WORD_ALIGNED(p)) {
+            while (p < words_end &&
+                   !(*(const size_t *)p & ASCII_CHAR_MASK))
+                p += SIZEOF_SIZE_T;
+            if (p == end)
+                break;
+        }
+        if ((unsigned char)*p & 0x80)
+            break;
+        p++;
+    }
+    return p - start;
+}
+
+/* Widen the ASCII bytes at the start of [start, end) into dest.  Return
+   their number. */
+Py_LOCAL_INLINE(Py_ssize_t)
+ascii_decode(const char *start, const char *end, Py_UNICODE *dest)
+{
+    Py_ssize_t i, n = ascii_run(start, end);
+
+    for (i = 0; i < n; i++)
+        dest[i] = (unsigned char)start[i];
+    return n;
+}
+
+/* Narrow the ASCII code units at the start of [start, end) into dest.
+   Return their number. */
+Py_LOCAL_INLINE(Py_ssize_t)
+ascii_encode(const Py_UNICODE *start, const Py_UNICODE *end, char *dest)
+{
+    const Py_UNICODE *p = start;
+#if UNICODE_ASCII_WORDS
+    const Py_UNICODE *words_end = WORDS_END(end, const Py_UNICODE);
+#endif
+    Py_ssize_t i, n;
+
+    while (p < end) {
+#if UNICODE_ASCII_WORDS
+        if (IS_WORD_ALIGNED(p)) {
+            while (p < words_end &&
+                   !(*(const size_t *)p & UNICODE_ASCII_MASK))
+                p += UNICODE_PER_WORD;
+            if (p == end)
+                break;
+        }
+#endif
+        if (*p >= 0x80)
+            break;
+        p++;
+    }
+    n = p - start;
+    for (i = 0; i < n; i++)
+        dest[i] = (char)start[i];
+    return n;
+}
+
 /* --- UTF-8 Codec -------------------------------------------------------- */
 
 static
@@ -1933,6 +2432,15 @@ PyObject *PyUnicode_DecodeUTF8Stateful(const char *s,
     PyObject *errorHandler = NULL;
     PyObject *exc = NULL;
 
+#ifdef Py_COMPACT_UNICODE
+    /* ASCII input is copied as it is */
+    if (size > 1 && ascii_run(s, s + size) == size) {
+        if (consumed)
+            *consumed = size;
+        return compact_from_latin1(s, size);
+    }
+#endif
+
     /* Note: size will always be longer than the resulting Unicode
        character count */
     unicode = _PyUnicode_New(size);
@@ -1952,8 +2460,9 @@ PyObject *PyUnicode_DecodeUTF8Stateful(const char *s,
         Py_UCS4 ch = (unsigned char)*s;
 
         if (ch < 0x80) {
-            *p++ = (Py_UNICODE)ch;
-            s++;
+            Py_ssize_t run = ascii_decode(s, e, p);
+            s += run;
+            p += run;
             continue;
         }
 
@@ -2083,6 +2592,7 @@ PyObject *PyUnicode_DecodeUTF8Stateful(const char *s,
     /* Adjust length */
     if (_PyUnicode_Resize(&unicode, p - unicode->str) < 0)
         goto onError;
+    unicode_compact(unicode);
 
     Py_XDECREF(errorHandler);
     Py_XDECREF(exc);
@@ -2138,13 +2648,22 @@ PyUnicode_EncodeUTF8(const Py_UNICODE *s,
     }
 
     for (i = 0; i < size;) {
-        Py_UCS4 ch = s[i++];
+        Py_UCS4 ch = s[i];
 
-        if (ch < 0x80)
-            /* Encode ASCII */
+        if (ch < 0x80) {
+            /* Encode ASCII, in bulk if a word of it follows */
             *p++ = (char) ch;
+            i++;
+            if (UNICODE_ASCII_WORD_AT(s + i, s + size)) {
+                Py_ssize_t run = ascii_encode(s + i, s + size, p);
+                i += run;
+                p += run;
+            }
+            continue;
+        }
+        i++;
 
-        else if (ch < 0x0800) {
+        if (ch < 0x0800) {
             /* Encode Latin-1 */
             *p++ = (char)(0xc0 | (ch >> 6));
             *p++ = (char)(0x80 | (ch & 0x3f));
@@ -2196,12 +2715,73 @@ PyUnicode_EncodeUTF8(const Py_UNICODE *s,
 #undef MAX_SHORT_UNICHARS
 }
 
+#ifdef Py_COMPACT_UNICODE
+
+/* PyUnicode_EncodeUTF8() for a compact string, which needs at most two
+   bytes per one-byte code unit and three per two-byte one. */
+static PyObject *
+compact_encode_utf8(PyUnicodeObject *u)
+{
+    Py_ssize_t i, n = u->length;
+    PyObject *v;
+    char *p;
+
+    if (u->kind == 1 && ascii_run((char *)u->data, (char *)u->data + n) == n)
+        return PyString_FromStringAndSize((char *)u->data, n);
+    if (n > PY_SSIZE_T_MAX / (u->kind + 1))
+        return PyErr_NoMemory();
+    v = PyString_FromStringAndSize(NULL, n * (u->kind + 1));
+    if (v == NULL)
+        return NULL;
+    p = PyString_AS_STRING(v);
+
+    for (i = 0; i < n;) {
+        Py_UCS4 ch = COMPACT_READ(u, i);
+
+        i++;
+        if (ch < 0x80)
+            *p++ = (char) ch;
+        else if (ch < 0x0800) {
+            *p++ = (char)(0xc0 | (ch >> 6));
+            *p++ = (char)(0x80 | (ch & 0x3f));
+        }
+        else {
+            /* Join surrogate pairs, as PyUnicode_EncodeUTF8() does */
+            if (0xD800 <= ch && ch <= 0xDBFF && i != n) {
+                Py_UCS4 ch2 = COMPACT_READ(u, i);
+                if (0xDC00 <= ch2 && ch2 <= 0xDFFF) {
+                    ch = ((ch - 0xD800) << 10 | (ch2 - 0xDC00)) + 0x10000;
+                    i++;
+                    *p++ = (char)(0xf0 | (ch >> 18));
+                    *p++ = (char)(0x80 | ((ch >> 12) & 0x3f));
+                    *p++ = (char)(0x80 | ((ch >> 6) & 0x3f));
+                    *p++ = (char)(0x80 | (ch & 0x3f));
+                    continue;
+                }
+            }
+            *p++ = (char)(0xe0 | (ch >> 12));
+            *p++ = (char)(0x80 | ((ch >> 6) & 0x3f));
+            *p++ = (char)(0x80 | (ch & 0x3f));
+        }
+    }
+
+    if (_PyString_Resize(&v, p - PyString_AS_STRING(v)))
+        return NULL;
+    return v;
+}
+
+#endif /* Py_COMPACT_UNICODE */
+
 PyObject *PyUnicode_AsUTF8String(PyObject *unicode)
 {
     if (!PyUnicode_Check(unicode)) {
         PyErr_BadArgument();
         return NULL;
     }
+#ifdef Py_COMPACT_UNICODE
+    if (((PyUnicodeObject *)unicode)->str == NULL)
+        return compact_encode_utf8((PyUnicodeObject *)unicode);
+#endif
     return PyUnicode_EncodeUTF8(PyUnicode_AS_UNICODE(unicode),
                                 PyUnicode_GET_SIZE(unicode),
                                 NULL);
@@ -2371,6 +2951,7 @@ PyUnicode_DecodeUTF32Stateful(const char *s,
     /* Adjust length */
     if (_PyUnicode_Resize(&unicode, p - unicode->str) < 0)
         goto onError;
+    unicode_compact(unicode);
 
     Py_XDECREF(errorHandler);
     Py_XDECREF(exc);
@@ -2645,6 +3226,7 @@ PyUnicode_DecodeUTF16Stateful(const char *s,
     /* Adjust length */
     if (_PyUnicode_Resize(&unicode, p - unicode->str) < 0)
         goto onError;
+    unicode_compact(unicode);
 
     Py_XDECREF(errorHandler);
     Py_XDECREF(exc);
@@ -2965,6 +3547,7 @@ PyObject *PyUnicode_DecodeUnicodeEscape(const char *s,
     }
     if (_PyUnicode_Resize(&v, p - PyUnicode_AS_UNICODE(v)) < 0)
         goto onError;
+    unicode_compact(v);
     Py_XDECREF(errorHandler);
     Py_XDECREF(exc);
     return (PyObject *)v;
@@ -3281,6 +3864,7 @@ PyObject *PyUnicode_DecodeRawUnicodeEscape(const char *s,
     }
     if (_PyUnicode_Resize(&v, p - PyUnicode_AS_UNICODE(v)) < 0)
         goto onError;
+    unicode_compact(v);
     Py_XDECREF(errorHandler);
     Py_XDECREF(exc);
     return (PyObject *)v;
@@ -3456,6 +4040,7 @@ PyObject *_PyUnicode_DecodeUnicodeInternal(const char *s,
 
     if (_PyUnicode_Resize(&v, p - PyUnicode_AS_UNICODE(v)) < 0)
         goto onError;
+    unicode_compact(v);
     Py_XDECREF(errorHandler);
     Py_XDECREF(exc);
     return (PyObject *)v;
@@ -3482,6 +4067,11 @@ PyObject *PyUnicode_DecodeLatin1(const char *s,
         return PyUnicode_FromUnicode(&r, 1);
     }
 
+#ifdef Py_COMPACT_UNICODE
+    if (size > 1)
+        return compact_from_latin1(s, size);
+#endif
+
     v = _PyUnicode_New(size);
     if (v == NULL)
         goto onError;
@@ -3627,8 +4217,13 @@ static PyObject *unicode_encode_ucs1(const Py_UNICODE *p,
         Py_UNICODE c = *p;
 
         /* can we encode this? */
-        if (c<limit) {
+        if (c < 0x80) {
             /* no overflow check, because we know that the space is enough */
+            Py_ssize_t run = ascii_encode(p, endp, str);
+            str += run;
+            p += run;
+        }
+        else if (c<limit) {
             *str++ = (char)c;
             ++p;
         }
@@ -3772,10 +4367,27 @@ PyObject *PyUnicode_EncodeLatin1(const Py_UNICODE *p,
 
 PyObject *PyUnicode_AsLatin1String(PyObject *unicode)
 {
+#ifdef Py_COMPACT_UNICODE
+    PyUnicodeObject *u = (PyUnicodeObject *)unicode;
+    Py_UNICODE *w;
+    PyObject *v;
+#endif
+
     if (!PyUnicode_Check(unicode)) {
         PyErr_BadArgument();
         return NULL;
     }
+#ifdef Py_COMPACT_UNICODE
+    if (u->str == NULL) {
+        if (u->kind == 1)
+            return PyString_FromStringAndSize((char *)u->data, u->length);
+        if ((w = unicode_borrow(u)) == NULL)
+            return NULL;
+        v = PyUnicode_EncodeLatin1(w, u->length, NULL);
+        unicode_unborrow(u, w);
+        return v;
+    }
+#endif
     return PyUnicode_EncodeLatin1(PyUnicode_AS_UNICODE(unicode),
                                   PyUnicode_GET_SIZE(unicode),
                                   NULL);
@@ -3803,6 +4415,11 @@ PyObject *PyUnicode_DecodeASCII(const char *s,
         return PyUnicode_FromUnicode(&r, 1);
     }
 
+#ifdef Py_COMPACT_UNICODE
+    if (size > 1 && ascii_run(s, s + size) == size)
+        return compact_from_latin1(s, size);
+#endif
+
     v = _PyUnicode_New(size);
     if (v == NULL)
         goto onError;
@@ -3813,8 +4430,9 @@ PyObject *PyUnicode_DecodeASCII(const char *s,
     while (s < e) {
         register unsigned char c = (unsigned char)*s;
         if (c < 128) {
-            *p++ = c;
-            ++s;
+            Py_ssize_t run = ascii_decode(s, e, p);
+            s += run;
+            p += run;
         }
         else {
             startinpos = s-starts;
@@ -3851,10 +4469,28 @@ PyObject *PyUnicode_EncodeASCII(const Py_UNICODE *p,
 
 PyObject *PyUnicode_AsASCIIString(PyObject *unicode)
 {
+#ifdef Py_COMPACT_UNICODE
+    PyUnicodeObject *u = (PyUnicodeObject *)unicode;
+    Py_UNICODE *w;
+    PyObject *v;
+#endif
+
     if (!PyUnicode_Check(unicode)) {
         PyErr_BadArgument();
         return NULL;
     }
+#ifdef Py_COMPACT_UNICODE
+    if (u->str == NULL) {
+        char *data = (char *)u->data;
+        if (u->kind == 1 && ascii_run(data, data + u->length) == u->length)
+            return PyString_FromStringAndSize(data, u->length);
+        if ((w = unicode_borrow(u)) == NULL)
+            return NULL;
+        v = PyUnicode_EncodeASCII(w, u->length, NULL);
+        unicode_unborrow(u, w);
+        return v;
+    }
+#endif
     return PyUnicode_EncodeASCII(PyUnicode_AS_UNICODE(unicode),
                                  PyUnicode_GET_SIZE(unicode),
                                  NULL);
@@ -4227,6 +4863,7 @@ PyObject *PyUnicode_DecodeCharmap(const char *s,
     if (p - PyUnicode_AS_UNICODE(v) < PyUnicode_GET_SIZE(v))
         if (_PyUnicode_Resize(&v, p - PyUnicode_AS_UNICODE(v)) < 0)
             goto onError;
+    unicode_compact(v);
     Py_XDECREF(errorHandler);
     Py_XDECREF(exc);
     return (PyObject *)v;
@@ -5272,6 +5909,17 @@ int PyUnicode_EncodeDecimal(Py_UNICODE *s,
 
 /* --- Helpers ------------------------------------------------------------ */
 
+#ifdef Py_COMPACT_UNICODE
+#include "stringlib/ucs1lib.h"
+#include "stringlib/fastsearch.h"
+#include "stringlib/undef.h"
+#if Py_UNICODE_SIZE == 4
+#include "stringlib/ucs2lib.h"
+#include "stringlib/fastsearch.h"
+#include "stringlib/undef.h"
+#endif
+#endif
+
 #include "stringlib/unicodedefs.h"
 #include "stringlib/fastsearch.h"
 
@@ -5295,6 +5943,141 @@ int PyUnicode_EncodeDecimal(Py_UNICODE *s,
             start = 0;                          \
     }
 
+#ifdef Py_COMPACT_UNICODE
+
+/* Short needles are narrowed on the stack */
+#define COMPACT_NEEDLE_SIZE 64
+
+/* fastsearch() for the compact haystack str.  The needle is narrowed to
+   the haystack's kind, unless it has characters that can't be found
+   there. */
+static Py_ssize_t
+compact_fastsearch(PyUnicodeObject *str, Py_ssize_t start, Py_ssize_t end,
+                   PyUnicodeObject *sub, Py_ssize_t maxcount, int mode)
+{
+    Py_UCS2 stackbuf[COMPACT_NEEDLE_SIZE];
+    void *needle = stackbuf;
+    char *haystack;
+    Py_ssize_t m = sub->length;
+    Py_ssize_t result;
+    int kind = str->kind;
+
+    if (m > end - start)
+        return -1;
+    if (sub->str != NULL ? unicode_kind(sub->str, m) > kind
+                         : sub->kind > kind)
+        return -1;
+    if (sub->str == NULL && sub->kind == kind)
+        needle = sub->data;
+    else {
+        if (m > COMPACT_NEEDLE_SIZE) {
+            needle = PyMem_Malloc(m * kind);
+            if (needle == NULL) {
+                PyErr_NoMemory();
+                return -2;
+            }
+        }
+        compact_copy(needle, kind, sub, 0, m);
+    }
+
+    haystack = (char *)str->data + start * kind;
+#if Py_UNICODE_SIZE == 4
+    if (kind == 2)
+        result = ucs2lib_fastsearch((Py_UCS2 *)haystack, end - start,
+                                    (Py_UCS2 *)needle, m, maxcount, mode);
+    else
+#endif
+        result = ucs1lib_fastsearch((Py_UCS1 *)haystack, end - start,
+                                    (Py_UCS1 *)needle, m, maxcount, mode);
+
+    if (needle != stackbuf && needle != sub->data)
+        PyMem_Free(needle);
+    return result;
+}
+
+/* fastsearch() over str[start:end], for strings of any storage.  Returns
+   -2 on error. */
+static Py_ssize_t
+unicode_fastsearch(PyUnicodeObject *str, Py_ssize_t start, Py_ssize_t end,
+                   PyUnicodeObject *sub, Py_ssize_t maxcount, int mode)
+{
+    Py_UNICODE *w;
+    Py_ssize_t result;
+
+    if (str->str == NULL)
+        return compact_fastsearch(str, start, end, sub, maxcount, mode);
+    if (sub->str == NULL) {
+        if ((w = unicode_borrow(sub)) == NULL)
+            return -2;
+        result = fastsearch(str->str + start, end - start,
+                            w, sub->length, maxcount, mode);
+        unicode_unborrow(sub, w);
+        return result;
+    }
+    return fastsearch(str->str + start, end - start,
+                      sub->str, sub->length, maxcount, mode);
+}
+
+#endif /* Py_COMPACT_UNICODE */
+
+/* stringlib_find_slice() and stringlib_rfind_slice() on unicode objects;
+   -2 on error */
+static Py_ssize_t
+unicode_find_slice(PyUnicodeObject *str, PyUnicodeObject *sub,
+                   Py_ssize_t start, Py_ssize_t end, int direction)
+{
+#ifdef Py_COMPACT_UNICODE
+    if (str->str == NULL || sub->str == NULL) {
+        Py_ssize_t pos;
+
+        ADJUST_INDICES(start, end, str->length);
+        if (end - start < 0)
+            return -1;
+        if (sub->length == 0)
+            return direction > 0 ? start : end;
+
+        pos = unicode_fastsearch(str, start, end, sub, -1,
+                                 direction > 0 ? FAST_SEARCH : FAST_RSEARCH);
+        if (pos >= 0)
+            pos += start;
+        return pos;
+    }
+#endif
+    if (direction > 0)
+        return stringlib_find_slice(str->str, str->length,
+                                    sub->str, sub->length, start, end);
+    return stringlib_rfind_slice(str->str, str->length,
+                                 sub->str, sub->length, start, end);
+}
+
+/* stringlib_count() on str[start:end]; -1 on error */
+static Py_ssize_t
+unicode_count_slice(PyUnicodeObject *str, PyUnicodeObject *sub,
+                    Py_ssize_t start, Py_ssize_t end, Py_ssize_t maxcount)
+{
+    ADJUST_INDICES(start, end, str->length);
+#ifdef Py_COMPACT_UNICODE
+    if (str->str == NULL || sub->str == NULL) {
+        Py_ssize_t count;
+
+        if (end - start < 0)
+            return 0;
+        if (sub->length == 0)
+            return (end - start < maxcount) ? end - start + 1 : maxcount;
+
+        count = unicode_fastsearch(str, start, end, sub, maxcount,
+                                   FAST_COUNT);
+        if (count == -2)
+            return -1;
+        if (count < 0)
+            return 0;   /* no match */
+        return count;
+    }
+#endif
+    return stringlib_count(str->str + start, end - start,
+                           sub->str, sub->length, maxcount);
+}
+
 Py_ssize_t PyUnicode_Count(PyObject *str,
                            PyObject *substr,
                            Py_ssize_t start,
@@ -5313,11 +6096,8 @@ Py_ssize_t PyUnicode_Count(PyObject *str,
         return -1;
     }
 
-    ADJUST_INDICES(start, end, str_obj->length);
-    result = stringlib_count(
-        str_obj->str + start, end - start, sub_obj->str, sub_obj->length,
-        PY_SSIZE_T_MAX
-        );
+    result = unicode_count_slice(str_obj, sub_obj, start, end,
+                                 PY_SSIZE_T_MAX);
 
     Py_DECREF(sub_obj);
     Py_DECREF(str_obj);
@@ -5342,18 +6122,9 @@ Py_ssize_t PyUnicode_Find(PyObject *str,
         return -2;
     }
 
-    if (direction > 0)
-        result = stringlib_find_slice(
-            PyUnicode_AS_UNICODE(str), PyUnicode_GET_SIZE(str),
-            PyUnicode_AS_UNICODE(sub), PyUnicode_GET_SIZE(sub),
-            start, end
-            );
-    else
-        result = stringlib_rfind_slice(
-            PyUnicode_AS_UNICODE(str), PyUnicode_GET_SIZE(str),
-            PyUnicode_AS_UNICODE(sub), PyUnicode_GET_SIZE(sub),
-            start, end
-            );
+    result = unicode_find_slice((PyUnicodeObject *)str,
+                                (PyUnicodeObject *)sub,
+                                start, end, direction);
 
     Py_DECREF(str);
     Py_DECREF(sub);
@@ -5376,13 +6147,19 @@ int tailmatch(PyUnicodeObject *self,
     if (end < start)
         return 0;
 
-    if (direction > 0) {
-        if (Py_UNICODE_MATCH(self, end, substring))
-            return 1;
-    } else {
-        if (Py_UNICODE_MATCH(self, start, substring))
-            return 1;
+    if (direction > 0)
+        start = end;
+#ifdef Py_COMPACT_UNICODE
+    if (self->str == NULL || substring->str == NULL) {
+        Py_ssize_t i;
+        for (i = 0; i < substring->length; i++)
+            if (UNICODE_READ(self, start + i) != UNICODE_READ(substring, i))
+                return 0;
+        return 1;
     }
+#endif
+    if (Py_UNICODE_MATCH(self, start, substring))
+        return 1;
 
     return 0;
 }
@@ -5426,7 +6203,7 @@ PyObject *fixup(PyUnicodeObject *self,
     if (u == NULL)
         return NULL;
 
-    Py_UNICODE_COPY(u->str, self->str, self->length);
+    unicode_copy(u->str, self, 0, self->length);
 
     if (!fixfct(u) && PyUnicode_CheckExact(self)) {
         /* fixfct should return TRUE if it modified the buffer. If
@@ -5436,6 +6213,7 @@ PyObject *fixup(PyUnicodeObject *self,
         Py_DECREF(u);
         return (PyObject*) self;
     }
+    unicode_compact(u);
     return (PyObject*) u;
 }
 
@@ -5619,7 +6397,7 @@ PyUnicode_Join(PyObject *separator, PyObject *seq)
             internal_separator = PyUnicode_FromObject(separator);
             if (internal_separator == NULL)
                 goto onError;
-            sep = PyUnicode_AS_UNICODE(internal_separator);
+            sep = NULL;     /* copied from internal_separator */
             seplen = PyUnicode_GET_SIZE(internal_separator);
             /* In case PyUnicode_FromObject() mutated seq. */
             seqlen = PySequence_Fast_GET_SIZE(fseq);
@@ -5679,10 +6457,14 @@ PyUnicode_Join(PyObject *separator, PyObject *seq)
         }
 
         /* Copy item, and maybe the separator. */
-        Py_UNICODE_COPY(res_p, PyUnicode_AS_UNICODE(item), itemlen);
+        unicode_copy(res_p, (PyUnicodeObject *)item, 0, itemlen);
         res_p += itemlen;
         if (i < seqlen - 1) {
-            Py_UNICODE_COPY(res_p, sep, seplen);
+            if (sep != NULL)
+                Py_UNICODE_COPY(res_p, sep, seplen);
+            else
+                unicode_copy(res_p, (PyUnicodeObject *)internal_separator,
+                             0, seplen);
             res_p += seplen;
         }
         Py_DECREF(item);
@@ -5694,6 +6476,7 @@ PyUnicode_Join(PyObject *separator, PyObject *seq)
      */
     if (_PyUnicode_Resize(&res, res_used) < 0)
         goto onError;
+    unicode_compact(res);
 
   Done:
     Py_XDECREF(internal_separator);
@@ -5740,7 +6523,7 @@ PyUnicodeObject *pad(PyUnicodeObject *self,
     if (u) {
         if (left)
             Py_UNICODE_FILL(u->str, fill, left);
-        Py_UNICODE_COPY(u->str + left, self->str, self->length);
+        unicode_copy(u->str + left, self, 0, self->length);
         if (right)
             Py_UNICODE_FILL(u->str + left + self->length, fill, right);
     }
@@ -5750,15 +6533,19 @@ PyUnicodeObject *pad(PyUnicodeObject *self,
 
 PyObject *PyUnicode_Splitlines(PyObject *string, int keepends)
 {
-    PyObject *list;
+    PyObject *list = NULL;
+    Py_UNICODE *s;
 
     string = PyUnicode_FromObject(string);
     if (string == NULL)
         return NULL;
 
-    list = stringlib_splitlines(
-        (PyObject*) string, PyUnicode_AS_UNICODE(string),
-        PyUnicode_GET_SIZE(string), keepends);
+    s = unicode_borrow((PyUnicodeObject *)string);
+    if (s != NULL) {
+        list = stringlib_splitlines(
+            (PyObject*) string, s, PyUnicode_GET_SIZE(string), keepends);
+        unicode_unborrow((PyUnicodeObject *)string, s);
+    }
 
     Py_DECREF(string);
     return list;
@@ -5769,19 +6556,31 @@ PyObject *split(PyUnicodeObject *self,
                 PyUnicodeObject *substring,
                 Py_ssize_t maxcount)
 {
+    PyObject *list = NULL;
+    Py_UNICODE *s, *sub = NULL;
+
     if (maxcount < 0)
         maxcount = PY_SSIZE_T_MAX;
 
+    s = unicode_borrow(self);
+    if (s == NULL)
+        return NULL;
+
     if (substring == NULL)
-        return stringlib_split_whitespace(
-            (PyObject*) self,  self->str, self->length, maxcount
+        list = stringlib_split_whitespace(
+            (PyObject*) self,  s, self->length, maxcount
             );
+    else if ((sub = unicode_borrow(substring)) != NULL) {
+        list = stringlib_split(
+            (PyObject*) self,  s, self->length,
+            sub, substring->length,
+            maxcount
+            );
+        unicode_unborrow(substring, sub);
+    }
 
-    return stringlib_split(
-        (PyObject*) self,  self->str, self->length,
-        substring->str, substring->length,
-        maxcount
-        );
+    unicode_unborrow(self, s);
+    return list;
 }
 
 static
@@ -5789,19 +6588,31 @@ PyObject *rsplit(PyUnicodeObject *self,
                  PyUnicodeObject *substring,
                  Py_ssize_t maxcount)
 {
+    PyObject *list = NULL;
+    Py_UNICODE *s, *sub = NULL;
+
     if (maxcount < 0)
         maxcount = PY_SSIZE_T_MAX;
 
+    s = unicode_borrow(self);
+    if (s == NULL)
+        return NULL;
+
     if (substring == NULL)
-        return stringlib_rsplit_whitespace(
-            (PyObject*) self,  self->str, self->length, maxcount
+        list = stringlib_rsplit_whitespace(
+            (PyObject*) self,  s, self->length, maxcount
             );
+    else if ((sub = unicode_borrow(substring)) != NULL) {
+        list = stringlib_rsplit(
+            (PyObject*) self,  s, self->length,
+            sub, substring->length,
+            maxcount
+            );
+        unicode_unborrow(substring, sub);
+    }
 
-    return stringlib_rsplit(
-        (PyObject*) self,  self->str, self->length,
-        substring->str, substring->length,
-        maxcount
-        );
+    unicode_unborrow(self, s);
+    return list;
 }
 
 static
@@ -5810,7 +6621,14 @@ PyObject *replace(PyUnicodeObject *self,
                   PyUnicodeObject *str2,
                   Py_ssize_t maxcount)
 {
-    PyUnicodeObject *u;
+    PyUnicodeObject *u = NULL;
+    Py_UNICODE *s, *s1, *s2;
+
+    s = unicode_borrow(self);
+    s1 = unicode_borrow(str1);
+    s2 = unicode_borrow(str2);
+    if (s == NULL || s1 == NULL || s2 == NULL)
+        goto done;
 
     if (maxcount < 0)
         maxcount = PY_SSIZE_T_MAX;
@@ -5825,14 +6643,14 @@ PyObject *replace(PyUnicodeObject *self,
         if (str1->length == 1) {
             /* replace characters */
             Py_UNICODE u1, u2;
-            if (!findchar(self->str, self->length, str1->str[0]))
+            if (!findchar(s, self->length, s1[0]))
                 goto nothing;
             u = (PyUnicodeObject*) PyUnicode_FromUnicode(NULL, self->length);
             if (!u)
-                return NULL;
-            Py_UNICODE_COPY(u->str, self->str, self->length);
-            u1 = str1->str[0];
-            u2 = str2->str[0];
+                goto done;
+            Py_UNICODE_COPY(u->str, s, self->length);
+            u1 = s1[0];
+            u2 = s2[0];
             for (i = 0; i < u->length; i++)
                 if (u->str[i] == u1) {
                     if (--maxcount < 0)
@@ -5841,26 +6659,26 @@ PyObject *replace(PyUnicodeObject *self,
                 }
         } else {
             i = stringlib_find(
-                self->str, self->length, str1->str, str1->length, 0
+                s, self->length, s1, str1->length, 0
                 );
             if (i < 0)
                 goto nothing;
             u = (PyUnicodeObject*) PyUnicode_FromUnicode(NULL, self->length);
             if (!u)
-                return NULL;
-            Py_UNICODE_COPY(u->str, self->str, self->length);
+                goto done;
+            Py_UNICODE_COPY(u->str, s, self->length);
 
             /* change everything in-place, starting with this one */
-            Py_UNICODE_COPY(u->str+i, str2->str, str2->length);
+            Py_UNICODE_COPY(u->str+i, s2, str2->length);
             i += str1->length;
 
             while ( --maxcount > 0) {
-                i = stringlib_find(self->str+i, self->length-i,
-                                   str1->str, str1->length,
+                i = stringlib_find(s+i, self->length-i,
+                                   s1, str1->length,
                                    i);
                 if (i == -1)
                     break;
-                Py_UNICODE_COPY(u->str+i, str2->str, str2->length);
+                Py_UNICODE_COPY(u->str+i, s2, str2->length);
                 i += str1->length;
             }
         }
@@ -5871,7 +6689,7 @@ PyObject *replace(PyUnicodeObject *self,
         Py_UNICODE *p;
 
         /* replace strings */
-        n = stringlib_count(self->str, self->length, str1->str, str1->length,
+        n = stringlib_count(s, self->length, s1, str1->length,
                             maxcount);
         if (n == 0)
             goto nothing;
@@ -5884,64 +6702,75 @@ PyObject *replace(PyUnicodeObject *self,
             if ((product / (str2->length - str1->length)) != n) {
                 PyErr_SetString(PyExc_OverflowError,
                                 "replace string is too long");
-                return NULL;
+                goto done;
             }
             new_size = self->length + product;
             if (new_size < 0) {
                 PyErr_SetString(PyExc_OverflowError,
                                 "replace string is too long");
-                return NULL;
+                goto done;
             }
         }
         u = _PyUnicode_New(new_size);
         if (!u)
-            return NULL;
+            goto done;
         i = 0;
         p = u->str;
         if (str1->length > 0) {
             while (n-- > 0) {
                 /* look for next match */
-                j = stringlib_find(self->str+i, self->length-i,
-                                   str1->str, str1->length,
+                j = stringlib_find(s+i, self->length-i,
+                                   s1, str1->length,
                                    i);
                 if (j == -1)
                     break;
                 else if (j > i) {
                     /* copy unchanged part [i:j] */
-                    Py_UNICODE_COPY(p, self->str+i, j-i);
+                    Py_UNICODE_COPY(p, s+i, j-i);
                     p += j - i;
                 }
                 /* copy substitution string */
                 if (str2->length > 0) {
-                    Py_UNICODE_COPY(p, str2->str, str2->length);
+                    Py_UNICODE_COPY(p, s2, str2->length);
                     p += str2->length;
                 }
                 i = j + str1->length;
             }
             if (i < self->length)
                 /* copy tail [i:] */
-                Py_UNICODE_COPY(p, self->str+i, self->length-i);
+                Py_UNICODE_COPY(p, s+i, self->length-i);
         } else {
             /* interleave */
             while (n > 0) {
-                Py_UNICODE_COPY(p, str2->str, str2->length);
+                Py_UNICODE_COPY(p, s2, str2->length);
                 p += str2->length;
                 if (--n <= 0)
                     break;
-                *p++ = self->str[i++];
+                *p++ = s[i++];
             }
-            Py_UNICODE_COPY(p, self->str+i, self->length-i);
+            Py_UNICODE_COPY(p, s+i, self->length-i);
         }
     }
-    return (PyObject *) u;
+    unicode_compact(u);
+    goto done;
 
   nothing:
     /* nothing to replace; return original string (when possible) */
     if (PyUnicode_CheckExact(self)) {
         Py_INCREF(self);
-        return (PyObject *) self;
+        u = self;
     }
-    return PyUnicode_FromUnicode(self->str, self->length);
+    else
+        u = (PyUnicodeObject *)PyUnicode_FromUnicode(s, self->length);
+
+  done:
+    if (s != NULL)
+        unicode_unborrow(self, s);
+    if (s1 != NULL)
+        unicode_unborrow(str1, s1);
+    if (s2 != NULL)
+        unicode_unborrow(str2, s2);
+    return (PyObject *) u;
 }
 
 /* --- Unicode Object Methods --------------------------------------------- */
@@ -6142,6 +6971,36 @@ unicode_compare(PyUnicodeObject *str1, PyUnicodeObject *str2)
 
 #endif
 
+#ifdef Py_COMPACT_UNICODE
+
+/* unicode_compare() for when either string is compact.  The UTF-16
+   fixup isn't needed:  in narrow builds compact strings are all Latin-1,
+   which sorts below surrogates either way. */
+static int
+compact_compare(PyUnicodeObject *str1, PyUnicodeObject *str2)
+{
+    Py_ssize_t len1 = str1->length, len2 = str2->length;
+    Py_ssize_t i, n = len1 < len2 ? len1 : len2;
+
+    if (str1->kind == 1 && str2->kind == 1) {
+        int cmp = memcmp(str1->data, str2->data, n);
+        if (cmp != 0)
+            return cmp < 0 ? -1 : 1;
+    }
+    else {
+        for (i = 0; i < n; i++) {
+            Py_UNICODE c1 = UNICODE_READ(str1, i);
+            Py_UNICODE c2 = UNICODE_READ(str2, i);
+            if (c1 != c2)
+                return (c1 < c2) ? -1 : 1;
+        }
+    }
+
+    return (len1 < len2) ? -1 : (len1 != len2);
+}
+
+#endif /* Py_COMPACT_UNICODE */
+
 int PyUnicode_Compare(PyObject *left,
                       PyObject *right)
 {
@@ -6163,6 +7022,11 @@ int PyUnicode_Compare(PyObject *left,
         return 0;
     }
 
+#ifdef Py_COMPACT_UNICODE
+    if (u->str == NULL || v->str == NULL)
+        result = compact_compare(u, v);
+    else
+#endif
     result = unicode_compare(u, v);
 
     Py_DECREF(u);
@@ -6269,7 +7133,13 @@ int PyUnicode_Contains(PyObject *container,
         return -1;
     }
 
-    result = stringlib_contains_obj(str, sub);
+    result = unicode_find_slice((PyUnicodeObject *)str,
+                                (PyUnicodeObject *)sub,
+                                0, PY_SSIZE_T_MAX, 1);
+    if (result == -2)
+        result = -1;
+    else
+        result = (result != -1);
 
     Py_DECREF(str);
     Py_DECREF(sub);
@@ -6303,11 +7173,29 @@ PyObject *PyUnicode_Concat(PyObject *left,
     }
 
     /* Concat the two Unicode strings */
+#ifdef Py_COMPACT_UNICODE
+    if (u->str == NULL && v->str == NULL) {
+        int kind = u->kind > v->kind ? u->kind : v->kind;
+        if (u->length > PY_SSIZE_T_MAX - v->length) {
+            PyErr_NoMemory();
+            goto onError;
+        }
+        w = compact_new(u->length + v->length, kind);
+        if (w == NULL)
+            goto onError;
+        compact_copy(w->data, kind, u, 0, u->length);
+        compact_copy((char *)w->data + u->length * kind, kind,
+                     v, 0, v->length);
+        Py_DECREF(u);
+        Py_DECREF(v);
+        return (PyObject *)w;
+    }
+#endif
     w = _PyUnicode_New(u->length + v->length);
     if (w == NULL)
         goto onError;
-    Py_UNICODE_COPY(w->str, u->str, u->length);
-    Py_UNICODE_COPY(w->str + u->length, v->str, v->length);
+    unicode_copy(w->str, u, 0, u->length);
+    unicode_copy(w->str + u->length, v, 0, v->length);
 
     Py_DECREF(u);
     Py_DECREF(v);
@@ -6332,22 +7220,18 @@ unicode_count(PyUnicodeObject *self, PyObject *args)
     PyUnicodeObject *substring;
     Py_ssize_t start = 0;
     Py_ssize_t end = PY_SSIZE_T_MAX;
-    PyObject *result;
+    Py_ssize_t count;
 
     if (!stringlib_parse_args_finds_unicode("count", args, &substring,
                                             &start, &end))
         return NULL;
 
-    ADJUST_INDICES(start, end, self->length);
-    result = PyInt_FromSsize_t(
-        stringlib_count(self->str + start, end - start,
-                        substring->str, substring->length,
-                        PY_SSIZE_T_MAX)
-        );
-
+    count = unicode_count_slice(self, substring, start, end, PY_SSIZE_T_MAX);
     Py_DECREF(substring);
+    if (count == -1)
+        return NULL;
 
-    return result;
+    return PyInt_FromSsize_t(count);
 }
 
 PyDoc_STRVAR(encode__doc__,
@@ -6445,6 +7329,8 @@ unicode_expandtabs(PyUnicodeObject *self, PyObject *args)
 
     if (!PyArg_ParseTuple(args, "|i:expandtabs", &tabsize))
         return NULL;
+    if (PyUnicode_AS_UNICODE(self) == NULL)
+        return NULL;
 
     /* First pass: determine size of output string */
     i = 0; /* chars up to and including most recent \n or \r */
@@ -6534,13 +7420,11 @@ unicode_find(PyUnicodeObject *self, PyObject *args)
                                             &start, &end))
         return NULL;
 
-    result = stringlib_find_slice(
-        PyUnicode_AS_UNICODE(self), PyUnicode_GET_SIZE(self),
-        PyUnicode_AS_UNICODE(substring), PyUnicode_GET_SIZE(substring),
-        start, end
-        );
+    result = unicode_find_slice(self, substring, start, end, 1);
 
     Py_DECREF(substring);
+    if (result == -2)
+        return NULL;
 
     return PyInt_FromSsize_t(result);
 }
@@ -6548,12 +7432,15 @@ unicode_find(PyUnicodeObject *self, PyObject *args)
 static PyObject *
 unicode_getitem(PyUnicodeObject *self, Py_ssize_t index)
 {
+    Py_UNICODE ch;
+
     if (index < 0 || index >= self->length) {
         PyErr_SetString(PyExc_IndexError, "string index out of range");
         return NULL;
     }
 
-    return (PyObject*) PyUnicode_FromUnicode(&self->str[index], 1);
+    ch = UNICODE_READ(self, index);
+    return (PyObject*) PyUnicode_FromUnicode(&ch, 1);
 }
 
 #ifdef _SYMBEX_HASHES
@@ -6603,11 +7490,31 @@ unicode_hash(PyUnicodeObject *self)
         self->hash = 0;
         return 0;
     }
-    p = PyUnicode_AS_UNICODE(self);
-    x = _Py_HashSecret.prefix;
-    x ^= *p << 7;
-    while (--len >= 0)
-        x = (1000003*x) ^ *p++;
+#ifdef Py_COMPACT_UNICODE
+    if (self->str == NULL) {
+        /* The same hash as the wide string's, a code unit at a time */
+        x = _Py_HashSecret.prefix;
+        x ^= COMPACT_READ(self, 0) << 7;
+        if (self->kind == 1) {
+            register Py_UCS1 *q = (Py_UCS1 *)self->data;
+            while (--len >= 0)
+                x = (1000003*x) ^ (Py_UNICODE)*q++;
+        }
+        else {
+            register Py_UCS2 *q = (Py_UCS2 *)self->data;
+            while (--len >= 0)
+                x = (1000003*x) ^ (Py_UNICODE)*q++;
+        }
+    }
+    else
+#endif
+    {
+        p = PyUnicode_AS_UNICODE(self);
+        x = _Py_HashSecret.prefix;
+        x ^= *p << 7;
+        while (--len >= 0)
+            x = (1000003*x) ^ *p++;
+    }
     x ^= PyUnicode_GET_SIZE(self);
     x ^= _Py_HashSecret.suffix;
     if (x == -1)
@@ -6635,13 +7542,11 @@ unicode_index(PyUnicodeObject *self, PyObject *args)
                                             &start, &end))
         return NULL;
 
-    result = stringlib_find_slice(
-        PyUnicode_AS_UNICODE(self), PyUnicode_GET_SIZE(self),
-        PyUnicode_AS_UNICODE(substring), PyUnicode_GET_SIZE(substring),
-        start, end
-        );
+    result = unicode_find_slice(self, substring, start, end, 1);
 
     Py_DECREF(substring);
+    if (result == -2)
+        return NULL;
 
     if (result < 0) {
         PyErr_SetString(PyExc_ValueError, "substring not found");
@@ -6664,6 +7569,9 @@ unicode_islower(PyUnicodeObject *self)
     register const Py_UNICODE *e;
     int cased;
 
+    if (p == NULL)
+        return NULL;
+
     /* Shortcut for single character strings */
     if (PyUnicode_GET_SIZE(self) == 1)
         return PyBool_FromLong(Py_UNICODE_ISLOWER(*p));
@@ -6698,6 +7606,9 @@ unicode_isupper(PyUnicodeObject *self)
     register const Py_UNICODE *e;
     int cased;
 
+    if (p == NULL)
+        return NULL;
+
     /* Shortcut for single character strings */
     if (PyUnicode_GET_SIZE(self) == 1)
         return PyBool_FromLong(Py_UNICODE_ISUPPER(*p) != 0);
@@ -6734,6 +7645,9 @@ unicode_istitle(PyUnicodeObject *self)
     register const Py_UNICODE *e;
     int cased, previous_is_cased;
 
+    if (p == NULL)
+        return NULL;
+
     /* Shortcut for single character strings */
     if (PyUnicode_GET_SIZE(self) == 1)
         return PyBool_FromLong((Py_UNICODE_ISTITLE(*p) != 0) ||
@@ -6779,6 +7693,9 @@ unicode_isspace(PyUnicodeObject *self)
     register const Py_UNICODE *p = PyUnicode_AS_UNICODE(self);
     register const Py_UNICODE *e;
 
+    if (p == NULL)
+        return NULL;
+
     /* Shortcut for single character strings */
     if (PyUnicode_GET_SIZE(self) == 1 &&
         Py_UNICODE_ISSPACE(*p))
@@ -6808,6 +7725,9 @@ unicode_isalpha(PyUnicodeObject *self)
     register const Py_UNICODE *p = PyUnicode_AS_UNICODE(self);
     register const Py_UNICODE *e;
 
+    if (p == NULL)
+        return NULL;
+
     /* Shortcut for single character strings */
     if (PyUnicode_GET_SIZE(self) == 1 &&
         Py_UNICODE_ISALPHA(*p))
@@ -6837,6 +7757,9 @@ unicode_isalnum(PyUnicodeObject *self)
     register const Py_UNICODE *p = PyUnicode_AS_UNICODE(self);
     register const Py_UNICODE *e;
 
+    if (p == NULL)
+        return NULL;
+
     /* Shortcut for single character strings */
     if (PyUnicode_GET_SIZE(self) == 1 &&
         Py_UNICODE_ISALNUM(*p))
@@ -6866,6 +7789,9 @@ unicode_isdecimal(PyUnicodeObject *self)
     register const Py_UNICODE *p = PyUnicode_AS_UNICODE(self);
     register const Py_UNICODE *e;
 
+    if (p == NULL)
+        return NULL;
+
     /* Shortcut for single character strings */
     if (PyUnicode_GET_SIZE(self) == 1 &&
         Py_UNICODE_ISDECIMAL(*p))
@@ -6895,6 +7821,9 @@ unicode_isdigit(PyUnicodeObject *self)
     register const Py_UNICODE *p = PyUnicode_AS_UNICODE(self);
     register const Py_UNICODE *e;
 
+    if (p == NULL)
+        return NULL;
+
     /* Shortcut for single character strings */
     if (PyUnicode_GET_SIZE(self) == 1 &&
         Py_UNICODE_ISDIGIT(*p))
@@ -6924,6 +7853,9 @@ unicode_isnumeric(PyUnicodeObject *self)
     register const Py_UNICODE *p = PyUnicode_AS_UNICODE(self);
     register const Py_UNICODE *e;
 
+    if (p == NULL)
+        return NULL;
+
     /* Shortcut for single character strings */
     if (PyUnicode_GET_SIZE(self) == 1 &&
         Py_UNICODE_ISNUMERIC(*p))
@@ -7006,13 +7938,23 @@ static const char *stripformat[] = {"|O:lstrip", "|O:rstrip", "|O:strip"};
 PyObject *
 _PyUnicode_XStrip(PyUnicodeObject *self, int striptype, PyObject *sepobj)
 {
-    Py_UNICODE *s = PyUnicode_AS_UNICODE(self);
+    Py_UNICODE *s;
     Py_ssize_t len = PyUnicode_GET_SIZE(self);
-    Py_UNICODE *sep = PyUnicode_AS_UNICODE(sepobj);
+    Py_UNICODE *sep;
     Py_ssize_t seplen = PyUnicode_GET_SIZE(sepobj);
     Py_ssize_t i, j;
+    BLOOM_MASK sepmask;
+    PyObject *result;
 
-    BLOOM_MASK sepmask = make_bloom_mask(sep, seplen);
+    s = unicode_borrow(self);
+    if (s == NULL)
+        return NULL;
+    sep = unicode_borrow((PyUnicodeObject *)sepobj);
+    if (sep == NULL) {
+        unicode_unborrow(self, s);
+        return NULL;
+    }
+    sepmask = make_bloom_mask(sep, seplen);
 
     i = 0;
     if (striptype != RIGHTSTRIP) {
@@ -7031,22 +7973,24 @@ _PyUnicode_XStrip(PyUnicodeObject *self, int striptype, PyObject *sepobj)
 
     if (i == 0 && j == len && PyUnicode_CheckExact(self)) {
         Py_INCREF(self);
-        return (PyObject*)self;
+        result = (PyObject*)self;
     }
     else
-        return PyUnicode_FromUnicode(s+i, j-i);
+        result = PyUnicode_FromUnicode(s+i, j-i);
+    unicode_unborrow(self, s);
+    unicode_unborrow((PyUnicodeObject *)sepobj, sep);
+    return result;
 }
 
 
 static PyObject *
 do_strip(PyUnicodeObject *self, int striptype)
 {
-    Py_UNICODE *s = PyUnicode_AS_UNICODE(self);
     Py_ssize_t len = PyUnicode_GET_SIZE(self), i, j;
 
     i = 0;
     if (striptype != RIGHTSTRIP) {
-        while (i < len && Py_UNICODE_ISSPACE(s[i])) {
+        while (i < len && Py_UNICODE_ISSPACE(UNICODE_READ(self, i))) {
             i++;
         }
     }
@@ -7055,7 +7999,7 @@ do_strip(PyUnicodeObject *self, int striptype)
     if (striptype != LEFTSTRIP) {
         do {
             j--;
-        } while (j >= i && Py_UNICODE_ISSPACE(s[j]));
+        } while (j >= i && Py_UNICODE_ISSPACE(UNICODE_READ(self, j)));
         j++;
     }
 
@@ -7063,8 +8007,11 @@ do_strip(PyUnicodeObject *self, int striptype)
         Py_INCREF(self);
         return (PyObject*)self;
     }
-    else
-        return PyUnicode_FromUnicode(s+i, j-i);
+#ifdef Py_COMPACT_UNICODE
+    if (self->str == NULL)
+        return compact_slice(self, i, j-i);
+#endif
+    return PyUnicode_FromUnicode(self->str+i, j-i);
 }
 
 
@@ -7184,6 +8131,24 @@ unicode_repeat(PyUnicodeObject *str, Py_ssize_t len)
                         "repeated string is too long");
         return NULL;
     }
+#ifdef Py_COMPACT_UNICODE
+    if (str->str == NULL && nchars > 1) {
+        /* Double the copied part, as below */
+        Py_ssize_t done, n, size = str->length * str->kind;
+        char *q;
+        u = compact_new(nchars, str->kind);
+        if (!u)
+            return NULL;
+        q = (char *)u->data;
+        Py_MEMCPY(q, str->data, size);
+        for (done = size; done < nchars * str->kind; done += n) {
+            n = (done <= nchars * str->kind - done) ?
+                done : nchars * str->kind - done;
+            Py_MEMCPY(q + done, q, n);
+        }
+        return (PyObject*) u;
+    }
+#endif
     u = _PyUnicode_New(nchars);
     if (!u)
         return NULL;
@@ -7304,13 +8269,11 @@ unicode_rfind(PyUnicodeObject *self, PyObject *args)
                                             &start, &end))
         return NULL;
 
-    result = stringlib_rfind_slice(
-        PyUnicode_AS_UNICODE(self), PyUnicode_GET_SIZE(self),
-        PyUnicode_AS_UNICODE(substring), PyUnicode_GET_SIZE(substring),
-        start, end
-        );
+    result = unicode_find_slice(self, substring, start, end, -1);
 
     Py_DECREF(substring);
+    if (result == -2)
+        return NULL;
 
     return PyInt_FromSsize_t(result);
 }
@@ -7332,13 +8295,11 @@ unicode_rindex(PyUnicodeObject *self, PyObject *args)
                                             &start, &end))
         return NULL;
 
-    result = stringlib_rfind_slice(
-        PyUnicode_AS_UNICODE(self), PyUnicode_GET_SIZE(self),
-        PyUnicode_AS_UNICODE(substring), PyUnicode_GET_SIZE(substring),
-        start, end
-        );
+    result = unicode_find_slice(self, substring, start, end, -1);
 
     Py_DECREF(substring);
+    if (result == -2)
+        return NULL;
 
     if (result < 0) {
         PyErr_SetString(PyExc_ValueError, "substring not found");
@@ -7388,6 +8349,10 @@ unicode_slice(PyUnicodeObject *self, Py_ssize_t start, Py_ssize_t end)
     if (start > end)
         start = end;
     /* copy slice */
+#ifdef Py_COMPACT_UNICODE
+    if (self->str == NULL)
+        return compact_slice(self, start, end - start);
+#endif
     return (PyObject*) PyUnicode_FromUnicode(self->str + start,
                                              end - start);
 }
@@ -7448,6 +8413,7 @@ PyUnicode_Partition(PyObject *str_in, PyObject *sep_in)
     PyObject* str_obj;
     PyObject* sep_obj;
     PyObject* out;
+    Py_UNICODE *str, *sep;
 
     str_obj = PyUnicode_FromObject(str_in);
     if (!str_obj)
@@ -7458,10 +8424,19 @@ PyUnicode_Partition(PyObject *str_in, PyObject *sep_in)
         return NULL;
     }
 
-    out = stringlib_partition(
-        str_obj, PyUnicode_AS_UNICODE(str_obj), PyUnicode_GET_SIZE(str_obj),
-        sep_obj, PyUnicode_AS_UNICODE(sep_obj), PyUnicode_GET_SIZE(sep_obj)
-        );
+    str = unicode_borrow((PyUnicodeObject *)str_obj);
+    sep = unicode_borrow((PyUnicodeObject *)sep_obj);
+    if (str != NULL && sep != NULL)
+        out = stringlib_partition(
+            str_obj, str, PyUnicode_GET_SIZE(str_obj),
+            sep_obj, sep, PyUnicode_GET_SIZE(sep_obj)
+            );
+    else
+        out = NULL;
+    if (str != NULL)
+        unicode_unborrow((PyUnicodeObject *)str_obj, str);
+    if (sep != NULL)
+        unicode_unborrow((PyUnicodeObject *)sep_obj, sep);
 
     Py_DECREF(sep_obj);
     Py_DECREF(str_obj);
@@ -7476,6 +8451,7 @@ PyUnicode_RPartition(PyObject *str_in, PyObject *sep_in)
     PyObject* str_obj;
     PyObject* sep_obj;
     PyObject* out;
+    Py_UNICODE *str, *sep;
 
     str_obj = PyUnicode_FromObject(str_in);
     if (!str_obj)
@@ -7486,10 +8462,19 @@ PyUnicode_RPartition(PyObject *str_in, PyObject *sep_in)
         return NULL;
     }
 
-    out = stringlib_rpartition(
-        str_obj, PyUnicode_AS_UNICODE(str_obj), PyUnicode_GET_SIZE(str_obj),
-        sep_obj, PyUnicode_AS_UNICODE(sep_obj), PyUnicode_GET_SIZE(sep_obj)
-        );
+    str = unicode_borrow((PyUnicodeObject *)str_obj);
+    sep = unicode_borrow((PyUnicodeObject *)sep_obj);
+    if (str != NULL && sep != NULL)
+        out = stringlib_rpartition(
+            str_obj, str, PyUnicode_GET_SIZE(str_obj),
+            sep_obj, sep, PyUnicode_GET_SIZE(sep_obj)
+            );
+    else
+        out = NULL;
+    if (str != NULL)
+        unicode_unborrow((PyUnicodeObject *)str_obj, str);
+    if (sep != NULL)
+        unicode_unborrow((PyUnicodeObject *)sep_obj, sep);
 
     Py_DECREF(sep_obj);
     Py_DECREF(str_obj);
@@ -7621,10 +8606,17 @@ are deleted.");
 static PyObject*
 unicode_translate(PyUnicodeObject *self, PyObject *table)
 {
-    return PyUnicode_TranslateCharmap(self->str,
-                                      self->length,
-                                      table,
-                                      "ignore");
+    Py_UNICODE *s = unicode_borrow(self);
+    PyObject *result;
+
+    if (s == NULL)
+        return NULL;
+    result = PyUnicode_TranslateCharmap(s,
+                                        self->length,
+                                        table,
+                                        "ignore");
+    unicode_unborrow(self, s);
+    return result;
 }
 
 PyDoc_STRVAR(upper__doc__,
@@ -7833,6 +8825,11 @@ Return a formatted version of S as described by format_spec.");
 static PyObject *
 unicode__sizeof__(PyUnicodeObject *v)
 {
+#ifdef Py_COMPACT_UNICODE
+    if (v->str == NULL)
+        return PyInt_FromSsize_t(sizeof(PyUnicodeObject) +
+                                 v->kind * (v->length + 1));
+#endif
     return PyInt_FromSsize_t(sizeof(PyUnicodeObject) +
                              sizeof(Py_UNICODE) * (v->length + 1));
 }
@@ -7845,7 +8842,14 @@ PyDoc_STRVAR(sizeof__doc__,
 static PyObject *
 unicode_getnewargs(PyUnicodeObject *v)
 {
-    return Py_BuildValue("(u#)", v->str, v->length);
+    Py_UNICODE *s = unicode_borrow(v);
+    PyObject *result;
+
+    if (s == NULL)
+        return NULL;
+    result = Py_BuildValue("(u#)", s, v->length);
+    unicode_unborrow(v, s);
+    return result;
 }
 
 
@@ -7953,7 +8957,6 @@ unicode_subscript(PyUnicodeObject* self, PyObject* item)
         return unicode_getitem(self, i);
     } else if (PySlice_Check(item)) {
         Py_ssize_t start, stop, step, slicelength, cur, i;
-        Py_UNICODE* source_buf;
         Py_UNICODE* result_buf;
         PyObject* result;
 
@@ -7969,9 +8972,12 @@ unicode_subscript(PyUnicodeObject* self, PyObject* item)
             Py_INCREF(self);
             return (PyObject *)self;
         } else if (step == 1) {
+#ifdef Py_COMPACT_UNICODE
+            if (self->str == NULL)
+                return compact_slice(self, start, slicelength);
+#endif
             return PyUnicode_FromUnicode(self->str + start, slicelength);
         } else {
-            source_buf = PyUnicode_AS_UNICODE((PyObject*)self);
             result_buf = (Py_UNICODE *)PyObject_MALLOC(slicelength*
                                                        sizeof(Py_UNICODE));
 
@@ -7979,7 +8985,7 @@ unicode_subscript(PyUnicodeObject* self, PyObject* item)
                 return PyErr_NoMemory();
 
             for (cur = start, i = 0; i < slicelength; cur += step, i++) {
-                result_buf[i] = source_buf[cur];
+                result_buf[i] = UNICODE_READ(self, cur);
             }
 
             result = PyUnicode_FromUnicode(result_buf, slicelength);
@@ -8008,7 +9014,9 @@ unicode_buffer_getreadbuf(PyUnicodeObject *self,
                         "accessing non-existent unicode segment");
         return -1;
     }
-    *ptr = (void *) self->str;
+    *ptr = (void *) PyUnicode_AS_UNICODE(self);
+    if (*ptr == NULL)
+        return -1;
     return PyUnicode_GET_DATA_SIZE(self);
 }
 
@@ -8302,9 +9310,9 @@ PyObject *PyUnicode_Format(PyObject *format,
                            PyObject *args)
 {
     Py_UNICODE *fmt, *res;
-    Py_ssize_t fmtcnt, rescnt, reslen, arglen, argidx;
+    Py_ssize_t fmtcnt, arglen, argidx;
     int args_owned = 0;
-    PyUnicodeObject *result = NULL;
+    _PyUnicodeWriter writer;
     PyObject *dict = NULL;
     PyObject *uformat;
 
@@ -8315,14 +9323,11 @@ PyObject *PyUnicode_Format(PyObject *format,
     uformat = PyUnicode_FromObject(format);
     if (uformat == NULL)
         return NULL;
+    _PyUnicodeWriter_Init(&writer);
     fmt = PyUnicode_AS_UNICODE(uformat);
-    fmtcnt = PyUnicode_GET_SIZE(uformat);
-
-    reslen = rescnt = fmtcnt + 100;
-    result = _PyUnicode_New(reslen);
-    if (result == NULL)
+    if (fmt == NULL)
         goto onError;
-    res = PyUnicode_AS_UNICODE(result);
+    fmtcnt = PyUnicode_GET_SIZE(uformat);
 
     if (PyTuple_Check(args)) {
         arglen = PyTuple_Size(args);
@@ -8338,15 +9343,14 @@ PyObject *PyUnicode_Format(PyObject *format,
 
     while (--fmtcnt >= 0) {
         if (*fmt != '%') {
-            if (--rescnt < 0) {
-                rescnt = fmtcnt + 100;
-                reslen += rescnt;
-                if (_PyUnicode_Resize(&result, reslen) < 0)
-                    goto onError;
-                res = PyUnicode_AS_UNICODE(result) + reslen - rescnt;
-                --rescnt;
-            }
-            *res++ = *fmt++;
+            /* copy the text up to the next '%' */
+            Py_ssize_t run = 1;
+            while (run <= fmtcnt && fmt[run] != '%')
+                run++;
+            if (_PyUnicodeWriter_Write(&writer, fmt, run) < 0)
+                goto onError;
+            fmt += run;
+            fmtcnt -= run - 1;
         }
         else {
             /* Got a format specifier */
@@ -8663,26 +9667,20 @@ PyObject *PyUnicode_Format(PyObject *format,
             }
             if (width < len)
                 width = len;
-            if (rescnt - (sign != 0) < width) {
-                reslen -= rescnt;
-                rescnt = width + fmtcnt + 100;
-                reslen += rescnt;
-                if (reslen < 0) {
-                    Py_XDECREF(temp);
-                    PyErr_NoMemory();
-                    goto onError;
-                }
-                if (_PyUnicode_Resize(&result, reslen) < 0) {
-                    Py_XDECREF(temp);
-                    goto onError;
-                }
-                res = PyUnicode_AS_UNICODE(result)
-                    + reslen - rescnt;
+            /* the field, and maybe a sign */
+            if (width == PY_SSIZE_T_MAX) {
+                Py_XDECREF(temp);
+                PyErr_NoMemory();
+                goto onError;
+            }
+            if (_PyUnicodeWriter_PREPARE(&writer, width + 1) < 0) {
+                Py_XDECREF(temp);
+                goto onError;
             }
+            res = writer.str + writer.pos;
             if (sign) {
                 if (fill != ' ')
                     *res++ = sign;
-                rescnt--;
                 if (width > len)
                     width--;
             }
@@ -8693,7 +9691,6 @@ PyObject *PyUnicode_Format(PyObject *format,
                     *res++ = *pbuf++;
                     *res++ = *pbuf++;
                 }
-                rescnt -= 2;
                 width -= 2;
                 if (width < 0)
                     width = 0;
@@ -8701,7 +9698,6 @@ PyObject *PyUnicode_Format(PyObject *format,
             }
             if (width > len && !(flags & F_LJUST)) {
                 do {
-                    --rescnt;
                     *res++ = fill;
                 } while (--width > len);
             }
@@ -8717,11 +9713,10 @@ PyObject *PyUnicode_Format(PyObject *format,
             }
             Py_UNICODE_COPY(res, pbuf, len);
             res += len;
-            rescnt -= len;
             while (--width >= len) {
-                --rescnt;
                 *res++ = ' ';
             }
+            writer.pos = res - writer.str;
             if (dict && (argidx < arglen) && c != '%') {
                 PyErr_SetString(PyExc_TypeError,
                                 "not all arguments converted during string formatting");
@@ -8737,16 +9732,14 @@ PyObject *PyUnicode_Format(PyObject *format,
         goto onError;
     }
 
-    if (_PyUnicode_Resize(&result, reslen - rescnt) < 0)
-        goto onError;
     if (args_owned) {
         Py_DECREF(args);
     }
     Py_DECREF(uformat);
-    return (PyObject *)result;
+    return _PyUnicodeWriter_Finish(&writer);
 
   onError:
-    Py_XDECREF(result);
+    _PyUnicodeWriter_Dealloc(&writer);
     Py_DECREF(uformat);
     if (args_owned) {
         Py_DECREF(args);
@@ -8808,7 +9801,11 @@ unicode_subtype_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
         Py_DECREF(tmp);
         return PyErr_NoMemory();
     }
-    Py_UNICODE_COPY(pnew->str, tmp->str, n+1);
+    unicode_copy(pnew->str, tmp, 0, n+1);
+#ifdef Py_COMPACT_UNICODE
+    pnew->data = NULL;
+    pnew->kind = Py_UNICODE_SIZE;
+#endif
     pnew->length = n;
     pnew->hash = tmp->hash;
     Py_DECREF(tmp);
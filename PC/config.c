@@ -65,6 +65,7 @@ extern void init_codecs_kr(void);
 extern void init_codecs_tw(void);
 extern void init_subprocess(void);
 extern void init_lsprof(void);
+extern void init_tracemalloc(void);
 extern void init_ast(void);
 extern void init_io(void);
 extern void _PyWarnings_Init(void);
@@ -121,6 +122,7 @@ struct _inittab _PyImport_Inittab[] = {
     {"_bisect", init_bisect},
     {"_heapq", init_heapq},
     {"_lsprof", init_lsprof},
+    {"_tracemalloc", init_tracemalloc},
     {"itertools", inititertools},
     {"_collections", init_collections},
     {"_symtable", init_symtable},
@@ -3341,7 +3341,7 @@ obj2ast_mod(PyObject* obj, mod_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "body");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Module field \"body\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Module field \"body\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -3377,7 +3377,7 @@ obj2ast_mod(PyObject* obj, mod_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "body");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Interactive field \"body\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Interactive field \"body\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -3436,7 +3436,7 @@ obj2ast_mod(PyObject* obj, mod_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "body");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Suite field \"body\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Suite field \"body\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -3545,7 +3545,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "body");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "FunctionDef field \"body\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "FunctionDef field \"body\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -3570,7 +3570,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "decorator_list");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "FunctionDef field \"decorator_list\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "FunctionDef field \"decorator_list\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -3622,7 +3622,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "bases");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "ClassDef field \"bases\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "ClassDef field \"bases\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -3647,7 +3647,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "body");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "ClassDef field \"body\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "ClassDef field \"body\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -3672,7 +3672,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "decorator_list");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "ClassDef field \"decorator_list\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "ClassDef field \"decorator_list\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -3731,7 +3731,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "targets");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Delete field \"targets\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Delete field \"targets\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -3768,7 +3768,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "targets");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Assign field \"targets\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Assign field \"targets\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -3878,7 +3878,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "values");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Print field \"values\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Print field \"values\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -3953,7 +3953,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "body");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "For field \"body\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "For field \"body\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -3978,7 +3978,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "orelse");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "For field \"orelse\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "For field \"orelse\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4029,7 +4029,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "body");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "While field \"body\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "While field \"body\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4054,7 +4054,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "orelse");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "While field \"orelse\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "While field \"orelse\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4104,7 +4104,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "body");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "If field \"body\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "If field \"body\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4129,7 +4129,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "orelse");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "If field \"orelse\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "If field \"orelse\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4190,7 +4190,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "body");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "With field \"body\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "With field \"body\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4275,7 +4275,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "body");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "TryExcept field \"body\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "TryExcept field \"body\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4300,7 +4300,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "handlers");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "TryExcept field \"handlers\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "TryExcept field \"handlers\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4325,7 +4325,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "orelse");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "TryExcept field \"orelse\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "TryExcept field \"orelse\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4363,7 +4363,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "body");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "TryFinally field \"body\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "TryFinally field \"body\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4388,7 +4388,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "finalbody");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "TryFinally field \"finalbody\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "TryFinally field \"finalbody\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4459,7 +4459,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "names");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Import field \"names\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Import field \"names\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4508,7 +4508,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "names");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "ImportFrom field \"names\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "ImportFrom field \"names\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4603,7 +4603,7 @@ obj2ast_stmt(PyObject* obj, stmt_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "names");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Global field \"names\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Global field \"names\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4751,7 +4751,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "values");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "BoolOp field \"values\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "BoolOp field \"values\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4958,7 +4958,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "keys");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Dict field \"keys\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Dict field \"keys\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -4983,7 +4983,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "values");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Dict field \"values\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Dict field \"values\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -5019,7 +5019,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "elts");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Set field \"elts\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Set field \"elts\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -5068,7 +5068,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "generators");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "ListComp field \"generators\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "ListComp field \"generators\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -5117,7 +5117,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "generators");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "SetComp field \"generators\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "SetComp field \"generators\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -5179,7 +5179,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "generators");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "DictComp field \"generators\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "DictComp field \"generators\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -5229,7 +5229,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "generators");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "GeneratorExp field \"generators\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "GeneratorExp field \"generators\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -5301,7 +5301,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "ops");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Compare field \"ops\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Compare field \"ops\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -5326,7 +5326,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "comparators");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Compare field \"comparators\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Compare field \"comparators\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -5379,7 +5379,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "args");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Call field \"args\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Call field \"args\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -5404,7 +5404,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "keywords");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Call field \"keywords\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Call field \"keywords\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -5667,7 +5667,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "elts");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "List field \"elts\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "List field \"elts\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -5716,7 +5716,7 @@ obj2ast_expr(PyObject* obj, expr_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "elts");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "Tuple field \"elts\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "Tuple field \"elts\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -5903,7 +5903,7 @@ obj2ast_slice(PyObject* obj, slice_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "dims");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "ExtSlice field \"dims\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "ExtSlice field \"dims\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -6280,7 +6280,7 @@ obj2ast_comprehension(PyObject* obj, comprehension_ty* out, PyArena* arena)
                 tmp = PyObject_GetAttrString(obj, "ifs");
                 if (tmp == NULL) goto failed;
                 if (!PyList_Check(tmp)) {
-                        PyErr_Format(PyExc_TypeError, "comprehension field \"ifs\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                        PyErr_Format(PyExc_TypeError, "comprehension field \"ifs\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                         goto failed;
                 }
                 len = PyList_GET_SIZE(tmp);
@@ -6380,7 +6380,7 @@ obj2ast_excepthandler(PyObject* obj, excepthandler_ty* out, PyArena* arena)
                         tmp = PyObject_GetAttrString(obj, "body");
                         if (tmp == NULL) goto failed;
                         if (!PyList_Check(tmp)) {
-                                PyErr_Format(PyExc_TypeError, "ExceptHandler field \"body\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                                PyErr_Format(PyExc_TypeError, "ExceptHandler field \"body\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                                 goto failed;
                         }
                         len = PyList_GET_SIZE(tmp);
@@ -6428,7 +6428,7 @@ obj2ast_arguments(PyObject* obj, arguments_ty* out, PyArena* arena)
                 tmp = PyObject_GetAttrString(obj, "args");
                 if (tmp == NULL) goto failed;
                 if (!PyList_Check(tmp)) {
-                        PyErr_Format(PyExc_TypeError, "arguments field \"args\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                        PyErr_Format(PyExc_TypeError, "arguments field \"args\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                         goto failed;
                 }
                 len = PyList_GET_SIZE(tmp);
@@ -6475,7 +6475,7 @@ obj2ast_arguments(PyObject* obj, arguments_ty* out, PyArena* arena)
                 tmp = PyObject_GetAttrString(obj, "defaults");
                 if (tmp == NULL) goto failed;
                 if (!PyList_Check(tmp)) {
-                        PyErr_Format(PyExc_TypeError, "arguments field \"defaults\" must be a list, not a %.200s", tmp->ob_type->tp_name);
+                        PyErr_Format(PyExc_TypeError, "arguments field \"defaults\" must be a list, not a %.200s", Py_TYPE(tmp)->tp_name);
                         goto failed;
                 }
                 len = PyList_GET_SIZE(tmp);
@@ -177,7 +177,7 @@ builtin_apply(PyObject *self, PyObject *args)
             if (!PySequence_Check(alist)) {
                 PyErr_Format(PyExc_TypeError,
                      "apply() arg 2 expected sequence, found %s",
-                         alist->ob_type->tp_name);
+                         Py_TYPE(alist)->tp_name);
                 return NULL;
             }
             t = PySequence_Tuple(alist);
@@ -189,7 +189,7 @@ builtin_apply(PyObject *self, PyObject *args)
     if (kwdict != NULL && !PyDict_Check(kwdict)) {
         PyErr_Format(PyExc_TypeError,
                      "apply() arg 3 expected dictionary, found %s",
-                     kwdict->ob_type->tp_name);
+                     Py_TYPE(kwdict)->tp_name);
         goto finally;
     }
     retval = PyEval_CallObjectWithKeywords(func, alist, kwdict);
@@ -270,7 +270,7 @@ builtin_filter(PyObject *self, PyObject *args)
         goto Fail_it;
 
     /* Get a result list. */
-    if (PyList_Check(seq) && seq->ob_refcnt == 1) {
+    if (PyList_Check(seq) && Py_REFCNT(seq) == 1) {
         /* Eww - can modify the list in-place. */
         Py_INCREF(seq);
         result = seq;
@@ -1089,11 +1089,11 @@ builtin_next(PyObject *self, PyObject *args)
     if (!PyIter_Check(it)) {
         PyErr_Format(PyExc_TypeError,
             "%.200s object is not an iterator",
-            it->ob_type->tp_name);
+            Py_TYPE(it)->tp_name);
         return NULL;
     }
 
-    res = (*it->ob_type->tp_iternext)(it);
+    res = (*Py_TYPE(it)->tp_iternext)(it);
     if (res != NULL) {
         return res;
     } else if (def != NULL) {
@@ -1186,7 +1186,7 @@ builtin_hex(PyObject *self, PyObject *v)
     PyNumberMethods *nb;
     PyObject *res;
 
-    if ((nb = v->ob_type->tp_as_number) == NULL ||
+    if ((nb = Py_TYPE(v)->tp_as_number) == NULL ||
         nb->nb_hex == NULL) {
         PyErr_SetString(PyExc_TypeError,
                    "hex() argument can't be converted to hex");
@@ -1196,7 +1196,7 @@ builtin_hex(PyObject *self, PyObject *v)
     if (res && !PyString_Check(res)) {
         PyErr_Format(PyExc_TypeError,
                      "__hex__ returned non-string (type %.200s)",
-                     res->ob_type->tp_name);
+                     Py_TYPE(res)->tp_name);
         Py_DECREF(res);
         return NULL;
     }
@@ -1454,7 +1454,7 @@ builtin_oct(PyObject *self, PyObject *v)
     PyNumberMethods *nb;
     PyObject *res;
 
-    if (v == NULL || (nb = v->ob_type->tp_as_number) == NULL ||
+    if (v == NULL || (nb = Py_TYPE(v)->tp_as_number) == NULL ||
         nb->nb_oct == NULL) {
         PyErr_SetString(PyExc_TypeError,
                    "oct() argument can't be converted to oct");
@@ -1464,7 +1464,7 @@ builtin_oct(PyObject *self, PyObject *v)
     if (res && !PyString_Check(res)) {
         PyErr_Format(PyExc_TypeError,
                      "__oct__ returned non-string (type %.200s)",
-                     res->ob_type->tp_name);
+                     Py_TYPE(res)->tp_name);
         Py_DECREF(res);
         return NULL;
     }
@@ -1520,7 +1520,7 @@ builtin_ord(PyObject *self, PyObject* obj)
     } else {
         PyErr_Format(PyExc_TypeError,
                      "ord() expected string of length 1, but " \
-                     "%.200s found", obj->ob_type->tp_name);
+                     "%.200s found", Py_TYPE(obj)->tp_name);
         return NULL;
     }
 
@@ -1611,7 +1611,7 @@ builtin_print(PyObject *self, PyObject *args, PyObject *kwds)
         else if (!PyString_Check(sep)) {
             PyErr_Format(PyExc_TypeError,
                          "sep must be None, str or unicode, not %.200s",
-                         sep->ob_type->tp_name);
+                         Py_TYPE(sep)->tp_name);
             return NULL;
         }
     }
@@ -1624,7 +1624,7 @@ builtin_print(PyObject *self, PyObject *args, PyObject *kwds)
         else if (!PyString_Check(end)) {
             PyErr_Format(PyExc_TypeError,
                          "end must be None, str or unicode, not %.200s",
-                         end->ob_type->tp_name);
+                         Py_TYPE(end)->tp_name);
             return NULL;
         }
     }
@@ -1764,7 +1764,7 @@ get_range_long_argument(PyObject *arg, const char *name)
         nb->nb_int == NULL) {
         PyErr_Format(PyExc_TypeError,
                      "range() integer %s argument expected, got %s.",
-                     name, arg->ob_type->tp_name);
+                     name, Py_TYPE(arg)->tp_name);
         return NULL;
     }
     v = nb->nb_int(arg);
@@ -2750,9 +2750,9 @@ filtertuple(PyObject *func, PyObject *tuple)
         PyObject *item, *good;
         int ok;
 
-        if (tuple->ob_type->tp_as_sequence &&
-            tuple->ob_type->tp_as_sequence->sq_item) {
-            item = tuple->ob_type->tp_as_sequence->sq_item(tuple, i);
+        if (Py_TYPE(tuple)->tp_as_sequence &&
+            Py_TYPE(tuple)->tp_as_sequence->sq_item) {
+            item = Py_TYPE(tuple)->tp_as_sequence->sq_item(tuple, i);
             if (item == NULL)
                 goto Fail_1;
         } else {
@@ -2824,7 +2824,7 @@ filterstring(PyObject *func, PyObject *strobj)
         PyObject *item;
         int ok;
 
-        item = (*strobj->ob_type->tp_as_sequence->sq_item)(strobj, i);
+        item = (*Py_TYPE(strobj)->tp_as_sequence->sq_item)(strobj, i);
         if (item == NULL)
             goto Fail_1;
         if (func==Py_None) {
@@ -2951,7 +2951,7 @@ filterunicode(PyObject *func, PyObject *strobj)
         PyObject *item, *arg, *good;
         int ok;
 
-        item = (*strobj->ob_type->tp_as_sequence->sq_item)(strobj, i);
+        item = (*Py_TYPE(strobj)->tp_as_sequence->sq_item)(strobj, i);
         if (item == NULL)
             goto Fail_1;
         if (func == Py_None) {
@@ -16,6 +16,7 @@
 #include "eval.h"
 #include "opcode.h"
 #include "structmember.h"
+#include "symbex.h"
 
 #include <ctype.h>
 
@@ -113,6 +114,8 @@ static PyObject * call_function(PyObject ***, int);
 static PyObject * fast_function(PyObject *, PyObject ***, int, int, int);
 static PyObject * do_call(PyObject *, PyObject ***, int, int);
 static PyObject * ext_do_call(PyObject *, PyObject ***, int, int, int);
+static PyObject * ext_fast_function(PyObject *, PyObject **, int, int,
+                                    PyObject *, PyObject *);
 static PyObject * update_keyword_args(PyObject *, int, PyObject ***,
                                       PyObject *);
 static PyObject * update_star_args(int, int, PyObject *, PyObject ***);
@@ -129,6 +132,7 @@ static int call_trace(Py_tracefunc, PyObject *, PyFrameObject *,
 static int call_trace_protected(Py_tracefunc, PyObject *,
                                 PyFrameObject *, int, PyObject *);
 static void call_exc_trace(Py_tracefunc, PyObject *, PyFrameObject *);
+static int stopiter_discarded(PyThreadState *, PyFrameObject *);
 static int maybe_call_line_trace(Py_tracefunc, PyObject *,
                                  PyFrameObject *, int *, int *, int *);
 
@@ -145,7 +149,8 @@ static void set_exc_info(PyThreadState *, PyObject *, PyObject *, PyObject *);
 static void reset_exc_info(PyThreadState *);
 static void format_exc_check_arg(PyObject *, char *, PyObject *);
 static PyObject * string_concatenate(PyObject *, PyObject *,
-                                     PyFrameObject *, unsigned char *);
+                                     PyFrameObject *, unsigned char *,
+                                     PyObject **);
 static PyObject * kwd_as_string(PyObject *);
 static PyObject * special_lookup(PyObject *, char *, PyObject **);
 
@@ -233,36 +238,41 @@ PyEval_GetCallStats(PyObject *self)
 #endif
 #include "pythread.h"
 
-static PyThread_type_lock interpreter_lock = 0; /* This is the GIL */
 static PyThread_type_lock pending_lock = 0; /* for pending calls */
 static long main_thread = 0;
 
+#include "ceval_gil.h"
+
 int
 PyEval_ThreadsInitialized(void)
 {
-    return interpreter_lock != 0;
+    return gil_created();
 }
 
 void
 PyEval_InitThreads(void)
 {
-    if (interpreter_lock)
+    if (gil_created())
         return;
-    interpreter_lock = PyThread_allocate_lock();
-    PyThread_acquire_lock(interpreter_lock, 1);
+    create_gil();
+    take_gil(_PyThreadState_Current);
     main_thread = PyThread_get_thread_ident();
 }
 
 void
 PyEval_AcquireLock(void)
 {
-    PyThread_acquire_lock(interpreter_lock, 1);
+    take_gil(_PyThreadState_Current);
 }
 
 void
 PyEval_ReleaseLock(void)
 {
-    PyThread_release_lock(interpreter_lock);
+    /* This function must succeed when the current thread state is NULL.
+       We therefore avoid PyThreadState_GET() which dumps a fatal error
+       in debug mode.
+    */
+    drop_gil(_PyThreadState_Current);
 }
 
 void
@@ -271,8 +281,8 @@ PyEval_AcquireThread(PyThreadState *tstate)
     if (tstate == NULL)
         Py_FatalError("PyEval_AcquireThread: NULL new thread state");
     /* Check someone has called PyEval_InitThreads() to create the lock */
-    assert(interpreter_lock);
-    PyThread_acquire_lock(interpreter_lock, 1);
+    assert(gil_created());
+    take_gil(tstate);
     if (PyThreadState_Swap(tstate) != NULL)
         Py_FatalError(
             "PyEval_AcquireThread: non-NULL old thread state");
@@ -285,7 +295,7 @@ PyEval_ReleaseThread(PyThreadState *tstate)
         Py_FatalError("PyEval_ReleaseThread: NULL thread state");
     if (PyThreadState_Swap(NULL) != tstate)
         Py_FatalError("PyEval_ReleaseThread: wrong thread state");
-    PyThread_release_lock(interpreter_lock);
+    drop_gil(tstate);
 }
 
 /* This function is called from PyOS_AfterFork to ensure that newly
@@ -299,20 +309,20 @@ PyEval_ReInitThreads(void)
     PyObject *threading, *result;
     PyThreadState *tstate;
 
-    if (!interpreter_lock)
+    if (!gil_created())
         return;
     /*XXX Can't use PyThread_free_lock here because it does too
       much error-checking.  Doing this cleanly would require
       adding a new function to each thread_*.h.  Instead, just
       create a new lock and waste a little bit of memory */
-    interpreter_lock = PyThread_allocate_lock();
+    recreate_gil();
     pending_lock = PyThread_allocate_lock();
-    PyThread_acquire_lock(interpreter_lock, 1);
+    tstate = PyThreadState_GET();
+    take_gil(tstate);
     main_thread = PyThread_get_thread_ident();
 
     /* Update the threading module with the new state.
      */
-    tstate = PyThreadState_GET();
     threading = PyMapping_GetItemString(tstate->interp->modules,
                                         "threading");
     if (threading == NULL) {
@@ -340,8 +350,8 @@ PyEval_SaveThread(void)
     if (tstate == NULL)
         Py_FatalError("PyEval_SaveThread: NULL tstate");
 #ifdef WITH_THREAD
-    if (interpreter_lock)
-        PyThread_release_lock(interpreter_lock);
+    if (gil_created())
+        drop_gil(tstate);
 #endif
     return tstate;
 }
@@ -352,11 +362,8 @@ PyEval_RestoreThread(PyThreadState *tstate)
     if (tstate == NULL)
         Py_FatalError("PyEval_RestoreThread: NULL tstate");
 #ifdef WITH_THREAD
-    if (interpreter_lock) {
-        int err = errno;
-        PyThread_acquire_lock(interpreter_lock, 1);
-        errno = err;
-    }
+    if (gil_created())
+        take_gil(tstate);
 #endif
     PyThreadState_Swap(tstate);
 }
@@ -661,6 +668,74 @@ static int _Py_TracingPossible = 0;
 int _Py_CheckInterval = 100;
 volatile int _Py_Ticker = 0; /* so that we hit a "tick" first thing */
 
+/* Quickening of arithmetic and comparison instructions.
+
+   The first time a code object is evaluated, its bytecode is copied into a
+   private buffer (co_quickened) which the eval loop then executes instead of
+   co_code.  Every generic BINARY_*, INPLACE_* and COMPARE_OP instruction in
+   that buffer counts how many times in a row it saw two exact ints or two
+   exact floats; after QUICKEN_THRESHOLD such executions it is rewritten in
+   place into the type-specialized opcode.  A specialized instruction whose
+   guard fails restores the generic opcode from co_code and is never
+   specialized again.  co_code itself is never touched, so marshal, dis,
+   code comparison and f_lasti keep their meaning.
+
+   The buffer holds the instructions followed by one counter byte per
+   instruction byte.  Symbolic execution builds that disable fast paths
+   also disable quickening.
+*/
+#ifndef _SYMBEX_SHORT_CIRCUITED
+#define USE_QUICKENING
+#endif
+
+#ifdef USE_QUICKENING
+
+#define QUICKEN_THRESHOLD 8
+#define QUICKEN_DISABLED  0xFF
+
+static unsigned char *
+quicken_code(PyCodeObject *co)
+{
+    Py_ssize_t n = PyString_GET_SIZE(co->co_code);
+    Py_ssize_t size = 2 * n;    /* instructions, then counters */
+    unsigned char *buf;
+
+    buf = (unsigned char *)PyMem_MALLOC(size);
+    if (buf == NULL)
+        return NULL;            /* not fatal: we just run co_code */
+    memcpy(buf, PyString_AS_STRING(co->co_code), n);
+    memset(buf + n, 0, n);
+    co->co_quickened = buf;
+    return buf;
+}
+
+/* Count one execution of the generic instruction at 'instr' with operands
+   v and w, and rewrite it into int_op or float_op (0 if there is none) once
+   it has seen enough monomorphic operands. */
+static void
+quicken_binary(unsigned char *instr, unsigned char *counter,
+               PyObject *v, PyObject *w, int int_op, int float_op)
+{
+    int op = 0;
+
+    if (*counter == QUICKEN_DISABLED)
+        return;
+    if (PyInt_CheckExact(v) && PyInt_CheckExact(w))
+        op = int_op;
+    else if (PyFloat_CheckExact(v) && PyFloat_CheckExact(w))
+        op = float_op;
+    if (op == 0) {
+        *counter = 0;
+        return;
+    }
+    if (++*counter >= QUICKEN_THRESHOLD) {
+        *instr = op;
+        *counter = 0;
+    }
+}
+
+#endif /* USE_QUICKENING */
+
 PyObject *
 PyEval_EvalCode(PyCodeObject *co, PyObject *globals, PyObject *locals)
 {
@@ -716,6 +791,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
     int instr_ub = -1, instr_lb = 0, instr_prev = -1;
 
     unsigned char *first_instr;
+    unsigned char *quick_counters = NULL;
     PyObject *names;
     PyObject *consts;
 #if defined(Py_DEBUG) || defined(LLTRACE)
@@ -781,6 +857,31 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
 #define JUMPTO(x)       (next_instr = first_instr + (x))
 #define JUMPBY(x)       (next_instr += (x))
 
+/* Quickening macros
+    QUICKEN() is used by a generic instruction of 'size' bytes, after v and
+    w have been fetched, to feed the specialization counters.  DEOPTIMIZE()
+    is used by a specialized instruction of 'size' bytes, before touching
+    the stack, to put the generic instruction back and execute it instead.
+*/
+
+#ifdef USE_QUICKENING
+#define QUICKEN(size, int_op, float_op) \
+    if (quick_counters != NULL) \
+        quicken_binary(next_instr - (size), \
+                       quick_counters + INSTR_OFFSET() - (size), \
+                       v, w, (int_op), (float_op))
+#define DEOPTIMIZE(size) \
+    { \
+        int offset = INSTR_OFFSET() - (size); \
+        opcode = (unsigned char)PyString_AS_STRING(co->co_code)[offset]; \
+        first_instr[offset] = opcode; \
+        quick_counters[offset] = QUICKEN_DISABLED; \
+        goto dispatch_opcode; \
+    }
+#else
+#define QUICKEN(size, int_op, float_op)
+#endif
+
 /* OpCode prediction macros
     Some opcodes tend to come in pairs thus making it possible to
     predict the second code when the first is run.  For example,
@@ -916,6 +1017,12 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
     fastlocals = f->f_localsplus;
     freevars = f->f_localsplus + co->co_nlocals;
     first_instr = (unsigned char*) PyString_AS_STRING(co->co_code);
+#ifdef USE_QUICKENING
+    if (co->co_quickened != NULL || quicken_code(co) != NULL) {
+        first_instr = co->co_quickened;
+        quick_counters = first_instr + PyString_GET_SIZE(co->co_code);
+    }
+#endif
     /* An explanation is in order for the next line.
 
        f->f_lasti now refers to the index of the last instruction
@@ -1008,19 +1115,20 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
                     _Py_Ticker = 0;
             }
 #ifdef WITH_THREAD
-            if (interpreter_lock) {
+            if (gil_drop_request && gil_created()) {
                 /* Give another thread a chance */
 
                 if (PyThreadState_Swap(NULL) != tstate)
                     Py_FatalError("ceval: tstate mix-up");
-                PyThread_release_lock(interpreter_lock);
+                drop_gil(tstate);
 
                 /* Other threads may run now */
 
-                PyThread_acquire_lock(interpreter_lock, 1);
+                take_gil(tstate);
                 if (PyThreadState_Swap(tstate) != NULL)
                     Py_FatalError("ceval: orphan tstate");
-
+            }
+            if (gil_created()) {
                 /* Check for thread interrupts */
 
                 if (tstate->async_exc != NULL) {
@@ -1261,6 +1369,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case BINARY_MULTIPLY:
             w = POP();
             v = TOP();
+            QUICKEN(1, BINARY_MULTIPLY_INT, BINARY_MULTIPLY_FLOAT);
             x = PyNumber_Multiply(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
@@ -1272,6 +1381,8 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
             if (!_Py_QnewFlag) {
                 w = POP();
                 v = TOP();
+                QUICKEN(1, 0, Py_DivisionWarningFlag < 2 ?
+                              BINARY_DIVIDE_FLOAT : 0);
                 x = PyNumber_Divide(v, w);
                 Py_DECREF(v);
                 Py_DECREF(w);
@@ -1284,6 +1395,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case BINARY_TRUE_DIVIDE:
             w = POP();
             v = TOP();
+            QUICKEN(1, 0, BINARY_DIVIDE_FLOAT);
             x = PyNumber_TrueDivide(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
@@ -1294,6 +1406,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case BINARY_FLOOR_DIVIDE:
             w = POP();
             v = TOP();
+            QUICKEN(1, BINARY_FLOOR_DIVIDE_INT, 0);
             x = PyNumber_FloorDivide(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
@@ -1304,6 +1417,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case BINARY_MODULO:
             w = POP();
             v = TOP();
+            QUICKEN(1, BINARY_MODULO_INT, 0);
             if (PyString_CheckExact(v))
                 x = PyString_Format(v, w);
             else
@@ -1317,6 +1431,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case BINARY_ADD:
             w = POP();
             v = TOP();
+            QUICKEN(1, BINARY_ADD_INT, BINARY_ADD_FLOAT);
             if (PyInt_CheckExact(v) && PyInt_CheckExact(w)) {
                 /* INLINE: int + int */
                 register long a, b, i;
@@ -1327,20 +1442,27 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
                 i = (long)((unsigned long)a + b);
                 if ((i^a) < 0 && (i^b) < 0)
                     goto slow_add;
-                x = PyInt_FromLong(i);
+                x = _PyInt_FROM_LONG(i);
             }
             else if (PyString_CheckExact(v) &&
                      PyString_CheckExact(w)) {
-                x = string_concatenate(v, w, f, next_instr);
+                x = string_concatenate(v, w, f, next_instr,
+                                       stack_pointer);
                 /* string_concatenate consumed the ref to v */
-                goto skip_decref_vx;
+                Py_DECREF(w);
+                SET_TOP(x);
+                /* v may have been taken out of the variable, attribute
+                   or item that the next opcodes store x in; run them
+                   before a thread switch or signal handler can see it
+                   missing */
+                if (x != NULL) goto fast_next_opcode;
+                break;
             }
             else {
               slow_add:
                 x = PyNumber_Add(v, w);
             }
             Py_DECREF(v);
-          skip_decref_vx:
             Py_DECREF(w);
             SET_TOP(x);
             if (x != NULL) continue;
@@ -1349,6 +1471,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case BINARY_SUBTRACT:
             w = POP();
             v = TOP();
+            QUICKEN(1, BINARY_SUBTRACT_INT, BINARY_SUBTRACT_FLOAT);
             if (PyInt_CheckExact(v) && PyInt_CheckExact(w)) {
                 /* INLINE: int - int */
                 register long a, b, i;
@@ -1359,7 +1482,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
                 i = (long)((unsigned long)a - b);
                 if ((i^a) < 0 && (i^~b) < 0)
                     goto slow_sub;
-                x = PyInt_FromLong(i);
+                x = _PyInt_FROM_LONG(i);
             }
             else {
               slow_sub:
@@ -1480,6 +1603,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case INPLACE_MULTIPLY:
             w = POP();
             v = TOP();
+            QUICKEN(1, BINARY_MULTIPLY_INT, BINARY_MULTIPLY_FLOAT);
             x = PyNumber_InPlaceMultiply(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
@@ -1491,6 +1615,8 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
             if (!_Py_QnewFlag) {
                 w = POP();
                 v = TOP();
+                QUICKEN(1, 0, Py_DivisionWarningFlag < 2 ?
+                              BINARY_DIVIDE_FLOAT : 0);
                 x = PyNumber_InPlaceDivide(v, w);
                 Py_DECREF(v);
                 Py_DECREF(w);
@@ -1503,6 +1629,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case INPLACE_TRUE_DIVIDE:
             w = POP();
             v = TOP();
+            QUICKEN(1, 0, BINARY_DIVIDE_FLOAT);
             x = PyNumber_InPlaceTrueDivide(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
@@ -1513,6 +1640,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case INPLACE_FLOOR_DIVIDE:
             w = POP();
             v = TOP();
+            QUICKEN(1, BINARY_FLOOR_DIVIDE_INT, 0);
             x = PyNumber_InPlaceFloorDivide(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
@@ -1523,6 +1651,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case INPLACE_MODULO:
             w = POP();
             v = TOP();
+            QUICKEN(1, BINARY_MODULO_INT, 0);
             x = PyNumber_InPlaceRemainder(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
@@ -1533,6 +1662,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case INPLACE_ADD:
             w = POP();
             v = TOP();
+            QUICKEN(1, BINARY_ADD_INT, BINARY_ADD_FLOAT);
             if (PyInt_CheckExact(v) && PyInt_CheckExact(w)) {
                 /* INLINE: int + int */
                 register long a, b, i;
@@ -1541,20 +1671,27 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
                 i = a + b;
                 if ((i^a) < 0 && (i^b) < 0)
                     goto slow_iadd;
-                x = PyInt_FromLong(i);
+                x = _PyInt_FROM_LONG(i);
             }
             else if (PyString_CheckExact(v) &&
                      PyString_CheckExact(w)) {
-                x = string_concatenate(v, w, f, next_instr);
+                x = string_concatenate(v, w, f, next_instr,
+                                       stack_pointer);
                 /* string_concatenate consumed the ref to v */
-                goto skip_decref_v;
+                Py_DECREF(w);
+                SET_TOP(x);
+                /* v may have been taken out of the variable, attribute
+                   or item that the next opcodes store x in; run them
+                   before a thread switch or signal handler can see it
+                   missing */
+                if (x != NULL) goto fast_next_opcode;
+                break;
             }
             else {
               slow_iadd:
                 x = PyNumber_InPlaceAdd(v, w);
             }
             Py_DECREF(v);
-          skip_decref_v:
             Py_DECREF(w);
             SET_TOP(x);
             if (x != NULL) continue;
@@ -1563,6 +1700,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case INPLACE_SUBTRACT:
             w = POP();
             v = TOP();
+            QUICKEN(1, BINARY_SUBTRACT_INT, BINARY_SUBTRACT_FLOAT);
             if (PyInt_CheckExact(v) && PyInt_CheckExact(w)) {
                 /* INLINE: int - int */
                 register long a, b, i;
@@ -1571,7 +1709,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
                 i = a - b;
                 if ((i^a) < 0 && (i^~b) < 0)
                     goto slow_isub;
-                x = PyInt_FromLong(i);
+                x = _PyInt_FROM_LONG(i);
             }
             else {
               slow_isub:
@@ -1633,6 +1771,160 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
             if (x != NULL) continue;
             break;
 
+#ifdef USE_QUICKENING
+        /* Specialized forms of the arithmetic opcodes, only found in
+           quickened code.  They stand for both the BINARY_* and the
+           INPLACE_* generic opcode, which behave the same on exact ints
+           and floats. */
+
+        case BINARY_ADD_INT:
+            w = TOP();
+            v = SECOND();
+            if (!PyInt_CheckExact(v) || !PyInt_CheckExact(w))
+                DEOPTIMIZE(1);
+            {
+                register long a, b, i;
+                a = PyInt_AS_LONG(v);
+                b = PyInt_AS_LONG(w);
+                /* cast to avoid undefined behaviour
+                   on overflow */
+                i = (long)((unsigned long)a + b);
+                if ((i^a) < 0 && (i^b) < 0)
+                    x = PyNumber_Add(v, w);
+                else
+                    x = _PyInt_FROM_LONG(i);
+            }
+            STACKADJ(-1);
+            Py_DECREF(v);
+            Py_DECREF(w);
+            SET_TOP(x);
+            if (x != NULL) continue;
+            break;
+
+        case BINARY_SUBTRACT_INT:
+            w = TOP();
+            v = SECOND();
+            if (!PyInt_CheckExact(v) || !PyInt_CheckExact(w))
+                DEOPTIMIZE(1);
+            {
+                register long a, b, i;
+                a = PyInt_AS_LONG(v);
+                b = PyInt_AS_LONG(w);
+                /* cast to avoid undefined behaviour
+                   on overflow */
+                i = (long)((unsigned long)a - b);
+                if ((i^a) < 0 && (i^~b) < 0)
+                    x = PyNumber_Subtract(v, w);
+                else
+                    x = _PyInt_FROM_LONG(i);
+            }
+            STACKADJ(-1);
+            Py_DECREF(v);
+            Py_DECREF(w);
+            SET_TOP(x);
+            if (x != NULL) continue;
+            break;
+
+        case BINARY_MULTIPLY_INT:
+            w = TOP();
+            v = SECOND();
+            if (!PyInt_CheckExact(v) || !PyInt_CheckExact(w))
+                DEOPTIMIZE(1);
+            {
+                /* The product cannot overflow when both factors fit
+                   in half a long; leave the rest to int_mul(). */
+                register long a, b;
+                const unsigned long half = 1UL << (LONG_BIT / 2 - 1);
+                a = PyInt_AS_LONG(v);
+                b = PyInt_AS_LONG(w);
+                if ((unsigned long)a + half < 2 * half &&
+                    (unsigned long)b + half < 2 * half)
+                    x = _PyInt_FROM_LONG(a * b);
+                else
+                    x = PyNumber_Multiply(v, w);
+            }
+            STACKADJ(-1);
+            Py_DECREF(v);
+            Py_DECREF(w);
+            SET_TOP(x);
+            if (x != NULL) continue;
+            break;
+
+        case BINARY_FLOOR_DIVIDE_INT:
+        case BINARY_MODULO_INT:
+            w = TOP();
+            v = SECOND();
+            if (!PyInt_CheckExact(v) || !PyInt_CheckExact(w))
+                DEOPTIMIZE(1);
+            {
+                /* Same as i_divmod() in intobject.c; division by
+                   zero and -sys.maxint-1 / -1 take the slow path. */
+                register long a, b, q, r;
+                a = PyInt_AS_LONG(v);
+                b = PyInt_AS_LONG(w);
+                if (b == 0 || (b == -1 && a == LONG_MIN)) {
+                    if (opcode == BINARY_MODULO_INT)
+                        x = PyNumber_Remainder(v, w);
+                    else
+                        x = PyNumber_FloorDivide(v, w);
+                }
+                else {
+                    q = a / b;
+                    r = (long)(a - (unsigned long)q * b);
+                    if (r && ((b ^ r) < 0)) {
+                        r += b;
+                        --q;
+                    }
+                    x = _PyInt_FROM_LONG(opcode == BINARY_MODULO_INT ?
+                                         r : q);
+                }
+            }
+            STACKADJ(-1);
+            Py_DECREF(v);
+            Py_DECREF(w);
+            SET_TOP(x);
+            if (x != NULL) continue;
+            break;
+
+        case BINARY_ADD_FLOAT:
+        case BINARY_SUBTRACT_FLOAT:
+        case BINARY_MULTIPLY_FLOAT:
+        case BINARY_DIVIDE_FLOAT:
+            w = TOP();
+            v = SECOND();
+            if (!PyFloat_CheckExact(v) || !PyFloat_CheckExact(w))
+                DEOPTIMIZE(1);
+            {
+                register double a, b;
+                a = PyFloat_AS_DOUBLE(v);
+                b = PyFloat_AS_DOUBLE(w);
+                switch (opcode) {
+                case BINARY_ADD_FLOAT:
+                    x = PyFloat_FromDouble(a + b);
+                    break;
+                case BINARY_SUBTRACT_FLOAT:
+                    x = PyFloat_FromDouble(a - b);
+                    break;
+                case BINARY_MULTIPLY_FLOAT:
+                    x = PyFloat_FromDouble(a * b);
+                    break;
+                default:
+                    /* let float_div() raise ZeroDivisionError */
+                    if (b == 0.0)
+                        x = PyNumber_TrueDivide(v, w);
+                    else
+                        x = PyFloat_FromDouble(a / b);
+                    break;
+                }
+            }
+            STACKADJ(-1);
+            Py_DECREF(v);
+            Py_DECREF(w);
+            SET_TOP(x);
+            if (x != NULL) continue;
+            break;
+#endif /* USE_QUICKENING */
+
         case SLICE+0:
         case SLICE+1:
         case SLICE+2:
@@ -2090,6 +2382,10 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
                         PUSH(x);
                         continue;
                     }
+                    /* A split dict doesn't hold its values in its
+                       entries:  use the un-inlined version */
+                    if (d->ma_values != NULL)
+                        goto load_global_dict;
                     d = (PyDictObject *)(f->f_builtins);
                     e = d->ma_lookup(d, w, hash);
                     if (e == NULL) {
@@ -2102,10 +2398,13 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
                         PUSH(x);
                         continue;
                     }
+                    if (d->ma_values != NULL)
+                        goto load_global_dict;
                     goto load_global_error;
                 }
             }
             /* This is the un-inlined version of the code above */
+          load_global_dict:
             x = PyDict_GetItem(f->f_globals, w);
             if (x == NULL) {
                 x = PyDict_GetItem(f->f_builtins, w);
@@ -2262,6 +2561,8 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case COMPARE_OP:
             w = POP();
             v = TOP();
+            if (oparg <= PyCmp_GE)
+                QUICKEN(3, COMPARE_OP_INT, COMPARE_OP_FLOAT);
             if (PyInt_CheckExact(w) && PyInt_CheckExact(v)) {
                 /* INLINE: cmp(int, int) */
                 register long a, b;
@@ -2294,6 +2595,69 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
             PREDICT(POP_JUMP_IF_TRUE);
             continue;
 
+#ifdef USE_QUICKENING
+        /* Specialized forms of COMPARE_OP for the six rich comparisons,
+           only found in quickened code. */
+
+        case COMPARE_OP_INT:
+            w = TOP();
+            v = SECOND();
+            if (!PyInt_CheckExact(v) || !PyInt_CheckExact(w))
+                DEOPTIMIZE(3);
+            {
+                register long a, b;
+                register int res;
+                a = PyInt_AS_LONG(v);
+                b = PyInt_AS_LONG(w);
+                switch (oparg) {
+                case PyCmp_LT: res = a <  b; break;
+                case PyCmp_LE: res = a <= b; break;
+                case PyCmp_EQ: res = a == b; break;
+                case PyCmp_NE: res = a != b; break;
+                case PyCmp_GT: res = a >  b; break;
+                default:       res = a >= b; break;
+                }
+                x = res ? Py_True : Py_False;
+                Py_INCREF(x);
+            }
+            STACKADJ(-1);
+            Py_DECREF(v);
+            Py_DECREF(w);
+            SET_TOP(x);
+            PREDICT(POP_JUMP_IF_FALSE);
+            PREDICT(POP_JUMP_IF_TRUE);
+            continue;
+
+        case COMPARE_OP_FLOAT:
+            w = TOP();
+            v = SECOND();
+            if (!PyFloat_CheckExact(v) || !PyFloat_CheckExact(w))
+                DEOPTIMIZE(3);
+            {
+                register double a, b;
+                register int res;
+                a = PyFloat_AS_DOUBLE(v);
+                b = PyFloat_AS_DOUBLE(w);
+                switch (oparg) {
+                case PyCmp_LT: res = a <  b; break;
+                case PyCmp_LE: res = a <= b; break;
+                case PyCmp_EQ: res = a == b; break;
+                case PyCmp_NE: res = a != b; break;
+                case PyCmp_GT: res = a >  b; break;
+                default:       res = a >= b; break;
+                }
+                x = res ? Py_True : Py_False;
+                Py_INCREF(x);
+            }
+            STACKADJ(-1);
+            Py_DECREF(v);
+            Py_DECREF(w);
+            SET_TOP(x);
+            PREDICT(POP_JUMP_IF_FALSE);
+            PREDICT(POP_JUMP_IF_TRUE);
+            continue;
+#endif /* USE_QUICKENING */
+
         case IMPORT_NAME:
             w = GETITEM(names, oparg);
             x = PyDict_GetItemString(f->f_builtins, "__import__");
@@ -2494,7 +2858,12 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         case FOR_ITER:
             /* before: [iter]; after: [iter, iter()] *or* [] */
             v = TOP();
-            x = (*v->ob_type->tp_iternext)(v);
+            {
+                PyFrameObject *outer = tstate->iternext_frame;
+                tstate->iternext_frame = f;
+                x = (*Py_TYPE(v)->tp_iternext)(v);
+                tstate->iternext_frame = outer;
+            }
             if (x != NULL) {
                 PUSH(x);
                 PREDICT(STORE_FAST);
@@ -2859,7 +3228,8 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
         /* Log traceback info if this is a real exception */
 
         if (why == WHY_EXCEPTION) {
-            PyTraceBack_Here(f);
+            if (!stopiter_discarded(tstate, f))
+                PyTraceBack_Here(f);
 
             if (tstate->c_tracefunc != NULL)
                 call_exc_trace(tstate->c_tracefunc,
@@ -3104,11 +3474,19 @@ PyEval_EvalCodeEx(PyCodeObject *co, PyObject *globals, PyObject *locals,
                 if (nm == keyword)
                     goto kw_found;
             }
-            /* Slow fallback, just in case */
+            /* Slow fallback, just in case.  Keywords that come from
+               a **kwargs dict are often not interned; compare plain
+               strings directly instead of through rich comparison. */
             for (j = 0; j < co->co_argcount; j++) {
                 PyObject *nm = co_varnames[j];
-                int cmp = PyObject_RichCompareBool(
-                    keyword, nm, Py_EQ);
+                int cmp;
+                if (PyString_CheckExact(keyword) &&
+                    PyString_CheckExact(nm)) {
+                    if (_PyString_Eq(keyword, nm))
+                        goto kw_found;
+                    continue;
+                }
+                cmp = PyObject_RichCompareBool(keyword, nm, Py_EQ);
                 if (cmp > 0)
                     goto kw_found;
                 else if (cmp < 0)
@@ -3515,6 +3893,15 @@ do_raise(PyObject *type, PyObject *value, PyObject *tb)
         Py_DECREF(tmp);
     }
 
+    if (type == PyExc_StopIteration && value == Py_None && tb == NULL) {
+        /* Leave a bare "raise StopIteration" unnormalized.  It usually
+           ends an iteration, which discards it without ever looking
+           at an instance. */
+        Py_DECREF(value);
+        PyErr_Restore(type, NULL, NULL);
+        return WHY_EXCEPTION;
+    }
+
     if (PyExceptionClass_Check(type)) {
         PyErr_NormalizeException(&type, &value, &tb);
         if (!PyExceptionInstance_Check(value)) {
@@ -3547,7 +3934,7 @@ do_raise(PyObject *type, PyObject *value, PyObject *tb)
         PyErr_Format(PyExc_TypeError,
                      "exceptions must be old-style classes or "
                      "derived from BaseException, not %s",
-                     type->ob_type->tp_name);
+                     Py_TYPE(type)->tp_name);
         goto raise_error;
     }
 
@@ -3571,6 +3958,27 @@ do_raise(PyObject *type, PyObject *value, PyObject *tb)
     return WHY_EXCEPTION;
 }
 
+/* Return true if the exception leaving f is a StopIteration that the
+   FOR_ITER or PyIter_Next() in f's caller will swallow.  f must have no
+   handler that could catch it first.  Then a traceback entry for f would
+   be thrown away unseen, so the caller need not record one.  Tracing and
+   profiling functions always get the full traceback. */
+
+static int
+stopiter_discarded(PyThreadState *tstate, PyFrameObject *f)
+{
+    int i;
+
+    if (f->f_back == NULL || f->f_back != tstate->iternext_frame ||
+        tstate->curexc_type != PyExc_StopIteration || tstate->use_tracing)
+        return 0;
+    for (i = 0; i < f->f_iblock; i++) {
+        if (f->f_blockstack[i].b_type != SETUP_LOOP)
+            return 0;
+    }
+    return 1;
+}
+
 /* Iterate v argcnt times and store the results on the stack (via decreasing
    sp).  Return 1 for success, 0 if error. */
 
@@ -3907,7 +4315,7 @@ PyEval_GetFuncName(PyObject *func)
         return PyString_AsString(
             ((PyInstanceObject*)func)->in_class->cl_name);
     } else {
-        return func->ob_type->tp_name;
+        return Py_TYPE(func)->tp_name;
     }
 }
 
@@ -4273,7 +4681,7 @@ ext_do_call(PyObject *func, PyObject ***pp_stack, int flags, int na, int nk)
                                  "must be a mapping, not %.200s",
                                  PyEval_GetFuncName(func),
                                  PyEval_GetFuncDesc(func),
-                                 kwdict->ob_type->tp_name);
+                                 Py_TYPE(kwdict)->tp_name);
                 }
                 goto ext_call_fail;
             }
@@ -4293,7 +4701,7 @@ ext_do_call(PyObject *func, PyObject ***pp_stack, int flags, int na, int nk)
                                  "must be a sequence, not %200s",
                                  PyEval_GetFuncName(func),
                                  PyEval_GetFuncDesc(func),
-                                 stararg->ob_type->tp_name);
+                                 Py_TYPE(stararg)->tp_name);
                 }
                 goto ext_call_fail;
             }
@@ -4302,6 +4710,12 @@ ext_do_call(PyObject *func, PyObject ***pp_stack, int flags, int na, int nk)
         }
         nstar = PyTuple_GET_SIZE(stararg);
     }
+    if (PyFunction_Check(func)) {
+        PCALL(PCALL_FUNCTION);
+        result = ext_fast_function(func, (*pp_stack) - na - 2 * nk, na, nk,
+                                   stararg, kwdict);
+        goto ext_call_fail;
+    }
     if (nk > 0) {
         kwdict = update_keyword_args(kwdict, nk, pp_stack, func);
         if (kwdict == NULL)
@@ -4339,6 +4753,115 @@ ext_call_fail:
     return result;
 }
 
+/* The ext_fast_function() function optimizes calls to Python functions
+   made with *args and/or **kwargs.  Instead of building the argument
+   tuple and the merged keyword dict that PyObject_Call() needs (and that
+   function_call() then unpacks again), positional arguments are taken
+   straight from the stack or the *args tuple, and keyword arguments from
+   the stack and the **kwargs dict are gathered into a single array, which
+   PyEval_EvalCodeEx() binds into the new frame's fast locals.  Small
+   argument lists are gathered in automatic storage.
+
+   'stack' points to the first positional argument on the value stack; it
+   is followed by nk keyword name/value pairs.  The arguments are left on
+   the stack for the caller to clear.
+*/
+
+#define EXT_CALL_SMALL_ARGS 16
+
+static PyObject *
+ext_fast_function(PyObject *func, PyObject **stack, int na, int nk,
+                  PyObject *stararg, PyObject *kwdict)
+{
+    PyCodeObject *co = (PyCodeObject *)PyFunction_GET_CODE(func);
+    PyObject *argdefs = PyFunction_GET_DEFAULTS(func);
+    PyObject *small_args[EXT_CALL_SMALL_ARGS];
+    PyObject *small_kws[2 * EXT_CALL_SMALL_ARGS];
+    PyObject **args = stack, **kws = stack + na, **d = NULL;
+    PyObject *key, *value, *result = NULL;
+    Py_ssize_t nstar = 0, ndict = 0, nd = 0, i, pos;
+    int filled = 2 * nk;
+
+    if (stararg != NULL)
+        nstar = PyTuple_GET_SIZE(stararg);
+    if (kwdict != NULL)
+        ndict = PyDict_Size(kwdict);
+    if (na + nstar > INT_MAX || nk + ndict > INT_MAX) {
+        PyErr_SetString(PyExc_OverflowError,
+                        "too many arguments in function call");
+        return NULL;
+    }
+
+    /* Positional arguments: the stack, then the *args tuple */
+    if (nstar > 0) {
+        if (na == 0)
+            args = &PyTuple_GET_ITEM(stararg, 0);
+        else {
+            if (na + nstar <= EXT_CALL_SMALL_ARGS)
+                args = small_args;
+            else if ((args = PyMem_NEW(PyObject *, na + nstar)) == NULL)
+                return PyErr_NoMemory();
+            memcpy(args, stack, na * sizeof(PyObject *));
+            memcpy(args + na, &PyTuple_GET_ITEM(stararg, 0),
+                   nstar * sizeof(PyObject *));
+        }
+    }
+
+    /* Keyword arguments: the stack pairs, then the **kwargs items.  The
+       items are borrowed from a dict that the callee may mutate, so we
+       hold references to them for the duration of the call. */
+    if (ndict > 0) {
+        for (i = 0; i < nk; i++) {
+            key = stack[na + 2 * i];
+            if (PyDict_GetItem(kwdict, key) != NULL) {
+                PyErr_Format(PyExc_TypeError,
+                             "%.200s%s got multiple values "
+                             "for keyword argument '%.200s'",
+                             PyEval_GetFuncName(func),
+                             PyEval_GetFuncDesc(func),
+                             PyString_AsString(key));
+                goto done;
+            }
+        }
+        if (nk + ndict <= EXT_CALL_SMALL_ARGS)
+            kws = small_kws;
+        else if ((kws = PyMem_NEW(PyObject *, 2 * (nk + ndict))) == NULL) {
+            kws = stack + na;
+            PyErr_NoMemory();
+            goto done;
+        }
+        memcpy(kws, stack + na, 2 * nk * sizeof(PyObject *));
+        pos = 0;
+        while (filled < 2 * (nk + ndict) &&
+               PyDict_Next(kwdict, &pos, &key, &value)) {
+            Py_INCREF(key);
+            Py_INCREF(value);
+            kws[filled++] = key;
+            kws[filled++] = value;
+        }
+    }
+
+    if (argdefs != NULL) {
+        d = &PyTuple_GET_ITEM(argdefs, 0);
+        nd = Py_SIZE(argdefs);
+    }
+    result = PyEval_EvalCodeEx(co, PyFunction_GET_GLOBALS(func),
+                               (PyObject *)NULL, args, (int)(na + nstar),
+                               kws, filled / 2, d, (int)nd,
+                               PyFunction_GET_CLOSURE(func));
+
+  done:
+    if (kws != stack + na) {
+        for (i = 2 * nk; i < filled; i++)
+            Py_DECREF(kws[i]);
+        if (kws != small_kws)
+            PyMem_FREE(kws);
+    }
+    if (args != stack && args != small_args && nstar > 0 && na > 0)
+        PyMem_FREE(args);
+    return result;
+}
+
 /* Extract a slice index from a PyInt or PyLong or an object with the
    nb_index slot defined, and store in *pi.
    Silently reduce values larger than PY_SSIZE_T_MAX to PY_SSIZE_T_MAX,
@@ -4384,7 +4907,7 @@ _PyEval_SliceIndex(PyObject *v, Py_ssize_t *pi)
 static PyObject *
 apply_slice(PyObject *u, PyObject *v, PyObject *w) /* return u[v:w] */
 {
-    PyTypeObject *tp = u->ob_type;
+    PyTypeObject *tp = Py_TYPE(u);
     PySequenceMethods *sq = tp->tp_as_sequence;
 
     if (sq && sq->sq_slice && ISINDEX(v) && ISINDEX(w)) {
@@ -4411,7 +4934,7 @@ static int
 assign_slice(PyObject *u, PyObject *v, PyObject *w, PyObject *x)
     /* u[v:w] = x */
 {
-    PyTypeObject *tp = u->ob_type;
+    PyTypeObject *tp = Py_TYPE(u);
     PySequenceMethods *sq = tp->tp_as_sequence;
 
     if (sq && sq->sq_ass_slice && ISINDEX(v) && ISINDEX(w)) {
@@ -4617,7 +5140,7 @@ build_class(PyObject *methods, PyObject *bases, PyObject *name)
         metaclass = PyObject_GetAttrString(base, "__class__");
         if (metaclass == NULL) {
             PyErr_Clear();
-            metaclass = (PyObject *)base->ob_type;
+            metaclass = (PyObject *)Py_TYPE(base);
             Py_INCREF(metaclass);
         }
     }
@@ -4777,12 +5300,73 @@ format_exc_check_arg(PyObject *exc, char *format_str, PyObject *obj)
     PyErr_Format(exc, format_str, obj_str);
 }
 
+/* Helpers for string_concatenate(), which takes the value being added to
+   out of its variable, attribute or item, so as to own the last reference
+   to it.  They must not run any Python code. */
+
+/* Replace the value of the str key in the exact dict d by None */
+static void
+release_dict_value(PyObject *d, PyObject *key)
+{
+    if (PyDict_SetItem(d, key, Py_None) != 0)
+        PyErr_Clear();
+}
+
+/* Return the dict that both obj.name and "obj.name = value" use, or NULL
+   if the attribute isn't kept in a plain instance dict or setting it runs
+   Python code. */
+static PyObject *
+attribute_dict(PyObject *obj, PyObject *name)
+{
+    PyObject **dictptr;
+    char *sname;
+
+    if (!PyString_CheckExact(name))
+        return NULL;
+    sname = PyString_AS_STRING(name);
+    if (sname[0] == '_' && sname[1] == '_')
+        return NULL;
+    if (PyInstance_Check(obj)) {
+        PyInstanceObject *inst = (PyInstanceObject *)obj;
+        if (inst->in_class->cl_setattr != NULL)
+            return NULL;
+        return inst->in_dict;
+    }
+    if (Py_TYPE(obj)->tp_setattro != PyObject_GenericSetAttr ||
+        _PyType_Lookup(Py_TYPE(obj), name) != NULL)
+        return NULL;
+    dictptr = _PyObject_GetDictPtr(obj);
+    return dictptr != NULL ? *dictptr : NULL;
+}
+
+/* Replace container[key] by None if it is v, container is an exact list or
+   dict and key a plain int or str */
+static void
+release_item(PyObject *container, PyObject *key, PyObject *v)
+{
+    if (PyList_CheckExact(container) && PyInt_CheckExact(key)) {
+        Py_ssize_t i = PyInt_AS_LONG(key);
+        if (i < 0)
+            i += PyList_GET_SIZE(container);
+        if (i >= 0 && i < PyList_GET_SIZE(container) &&
+            PyList_GET_ITEM(container, i) == v) {
+            Py_INCREF(Py_None);
+            PyList_SET_ITEM(container, i, Py_None);
+            Py_DECREF(v);
+        }
+    }
+    else if (PyDict_CheckExact(container) && PyString_CheckExact(key) &&
+             PyDict_GetItem(container, key) == v)
+        release_dict_value(container, key);
+}
+
 static PyObject *
 string_concatenate(PyObject *v, PyObject *w,
-                   PyFrameObject *f, unsigned char *next_instr)
+                   PyFrameObject *f, unsigned char *next_instr,
+                   PyObject **stack_pointer)
 {
     /* This function implements 'variable += expr' when both arguments
-       are strings. */
+       are strings.  v is on top of the stack. */
     Py_ssize_t v_len = PyString_GET_SIZE(v);
     Py_ssize_t w_len = PyString_GET_SIZE(w);
     Py_ssize_t new_len = v_len + w_len;
@@ -4792,7 +5376,7 @@ string_concatenate(PyObject *v, PyObject *w,
         return NULL;
     }
 
-    if (v->ob_refcnt == 2) {
+    if (Py_REFCNT(v) == 2) {
         /* In the common case, there are 2 references to the value
          * stored in 'variable' when the += is performed: one on the
          * value stack (in 'v') and one still stored in the
@@ -4830,10 +5414,37 @@ string_concatenate(PyObject *v, PyObject *w,
             }
             break;
         }
+        case STORE_GLOBAL:
+        {
+            PyObject *names = f->f_code->co_names;
+            PyObject *name = GETITEM(names, PEEKARG());
+            PyObject *globals = f->f_globals;
+            if (PyDict_CheckExact(globals) &&
+                PyDict_GetItem(globals, name) == v)
+                release_dict_value(globals, name);
+            break;
+        }
+        case ROT_TWO:
+            /* obj.attr += expr leaves obj under v */
+            if (next_instr[1] == STORE_ATTR) {
+                PyObject *names = f->f_code->co_names;
+                PyObject *name = GETITEM(names,
+                                         (next_instr[3]<<8) + next_instr[2]);
+                PyObject *dict = attribute_dict(stack_pointer[-2], name);
+                if (dict != NULL && PyDict_CheckExact(dict) &&
+                    PyDict_GetItem(dict, name) == v)
+                    release_dict_value(dict, name);
+            }
+            break;
+        case ROT_THREE:
+            /* container[key] += expr leaves container and key under v */
+            if (next_instr[1] == STORE_SUBSCR)
+                release_item(stack_pointer[-3], stack_pointer[-2], v);
+            break;
         }
     }
 
-    if (v->ob_refcnt == 1 && !PyString_CHECK_INTERNED(v)) {
+    if (Py_REFCNT(v) == 1 && !PyString_CHECK_INTERNED(v)) {
         /* Now we own the last reference to 'v', so we can resize it
          * in-place.
          */
@@ -1486,6 +1486,107 @@ bigcomp(U *rv, const char *s0, BCinfo *bc)
     return 0;
 }
 
+#ifdef ULLong
+
+/* The Eisel-Lemire fast path (Daniel Lemire, "Number Parsing at a Gigabyte
+   per Second", 2021, after Michael Eisel).  w * 10**q, for w != 0, is
+   rounded from the 128-bit product of w with the leading 128 bits of 10**q
+   in el_pow10_split, extended to 192 bits when the low bits are close to
+   a carry.  The error of the table is below one unit in its last place,
+   so the product decides the double unless it is within that error of a
+   halfway case.  In that case, and for results that overflow or are
+   subnormal, eisel_lemire returns 0 and the caller goes on with the
+   Bigint-based code.  Otherwise it sets *rv and returns 1. */
+
+#define EL_U64(hi, lo) (((ULLong)(hi) << 32) | (ULLong)(lo))
+#include "eisel_lemire_tables.h"
+
+/* the low word of the product of a and b; the high word goes to *high */
+static ULLong
+el_mul128(ULLong a, ULLong b, ULLong *high)
+{
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 ULLLong;
+    ULLLong product = (ULLLong)a * b;
+
+    *high = (ULLong)(product >> 64);
+    return (ULLong)product;
+#else
+    ULLong a_lo = a & 0xffffffffU, a_hi = a >> 32;
+    ULLong b_lo = b & 0xffffffffU, b_hi = b >> 32;
+    ULLong b00 = a_lo * b_lo;
+    ULLong mid1 = a_hi * b_lo + (b00 >> 32);
+    ULLong mid2 = a_lo * b_hi + (mid1 & 0xffffffffU);
+
+    *high = a_hi * b_hi + (mid1 >> 32) + (mid2 >> 32);
+    return (mid2 << 32) | (b00 & 0xffffffffU);
+#endif
+}
+
+static int
+eisel_lemire(ULLong w, int q, U *rv)
+{
+    ULLong x_hi, x_lo, y_hi, y_lo, mantissa, upper;
+    const ULLong *pow10;
+    int lz, e2;
+
+    if (q < EL_MIN_EXP10 || q > EL_MAX_EXP10)
+        return 0;
+
+    /* normalize w so that its top bit is set */
+    lz = 0;
+    while (!(w >> 56)) {
+        w <<= 8;
+        lz += 8;
+    }
+    while (!(w >> 63)) {
+        w <<= 1;
+        lz++;
+    }
+    /* floor(q * log2(10)) + 64 is the binary exponent of the product's
+       top bit, give or take one */
+    e2 = Py_ARITHMETIC_RIGHT_SHIFT(int, 217706 * q, 16) + 64 + Bias - lz;
+
+    pow10 = el_pow10_split[q - EL_MIN_EXP10];
+    x_lo = el_mul128(w, pow10[1], &x_hi);
+    if ((x_hi & 0x1ff) == 0x1ff && x_lo + w < w) {
+        /* the bits below the 54 kept may carry into them: take the lower
+           word of 10**q into account too */
+        y_lo = el_mul128(w, pow10[0], &y_hi);
+        if (x_lo + y_hi < x_lo)
+            x_hi++;
+        x_lo += y_hi;
+        if ((x_hi & 0x1ff) == 0x1ff && x_lo + 1 == 0 && y_lo + w < w)
+            return 0;
+    }
+
+    /* keep 54 bits, one more than a double's mantissa */
+    upper = x_hi >> 63;
+    mantissa = x_hi >> (upper + 9);
+    e2 -= 1 ^ (int)upper;
+
+    /* possibly exactly halfway between two doubles */
+    if (x_lo == 0 && (x_hi & 0x1ff) == 0 && (mantissa & 3) == 1)
+        return 0;
+
+    /* round to 53 bits */
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >> 53) {
+        mantissa >>= 1;
+        e2++;
+    }
+    if (e2 <= 0 || e2 >= 0x7ff)
+        return 0;
+
+    word0(rv) = ((ULong)e2 << Exp_shift) |
+        ((ULong)(mantissa >> 32) & Frac_mask);
+    word1(rv) = (ULong)(mantissa & 0xffffffffU);
+    return 1;
+}
+
+#endif  /* ULLong */
+
 double
 _Py_dg_strtod(const char *s00, char **se)
 {
@@ -1703,6 +1804,27 @@ _Py_dg_strtod(const char *s00, char **se)
             goto ret;
         }
     }
+
+#ifdef ULLong
+    /* Try the Eisel-Lemire fast path on the first 19 significant digits,
+       which fit in a ULLong.  If there are more, the digits rounded down
+       and rounded up must give the same double. */
+    if (Flt_Rounds == 1) {
+        ULLong w = 0;
+        int nw = nd < 19 ? nd : 19;
+        U rv1, rv2;
+
+        for (i = 0; i < nw; i++)
+            w = 10*w + s0[i < nd0 ? i : i+1] - '0';
+        if (eisel_lemire(w, e + nd - nw, &rv1) &&
+            (nd == nw || (eisel_lemire(w + 1, e + nd - nw, &rv2) &&
+                          dval(&rv1) == dval(&rv2)))) {
+            dval(&rv) = dval(&rv1);
+            goto ret;
+        }
+    }
+#endif
+
     e1 += nd - k;
 
     bc.scale = 0;
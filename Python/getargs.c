@@ -454,7 +454,7 @@ converttuple(PyObject *arg, const char **p_format, va_list *p_va, int flags,
                       toplevel ? "expected %d arguments, not %.50s" :
                       "must be %d-item sequence, not %.50s",
                   n,
-                  arg == Py_None ? "None" : arg->ob_type->tp_name);
+                  arg == Py_None ? "None" : Py_TYPE(arg)->tp_name);
         return msgbuf;
     }
 
@@ -535,7 +535,7 @@ converterr(const char *expected, PyObject *arg, char *msgbuf, size_t bufsize)
     assert(arg != NULL);
     PyOS_snprintf(msgbuf, bufsize,
                   "must be %.50s, not %.50s", expected,
-                  arg == Py_None ? "None" : arg->ob_type->tp_name);
+                  arg == Py_None ? "None" : Py_TYPE(arg)->tp_name);
     return msgbuf;
 }
 
@@ -1228,7 +1228,7 @@ convertsimple(PyObject *arg, const char **p_format, va_list *p_va, int flags,
             type = va_arg(*p_va, PyTypeObject*);
             p = va_arg(*p_va, PyObject **);
             format++;
-            if (PyType_IsSubtype(arg->ob_type, type))
+            if (PyType_IsSubtype(Py_TYPE(arg), type))
                 *p = arg;
             else
                 return converterr(type->tp_name, arg, msgbuf, bufsize);
@@ -1265,7 +1265,7 @@ convertsimple(PyObject *arg, const char **p_format, va_list *p_va, int flags,
     case 'w': { /* memory buffer, read-write access */
         void **p = va_arg(*p_va, void **);
         void *res;
-        PyBufferProcs *pb = arg->ob_type->tp_as_buffer;
+        PyBufferProcs *pb = Py_TYPE(arg)->tp_as_buffer;
         Py_ssize_t count;
 
         if (pb && pb->bf_releasebuffer && *format != '*')
@@ -1317,14 +1317,14 @@ convertsimple(PyObject *arg, const char **p_format, va_list *p_va, int flags,
 
     case 't': { /* 8-bit character buffer, read-only access */
         char **p = va_arg(*p_va, char **);
-        PyBufferProcs *pb = arg->ob_type->tp_as_buffer;
+        PyBufferProcs *pb = Py_TYPE(arg)->tp_as_buffer;
         Py_ssize_t count;
 
         if (*format++ != '#')
             return converterr(
                 "invalid use of 't' format character",
                 arg, msgbuf, bufsize);
-        if (!PyType_HasFeature(arg->ob_type,
+        if (!PyType_HasFeature(Py_TYPE(arg),
                                Py_TPFLAGS_HAVE_GETCHARBUFFER) ||
             pb == NULL || pb->bf_getcharbuffer == NULL ||
             pb->bf_getsegcount == NULL)
@@ -1364,7 +1364,7 @@ convertsimple(PyObject *arg, const char **p_format, va_list *p_va, int flags,
 static Py_ssize_t
 convertbuffer(PyObject *arg, void **p, char **errmsg)
 {
-    PyBufferProcs *pb = arg->ob_type->tp_as_buffer;
+    PyBufferProcs *pb = Py_TYPE(arg)->tp_as_buffer;
     Py_ssize_t count;
     if (pb == NULL ||
         pb->bf_getreadbuffer == NULL ||
@@ -1388,7 +1388,7 @@ getbuffer(PyObject *arg, Py_buffer *view, char **errmsg)
 {
     void *buf;
     Py_ssize_t count;
-    PyBufferProcs *pb = arg->ob_type->tp_as_buffer;
+    PyBufferProcs *pb = Py_TYPE(arg)->tp_as_buffer;
     if (pb == NULL) {
         *errmsg = "string or buffer";
         return -1;
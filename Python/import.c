@@ -466,7 +466,7 @@ PyImport_Cleanup(void)
         ndone = 0;
         pos = 0;
         while (PyDict_Next(modules, &pos, &key, &value)) {
-            if (value->ob_refcnt != 1)
+            if (Py_REFCNT(value) != 1)
                 continue;
             if (PyString_Check(key) && PyModule_Check(value)) {
                 name = PyString_AS_STRING(key);
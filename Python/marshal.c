@@ -429,7 +429,7 @@ w_object(PyObject *v, WFILE *p)
     else if (PyObject_CheckReadBuffer(v)) {
         /* Write unknown buffer-style objects as a string */
         char *s;
-        PyBufferProcs *pb = v->ob_type->tp_as_buffer;
+        PyBufferProcs *pb = Py_TYPE(v)->tp_as_buffer;
         w_byte(TYPE_STRING, p);
         n = (*pb->bf_getreadbuffer)(v, 0, (void **)&s);
         if (n > INT_MAX) {
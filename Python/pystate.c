@@ -2,6 +2,7 @@
 /* Thread and interpreter state structures and their interfaces */
 
 #include "Python.h"
+#include "frameobject.h"
 
 /* --------------------------------------------------------------------------
 CAUTION
@@ -172,6 +173,8 @@ new_threadstate(PyInterpreterState *interp, int init)
         tstate->tick_counter = 0;
         tstate->gilstate_counter = 0;
         tstate->async_exc = NULL;
+        tstate->frame_chunk = NULL;
+        tstate->iternext_frame = NULL;
 #ifdef WITH_THREAD
         tstate->thread_id = PyThread_get_thread_ident();
 #else
@@ -287,6 +290,7 @@ tstate_delete_common(PyThreadState *tstate)
     }
     *p = tstate->next;
     HEAD_UNLOCK();
+    _PyFrame_DeleteArena(tstate);
     free(tstate);
 }
 
@@ -2,6 +2,7 @@
 
 #include <Python.h>
 #include <locale.h>
+#include <float.h>
 
 /* Case-insensitive string match used for nan and inf detection; t should be
    lower-case.  Returns 1 for a successful match, 0 otherwise. */
@@ -905,6 +906,56 @@ static char *uc_float_strings[] = {
 };
 
 
+/* The digits _Py_dg_dtoa(d, mode, precision, ...) returns for the finite
+   double d, found from the shortest digits of d, which _Py_ryu_shortest
+   computes without bignums.  digits must have room for 17 digits.  Returns
+   the number of digits, or -1 if the shortest digits don't settle the
+   result and it has to come from _Py_dg_dtoa.
+
+   Modes 2 and 3 round the exact value x of d to p significant digits.
+   Let s be the n shortest digits.  If n <= p, p <= 15 and d is normal, x
+   is within half a unit in the 17th place of s, well within half a unit
+   in the p-th place, so the result is s.  If n >= p + 2, rounding s gives
+   the result: the midpoint between the two p-digit candidates has p + 1
+   digits, so if it lay between x and s, s would not be the shortest. */
+
+static int
+shortest_float_digits(double d, int mode, int precision,
+                      char *digits, int *decpt, int *sign)
+{
+    int n, p;
+
+    n = _Py_ryu_shortest(d, digits, decpt, sign);
+    if (mode == 0 || d == 0.0)
+        return n;
+    if (mode == 2)
+        p = precision < 1 ? 1 : precision;
+    else
+        p = *decpt + precision;
+    if (n <= p)
+        return (p <= 15 && fabs(d) >= DBL_MIN) ? n : -1;
+    if (n < p + 2 || p <= 0)
+        return -1;
+
+    /* digits[p] is never a 5 followed only by zeros here */
+    n = p;
+    if (digits[p] >= '5') {
+        while (n > 0 && digits[n-1] == '9')
+            n--;
+        if (n == 0) {
+            digits[n++] = '1';
+            (*decpt)++;
+        }
+        else
+            digits[n-1]++;
+    }
+    else {
+        while (digits[n-1] == '0')
+            n--;
+    }
+    return n;
+}
+
 /* Convert a double d to a string, and return a PyMem_Malloc'd block of
    memory contain the resulting string.
 
@@ -942,17 +993,28 @@ format_float_short(double d, char format_code,
     char *buf = NULL;
     char *p = NULL;
     Py_ssize_t bufsize = 0;
-    char *digits, *digits_end;
-    int decpt_as_int, sign, exp_len, exp = 0, use_exp = 0;
+    char *digits, *digits_end, *dtoa_digits = NULL;
+    char short_digits[17];
+    int decpt_as_int, sign, exp_len, exp = 0, use_exp = 0, n = -1;
     Py_ssize_t decpt, digits_len, vdigits_start, vdigits_end;
     _Py_SET_53BIT_PRECISION_HEADER;
 
-    /* _Py_dg_dtoa returns a digit string (no decimal point or exponent).
-       Must be matched by a call to _Py_dg_freedtoa. */
-    _Py_SET_53BIT_PRECISION_START;
-    digits = _Py_dg_dtoa(d, mode, precision, &decpt_as_int, &sign,
-                         &digits_end);
-    _Py_SET_53BIT_PRECISION_END;
+    if (Py_IS_FINITE(d) && precision <= INT_MAX)
+        n = shortest_float_digits(d, mode, (int)precision, short_digits,
+                                  &decpt_as_int, &sign);
+    if (n >= 0) {
+        digits = short_digits;
+        digits_end = digits + n;
+    }
+    else {
+        /* _Py_dg_dtoa returns a digit string (no decimal point or
+           exponent).  Must be matched by a call to _Py_dg_freedtoa. */
+        _Py_SET_53BIT_PRECISION_START;
+        digits = dtoa_digits = _Py_dg_dtoa(d, mode, precision,
+                                           &decpt_as_int, &sign,
+                                           &digits_end);
+        _Py_SET_53BIT_PRECISION_END;
+    }
 
     decpt = (Py_ssize_t)decpt_as_int;
     if (digits == NULL) {
@@ -1175,8 +1237,8 @@ format_float_short(double d, char format_code,
            memory that isn't ours. But it's an okay debugging test. */
         assert(p-buf < bufsize);
     }
-    if (digits)
-        _Py_dg_freedtoa(digits);
+    if (dtoa_digits)
+        _Py_dg_freedtoa(dtoa_digits);
 
     return buf;
 }
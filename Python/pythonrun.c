@@ -173,6 +173,7 @@ Py_InitializeEx(int install_sigs)
         Py_HashRandomizationFlag = add_flag(Py_HashRandomizationFlag, p);
 
     _PyRandom_Init();
+    _PyFreeLists_Init();
 
     interp = PyInterpreterState_New();
     if (interp == NULL)
@@ -0,0 +1,296 @@
+/* Shortest round-tripping decimal digits of a double, without bignums.
+
+   This is Ulf Adams' Ryu algorithm (Ryu: Fast Float-to-String
+   Conversion, PLDI 2018).  The interval of reals that round to the
+   double is scaled by a power of ten from the tables in
+   Python/ryu_tables.h, using 64x128-bit multiplications, and decimal
+   digits are then removed while the scaled interval still holds a
+   shorter number.
+
+   The result is the one _Py_dg_dtoa() returns in mode 0: the shortest
+   digit string that rounds back to the double, and of those the one
+   closest to it, with an exact tie going to an even last digit.  The
+   bounds of the interval belong to it when the double's mantissa is
+   even, as round-half-even reading does.  Python/pystrtod.c uses this
+   for repr(), and to derive most of the results of the other modes. */
+
+#include "Python.h"
+
+/* if PY_NO_SHORT_FLOAT_REPR is defined, doubles are not IEEE 754 doubles
+   that can be read as their bits, and _Py_dg_dtoa isn't used either */
+#ifndef PY_NO_SHORT_FLOAT_REPR
+
+#if defined(HAVE_UINT64_T)
+typedef PY_UINT64_T ULLong;
+#else
+#error "Failed to find an exact-width 64-bit integer type"
+#endif
+
+/* the tables are written with 32-bit halves, as C89 has no 64-bit
+   literals */
+#define RYU_U64(hi, lo) (((ULLong)(hi) << 32) | (ULLong)(lo))
+
+#include "ryu_tables.h"
+
+#define DOUBLE_MANTISSA_BITS 52
+#define DOUBLE_EXPONENT_BITS 11
+#define DOUBLE_BIAS 1023
+
+/* ceil(log2(5**e)) for 0 < e <= 3528, and 1 for e == 0 */
+Py_LOCAL_INLINE(int)
+pow5bits(int e)
+{
+    return ((e * 1217359) >> 19) + 1;
+}
+
+/* floor(log10(2**e)) for 0 <= e <= 1650 */
+Py_LOCAL_INLINE(int)
+log10pow2(int e)
+{
+    return (e * 78913) >> 18;
+}
+
+/* floor(log10(5**e)) for 0 <= e <= 2620 */
+Py_LOCAL_INLINE(int)
+log10pow5(int e)
+{
+    return (e * 732923) >> 20;
+}
+
+/* is value, which isn't 0, divisible by 5**p? */
+Py_LOCAL_INLINE(int)
+multiple_of_pow5(ULLong value, int p)
+{
+    int count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        count++;
+    }
+    return count >= p;
+}
+
+/* is value divisible by 2**p, for 0 <= p < 64? */
+Py_LOCAL_INLINE(int)
+multiple_of_pow2(ULLong value, int p)
+{
+    return (value & (((ULLong)1 << p) - 1)) == 0;
+}
+
+#ifndef __SIZEOF_INT128__
+/* the low word of the product of a and b; the high word goes to *high */
+Py_LOCAL_INLINE(ULLong)
+umul128(ULLong a, ULLong b, ULLong *high)
+{
+    ULLong a_lo = a & 0xffffffffU, a_hi = a >> 32;
+    ULLong b_lo = b & 0xffffffffU, b_hi = b >> 32;
+    ULLong b00 = a_lo * b_lo;
+    ULLong b01 = a_lo * b_hi;
+    ULLong b10 = a_hi * b_lo;
+    ULLong b11 = a_hi * b_hi;
+    ULLong mid1 = b10 + (b00 >> 32);
+    ULLong mid2 = b01 + (mid1 & 0xffffffffU);
+
+    *high = b11 + (mid1 >> 32) + (mid2 >> 32);
+    return (mid2 << 32) | (b00 & 0xffffffffU);
+}
+#endif
+
+/* (m * mul) >> j, where mul is a table entry (low word first), m has at
+   most 55 bits and 64 < j < 128, so that the result fits in 64 bits */
+Py_LOCAL_INLINE(ULLong)
+mulshift(ULLong m, const ULLong *mul, int j)
+{
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 ULLLong;
+    ULLLong low = (ULLLong)m * mul[0];
+    ULLLong high = (ULLLong)m * mul[1];
+
+    assert(j > 64 && j < 128);
+    return (ULLong)(((low >> 64) + high) >> (j - 64));
+#else
+    ULLong high0, high1, low1, sum;
+
+    assert(j > 64 && j < 128);
+    umul128(m, mul[0], &high0);
+    low1 = umul128(m, mul[1], &high1);
+    sum = high0 + low1;
+    if (sum < high0)
+        high1++;
+    j -= 64;
+    return (high1 << (64 - j)) | (sum >> j);
+#endif
+}
+
+/* Write the shortest decimal digits that round back to the finite double d
+   to digits, which must have room for 17 of them, with no trailing zeros
+   and no terminating NUL.  Set *decpt to the position of the decimal point
+   relative to the first digit and *sign to 1 if d is negative (or -0.0),
+   as _Py_dg_dtoa does.  Returns the number of digits.  0.0 gives "0" with
+   *decpt == 1. */
+
+int
+_Py_ryu_shortest(double d, char *digits, int *decpt, int *sign)
+{
+    ULLong bits, ieee_mantissa, m2, mv, vr, vp, vm, output, q10;
+    int ieee_exponent, e2, e10, q, i, k, mm_shift, accept_bounds;
+    int vm_is_trailing_zeros = 0, vr_is_trailing_zeros = 0;
+    int removed = 0, last_removed_digit = 0, round_up = 0, n;
+    char *p;
+
+    memcpy(&bits, &d, sizeof(bits));
+#ifdef DOUBLE_IS_ARM_MIXED_ENDIAN_IEEE754
+    bits = (bits << 32) | (bits >> 32);
+#endif
+    *sign = (int)(bits >> 63);
+    ieee_mantissa = bits & (((ULLong)1 << DOUBLE_MANTISSA_BITS) - 1);
+    ieee_exponent = (int)(bits >> DOUBLE_MANTISSA_BITS) &
+        ((1 << DOUBLE_EXPONENT_BITS) - 1);
+    assert(ieee_exponent != (1 << DOUBLE_EXPONENT_BITS) - 1);
+
+    if (ieee_exponent == 0 && ieee_mantissa == 0) {
+        digits[0] = '0';
+        *decpt = 1;
+        return 1;
+    }
+
+    /* d is m2 * 2**e2 / 4: m2 * 2**e2 is four times d, so that the
+       interval bounds halfway to the neighbouring doubles are integers
+       too */
+    if (ieee_exponent == 0) {
+        e2 = 1 - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = ieee_mantissa;
+    }
+    else {
+        e2 = ieee_exponent - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = ((ULLong)1 << DOUBLE_MANTISSA_BITS) | ieee_mantissa;
+    }
+    accept_bounds = (m2 & 1) == 0;
+
+    /* the interval is (mv - 1 - mm_shift, mv + 2) times 2**e2; its lower
+       half is narrower when d is a power of two above the smallest
+       normal, as the double below d is then closer */
+    mv = 4 * m2;
+    mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+    /* scale the interval by 10**-e10 to vm < vr < vp, keeping track of
+       whether the parts lost to the scaling were all zeros */
+    if (e2 >= 0) {
+        q = log10pow2(e2) - (e2 > 3);
+        e10 = q;
+        k = RYU_POW5_INV_BITCOUNT + pow5bits(q) - 1;
+        i = -e2 + q + k;
+        vr = mulshift(4 * m2, ryu_pow5_inv_split[q], i);
+        vp = mulshift(4 * m2 + 2, ryu_pow5_inv_split[q], i);
+        vm = mulshift(4 * m2 - 1 - mm_shift, ryu_pow5_inv_split[q], i);
+        if (q <= 21) {
+            /* only one of mv, mv + 2 and mv - 1 - mm_shift can be a
+               multiple of 5, if any is */
+            if (mv % 5 == 0)
+                vr_is_trailing_zeros = multiple_of_pow5(mv, q);
+            else if (accept_bounds)
+                vm_is_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift,
+                                                        q);
+            else
+                vp -= multiple_of_pow5(mv + 2, q);
+        }
+    }
+    else {
+        q = log10pow5(-e2) - (-e2 > 1);
+        e10 = q + e2;
+        i = -e2 - q;
+        k = pow5bits(i) - RYU_POW5_BITCOUNT;
+        vr = mulshift(4 * m2, ryu_pow5_split[i], q - k);
+        vp = mulshift(4 * m2 + 2, ryu_pow5_split[i], q - k);
+        vm = mulshift(4 * m2 - 1 - mm_shift, ryu_pow5_split[i], q - k);
+        if (q <= 1) {
+            /* mv has at least two trailing zero bits, and mv + 2 one */
+            vr_is_trailing_zeros = 1;
+            if (accept_bounds)
+                vm_is_trailing_zeros = mm_shift == 1;
+            else
+                vp--;
+        }
+        else if (q < 63) {
+            vr_is_trailing_zeros = multiple_of_pow2(mv, q);
+        }
+    }
+
+    /* remove digits while vm and vp still differ in the remaining ones */
+    if (vm_is_trailing_zeros || vr_is_trailing_zeros) {
+        /* the bounds or d itself may be exact at some digit count; this
+           is rare */
+        for (;;) {
+            if (vp / 10 <= vm / 10)
+                break;
+            vm_is_trailing_zeros &= vm % 10 == 0;
+            vr_is_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit = (int)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vm_is_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_is_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit = (int)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0)
+            /* exactly halfway: round to even */
+            last_removed_digit = 4;
+        output = vr + ((vr == vm &&
+                        (!accept_bounds || !vm_is_trailing_zeros)) ||
+                       last_removed_digit >= 5);
+    }
+    else {
+        /* common case: two digits at a time first */
+        if (vp / 100 > vm / 100) {
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        for (;;) {
+            if (vp / 10 <= vm / 10)
+                break;
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+    e10 += removed;
+
+    /* _Py_dg_dtoa never returns trailing zeros */
+    for (;;) {
+        q10 = output / 10;
+        if (output - 10 * q10 != 0)
+            break;
+        output = q10;
+        e10++;
+    }
+
+    /* write the digits from the right */
+    n = 1;
+    for (q10 = output; q10 >= 10; q10 /= 10)
+        n++;
+    p = digits + n;
+    do {
+        *--p = (char)('0' + (int)(output % 10));
+        output /= 10;
+    } while (output != 0);
+    assert(p == digits && n <= 17);
+
+    *decpt = e10 + n;
+    return n;
+}
+
+#endif  /* PY_NO_SHORT_FLOAT_REPR */
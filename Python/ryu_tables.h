@@ -0,0 +1,630 @@
+/* this file was generated by Tools/scripts/makefloattables.py */
+
+#define RYU_POW5_BITCOUNT 125
+#define RYU_POW5_INV_BITCOUNT 125
+
+/* floor(2**(pow5bits(q) - 1 + 125) / 5**q) + 1, low word first */
+static const PY_UINT64_T ryu_pow5_inv_split[291][2] = {
+    {RYU_U64(0x00000000, 0x00000001), RYU_U64(0x20000000, 0x00000000)},
+    {RYU_U64(0x99999999, 0x9999999a), RYU_U64(0x19999999, 0x99999999)},
+    {RYU_U64(0x47ae147a, 0xe147ae15), RYU_U64(0x147ae147, 0xae147ae1)},
+    {RYU_U64(0x6c8b4395, 0x810624de), RYU_U64(0x10624dd2, 0xf1a9fbe7)},
+    {RYU_U64(0x7a786c22, 0x6809d496), RYU_U64(0x1a36e2eb, 0x1c432ca5)},
+    {RYU_U64(0x61f9f01b, 0x866e43ab), RYU_U64(0x14f8b588, 0xe368f084)},
+    {RYU_U64(0xb4c7f349, 0x38583622), RYU_U64(0x10c6f7a0, 0xb5ed8d36)},
+    {RYU_U64(0x87a6520e, 0xc08d236a), RYU_U64(0x1ad7f29a, 0xbcaf4857)},
+    {RYU_U64(0x9fb841a5, 0x66d74f88), RYU_U64(0x15798ee2, 0x308c39df)},
+    {RYU_U64(0xe62d0151, 0x1f12a607), RYU_U64(0x112e0be8, 0x26d694b2)},
+    {RYU_U64(0xd6ae6881, 0xcb5109a4), RYU_U64(0x1b7cdfd9, 0xd7bdbab7)},
+    {RYU_U64(0xdef1ed34, 0xa2a73aea), RYU_U64(0x15fd7fe1, 0x7964955f)},
+    {RYU_U64(0x7f27f0f6, 0xe885c8bb), RYU_U64(0x11979981, 0x2dea1119)},
+    {RYU_U64(0x650cb4be, 0x40d60df8), RYU_U64(0x1c25c268, 0x497681c2)},
+    {RYU_U64(0xea709098, 0x33de7193), RYU_U64(0x16849b86, 0xa12b9b01)},
+    {RYU_U64(0x21f3a6e0, 0x297ec143), RYU_U64(0x1203af9e, 0xe756159b)},
+    {RYU_U64(0x6985d7cd, 0x0f313537), RYU_U64(0x1cd2b297, 0xd889bc2b)},
+    {RYU_U64(0x2137dfd7, 0x3f5a90f9), RYU_U64(0x170ef546, 0x46d49689)},
+    {RYU_U64(0xe75fe645, 0xcc4873fa), RYU_U64(0x12725dd1, 0xd243aba0)},
+    {RYU_U64(0xa5663d3c, 0x7a0d865d), RYU_U64(0x1d83c94f, 0xb6d2ac34)},
+    {RYU_U64(0x511e9763, 0x94d79eb1), RYU_U64(0x179ca10c, 0x9242235d)},
+    {RYU_U64(0xda7edf82, 0xdd794bc1), RYU_U64(0x12e3b40a, 0x0e9b4f7d)},
+    {RYU_U64(0x2a6498d1, 0x625bac68), RYU_U64(0x1e392010, 0x175ee596)},
+    {RYU_U64(0xeeb6e0a7, 0x81e2f053), RYU_U64(0x182db340, 0x12b25144)},
+    {RYU_U64(0x58924d52, 0xce4f26a9), RYU_U64(0x1357c299, 0xa88ea76a)},
+    {RYU_U64(0x27507bb7, 0xb07ea441), RYU_U64(0x1ef2d0f5, 0xda7dd8aa)},
+    {RYU_U64(0x52a6c95f, 0xc0655034), RYU_U64(0x18c240c4, 0xaecb13bb)},
+    {RYU_U64(0x0eebd44c, 0x99eaa690), RYU_U64(0x13ce9a36, 0xf23c0fc9)},
+    {RYU_U64(0xb17953ad, 0xc3110a80), RYU_U64(0x1fb0f6be, 0x50601941)},
+    {RYU_U64(0xc12ddc8b, 0x02740867), RYU_U64(0x195a5efe, 0xa6b34767)},
+    {RYU_U64(0x3424b06f, 0x3529a052), RYU_U64(0x14484bfe, 0xebc29f86)},
+    {RYU_U64(0x901d59f2, 0x90ee19db), RYU_U64(0x1039d665, 0x89687f9e)},
+    {RYU_U64(0x4cfbc31d, 0xb4b0295f), RYU_U64(0x19f623d5, 0xa8a73297)},
+    {RYU_U64(0x3d9635b1, 0x5d59bab2), RYU_U64(0x14c4e977, 0xba1f5bac)},
+    {RYU_U64(0x97ab5e27, 0x7de16228), RYU_U64(0x109d8792, 0xfb4c4956)},
+    {RYU_U64(0xf2abc9d8, 0xc9689d0d), RYU_U64(0x1a95a5b7, 0xf87a0ef0)},
+    {RYU_U64(0x5bbca17a, 0x3aba173e), RYU_U64(0x15448493, 0x2d2e725a)},
+    {RYU_U64(0xafca1ac8, 0x2efb45cb), RYU_U64(0x11039d42, 0x8a8b8eae)},
+    {RYU_U64(0xb2dcf7a6, 0xb1920945), RYU_U64(0x1b38fb9d, 0xaa78e44a)},
+    {RYU_U64(0xf57d92eb, 0xc141a104), RYU_U64(0x15c72fb1, 0x552d836e)},
+    {RYU_U64(0xc4647589, 0x6767b403), RYU_U64(0x116c2627, 0x77579c58)},
+    {RYU_U64(0x6d6d88db, 0xd8a5ecd2), RYU_U64(0x1be03d0b, 0xf225c6f4)},
+    {RYU_U64(0x8abe0716, 0x46eb23db), RYU_U64(0x164cfda3, 0x281e38c3)},
+    {RYU_U64(0x6efe6c11, 0xd255b649), RYU_U64(0x11d7314f, 0x534b609c)},
+    {RYU_U64(0xb197134f, 0xb6ef8a0e), RYU_U64(0x1c8b8218, 0x85456760)},
+    {RYU_U64(0x27ac0f72, 0xf8bfa1a5), RYU_U64(0x16d601ad, 0x376ab91a)},
+    {RYU_U64(0xb95672c2, 0x60994e1e), RYU_U64(0x1244ce24, 0x2c5560e1)},
+    {RYU_U64(0xf5571e03, 0xcdc21695), RYU_U64(0x1d3ae36d, 0x13bbce35)},
+    {RYU_U64(0x2aac1803, 0x0b01abab), RYU_U64(0x17624f8a, 0x762fd82b)},
+    {RYU_U64(0xbbbce002, 0x6f348956), RYU_U64(0x12b50c6e, 0xc4f31355)},
+    {RYU_U64(0x92c7ccd0, 0xb1eda889), RYU_U64(0x1dee7a4a, 0xd4b81eef)},
+    {RYU_U64(0xdbd30a40, 0x8e57ba07), RYU_U64(0x17f1fb6f, 0x10934bf2)},
+    {RYU_U64(0x7ca8d500, 0x71dfc806), RYU_U64(0x1327fc58, 0xda0f6ff5)},
+    {RYU_U64(0xfaa7bb33, 0xe9660cd6), RYU_U64(0x1ea6608e, 0x29b24cbb)},
+    {RYU_U64(0x9552fc29, 0x8784d711), RYU_U64(0x18851a0b, 0x548ea3c9)},
+    {RYU_U64(0xaaa8c9ba, 0xd2d0ac0e), RYU_U64(0x139dae6f, 0x76d88307)},
+    {RYU_U64(0xdddadc5e, 0x1e1aace3), RYU_U64(0x1f62b0b2, 0x57c0d1a5)},
+    {RYU_U64(0x7e48b04b, 0x4b488a4f), RYU_U64(0x191bc08e, 0xac9a4151)},
+    {RYU_U64(0xcb6d59d5, 0xd5d3a1d9), RYU_U64(0x141633a5, 0x56e1cdda)},
+    {RYU_U64(0x3c577b11, 0x77dc817b), RYU_U64(0x1011c2ea, 0xabe7d7e2)},
+    {RYU_U64(0xc6f25e82, 0x5960cf2a), RYU_U64(0x19b604aa, 0xaca62636)},
+    {RYU_U64(0x6bf51868, 0x4780a5bb), RYU_U64(0x14919d55, 0x56eb51c5)},
+    {RYU_U64(0x232a79ed, 0x06008496), RYU_U64(0x10747ddd, 0xdf22a7d1)},
+    {RYU_U64(0xd1dd8fe1, 0xa3340756), RYU_U64(0x1a53fc96, 0x31d10c81)},
+    {RYU_U64(0xa7e4731a, 0xe8f66c45), RYU_U64(0x150ffd44, 0xf4a73d34)},
+    {RYU_U64(0x531d28e2, 0x53f8569e), RYU_U64(0x10d9976a, 0x5d52975d)},
+    {RYU_U64(0xeb61db03, 0xb98d5762), RYU_U64(0x1af5bf10, 0x9550f22e)},
+    {RYU_U64(0xbc4e48cf, 0xc7a445e8), RYU_U64(0x159165a6, 0xddda5b58)},
+    {RYU_U64(0x6371d3d9, 0x6c836b20), RYU_U64(0x11411e1f, 0x17e1e2ad)},
+    {RYU_U64(0x9f1c8628, 0xad9f11cd), RYU_U64(0x1b9b6364, 0xf3030448)},
+    {RYU_U64(0xe5b06b53, 0xbe18db0b), RYU_U64(0x1615e91d, 0x8f359d06)},
+    {RYU_U64(0xeaf3890f, 0xcb4715a2), RYU_U64(0x11ab20e4, 0x72914a6b)},
+    {RYU_U64(0x44b8db4c, 0x7871bc37), RYU_U64(0x1c45016d, 0x841baa46)},
+    {RYU_U64(0x03c715d6, 0xc6c1635f), RYU_U64(0x169d9abe, 0x03495505)},
+    {RYU_U64(0x3638de45, 0x6bcde919), RYU_U64(0x1217aefe, 0x69077737)},
+    {RYU_U64(0x56c163a2, 0x461641c1), RYU_U64(0x1cf2b197, 0x0e725858)},
+    {RYU_U64(0xdf011c81, 0xd1ab67ce), RYU_U64(0x17288e12, 0x71f51379)},
+    {RYU_U64(0x7f3416ce, 0x4155eca5), RYU_U64(0x1286d80e, 0xc190dc61)},
+    {RYU_U64(0x6520247d, 0x3556476e), RYU_U64(0x1da48ce4, 0x68e7c702)},
+    {RYU_U64(0xea801d30, 0xf7783925), RYU_U64(0x17b6d71d, 0x20b96c01)},
+    {RYU_U64(0xbb99b0f3, 0xf92cfa84), RYU_U64(0x12f8ac17, 0x4d612334)},
+    {RYU_U64(0x5f5c4e53, 0x2847f739), RYU_U64(0x1e5aacf2, 0x15683854)},
+    {RYU_U64(0x7f7d0b75, 0xb9d32c2e), RYU_U64(0x18488a5b, 0x44536043)},
+    {RYU_U64(0x9930d5f7, 0xc7dc2358), RYU_U64(0x136d3b7c, 0x36a919cf)},
+    {RYU_U64(0x8eb4898c, 0x72f9d226), RYU_U64(0x1f152bf9, 0xf10e8fb2)},
+    {RYU_U64(0x722a07a3, 0x8f2e41b8), RYU_U64(0x18ddbcc7, 0xf40ba628)},
+    {RYU_U64(0xc1bb394f, 0xa5be9afa), RYU_U64(0x13e49706, 0x5cd61e86)},
+    {RYU_U64(0x9c5ec219, 0x0930f7f6), RYU_U64(0x1fd424d6, 0xfaf030d7)},
+    {RYU_U64(0x49e56814, 0x075a5ff8), RYU_U64(0x197683df, 0x2f268d79)},
+    {RYU_U64(0x6e512010, 0x05e1e660), RYU_U64(0x145ecfe5, 0xbf520ac7)},
+    {RYU_U64(0xf1da800c, 0xd181851a), RYU_U64(0x104bd984, 0x990e6f05)},
+    {RYU_U64(0x4fc40014, 0x8268d4f5), RYU_U64(0x1a12f5a0, 0xf4e3e4d6)},
+    {RYU_U64(0xd96999aa, 0x01ed772b), RYU_U64(0x14dbf7b3, 0xf71cb711)},
+    {RYU_U64(0xadee1488, 0x018ac5bc), RYU_U64(0x10aff95c, 0xc5b09274)},
+    {RYU_U64(0x497ceda6, 0x68de092c), RYU_U64(0x1ab32894, 0x6f80ea54)},
+    {RYU_U64(0x3aca57b8, 0x53e4d424), RYU_U64(0x155c2076, 0xbf9a5510)},
+    {RYU_U64(0x623b7960, 0x431d7683), RYU_U64(0x1116805e, 0xffaeaa73)},
+    {RYU_U64(0x9d2bf566, 0xd1c8bd9e), RYU_U64(0x1b5733cb, 0x32b110b8)},
+    {RYU_U64(0x7dbcc452, 0x416d647f), RYU_U64(0x15df5ca2, 0x8ef40d60)},
+    {RYU_U64(0xcafd69db, 0x678ab6cc), RYU_U64(0x117f7d4e, 0xd8c33de6)},
+    {RYU_U64(0xab2f0fc5, 0x72778adf), RYU_U64(0x1bff2ee4, 0x8e052fd7)},
+    {RYU_U64(0x88f27304, 0x5b92d580), RYU_U64(0x1665bf1d, 0x3e6a8cac)},
+    {RYU_U64(0xd3f528d0, 0x49424466), RYU_U64(0x11eaff4a, 0x98553d56)},
+    {RYU_U64(0xb988414d, 0x4203a0a3), RYU_U64(0x1cab3210, 0xf3bb9557)},
+    {RYU_U64(0x6139cdd7, 0x6802e6e9), RYU_U64(0x16ef5b40, 0xc2fc7779)},
+    {RYU_U64(0xe7617179, 0x20025254), RYU_U64(0x125915cd, 0x68c9f92d)},
+    {RYU_U64(0xa568b58e, 0x999d5086), RYU_U64(0x1d5b5615, 0x74765b7c)},
+    {RYU_U64(0x5120913e, 0xe14aa6d2), RYU_U64(0x177c44dd, 0xf6c515fd)},
+    {RYU_U64(0xa74d40ff, 0x1aa21f0e), RYU_U64(0x12c9d0b1, 0x923744ca)},
+    {RYU_U64(0x0baece64, 0xf769cb4a), RYU_U64(0x1e0fb44f, 0x50586e11)},
+    {RYU_U64(0x3c8bd850, 0xc5ee3c3b), RYU_U64(0x180c903f, 0x7379f1a7)},
+    {RYU_U64(0xca0979da, 0x37f1c9c9), RYU_U64(0x133d4032, 0xc2c7f485)},
+    {RYU_U64(0xa9a8c2f6, 0xbfe942db), RYU_U64(0x1ec866b7, 0x9e0cba6f)},
+    {RYU_U64(0x2153cf2b, 0xccba9be3), RYU_U64(0x18a0522c, 0x7e709526)},
+    {RYU_U64(0x1aa97289, 0x70954982), RYU_U64(0x13b374f0, 0x6526ddb8)},
+    {RYU_U64(0xf775840f, 0x1a88759d), RYU_U64(0x1f8587e7, 0x083e2f8c)},
+    {RYU_U64(0x5f913672, 0x7ba05e17), RYU_U64(0x19379fec, 0x0698260a)},
+    {RYU_U64(0x1940f85b, 0x9619e4df), RYU_U64(0x142c7ff0, 0x054684d5)},
+    {RYU_U64(0xe100c6af, 0xab47ea4c), RYU_U64(0x1023998c, 0xd1053710)},
+    {RYU_U64(0xce67a44c, 0x453fdd47), RYU_U64(0x19d28f47, 0xb4d524e7)},
+    {RYU_U64(0xd852e9d6, 0x9dccb106), RYU_U64(0x14a8729f, 0xc3ddb71f)},
+    {RYU_U64(0x79dbee45, 0x4b0a2738), RYU_U64(0x1086c219, 0x697e2c19)},
+    {RYU_U64(0x295fe3a2, 0x11a9d859), RYU_U64(0x1a71368f, 0x0f30468f)},
+    {RYU_U64(0xbab31c81, 0xa7bb137a), RYU_U64(0x15275ed8, 0xd8f36ba5)},
+    {RYU_U64(0x6228e39a, 0xec95a92f), RYU_U64(0x10ec4be0, 0xad8f8951)},
+    {RYU_U64(0x9d0e38f7, 0xe0ef7517), RYU_U64(0x1b13ac9a, 0xaf4c0ee8)},
+    {RYU_U64(0xb0d82d93, 0x1a592a79), RYU_U64(0x15a956e2, 0x25d67253)},
+    {RYU_U64(0x8d79be0f, 0x4847552e), RYU_U64(0x11544581, 0xb7dec1dc)},
+    {RYU_U64(0x158f967e, 0xda0bbb7c), RYU_U64(0x1bba08cf, 0x8c979c94)},
+    {RYU_U64(0x77a611ff, 0x14d62f97), RYU_U64(0x162e6d72, 0xd6dfb076)},
+    {RYU_U64(0xf951a7ff, 0x43de8c79), RYU_U64(0x11bebdf5, 0x78b2f391)},
+    {RYU_U64(0xc21c3ffe, 0xd2fdad8e), RYU_U64(0x1c646322, 0x5ab7ec1c)},
+    {RYU_U64(0x01b03332, 0x42648ad8), RYU_U64(0x16b6b5b5, 0x155ff017)},
+    {RYU_U64(0x0159c28e, 0x9b83a246), RYU_U64(0x122bc490, 0xdde659ac)},
+    {RYU_U64(0xcef60417, 0x5f3903a3), RYU_U64(0x1d12d41a, 0xfca3c2ac)},
+    {RYU_U64(0x725e69ac, 0x4c2d9c83), RYU_U64(0x17424348, 0xca1c9bbd)},
+    {RYU_U64(0xf5185489, 0xd68ae39c), RYU_U64(0x129b6907, 0x0816e2fd)},
+    {RYU_U64(0xee8d540f, 0xbdab05c6), RYU_U64(0x1dc574d8, 0x0cf16b2f)},
+    {RYU_U64(0xbed77672, 0xfe226b05), RYU_U64(0x17d12a46, 0x70c1228c)},
+    {RYU_U64(0xff12c528, 0xcb4ebc04), RYU_U64(0x130dbb6b, 0x8d674ed6)},
+    {RYU_U64(0xcb513b74, 0x787df9a0), RYU_U64(0x1e7c5f12, 0x7bd87e24)},
+    {RYU_U64(0x090dc929, 0xf9fe614d), RYU_U64(0x18637f41, 0xfcad31b7)},
+    {RYU_U64(0xa0d7d421, 0x94cb810a), RYU_U64(0x1382cc34, 0xca2427c5)},
+    {RYU_U64(0x67bfb9cf, 0x5478ce77), RYU_U64(0x1f37ad21, 0x436d0c6f)},
+    {RYU_U64(0x1fcc94a5, 0xdd2d71f9), RYU_U64(0x18f9574d, 0xcf8a7059)},
+    {RYU_U64(0x7fd6dd51, 0x7dbdf4c7), RYU_U64(0x13faac3e, 0x3fa1f37a)},
+    {RYU_U64(0xffbe2ee8, 0xc92fee0b), RYU_U64(0x1ff779fd, 0x329cb8c3)},
+    {RYU_U64(0x6631bf20, 0xa0f324d6), RYU_U64(0x1992c7fd, 0xc216fa36)},
+    {RYU_U64(0xb827cc1a, 0x1a5c1d78), RYU_U64(0x14756ccb, 0x01abfb5e)},
+    {RYU_U64(0x935309ae, 0x7b7ce460), RYU_U64(0x105df0a2, 0x67bcc918)},
+    {RYU_U64(0x1eeb42b0, 0xc594a099), RYU_U64(0x1a2fe76a, 0x3f9474f4)},
+    {RYU_U64(0xe5890227, 0x0476e6e1), RYU_U64(0x14f31f88, 0x32dd2a5c)},
+    {RYU_U64(0xb7a0ce85, 0x9d2bebe7), RYU_U64(0x10c27fa0, 0x28b0eeb0)},
+    {RYU_U64(0x59014a6f, 0x61dfdfd8), RYU_U64(0x1ad0cc33, 0x744e4ab4)},
+    {RYU_U64(0xe0cdd525, 0xe7e64cad), RYU_U64(0x1573d68f, 0x903ea229)},
+    {RYU_U64(0x4d717751, 0x8651d6f1), RYU_U64(0x11297872, 0xd9cbb4ee)},
+    {RYU_U64(0x7be8bee8, 0xd6e957e8), RYU_U64(0x1b758d84, 0x8fac54b0)},
+    {RYU_U64(0xfcba3253, 0xdf211320), RYU_U64(0x15f7a46a, 0x0c89dd59)},
+    {RYU_U64(0x63c82843, 0x18e74280), RYU_U64(0x1192e9ee, 0x706e4aae)},
+    {RYU_U64(0x060d0d38, 0x27d86a66), RYU_U64(0x1c1e4317, 0x1a4a1117)},
+    {RYU_U64(0x6b3da42c, 0xecad21eb), RYU_U64(0x167e9c12, 0x7b6e7412)},
+    {RYU_U64(0x88fe1cf0, 0xbd574e56), RYU_U64(0x11fee341, 0xfc585cdb)},
+    {RYU_U64(0x419694b4, 0x62254a23), RYU_U64(0x1ccb0536, 0x608d615f)},
+    {RYU_U64(0x67abaa29, 0xe81dd4e9), RYU_U64(0x1708d0f8, 0x4d3de77f)},
+    {RYU_U64(0xb95621bb, 0x2017dd87), RYU_U64(0x126d73f9, 0xd764b932)},
+    {RYU_U64(0xc223692b, 0x668c95a5), RYU_U64(0x1d7becc2, 0xf23ac1ea)},
+    {RYU_U64(0xce82ba89, 0x1ed6de1d), RYU_U64(0x17965702, 0x5b6234bb)},
+    {RYU_U64(0xa5356207, 0x4bdf1818), RYU_U64(0x12deac01, 0xe2b4f6fc)},
+    {RYU_U64(0x3b889cd8, 0x7964f359), RYU_U64(0x1e311336, 0x3787f194)},
+    {RYU_U64(0xfc6d4a46, 0xc783f5e1), RYU_U64(0x18274291, 0xc6065adc)},
+    {RYU_U64(0x30576e9f, 0x06032b1a), RYU_U64(0x13529ba7, 0xd19eaf17)},
+    {RYU_U64(0x1a257dcb, 0x3cd1de90), RYU_U64(0x1eea92a6, 0x1c311825)},
+    {RYU_U64(0x481dfe3c, 0x30a7e540), RYU_U64(0x18bba884, 0xe35a79b7)},
+    {RYU_U64(0xd34b31c9, 0xc0865100), RYU_U64(0x13c9539d, 0x82aec7c5)},
+    {RYU_U64(0x5211e942, 0xcda3b4cd), RYU_U64(0x1fa885c8, 0xd117a609)},
+    {RYU_U64(0x74db2102, 0x3e1c90a4), RYU_U64(0x19539e3a, 0x40dfb807)},
+    {RYU_U64(0xf715b401, 0xcb4a0d50), RYU_U64(0x1442e4fb, 0x67196005)},
+    {RYU_U64(0xf8de299b, 0x09080aa7), RYU_U64(0x103583fc, 0x527ab337)},
+    {RYU_U64(0x8e304291, 0xa80cddd7), RYU_U64(0x19ef3993, 0xb72ab859)},
+    {RYU_U64(0x3e8d020e, 0x200a4b13), RYU_U64(0x14bf6142, 0xf8eef9e1)},
+    {RYU_U64(0x653d9b3e, 0x80083c0f), RYU_U64(0x10991a9b, 0xfa58c7e7)},
+    {RYU_U64(0x6ec8f864, 0x000d2ce4), RYU_U64(0x1a8e90f9, 0x908e0ca5)},
+    {RYU_U64(0x8bd3f9e9, 0x99a423ea), RYU_U64(0x153eda61, 0x4071a3b7)},
+    {RYU_U64(0x3ca994ba, 0xe1501cbb), RYU_U64(0x10ff151a, 0x99f482f9)},
+    {RYU_U64(0xc775bac4, 0x9bb3612b), RYU_U64(0x1b31bb5d, 0xc320d18e)},
+    {RYU_U64(0xd2c4956a, 0x16291a89), RYU_U64(0x15c162b1, 0x68e70e0b)},
+    {RYU_U64(0xdbd07788, 0x11ba7ba1), RYU_U64(0x11678227, 0x871f3e6f)},
+    {RYU_U64(0x2c80bf40, 0x1c5d929b), RYU_U64(0x1bd8d03f, 0x3e9863e6)},
+    {RYU_U64(0xbd33cc33, 0x49e47549), RYU_U64(0x16470cff, 0x6546b651)},
+    {RYU_U64(0xca8fd68f, 0x6e505dd4), RYU_U64(0x11d270cc, 0x51055ea7)},
+    {RYU_U64(0x4419574b, 0xe3b3c953), RYU_U64(0x1c83e7ad, 0x4e6efdd9)},
+    {RYU_U64(0x03477909, 0x82f63aa9), RYU_U64(0x16cfec8a, 0xa52597e1)},
+    {RYU_U64(0xcf6c60d4, 0x68c4fbba), RYU_U64(0x123ff06e, 0xea847980)},
+    {RYU_U64(0xe57a3487, 0x0e07f92a), RYU_U64(0x1d331a4b, 0x10d3f59a)},
+    {RYU_U64(0x512e906c, 0x0b399422), RYU_U64(0x175c1508, 0xda432ae2)},
+    {RYU_U64(0xda8ba6bc, 0xd5c7a9b5), RYU_U64(0x12b010d3, 0xe1cf5581)},
+    {RYU_U64(0x90df712e, 0x22d90f87), RYU_U64(0x1de68153, 0x02e5559c)},
+    {RYU_U64(0xda4c5a8b, 0x4f140c6c), RYU_U64(0x17eb9aa8, 0xcf1dde16)},
+    {RYU_U64(0xaea37ba2, 0xa5a9a38a), RYU_U64(0x1322e220, 0xa5b17e78)},
+    {RYU_U64(0x7dd25f6a, 0xa2a905a9), RYU_U64(0x1e9e369a, 0xa2b59727)},
+    {RYU_U64(0x97db7f88, 0x8220d154), RYU_U64(0x187e9215, 0x4ef7ac1f)},
+    {RYU_U64(0x797c6606, 0xce80a777), RYU_U64(0x139874dd, 0xd8c6234c)},
+    {RYU_U64(0x8f2d700a, 0xe4010bf1), RYU_U64(0x1f5a5496, 0x27a36bad)},
+    {RYU_U64(0x0c2459a2, 0x5000d65a), RYU_U64(0x19151078, 0x1fb5efbe)},
+    {RYU_U64(0x701d1481, 0xd99a4515), RYU_U64(0x1410d9f9, 0xb2f7f2fe)},
+    {RYU_U64(0xc017439b, 0x147b6a77), RYU_U64(0x100d7b2e, 0x28c65bfe)},
+    {RYU_U64(0xccf205c4, 0xed9243f2), RYU_U64(0x19af2b7d, 0x0e0a2cca)},
+    {RYU_U64(0x0a5b37d0, 0xbe0e9cc2), RYU_U64(0x148c22ca, 0x71a1bd6f)},
+    {RYU_U64(0x0848f973, 0xcb3ee3ce), RYU_U64(0x10701bd5, 0x27b4978c)},
+    {RYU_U64(0xda0e5bec, 0x78649fb0), RYU_U64(0x1a4cf955, 0x0c5425ac)},
+    {RYU_U64(0x7b3eaff0, 0x60507fc0), RYU_U64(0x150a6110, 0xd6a9b7bd)},
+    {RYU_U64(0x95cbbff3, 0x80406633), RYU_U64(0x10d51a73, 0xdeee2c97)},
+    {RYU_U64(0xefac6652, 0x66cd7052), RYU_U64(0x1aee90b9, 0x64b04758)},
+    {RYU_U64(0x2623850e, 0xb8a459db), RYU_U64(0x158ba6fa, 0xb6f36c47)},
+    {RYU_U64(0x1e82d0d8, 0x93b6ae49), RYU_U64(0x113c8595, 0x5f29236c)},
+    {RYU_U64(0xfd9e1af4, 0x1f8ab075), RYU_U64(0x1b9408ee, 0xfea838ac)},
+    {RYU_U64(0x97b1af29, 0xb2d559f7), RYU_U64(0x16100725, 0x988693bd)},
+    {RYU_U64(0xac8e25ba, 0xf5777b2c), RYU_U64(0x11a66c1e, 0x139edc97)},
+    {RYU_U64(0x7a7d092b, 0x2258c513), RYU_U64(0x1c3d79c9, 0xb8fe2dbf)},
+    {RYU_U64(0x61fda0ef, 0x4ead6a76), RYU_U64(0x169794a1, 0x60cb57cc)},
+    {RYU_U64(0xe7fe1a59, 0x0bbdeec5), RYU_U64(0x1212dd4d, 0xe7091309)},
+    {RYU_U64(0xa6635d5b, 0x45fcb13a), RYU_U64(0x1ceafbaf, 0xd80e84dc)},
+    {RYU_U64(0x851c4aaf, 0x6b308dc8), RYU_U64(0x172262f3, 0x133ed0b0)},
+    {RYU_U64(0xd0e36ef2, 0xbc26d7d4), RYU_U64(0x1281e8c2, 0x75cbda26)},
+    {RYU_U64(0xb49f17ea, 0xc6a48c86), RYU_U64(0x1d9ca79d, 0x894629d7)},
+    {RYU_U64(0x2a18dfef, 0x0550706b), RYU_U64(0x17b08617, 0xa104ee46)},
+    {RYU_U64(0x54e0b325, 0x9dd9f389), RYU_U64(0x12f39e79, 0x4d9d8b6b)},
+    {RYU_U64(0x87cdeb6f, 0x62f65274), RYU_U64(0x1e529728, 0x7c2f4578)},
+    {RYU_U64(0xd30b22bf, 0x825ea85d), RYU_U64(0x18421286, 0xc9bf6ac6)},
+    {RYU_U64(0x0f3c1bcc, 0x684bb9e4), RYU_U64(0x13680ed2, 0x3aff889f)},
+    {RYU_U64(0x18602c7a, 0x4079296d), RYU_U64(0x1f0ce483, 0x9198da98)},
+    {RYU_U64(0x46b356c8, 0x33942124), RYU_U64(0x18d71d36, 0x0e13e213)},
+    {RYU_U64(0x388f78a0, 0x29434db6), RYU_U64(0x13df4a91, 0xa4dcb4dc)},
+    {RYU_U64(0x5a7f2766, 0xa86baf8a), RYU_U64(0x1fcbaa82, 0xa1612160)},
+    {RYU_U64(0x153285eb, 0xb9efbfa2), RYU_U64(0x196fbb9b, 0xb44db44d)},
+    {RYU_U64(0xaa8ed189, 0x618c994e), RYU_U64(0x145962e2, 0xf6a4903d)},
+    {RYU_U64(0xeed8a7a1, 0x1ad6e10c), RYU_U64(0x1047824f, 0x2bb6d9ca)},
+    {RYU_U64(0x7e27729b, 0x5e249b45), RYU_U64(0x1a0c03b1, 0xdf8af611)},
+    {RYU_U64(0xfe85f549, 0x181d4904), RYU_U64(0x14d6695b, 0x193bf80d)},
+    {RYU_U64(0xcb9e5dd4, 0x134aa0d0), RYU_U64(0x10ab877c, 0x142ff9a4)},
+    {RYU_U64(0xdf63c953, 0x5211014d), RYU_U64(0x1aac0bf9, 0xb9e65c3a)},
+    {RYU_U64(0x191ca10f, 0x74da6771), RYU_U64(0x15566ffa, 0xfb1eb02f)},
+    {RYU_U64(0xadb080d9, 0x2a4852c1), RYU_U64(0x1111f32f, 0x2f4bc025)},
+    {RYU_U64(0x15e7348e, 0xaa0d5134), RYU_U64(0x1b4feb7e, 0xb212cd09)},
+    {RYU_U64(0xab1f5d3e, 0xee710dc4), RYU_U64(0x15d98932, 0x280f0a6d)},
+    {RYU_U64(0xbc191765, 0x8b8da49d), RYU_U64(0x117ad428, 0x200c0857)},
+    {RYU_U64(0x2cf4f23c, 0x127c3a94), RYU_U64(0x1bf7b9d9, 0xcce00d59)},
+    {RYU_U64(0xf0c3f4fc, 0xdb969543), RYU_U64(0x165fc7e1, 0x70b33de0)},
+    {RYU_U64(0x5a365d97, 0x16121103), RYU_U64(0x11e63981, 0x26f5cb1a)},
+    {RYU_U64(0x9056fc24, 0xf01ce804), RYU_U64(0x1ca38f35, 0x0b22de90)},
+    {RYU_U64(0xd9df301d, 0x8ce3ecd0), RYU_U64(0x16e93f5d, 0xa2824ba6)},
+    {RYU_U64(0xe17f59b1, 0x3d8323da), RYU_U64(0x125432b1, 0x4ecea2eb)},
+    {RYU_U64(0x68cbc2b5, 0x2f38395c), RYU_U64(0x1d53844e, 0xe47dd179)},
+    {RYU_U64(0x53d6355d, 0xbf602de3), RYU_U64(0x17760372, 0x5064a794)},
+    {RYU_U64(0xa9782ab1, 0x65e68b1c), RYU_U64(0x12c4cf8e, 0xa6b6ec76)},
+    {RYU_U64(0x0f26aab5, 0x6fd744fa), RYU_U64(0x1e07b27d, 0xd78b13f1)},
+    {RYU_U64(0x3f52222a, 0xbfdf6a62), RYU_U64(0x18062864, 0xac6f4327)},
+    {RYU_U64(0x65db4e88, 0x997f884e), RYU_U64(0x13382050, 0x89f29c1f)},
+    {RYU_U64(0x6fc54a74, 0x28cc0d4a), RYU_U64(0x1ec033b4, 0x0fea9365)},
+    {RYU_U64(0x596aa1f6, 0x8709a43b), RYU_U64(0x1899c2f6, 0x73220f84)},
+    {RYU_U64(0xadeee7f8, 0x6c07b696), RYU_U64(0x13ae3591, 0xf5b4d936)},
+    {RYU_U64(0x497e3ff3, 0xe00c5756), RYU_U64(0x1f7d2283, 0x22baf524)},
+    {RYU_U64(0xd464fff6, 0x4cd6ac45), RYU_U64(0x1930e868, 0xe89590e9)},
+    {RYU_U64(0x4383fff8, 0x3d7889d1), RYU_U64(0x14272053, 0xed4473ee)},
+    {RYU_U64(0xcf9cccc6, 0x9793a174), RYU_U64(0x101f4d0f, 0xf1038ff1)},
+    {RYU_U64(0x7f6147a4, 0x25b90252), RYU_U64(0x19cbae7f, 0xe805b31c)},
+    {RYU_U64(0xcc4dd2e9, 0xb7c7350f), RYU_U64(0x14a2f1ff, 0xecd15c16)},
+    {RYU_U64(0x3d0b0f21, 0x5fd290d9), RYU_U64(0x10825b33, 0x23dab012)},
+    {RYU_U64(0x61ab4b68, 0x9950e7c1), RYU_U64(0x1a6a2b85, 0x062ab350)},
+    {RYU_U64(0x4e22a2ba, 0x1440b967), RYU_U64(0x1521bc6a, 0x6b555c40)},
+    {RYU_U64(0x0b4ee894, 0xdd009453), RYU_U64(0x10e7c9ee, 0xbc4449cd)},
+    {RYU_U64(0x1217da87, 0xc800ed51), RYU_U64(0x1b0c764a, 0xc6d3a948)},
+    {RYU_U64(0xdb46486c, 0xa000bdda), RYU_U64(0x15a391d5, 0x6bdc876c)},
+    {RYU_U64(0x490506bd, 0x4ccd64af), RYU_U64(0x114fa7dd, 0xefe39f8a)},
+    {RYU_U64(0xa8080ac8, 0x7ae23ab1), RYU_U64(0x1bb2a62f, 0xe638ff43)},
+    {RYU_U64(0x5339a239, 0xfbe82ef4), RYU_U64(0x162884f3, 0x1e93ff69)},
+    {RYU_U64(0x75c7b4fb, 0x2fecf25d), RYU_U64(0x11ba03f5, 0xb20fff87)},
+    {RYU_U64(0x22d92191, 0xe647ea2e), RYU_U64(0x1c5cd322, 0xb67fff3f)},
+    {RYU_U64(0xb57a8141, 0x850654f2), RYU_U64(0x16b0a8e8, 0x91ffff65)},
+    {RYU_U64(0xc4620101, 0x373843f5), RYU_U64(0x1226ed86, 0xdb3332b7)},
+    {RYU_U64(0x3a366801, 0xf1f39fee), RYU_U64(0x1d0b15a4, 0x91eb8459)},
+    {RYU_U64(0xfb5eb99b, 0x27f6198b), RYU_U64(0x173c1150, 0x74bc69e0)},
+    {RYU_U64(0x2f7efae2, 0x865e7ad6), RYU_U64(0x12967440, 0x5d6387e7)},
+    {RYU_U64(0xe597f7d0, 0xd6fd9156), RYU_U64(0x1dbd86cd, 0x6238d971)},
+    {RYU_U64(0x8479930d, 0x78cadaab), RYU_U64(0x17cad23d, 0xe82d7ac1)},
+    {RYU_U64(0xd0614271, 0x2d6f1556), RYU_U64(0x1308a831, 0x868ac89a)},
+    {RYU_U64(0x4d686a4e, 0xaf182222), RYU_U64(0x1e74404f, 0x3daada91)},
+    {RYU_U64(0xa453883e, 0xf279b4e8), RYU_U64(0x185d003f, 0x6488aeda)},
+    {RYU_U64(0xe9dc6cff, 0x28615d87), RYU_U64(0x137d99cc, 0x506d58ae)},
+    {RYU_U64(0xa960ae65, 0x0d6895a4), RYU_U64(0x1f2f5c7a, 0x1a488de4)},
+    {RYU_U64(0xbab3beb7, 0x3ded4483), RYU_U64(0x18f2b061, 0xaea07183)},
+};
+
+/* the leading 125 bits of 5**i, low word first */
+static const PY_UINT64_T ryu_pow5_split[326][2] = {
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x10000000, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x14000000, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x19000000, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x1f400000, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x13880000, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x186a0000, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x1e848000, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x1312d000, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x17d78400, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x1dcd6500, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x12a05f20, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x174876e8, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x1d1a94a2, 0x00000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x12309ce5, 0x40000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x16bcc41e, 0x90000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x1c6bf526, 0x34000000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x11c37937, 0xe0800000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x16345785, 0xd8a00000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x1bc16d67, 0x4ec80000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x1158e460, 0x913d0000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x15af1d78, 0xb58c4000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x1b1ae4d6, 0xe2ef5000)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x10f0cf06, 0x4dd59200)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x152d02c7, 0xe14af680)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x1a784379, 0xd99db420)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x108b2a2c, 0x28029094)},
+    {RYU_U64(0x00000000, 0x00000000), RYU_U64(0x14adf4b7, 0x320334b9)},
+    {RYU_U64(0x40000000, 0x00000000), RYU_U64(0x19d971e4, 0xfe8401e7)},
+    {RYU_U64(0x88000000, 0x00000000), RYU_U64(0x1027e72f, 0x1f128130)},
+    {RYU_U64(0xaa000000, 0x00000000), RYU_U64(0x1431e0fa, 0xe6d7217c)},
+    {RYU_U64(0xd4800000, 0x00000000), RYU_U64(0x193e5939, 0xa08ce9db)},
+    {RYU_U64(0xc9a00000, 0x00000000), RYU_U64(0x1f8def88, 0x08b02452)},
+    {RYU_U64(0xbe040000, 0x00000000), RYU_U64(0x13b8b5b5, 0x056e16b3)},
+    {RYU_U64(0xad850000, 0x00000000), RYU_U64(0x18a6e322, 0x46c99c60)},
+    {RYU_U64(0xd8e64000, 0x00000000), RYU_U64(0x1ed09bea, 0xd87c0378)},
+    {RYU_U64(0x878fe800, 0x00000000), RYU_U64(0x13426172, 0xc74d822b)},
+    {RYU_U64(0x6973e200, 0x00000000), RYU_U64(0x1812f9cf, 0x7920e2b6)},
+    {RYU_U64(0x03d0da80, 0x00000000), RYU_U64(0x1e17b843, 0x57691b64)},
+    {RYU_U64(0x82628890, 0x00000000), RYU_U64(0x12ced32a, 0x16a1b11e)},
+    {RYU_U64(0x22fb2ab4, 0x00000000), RYU_U64(0x178287f4, 0x9c4a1d66)},
+    {RYU_U64(0xabb9f561, 0x00000000), RYU_U64(0x1d6329f1, 0xc35ca4bf)},
+    {RYU_U64(0xcb54395c, 0xa0000000), RYU_U64(0x125dfa37, 0x1a19e6f7)},
+    {RYU_U64(0xbe2947b3, 0xc8000000), RYU_U64(0x16f578c4, 0xe0a060b5)},
+    {RYU_U64(0x2db399a0, 0xba000000), RYU_U64(0x1cb2d6f6, 0x18c878e3)},
+    {RYU_U64(0xfc904004, 0x74400000), RYU_U64(0x11efc659, 0xcf7d4b8d)},
+    {RYU_U64(0x7bb45005, 0x91500000), RYU_U64(0x166bb7f0, 0x435c9e71)},
+    {RYU_U64(0xdaa16406, 0xf5a40000), RYU_U64(0x1c06a5ec, 0x5433c60d)},
+    {RYU_U64(0xa8a4de84, 0x59868000), RYU_U64(0x118427b3, 0xb4a05bc8)},
+    {RYU_U64(0xd2ce1625, 0x6fe82000), RYU_U64(0x15e531a0, 0xa1c872ba)},
+    {RYU_U64(0x87819bae, 0xcbe22800), RYU_U64(0x1b5e7e08, 0xca3a8f69)},
+    {RYU_U64(0xf4b1014d, 0x3f6d5900), RYU_U64(0x111b0ec5, 0x7e6499a1)},
+    {RYU_U64(0x71dd41a0, 0x8f48af40), RYU_U64(0x1561d276, 0xddfdc00a)},
+    {RYU_U64(0x0e549208, 0xb31adb10), RYU_U64(0x1aba4714, 0x957d300d)},
+    {RYU_U64(0x28f4db45, 0x6ff0c8ea), RYU_U64(0x10b46c6c, 0xdd6e3e08)},
+    {RYU_U64(0x33321216, 0xcbecfb24), RYU_U64(0x14e18788, 0x14c9cd8a)},
+    {RYU_U64(0xbffe969c, 0x7ee839ed), RYU_U64(0x1a19e96a, 0x19fc40ec)},
+    {RYU_U64(0xf7ff1e21, 0xcf512434), RYU_U64(0x105031e2, 0x503da893)},
+    {RYU_U64(0xf5fee5aa, 0x43256d41), RYU_U64(0x14643e5a, 0xe44d12b8)},
+    {RYU_U64(0x337e9f14, 0xd3eec892), RYU_U64(0x197d4df1, 0x9d605767)},
+    {RYU_U64(0x005e46da, 0x08ea7ab6), RYU_U64(0x1fdca16e, 0x04b86d41)},
+    {RYU_U64(0xa03aec48, 0x45928cb2), RYU_U64(0x13e9e4e4, 0xc2f34448)},
+    {RYU_U64(0xc849a75a, 0x56f72fde), RYU_U64(0x18e45e1d, 0xf3b0155a)},
+    {RYU_U64(0x7a5c1130, 0xecb4fbd6), RYU_U64(0x1f1d75a5, 0x709c1ab1)},
+    {RYU_U64(0xec798abe, 0x93f11d65), RYU_U64(0x13726987, 0x666190ae)},
+    {RYU_U64(0xa797ed6e, 0x38ed64bf), RYU_U64(0x184f03e9, 0x3ff9f4da)},
+    {RYU_U64(0x517de8c9, 0xc728bdef), RYU_U64(0x1e62c4e3, 0x8ff87211)},
+    {RYU_U64(0xd2eeb17e, 0x1c7976b5), RYU_U64(0x12fdbb0e, 0x39fb474a)},
+    {RYU_U64(0x87aa5ddd, 0xa397d462), RYU_U64(0x17bd29d1, 0xc87a191d)},
+    {RYU_U64(0xe994f555, 0x0c7dc97b), RYU_U64(0x1dac7446, 0x3a989f64)},
+    {RYU_U64(0x11fd1955, 0x27ce9ded), RYU_U64(0x128bc8ab, 0xe49f639f)},
+    {RYU_U64(0xd67c5faa, 0x71c24568), RYU_U64(0x172ebad6, 0xddc73c86)},
+    {RYU_U64(0x8c1b7795, 0x0e32d6c2), RYU_U64(0x1cfa698c, 0x95390ba8)},
+    {RYU_U64(0x57912abd, 0x28dfc639), RYU_U64(0x121c81f7, 0xdd43a749)},
+    {RYU_U64(0xad75756c, 0x7317b7c8), RYU_U64(0x16a3a275, 0xd494911b)},
+    {RYU_U64(0x98d2d2c7, 0x8fdda5ba), RYU_U64(0x1c4c8b13, 0x49b9b562)},
+    {RYU_U64(0x9f83c3bc, 0xb9ea8794), RYU_U64(0x11afd6ec, 0x0e14115d)},
+    {RYU_U64(0x0764b4ab, 0xe8652979), RYU_U64(0x161bcca7, 0x119915b5)},
+    {RYU_U64(0x493de1d6, 0xe27e73d7), RYU_U64(0x1ba2bfd0, 0xd5ff5b22)},
+    {RYU_U64(0x6dc6ad26, 0x4d8f0866), RYU_U64(0x1145b7e2, 0x85bf98f5)},
+    {RYU_U64(0xc938586f, 0xe0f2ca80), RYU_U64(0x159725db, 0x272f7f32)},
+    {RYU_U64(0x7b866e8b, 0xd92f7d20), RYU_U64(0x1afcef51, 0xf0fb5eff)},
+    {RYU_U64(0xad340517, 0x67bdae34), RYU_U64(0x10de1593, 0x369d1b5f)},
+    {RYU_U64(0x9881065d, 0x41ad19c1), RYU_U64(0x15159af8, 0x04446237)},
+    {RYU_U64(0x7ea147f4, 0x92186032), RYU_U64(0x1a5b01b6, 0x05557ac5)},
+    {RYU_U64(0x6f24ccf8, 0xdb4f3c1f), RYU_U64(0x1078e111, 0xc3556cbb)},
+    {RYU_U64(0x4aee0037, 0x12230b27), RYU_U64(0x14971956, 0x342ac7ea)},
+    {RYU_U64(0xdda98044, 0xd6abcdf0), RYU_U64(0x19bcdfab, 0xc13579e4)},
+    {RYU_U64(0x0a89f02b, 0x062b60b6), RYU_U64(0x10160bcb, 0x58c16c2f)},
+    {RYU_U64(0xcd2c6c35, 0xc7b638e4), RYU_U64(0x141b8ebe, 0x2ef1c73a)},
+    {RYU_U64(0x80778743, 0x39a3c71d), RYU_U64(0x1922726d, 0xbaae3909)},
+    {RYU_U64(0xe0956914, 0x080cb8e4), RYU_U64(0x1f6b0f09, 0x2959c74b)},
+    {RYU_U64(0x6c5d61ac, 0x8507f38e), RYU_U64(0x13a2e965, 0xb9d81c8f)},
+    {RYU_U64(0x4774ba17, 0xa649f072), RYU_U64(0x188ba3bf, 0x284e23b3)},
+    {RYU_U64(0x1951e89d, 0x8fdc6c8f), RYU_U64(0x1eae8cae, 0xf261aca0)},
+    {RYU_U64(0x0fd33162, 0x79e9c3d9), RYU_U64(0x132d17ed, 0x577d0be4)},
+    {RYU_U64(0x13c7fdbb, 0x186434cf), RYU_U64(0x17f85de8, 0xad5c4edd)},
+    {RYU_U64(0x58b9fd29, 0xde7d4203), RYU_U64(0x1df67562, 0xd8b36294)},
+    {RYU_U64(0xb7743e3a, 0x2b0e4942), RYU_U64(0x12ba095d, 0xc7701d9c)},
+    {RYU_U64(0xe5514dc8, 0xb5d1db92), RYU_U64(0x17688bb5, 0x394c2503)},
+    {RYU_U64(0xdea5a13a, 0xe3465277), RYU_U64(0x1d42aea2, 0x879f2e44)},
+    {RYU_U64(0x0b2784c4, 0xce0bf38a), RYU_U64(0x1249ad25, 0x94c37ceb)},
+    {RYU_U64(0xcdf165f6, 0x018ef06d), RYU_U64(0x16dc186e, 0xf9f45c25)},
+    {RYU_U64(0x416dbf73, 0x81f2ac88), RYU_U64(0x1c931e8a, 0xb871732f)},
+    {RYU_U64(0x88e497a8, 0x3137abd5), RYU_U64(0x11dbf316, 0xb346e7fd)},
+    {RYU_U64(0xeb1dbd92, 0x3d8596ca), RYU_U64(0x1652efdc, 0x6018a1fc)},
+    {RYU_U64(0x25e52cf6, 0xcce6fc7d), RYU_U64(0x1be7abd3, 0x781eca7c)},
+    {RYU_U64(0x97af3c1a, 0x40105dce), RYU_U64(0x1170cb64, 0x2b133e8d)},
+    {RYU_U64(0xfd9b0b20, 0xd0147542), RYU_U64(0x15ccfe3d, 0x35d80e30)},
+    {RYU_U64(0x3d01cde9, 0x04199292), RYU_U64(0x1b403dcc, 0x834e11bd)},
+    {RYU_U64(0x462120b1, 0xa28ffb9b), RYU_U64(0x1108269f, 0xd210cb16)},
+    {RYU_U64(0xd7a968de, 0x0b33fa82), RYU_U64(0x154a3047, 0xc694fddb)},
+    {RYU_U64(0xcd93c315, 0x8e00f923), RYU_U64(0x1a9cbc59, 0xb83a3d52)},
+    {RYU_U64(0xc07c59ed, 0x78c09bb6), RYU_U64(0x10a1f5b8, 0x13246653)},
+    {RYU_U64(0xb09b7068, 0xd6f0c2a3), RYU_U64(0x14ca7326, 0x17ed7fe8)},
+    {RYU_U64(0xdcc24c83, 0x0cacf34c), RYU_U64(0x19fd0fef, 0x9de8dfe2)},
+    {RYU_U64(0xc9f96fd1, 0xe7ec180f), RYU_U64(0x103e29f5, 0xc2b18bed)},
+    {RYU_U64(0x3c77cbc6, 0x61e71e13), RYU_U64(0x144db473, 0x335deee9)},
+    {RYU_U64(0x8b95beb7, 0xfa60e598), RYU_U64(0x19612190, 0x00356aa3)},
+    {RYU_U64(0x6e7b2e65, 0xf8f91efe), RYU_U64(0x1fb969f4, 0x0042c54c)},
+    {RYU_U64(0xc50cfcff, 0xbb9bb35f), RYU_U64(0x13d3e238, 0x8029bb4f)},
+    {RYU_U64(0xb6503c3f, 0xaa82a037), RYU_U64(0x18c8dac6, 0xa0342a23)},
+    {RYU_U64(0xa3e44b4f, 0x95234844), RYU_U64(0x1efb1178, 0x484134ac)},
+    {RYU_U64(0xe66eaf11, 0xbd360d2b), RYU_U64(0x135ceaeb, 0x2d28c0eb)},
+    {RYU_U64(0xe00a5ad6, 0x2c839075), RYU_U64(0x183425a5, 0xf872f126)},
+    {RYU_U64(0x980cf18b, 0xb7a47493), RYU_U64(0x1e412f0f, 0x768fad70)},
+    {RYU_U64(0x5f0816f7, 0x52c6c8dc), RYU_U64(0x12e8bd69, 0xaa19cc66)},
+    {RYU_U64(0xf6ca1cb5, 0x27787b13), RYU_U64(0x17a2ecc4, 0x14a03f7f)},
+    {RYU_U64(0xf47ca3e2, 0x715699d7), RYU_U64(0x1d8ba7f5, 0x19c84f5f)},
+    {RYU_U64(0xf8cde66d, 0x86d62026), RYU_U64(0x127748f9, 0x301d319b)},
+    {RYU_U64(0xf7016008, 0xe88ba830), RYU_U64(0x17151b37, 0x7c247e02)},
+    {RYU_U64(0xb4c1b80b, 0x22ae923c), RYU_U64(0x1cda6205, 0x5b2d9d83)},
+    {RYU_U64(0x50f91306, 0xf5ad1b65), RYU_U64(0x12087d43, 0x58fc8272)},
+    {RYU_U64(0xe53757c8, 0xb318623f), RYU_U64(0x168a9c94, 0x2f3ba30e)},
+    {RYU_U64(0x9e852dba, 0xdfde7acf), RYU_U64(0x1c2d43b9, 0x3b0a8bd2)},
+    {RYU_U64(0xa3133c94, 0xcbeb0cc1), RYU_U64(0x119c4a53, 0xc4e69763)},
+    {RYU_U64(0x8bd80bb9, 0xfee5cff1), RYU_U64(0x16035ce8, 0xb6203d3c)},
+    {RYU_U64(0xaece0ea8, 0x7e9f43ee), RYU_U64(0x1b843422, 0xe3a84c8b)},
+    {RYU_U64(0x4d40c929, 0x4f238a75), RYU_U64(0x1132a095, 0xce492fd7)},
+    {RYU_U64(0x2090fb73, 0xa2ec6d12), RYU_U64(0x157f48bb, 0x41db7bcd)},
+    {RYU_U64(0x68b53a50, 0x8ba78856), RYU_U64(0x1adf1aea, 0x12525ac0)},
+    {RYU_U64(0x41714472, 0x5748b536), RYU_U64(0x10cb70d2, 0x4b7378b8)},
+    {RYU_U64(0x51cd958e, 0xed1ae283), RYU_U64(0x14fe4d06, 0xde5056e6)},
+    {RYU_U64(0xe640faf2, 0xa8619b24), RYU_U64(0x1a3de048, 0x95e46c9f)},
+    {RYU_U64(0xefe89cd7, 0xa93d00f7), RYU_U64(0x1066ac2d, 0x5daec3e3)},
+    {RYU_U64(0xebe2c40d, 0x938c4134), RYU_U64(0x14805738, 0xb51a74dc)},
+    {RYU_U64(0x26db7510, 0xf86f5181), RYU_U64(0x19a06d06, 0xe2611214)},
+    {RYU_U64(0x9849292a, 0x9b4592f1), RYU_U64(0x10044424, 0x4d7cab4c)},
+    {RYU_U64(0xbe5b7375, 0x4216f7ad), RYU_U64(0x1405552d, 0x60dbd61f)},
+    {RYU_U64(0xadf25052, 0x929cb598), RYU_U64(0x1906aa78, 0xb912cba7)},
+    {RYU_U64(0x996ee467, 0x3743e2ff), RYU_U64(0x1f485516, 0xe7577e91)},
+    {RYU_U64(0xffe54ec0, 0x828a6ddf), RYU_U64(0x138d352e, 0x5096af1a)},
+    {RYU_U64(0xbfdea270, 0xa32d0957), RYU_U64(0x18708279, 0xe4bc5ae1)},
+    {RYU_U64(0x2fd64b0c, 0xcbf84bad), RYU_U64(0x1e8ca318, 0x5deb719a)},
+    {RYU_U64(0x5de5eee7, 0xff7b2f4c), RYU_U64(0x1317e5ef, 0x3ab32700)},
+    {RYU_U64(0x755f6aa1, 0xff59fb1f), RYU_U64(0x17dddf6b, 0x095ff0c0)},
+    {RYU_U64(0x92b7454a, 0x7f3079e7), RYU_U64(0x1dd55745, 0xcbb7ecf0)},
+    {RYU_U64(0x5bb28b4e, 0x8f7e4c30), RYU_U64(0x12a5568b, 0x9f52f416)},
+    {RYU_U64(0xf29f2e22, 0x335ddf3c), RYU_U64(0x174eac2e, 0x8727b11b)},
+    {RYU_U64(0xef46f9aa, 0xc035570b), RYU_U64(0x1d22573a, 0x28f19d62)},
+    {RYU_U64(0xd58c5c0a, 0xb8215667), RYU_U64(0x12357684, 0x5997025d)},
+    {RYU_U64(0x4aef730d, 0x6629ac01), RYU_U64(0x16c2d425, 0x6ffcc2f5)},
+    {RYU_U64(0x9dab4fd0, 0xbfb41701), RYU_U64(0x1c73892e, 0xcbfbf3b2)},
+    {RYU_U64(0xa28b11e2, 0x77d08e60), RYU_U64(0x11c835bd, 0x3f7d784f)},
+    {RYU_U64(0x8b2dd65b, 0x15c4b1f9), RYU_U64(0x163a432c, 0x8f5cd663)},
+    {RYU_U64(0x6df94bf1, 0xdb35de77), RYU_U64(0x1bc8d3f7, 0xb3340bfc)},
+    {RYU_U64(0xc4bbcf77, 0x2901ab0a), RYU_U64(0x115d847a, 0xd000877d)},
+    {RYU_U64(0x35eac354, 0xf34215cd), RYU_U64(0x15b4e599, 0x8400a95d)},
+    {RYU_U64(0x8365742a, 0x30129b40), RYU_U64(0x1b221eff, 0xe500d3b4)},
+    {RYU_U64(0xd21f689a, 0x5e0ba108), RYU_U64(0x10f5535f, 0xef208450)},
+    {RYU_U64(0x06a742c0, 0xf58e894a), RYU_U64(0x1532a837, 0xeae8a565)},
+    {RYU_U64(0x48511371, 0x32f22b9d), RYU_U64(0x1a7f5245, 0xe5a2cebe)},
+    {RYU_U64(0xed32ac26, 0xbfd75b42), RYU_U64(0x108f936b, 0xaf85c136)},
+    {RYU_U64(0xa87f5730, 0x6fcd3212), RYU_U64(0x14b37846, 0x9b673184)},
+    {RYU_U64(0xd29f2cfc, 0x8bc07e97), RYU_U64(0x19e05658, 0x4240fde5)},
+    {RYU_U64(0xa3a37c1d, 0xd7584f1e), RYU_U64(0x102c35f7, 0x29689eaf)},
+    {RYU_U64(0x8c8c5b25, 0x4d2e62e6), RYU_U64(0x14374374, 0xf3c2c65b)},
+    {RYU_U64(0x6faf71ee, 0xa079fb9f), RYU_U64(0x19451452, 0x30b377f2)},
+    {RYU_U64(0x0b9b4e6a, 0x48987a87), RYU_U64(0x1f965966, 0xbce055ef)},
+    {RYU_U64(0x67411102, 0x6d5f4c94), RYU_U64(0x13bdf7e0, 0x360c35b5)},
+    {RYU_U64(0xc1115543, 0x08b71fba), RYU_U64(0x18ad75d8, 0x438f4322)},
+    {RYU_U64(0x7155aa93, 0xcae4e7a8), RYU_U64(0x1ed8d34e, 0x547313eb)},
+    {RYU_U64(0x26d58a9c, 0x5ecf10c9), RYU_U64(0x13478410, 0xf4c7ec73)},
+    {RYU_U64(0xf08aed43, 0x7682d4fb), RYU_U64(0x18196515, 0x31f9e78f)},
+    {RYU_U64(0xecada894, 0x54238a3a), RYU_U64(0x1e1fbe5a, 0x7e786173)},
+    {RYU_U64(0x73ec895c, 0xb4963664), RYU_U64(0x12d3d6f8, 0x8f0b3ce8)},
+    {RYU_U64(0x90e7abb3, 0xe1bbc3fd), RYU_U64(0x1788ccb6, 0xb2ce0c22)},
+    {RYU_U64(0x352196a0, 0xda2ab4fd), RYU_U64(0x1d6affe4, 0x5f818f2b)},
+    {RYU_U64(0x0134fe24, 0x885ab11e), RYU_U64(0x1262dfee, 0xbbb0f97b)},
+    {RYU_U64(0xc1823dad, 0xaa715d65), RYU_U64(0x16fb97ea, 0x6a9d37d9)},
+    {RYU_U64(0x31e2cd19, 0x150db4bf), RYU_U64(0x1cba7de5, 0x054485d0)},
+    {RYU_U64(0x1f2dc02f, 0xad2890f7), RYU_U64(0x11f48eaf, 0x234ad3a2)},
+    {RYU_U64(0xa6f9303b, 0x9872b535), RYU_U64(0x1671b25a, 0xec1d888a)},
+    {RYU_U64(0x50b77c4a, 0x7e8f6282), RYU_U64(0x1c0e1ef1, 0xa724eaad)},
+    {RYU_U64(0x5272adae, 0x8f199d91), RYU_U64(0x1188d357, 0x087712ac)},
+    {RYU_U64(0x670f591a, 0x32e004f6), RYU_U64(0x15eb082c, 0xca94d757)},
+    {RYU_U64(0x40d32f60, 0xbf980633), RYU_U64(0x1b65ca37, 0xfd3a0d2d)},
+    {RYU_U64(0x4883fd9c, 0x77bf03e0), RYU_U64(0x111f9e62, 0xfe44483c)},
+    {RYU_U64(0x5aa4fd03, 0x95aec4d8), RYU_U64(0x156785fb, 0xbdd55a4b)},
+    {RYU_U64(0x314e3c44, 0x7b1a760e), RYU_U64(0x1ac1677a, 0xad4ab0de)},
+    {RYU_U64(0xded0e5aa, 0xccf089c9), RYU_U64(0x10b8e0ac, 0xac4eae8a)},
+    {RYU_U64(0x96851f15, 0x802cac3b), RYU_U64(0x14e718d7, 0xd7625a2d)},
+    {RYU_U64(0xfc2666da, 0xe037d74a), RYU_U64(0x1a20df0d, 0xcd3af0b8)},
+    {RYU_U64(0x9d980048, 0xcc22e68e), RYU_U64(0x10548b68, 0xa044d673)},
+    {RYU_U64(0x84fe005a, 0xff2ba032), RYU_U64(0x1469ae42, 0xc8560c10)},
+    {RYU_U64(0xa63d8071, 0xbef6883e), RYU_U64(0x198419d3, 0x7a6b8f14)},
+    {RYU_U64(0xcfcce08e, 0x2eb42a4e), RYU_U64(0x1fe52048, 0x590672d9)},
+    {RYU_U64(0x21e00c58, 0xdd309a70), RYU_U64(0x13ef342d, 0x37a407c8)},
+    {RYU_U64(0x2a580f6f, 0x147cc10d), RYU_U64(0x18eb0138, 0x858d09ba)},
+    {RYU_U64(0xb4ee134a, 0xd99bf150), RYU_U64(0x1f25c186, 0xa6f04c28)},
+    {RYU_U64(0x7114cc0e, 0xc80176d2), RYU_U64(0x137798f4, 0x28562f99)},
+    {RYU_U64(0xcd59ff12, 0x7a01d486), RYU_U64(0x18557f31, 0x326bbb7f)},
+    {RYU_U64(0xc0b07ed7, 0x188249a8), RYU_U64(0x1e6adefd, 0x7f06aa5f)},
+    {RYU_U64(0xd86e4f46, 0x6f516e09), RYU_U64(0x1302cb5e, 0x6f642a7b)},
+    {RYU_U64(0xce89e318, 0x0b25c98b), RYU_U64(0x17c37e36, 0x0b3d351a)},
+    {RYU_U64(0x822c5bde, 0x0def3bee), RYU_U64(0x1db45dc3, 0x8e0c8261)},
+    {RYU_U64(0xf15bb96a, 0xc8b58575), RYU_U64(0x1290ba9a, 0x38c7d17c)},
+    {RYU_U64(0x2db2a7c5, 0x7ae2e6d2), RYU_U64(0x1734e940, 0xc6f9c5dc)},
+    {RYU_U64(0x391f51b6, 0xd99ba086), RYU_U64(0x1d022390, 0xf8b83753)},
+    {RYU_U64(0x03b39312, 0x48014454), RYU_U64(0x1221563a, 0x9b732294)},
+    {RYU_U64(0x04a077d6, 0xda019569), RYU_U64(0x16a9abc9, 0x424feb39)},
+    {RYU_U64(0x45c895cc, 0x9081fac3), RYU_U64(0x1c5416bb, 0x92e3e607)},
+    {RYU_U64(0x8b9d5d9f, 0xda513cba), RYU_U64(0x11b48e35, 0x3bce6fc4)},
+    {RYU_U64(0xae84b507, 0xd0e58be8), RYU_U64(0x1621b1c2, 0x8ac20bb5)},
+    {RYU_U64(0x1a25e249, 0xc51eeee3), RYU_U64(0x1baa1e33, 0x2d728ea3)},
+    {RYU_U64(0xf057ad6e, 0x1b33554d), RYU_U64(0x114a52df, 0xfc679925)},
+    {RYU_U64(0x6c6d98c9, 0xa2002aa1), RYU_U64(0x159ce797, 0xfb817f6f)},
+    {RYU_U64(0x4788fefc, 0x0a803549), RYU_U64(0x1b04217d, 0xfa61df4b)},
+    {RYU_U64(0x0cb59f5d, 0x8690214e), RYU_U64(0x10e294ee, 0xbc7d2b8f)},
+    {RYU_U64(0xcfe30734, 0xe83429a1), RYU_U64(0x151b3a2a, 0x6b9c7672)},
+    {RYU_U64(0x83dbc902, 0x2241340a), RYU_U64(0x1a6208b5, 0x0683940f)},
+    {RYU_U64(0xb2695da1, 0x5568c086), RYU_U64(0x107d4571, 0x24123c89)},
+    {RYU_U64(0x1f03b509, 0xaac2f0a7), RYU_U64(0x149c96cd, 0x6d16cbac)},
+    {RYU_U64(0x26c4a24c, 0x1573acd1), RYU_U64(0x19c3bc80, 0xc85c7e97)},
+    {RYU_U64(0x783ae56f, 0x8d684c03), RYU_U64(0x101a55d0, 0x7d39cf1e)},
+    {RYU_U64(0x16499ecb, 0x70c25f03), RYU_U64(0x1420eb44, 0x9c8842e6)},
+    {RYU_U64(0x9bdc067e, 0x4cf2f6c4), RYU_U64(0x19292615, 0xc3aa539f)},
+    {RYU_U64(0x82d3081d, 0xe02fb476), RYU_U64(0x1f736f9b, 0x3494e887)},
+    {RYU_U64(0xb1c3e512, 0xac1dd0c9), RYU_U64(0x13a825c1, 0x00dd1154)},
+    {RYU_U64(0xde34de57, 0x572544fc), RYU_U64(0x18922f31, 0x411455a9)},
+    {RYU_U64(0x55c215ed, 0x2cee963b), RYU_U64(0x1eb6bafd, 0x91596b14)},
+    {RYU_U64(0xb5994db4, 0x3c151de5), RYU_U64(0x133234de, 0x7ad7e2ec)},
+    {RYU_U64(0xe2ffa121, 0x4b1a655e), RYU_U64(0x17fec216, 0x198ddba7)},
+    {RYU_U64(0xdbbf8969, 0x9de0feb6), RYU_U64(0x1dfe729b, 0x9ff15291)},
+    {RYU_U64(0x2957b5e2, 0x02ac9f31), RYU_U64(0x12bf07a1, 0x43f6d39b)},
+    {RYU_U64(0xf3ada35a, 0x8357c6fe), RYU_U64(0x176ec989, 0x94f48881)},
+    {RYU_U64(0x70990c31, 0x242db8bd), RYU_U64(0x1d4a7beb, 0xfa31aaa2)},
+    {RYU_U64(0x865fa79e, 0xb69c9376), RYU_U64(0x124e8d73, 0x7c5f0aa5)},
+    {RYU_U64(0xe7f79186, 0x6443b854), RYU_U64(0x16e230d0, 0x5b76cd4e)},
+    {RYU_U64(0xa1f575e7, 0xfd54a669), RYU_U64(0x1c9abd04, 0x725480a2)},
+    {RYU_U64(0xa53969b0, 0xfe54e801), RYU_U64(0x11e0b622, 0xc774d065)},
+    {RYU_U64(0x0e87c41d, 0x3dea2202), RYU_U64(0x1658e3ab, 0x7952047f)},
+    {RYU_U64(0xd229b524, 0x8d64aa82), RYU_U64(0x1bef1c96, 0x57a6859e)},
+    {RYU_U64(0x435a1136, 0xd85eea91), RYU_U64(0x117571dd, 0xf6c81383)},
+    {RYU_U64(0x14309584, 0x8e76a536), RYU_U64(0x15d2ce55, 0x747a1864)},
+    {RYU_U64(0x193cbae5, 0xb2144e83), RYU_U64(0x1b4781ea, 0xd1989e7d)},
+    {RYU_U64(0x2fc5f4cf, 0x8f4cb112), RYU_U64(0x110cb132, 0xc2ff630e)},
+    {RYU_U64(0xbbb77203, 0x731fdd56), RYU_U64(0x154fdd7f, 0x73bf3bd1)},
+    {RYU_U64(0x2aa54e84, 0x4fe7d4ac), RYU_U64(0x1aa3d4df, 0x50af0ac6)},
+    {RYU_U64(0xdaa75112, 0xb1f0e4eb), RYU_U64(0x10a6650b, 0x926d66bb)},
+    {RYU_U64(0xd1512557, 0x5e6d1e26), RYU_U64(0x14cffe4e, 0x7708c06a)},
+    {RYU_U64(0x85a56ead, 0x360865b0), RYU_U64(0x1a03fde2, 0x14caf085)},
+    {RYU_U64(0x7387652c, 0x41c53f8e), RYU_U64(0x10427ead, 0x4cfed653)},
+    {RYU_U64(0x50693e77, 0x52368f71), RYU_U64(0x14531e58, 0xa03e8be8)},
+    {RYU_U64(0x64838e15, 0x26c4334e), RYU_U64(0x1967e5ee, 0xc84e2ee2)},
+    {RYU_U64(0xfda4719a, 0x70754022), RYU_U64(0x1fc1df6a, 0x7a61ba9a)},
+    {RYU_U64(0xde86c700, 0x86494815), RYU_U64(0x13d92ba2, 0x8c7d14a0)},
+    {RYU_U64(0x162878c0, 0xa7db9a1a), RYU_U64(0x18cf768b, 0x2f9c59c9)},
+    {RYU_U64(0x5bb296f0, 0xd1d280a1), RYU_U64(0x1f03542d, 0xfb83703b)},
+    {RYU_U64(0x194f9e56, 0x83239064), RYU_U64(0x1362149c, 0xbd322625)},
+    {RYU_U64(0x5fa385ec, 0x23ec747e), RYU_U64(0x183a99c3, 0xec7eafae)},
+    {RYU_U64(0xf78c6767, 0x2ce7919d), RYU_U64(0x1e494034, 0xe79e5b99)},
+    {RYU_U64(0x3ab7c0a0, 0x7c10bb02), RYU_U64(0x12edc821, 0x10c2f940)},
+    {RYU_U64(0x4965b0c8, 0x9b14e9c3), RYU_U64(0x17a93a29, 0x54f3b790)},
+    {RYU_U64(0x5bbf1cfa, 0xc1da2433), RYU_U64(0x1d9388b3, 0xaa30a574)},
+    {RYU_U64(0xb957721c, 0xb92856a0), RYU_U64(0x127c3570, 0x4a5e6768)},
+    {RYU_U64(0xe7ad4ea3, 0xe7726c48), RYU_U64(0x171b42cc, 0x5cf60142)},
+    {RYU_U64(0xa198a24c, 0xe14f075a), RYU_U64(0x1ce2137f, 0x74338193)},
+    {RYU_U64(0x44ff6570, 0x0cd16498), RYU_U64(0x120d4c2f, 0xa8a030fc)},
+    {RYU_U64(0x563f3ecc, 0x1005bdbe), RYU_U64(0x16909f3b, 0x92c83d3b)},
+    {RYU_U64(0x2bcf0e7f, 0x14072d2e), RYU_U64(0x1c34c70a, 0x777a4c8a)},
+    {RYU_U64(0x5b61690f, 0x6c847c3d), RYU_U64(0x11a0fc66, 0x8aac6fd6)},
+    {RYU_U64(0xf239c353, 0x47a59b4c), RYU_U64(0x16093b80, 0x2d578bcb)},
+    {RYU_U64(0xeec83428, 0x198f021f), RYU_U64(0x1b8b8a60, 0x38ad6ebe)},
+    {RYU_U64(0x553d2099, 0x0ff96153), RYU_U64(0x1137367c, 0x236c6537)},
+    {RYU_U64(0x2a8c68bf, 0x53f7b9a8), RYU_U64(0x1585041b, 0x2c477e85)},
+    {RYU_U64(0x752f82ef, 0x28f5a812), RYU_U64(0x1ae64521, 0xf7595e26)},
+    {RYU_U64(0x093db1d5, 0x7999890b), RYU_U64(0x10cfeb35, 0x3a97dad8)},
+    {RYU_U64(0x0b8d1e4a, 0xd7ffeb4e), RYU_U64(0x1503e602, 0x893dd18e)},
+    {RYU_U64(0x8e7065dd, 0x8dffe622), RYU_U64(0x1a44df83, 0x2b8d45f1)},
+    {RYU_U64(0xf9063faa, 0x78bfefd5), RYU_U64(0x106b0bb1, 0xfb384bb6)},
+    {RYU_U64(0xb747cf95, 0x16efebca), RYU_U64(0x1485ce9e, 0x7a065ea4)},
+    {RYU_U64(0xe519c37a, 0x5cabe6bd), RYU_U64(0x19a74246, 0x1887f64d)},
+    {RYU_U64(0xaf301a2c, 0x79eb7036), RYU_U64(0x1008896b, 0xcf54f9f0)},
+    {RYU_U64(0xdafc20b7, 0x98664c43), RYU_U64(0x140aabc6, 0xc32a386c)},
+    {RYU_U64(0x11bb28e5, 0x7e7fdf54), RYU_U64(0x190d56b8, 0x73f4c688)},
+    {RYU_U64(0x1629f31e, 0xde1fd72a), RYU_U64(0x1f50ac66, 0x90f1f82a)},
+    {RYU_U64(0x4dda37f3, 0x4ad3e67a), RYU_U64(0x13926bc0, 0x1a973b1a)},
+    {RYU_U64(0xe150c5f0, 0x1d88e019), RYU_U64(0x187706b0, 0x213d09e0)},
+    {RYU_U64(0x19a4f76c, 0x24eb181f), RYU_U64(0x1e94c85c, 0x298c4c59)},
+    {RYU_U64(0xb0071aa3, 0x9712ef13), RYU_U64(0x131cfd39, 0x99f7afb7)},
+    {RYU_U64(0x9c08e14c, 0x7cd7aad8), RYU_U64(0x17e43c88, 0x00759ba5)},
+    {RYU_U64(0x030b199f, 0x9c0d958e), RYU_U64(0x1ddd4baa, 0x0093028f)},
+    {RYU_U64(0x61e6f003, 0xc1887d79), RYU_U64(0x12aa4f4a, 0x405be199)},
+    {RYU_U64(0xba60ac04, 0xb1ea9cd7), RYU_U64(0x1754e31c, 0xd072d9ff)},
+    {RYU_U64(0xa8f8d705, 0xde65440d), RYU_U64(0x1d2a1be4, 0x048f907f)},
+    {RYU_U64(0xc99b8663, 0xaaff4a88), RYU_U64(0x123a516e, 0x82d9ba4f)},
+    {RYU_U64(0xbc0267fc, 0x95bf1d2a), RYU_U64(0x16c8e5ca, 0x239028e3)},
+    {RYU_U64(0xab0301fb, 0xbb2ee474), RYU_U64(0x1c7b1f3c, 0xac74331c)},
+    {RYU_U64(0xeae1e13d, 0x54fd4ec9), RYU_U64(0x11ccf385, 0xebc89ff1)},
+    {RYU_U64(0x659a598c, 0xaa3ca27b), RYU_U64(0x16403067, 0x66bac7ee)},
+    {RYU_U64(0xff00efef, 0xd4cbcb1a), RYU_U64(0x1bd03c81, 0x406979e9)},
+    {RYU_U64(0x3f6095f5, 0xe4ff5ef0), RYU_U64(0x116225d0, 0xc841ec32)},
+    {RYU_U64(0xcf38bb73, 0x5e3f36ac), RYU_U64(0x15baaf44, 0xfa52673e)},
+    {RYU_U64(0x8306ea50, 0x35cf0457), RYU_U64(0x1b295b16, 0x38e7010e)},
+    {RYU_U64(0x11e45272, 0x21a162b6), RYU_U64(0x10f9d8ed, 0xe39060a9)},
+    {RYU_U64(0x565d670e, 0xaa09bb64), RYU_U64(0x15384f29, 0x5c7478d3)},
+    {RYU_U64(0x2bf4c0d2, 0x548c2a3d), RYU_U64(0x1a8662f3, 0xb3919708)},
+    {RYU_U64(0x1b78f883, 0x74d79a66), RYU_U64(0x1093fdd8, 0x503afe65)},
+    {RYU_U64(0x625736a4, 0x520d8100), RYU_U64(0x14b8fd4e, 0x6449bdfe)},
+    {RYU_U64(0xfaed044d, 0x6690e140), RYU_U64(0x19e73ca1, 0xfd5c2d7d)},
+    {RYU_U64(0xbcd422b0, 0x601a8cc8), RYU_U64(0x103085e5, 0x3e599c6e)},
+    {RYU_U64(0x6c092b5c, 0x78212ffa), RYU_U64(0x143ca75e, 0x8df0038a)},
+    {RYU_U64(0x070b7633, 0x96297bf8), RYU_U64(0x194bd136, 0x316c046d)},
+    {RYU_U64(0x48ce53c0, 0x7bb3daf6), RYU_U64(0x1f9ec583, 0xbdc70588)},
+    {RYU_U64(0x2d80f458, 0x4d5068da), RYU_U64(0x13c33b72, 0x569c6375)},
+    {RYU_U64(0x78e1316e, 0x60a48310), RYU_U64(0x18b40a4e, 0xec437c52)},
+};
+
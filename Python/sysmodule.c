@@ -488,6 +488,47 @@ PyDoc_STRVAR(getcheckinterval_doc,
 "getcheckinterval() -> current check interval; see setcheckinterval()."
 );
 
+#ifdef WITH_THREAD
+static PyObject *
+sys_setswitchinterval(PyObject *self, PyObject *args)
+{
+    double d;
+    if (!PyArg_ParseTuple(args, "d:setswitchinterval", &d))
+        return NULL;
+    if (d <= 0.0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "switch interval must be strictly positive");
+        return NULL;
+    }
+    _PyEval_SetSwitchInterval((unsigned long) (1e6 * d));
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyDoc_STRVAR(setswitchinterval_doc,
+"setswitchinterval(n)\n\
+\n\
+Set the ideal thread switching delay inside the Python interpreter.\n\
+The actual frequency of switching threads can be lower if the\n\
+interpreter executes long sequences of uninterruptible code\n\
+(this is implementation-specific and workload-dependent).\n\
+\n\
+The parameter must represent the desired switching delay in seconds.\n\
+A typical value is 0.005 (5 milliseconds)."
+);
+
+static PyObject *
+sys_getswitchinterval(PyObject *self, PyObject *args)
+{
+    return PyFloat_FromDouble(1e-6 * _PyEval_GetSwitchInterval());
+}
+
+PyDoc_STRVAR(getswitchinterval_doc,
+"getswitchinterval() -> current thread switch interval; see setswitchinterval()."
+);
+
+#endif /* WITH_THREAD */
+
 #ifdef WITH_TSC
 static PyObject *
 sys_settscdump(PyObject *self, PyObject *args)
@@ -748,10 +789,54 @@ PyDoc_STRVAR(getsizeof_doc,
 \n\
 Return the size of object in bytes.");
 
+static PyObject *
+sys_getfreeliststats(PyObject *self)
+{
+    PyObject *res, *stats;
+    _PyFreeList **fl;
+    int err;
+
+    res = PyDict_New();
+    if (res == NULL)
+        return NULL;
+    for (fl = _PyFreeLists; *fl != NULL; fl++) {
+#ifdef Py_FREELIST_STATS
+        stats = Py_BuildValue("{snsnsnsn}",
+                              "numfree", (*fl)->numfree,
+                              "maxfree", (*fl)->maxfree,
+                              "hits", (*fl)->hits,
+                              "misses", (*fl)->misses);
+#else
+        stats = Py_BuildValue("{snsn}",
+                              "numfree", (*fl)->numfree,
+                              "maxfree", (*fl)->maxfree);
+#endif
+        if (stats == NULL) {
+            Py_DECREF(res);
+            return NULL;
+        }
+        err = PyDict_SetItemString(res, (*fl)->name, stats);
+        Py_DECREF(stats);
+        if (err < 0) {
+            Py_DECREF(res);
+            return NULL;
+        }
+    }
+    return res;
+}
+
+PyDoc_STRVAR(getfreeliststats_doc,
+"getfreeliststats() -> dict\n\
+\n\
+Return a dict mapping the names of the free lists of deallocated objects\n\
+to dicts with their numfree and maxfree.  The hits and misses needed for\n\
+hit rates are only counted, and reported, in debug builds and builds with\n\
+Py_FREELIST_STATS defined.");
+
 static PyObject *
 sys_getrefcount(PyObject *self, PyObject *arg)
 {
-    return PyInt_FromSsize_t(arg->ob_refcnt);
+    return PyInt_FromSsize_t(Py_REFCNT(arg));
 }
 
 #ifdef Py_REF_DEBUG
@@ -941,6 +1026,8 @@ static PyMethodDef sys_methods[] = {
      getrecursionlimit_doc},
     {"getsizeof",   (PyCFunction)sys_getsizeof,
      METH_VARARGS | METH_KEYWORDS, getsizeof_doc},
+    {"getfreeliststats", (PyCFunction)sys_getfreeliststats, METH_NOARGS,
+     getfreeliststats_doc},
     {"_getframe", sys_getframe, METH_VARARGS, getframe_doc},
 #ifdef MS_WINDOWS
     {"getwindowsversion", (PyCFunction)sys_getwindowsversion, METH_NOARGS,
@@ -957,6 +1044,12 @@ static PyMethodDef sys_methods[] = {
      setcheckinterval_doc},
     {"getcheckinterval",        sys_getcheckinterval, METH_NOARGS,
      getcheckinterval_doc},
+#ifdef WITH_THREAD
+    {"setswitchinterval",       sys_setswitchinterval, METH_VARARGS,
+     setswitchinterval_doc},
+    {"getswitchinterval",       sys_getswitchinterval, METH_NOARGS,
+     getswitchinterval_doc},
+#endif
 #ifdef HAVE_DLOPEN
     {"setdlopenflags", sys_setdlopenflags, METH_VARARGS,
      setdlopenflags_doc},
@@ -1126,12 +1219,14 @@ getprofile() -- get the global profiling function\n\
 getrefcount() -- return the reference count for an object (plus one :-)\n\
 getrecursionlimit() -- return the max recursion depth for the interpreter\n\
 getsizeof() -- return the size of an object in bytes\n\
+getfreeliststats() -- return statistics on the free lists of objects\n\
 gettrace() -- get the global debug tracing function\n\
 setcheckinterval() -- control how often the interpreter checks for events\n\
 setdlopenflags() -- set the flags to be used for dlopen() calls\n\
 setprofile() -- set the global profiling function\n\
 setrecursionlimit() -- set the max recursion depth for the interpreter\n\
 settrace() -- set the global debug tracing function\n\
+setswitchinterval() -- set the ideal thread switching delay\n\
 "
 )
 /* end of sys_doc */ ;
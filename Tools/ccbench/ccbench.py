@@ -588,6 +588,11 @@ def main():
         platform.system(),
         cpu,
     ))
+    if hasattr(sys, 'getswitchinterval'):
+        print("== switch interval: %.1f ms., check interval: %d ==" % (
+            sys.getswitchinterval() * 1000.0,
+            sys.getcheckinterval(),
+        ))
     print()
 
     if options.throughput:
@@ -0,0 +1,146 @@
+# -*- coding: utf-8 -*-
+"""Measure how much memory forked workers stop sharing with their parent.
+
+The parent imports modules and builds data, like a server does at startup,
+then forks workers.  Each worker runs a workload that only reads the shared
+objects, and reports the memory it had to copy from its parent (the
+"Private_Dirty" pages of /proc/self/smaps) and how long the workload took.
+Run it with --freeze and --immortalize to see what gc.freeze() and
+gc.immortalize_heap() save.
+"""
+
+import gc
+import os
+import sys
+import time
+from optparse import OptionParser
+
+MODULES = ["BaseHTTPServer", "cgi", "collections", "decimal", "difflib",
+           "email.parser", "fractions", "inspect", "json", "logging",
+           "optparse", "pickle", "pydoc", "random", "re", "shlex",
+           "SimpleXMLRPCServer", "string", "tarfile", "textwrap", "urllib2",
+           "xml.dom.minidom", "zipfile"]
+
+
+def build_data(n):
+    """A table of records, as a server could load at startup."""
+    return dict(("key%d" % i, {"id": i, "name": "record %d" % i,
+                               "tags": ("a", "b", str(i % 100))})
+                for i in xrange(n))
+
+
+def workload(data, modules, loops):
+    """Read the shared objects, touching their reference counts."""
+    total = 0
+    for loop in xrange(loops):
+        for record in data.itervalues():
+            total += record["id"] + len(record["tags"])
+        for mod in modules:
+            for name, value in vars(mod).items():
+                if callable(value):
+                    total += 1
+    return total
+
+
+def memory_usage():
+    """Return the private and shared memory of this process, in kB."""
+    private = shared = 0
+    try:
+        f = open("/proc/self/smaps")
+    except IOError:
+        return None, None
+    with f:
+        for line in f:
+            if line.startswith("Private_Dirty:"):
+                private += int(line.split()[1])
+            elif line.startswith(("Shared_Clean:", "Shared_Dirty:")):
+                shared += int(line.split()[1])
+    return private, shared
+
+
+def worker(data, modules, loops, wfd):
+    before, _ = memory_usage()
+    t = time.time()
+    workload(data, modules, loops)
+    t = time.time() - t
+    after, shared = memory_usage()
+    if before is None:
+        os.write(wfd, "%f -1 -1\n" % t)
+    else:
+        os.write(wfd, "%f %d %d\n" % (t, after - before, shared))
+
+
+def run(options):
+    modules = []
+    for name in MODULES:
+        __import__(name)
+        modules.append(sys.modules[name])
+    data = build_data(options.records)
+    print("%d objects tracked by the collector" % len(gc.get_objects()))
+    if options.freeze:
+        gc.freeze()
+    if options.immortalize:
+        if not hasattr(gc, "immortalize_heap"):
+            sys.exit("Python wasn't configured --with-immortal-objects")
+        gc.immortalize_heap()
+
+    results = []
+    for i in range(options.workers):
+        rfd, wfd = os.pipe()
+        pid = os.fork()
+        if pid == 0:
+            os.close(rfd)
+            try:
+                worker(data, modules, options.loops, wfd)
+            finally:
+                os._exit(0)
+        os.close(wfd)
+        with os.fdopen(rfd) as f:
+            line = f.read()
+        os.waitpid(pid, 0)
+        t, private, shared = line.split()
+        results.append((float(t), int(private), int(shared)))
+
+    for i, (t, private, shared) in enumerate(results):
+        if private < 0:
+            print("worker %d: %.3f s" % (i, t))
+        else:
+            print("worker %d: %.3f s, %.1f MB copied, %.1f MB shared"
+                  % (i, t, private / 1024.0, shared / 1024.0))
+    times = [r[0] for r in results]
+    print("best time: %.3f s" % min(times))
+    if results[0][1] >= 0:
+        copied = [r[1] for r in results]
+        print("average copied: %.1f MB per worker"
+              % (sum(copied) / 1024.0 / len(copied)))
+
+
+def main():
+    usage = "usage: %prog [-h|--help] [options]"
+    parser = OptionParser(usage=usage)
+    parser.add_option("-w", "--workers",
+                      action="store", type="int", dest="workers", default=4,
+                      help="number of workers to fork (default: 4)")
+    parser.add_option("-n", "--records",
+                      action="store", type="int", dest="records",
+                      default=200000,
+                      help="number of records the parent builds "
+                           "(default: 200000)")
+    parser.add_option("-l", "--loops",
+                      action="store", type="int", dest="loops", default=5,
+                      help="passes of each worker over the data (default: 5)")
+    parser.add_option("-f", "--freeze",
+                      action="store_true", dest="freeze", default=False,
+                      help="call gc.freeze() before forking")
+    parser.add_option("-i", "--immortalize",
+                      action="store_true", dest="immortalize", default=False,
+                      help="call gc.immortalize_heap() before forking")
+    options, args = parser.parse_args()
+    if args:
+        parser.error("unexpected arguments")
+    if not hasattr(os, "fork"):
+        sys.exit("os.fork() is required")
+    run(options)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,109 @@
+"""Time arithmetic on big longs, from a thousand to ten million digits.
+
+Each operation is timed on operands of a growing number of decimal digits,
+built from a fixed seed so that runs are comparable between interpreters:
+multiplication of balanced and unbalanced operands, squaring, modular
+exponentiation with a modulus of the same size, and conversion to and from
+decimal strings.  The largest sizes take minutes with a quadratic
+multiplication; use -m to stop earlier.
+"""
+
+import random
+import time
+from optparse import OptionParser
+
+SIZES = [1000, 3000, 10000, 30000, 100000, 300000, 1000000, 3000000,
+         10000000]
+LOG2_10 = 3.321928094887362
+
+
+def operand(rng, digits):
+    """Return a random long of about digits decimal digits."""
+    bits = int(digits * LOG2_10)
+    return rng.getrandbits(bits) | (1L << (bits - 1))
+
+
+def bench(func, min_time, repeat):
+    """Return the best time of func(), repeated until min_time passes."""
+    best = None
+    for i in xrange(repeat):
+        n = 0
+        start = time.time()
+        while True:
+            func()
+            n += 1
+            elapsed = time.time() - start
+            if elapsed >= min_time:
+                break
+        if best is None or elapsed / n < best:
+            best = elapsed / n
+    return best
+
+
+def workloads(rng, digits):
+    a = operand(rng, digits)
+    b = operand(rng, digits)
+    c = operand(rng, digits // 10 or 1)
+    m = operand(rng, digits) | 1
+    s = str(a)
+    e = rng.getrandbits(64)
+    return [
+        ("mul", lambda: a * b),
+        ("mul 10:1", lambda: a * c),
+        ("square", lambda: a * a),
+        ("pow mod", lambda: pow(a, e, m)),
+        ("str", lambda: str(a)),
+        ("long", lambda: long(s)),
+    ]
+
+
+def run(options):
+    names = None
+    for digits in SIZES:
+        if digits > options.max_digits:
+            break
+        rng = random.Random(digits)
+        work = [(name, func) for name, func in workloads(rng, digits)
+                if not options.ops or name.split()[0] in options.ops]
+        if names is None:
+            names = [name for name, func in work]
+            print("%-10s" % "digits" + "".join("%12s" % n for n in names))
+        row = []
+        for name, func in work:
+            # pow() at the biggest sizes costs hundreds of multiplications
+            if name == "pow mod" and digits > options.max_pow_digits:
+                row.append("%12s" % "-")
+                continue
+            t = bench(func, options.min_time, options.repeat)
+            row.append("%11.4gs" % t)
+        print("%-10d" % digits + "".join(row))
+
+
+def main():
+    usage = "usage: %prog [-h|--help] [options] [operation ...]"
+    parser = OptionParser(usage=usage)
+    parser.add_option("-m", "--max-digits",
+                      action="store", type="int", dest="max_digits",
+                      default=SIZES[-1],
+                      help="largest operands, in decimal digits "
+                           "(default: %d)" % SIZES[-1])
+    parser.add_option("-p", "--max-pow-digits",
+                      action="store", type="int", dest="max_pow_digits",
+                      default=30000,
+                      help="largest modulus for pow(), in decimal digits "
+                           "(default: 30000)")
+    parser.add_option("-t", "--min-time",
+                      action="store", type="float", dest="min_time",
+                      default=0.2,
+                      help="seconds to repeat each operation for "
+                           "(default: 0.2)")
+    parser.add_option("-r", "--repeat",
+                      action="store", type="int", dest="repeat", default=3,
+                      help="runs of each operation to take the best of "
+                           "(default: 3)")
+    options, args = parser.parse_args()
+    options.ops = args
+    run(options)
+
+if __name__ == "__main__":
+    main()
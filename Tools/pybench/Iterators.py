@@ -0,0 +1,196 @@
+from pybench import Test
+
+class PythonIterators(Test):
+
+    version = 2.0
+    operations = 5*4
+    rounds = 40000
+
+    def test(self):
+
+        class Countdown(object):
+            def __init__(self, n):
+                self.n = n
+            def __iter__(self):
+                return self
+            def next(self):
+                n = self.n
+                if n == 0:
+                    raise StopIteration
+                self.n = n - 1
+                return n
+
+        # Short iterations, so that raising and swallowing the final
+        # StopIteration weighs in
+        for i in xrange(self.rounds):
+
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+            for x in Countdown(2): pass
+
+    def calibrate(self):
+
+        class Countdown(object):
+            def __init__(self, n):
+                self.n = n
+            def __iter__(self):
+                return self
+            def next(self):
+                n = self.n
+                if n == 0:
+                    raise StopIteration
+                self.n = n - 1
+                return n
+
+        for i in xrange(self.rounds):
+            pass
+
+class PythonIteratorConsumers(Test):
+
+    version = 2.0
+    operations = 5*4
+    rounds = 30000
+
+    def test(self):
+
+        class Countdown(object):
+            def __init__(self, n):
+                self.n = n
+            def __iter__(self):
+                return self
+            def next(self):
+                n = self.n
+                if n == 0:
+                    raise StopIteration
+                self.n = n - 1
+                return n
+
+        # Iterators drained from C, through PyIter_Next()
+        for i in xrange(self.rounds):
+
+            l = list(Countdown(2))
+            t = tuple(Countdown(2))
+            s = sum(Countdown(2))
+            a, b = Countdown(2)
+
+            l = list(Countdown(2))
+            t = tuple(Countdown(2))
+            s = sum(Countdown(2))
+            a, b = Countdown(2)
+
+            l = list(Countdown(2))
+            t = tuple(Countdown(2))
+            s = sum(Countdown(2))
+            a, b = Countdown(2)
+
+            l = list(Countdown(2))
+            t = tuple(Countdown(2))
+            s = sum(Countdown(2))
+            a, b = Countdown(2)
+
+            l = list(Countdown(2))
+            t = tuple(Countdown(2))
+            s = sum(Countdown(2))
+            a, b = Countdown(2)
+
+    def calibrate(self):
+
+        class Countdown(object):
+            def __init__(self, n):
+                self.n = n
+            def __iter__(self):
+                return self
+            def next(self):
+                n = self.n
+                if n == 0:
+                    raise StopIteration
+                self.n = n - 1
+                return n
+
+        for i in xrange(self.rounds):
+            pass
+
+class GeneratorIterators(Test):
+
+    version = 2.0
+    operations = 5*4
+    rounds = 40000
+
+    def test(self):
+
+        def countdown(n):
+            while n:
+                yield n
+                n = n - 1
+
+        def raising_countdown(n):
+            while 1:
+                if n == 0:
+                    raise StopIteration
+                yield n
+                n = n - 1
+
+        for i in xrange(self.rounds):
+
+            for x in countdown(2): pass
+            for x in countdown(2): pass
+            for x in raising_countdown(2): pass
+            for x in raising_countdown(2): pass
+
+            for x in countdown(2): pass
+            for x in countdown(2): pass
+            for x in raising_countdown(2): pass
+            for x in raising_countdown(2): pass
+
+            for x in countdown(2): pass
+            for x in countdown(2): pass
+            for x in raising_countdown(2): pass
+            for x in raising_countdown(2): pass
+
+            for x in countdown(2): pass
+            for x in countdown(2): pass
+            for x in raising_countdown(2): pass
+            for x in raising_countdown(2): pass
+
+            for x in countdown(2): pass
+            for x in countdown(2): pass
+            for x in raising_countdown(2): pass
+            for x in raising_countdown(2): pass
+
+    def calibrate(self):
+
+        def countdown(n):
+            while n:
+                yield n
+                n = n - 1
+
+        def raising_countdown(n):
+            while 1:
+                if n == 0:
+                    raise StopIteration
+                yield n
+                n = n - 1
+
+        for i in xrange(self.rounds):
+            pass
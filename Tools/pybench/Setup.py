@@ -30,6 +30,7 @@ from Lists import *
 from Tuples import *
 from Dict import *
 from Exceptions import *
+from Iterators import *
 try:
     from With import *
 except SyntaxError:
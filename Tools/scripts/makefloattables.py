@@ -0,0 +1,135 @@
+#! /usr/bin/env python
+"""Generate the tables of powers of five and ten used to convert doubles.
+
+Usage: makefloattables.py [directory]
+
+Writes ryu_tables.h, for repr() in Python/ryu.c, and
+eisel_lemire_tables.h, for float() in Python/dtoa.c, to the given
+directory, or to Python.  Each entry is a 128-bit integer, written as
+low and high 64-bit words built from 32-bit halves so that no compiler
+needs 64-bit literals.
+"""
+
+import os
+import sys
+
+# bits kept of each power of five and of each inverse power of five
+POW5_BITCOUNT = 125
+POW5_INV_BITCOUNT = 125
+
+# IEEE 754 double: e2 is the binary exponent of the mantissa times 4,
+# as ryu.c computes it
+MANTISSA_BITS = 52
+BIAS = 1023
+E2_MAX = (1 << 11) - 2 - BIAS - MANTISSA_BITS - 2
+E2_MIN = 1 - BIAS - MANTISSA_BITS - 2
+
+
+def pow5bits(e):
+    """ceil(log2(5**e)), or 1 for e == 0, as ryu.c computes it."""
+    return ((e * 1217359) >> 19) + 1
+
+
+def log10pow2(e):
+    return (e * 78913) >> 18
+
+
+def log10pow5(e):
+    return (e * 732923) >> 20
+
+
+def pow5_split(i):
+    """The POW5_BITCOUNT leading bits of 5**i."""
+    pow5 = 5 ** i
+    shift = pow5.bit_length() - POW5_BITCOUNT
+    assert pow5.bit_length() == pow5bits(i) or i == 0
+    if shift >= 0:
+        return pow5 >> shift
+    return pow5 << -shift
+
+
+def pow5_inv_split(q):
+    """floor(2**k / 5**q) + 1 with k = pow5bits(q) - 1 + POW5_INV_BITCOUNT."""
+    pow5 = 5 ** q
+    k = pow5.bit_length() - 1 + POW5_INV_BITCOUNT
+    return (1 << k) // pow5 + 1
+
+
+# the exponents q for which dtoa.c looks up 10**q
+EISEL_LEMIRE_MIN_EXP10 = -342
+EISEL_LEMIRE_MAX_EXP10 = 308
+
+
+def pow10_split(q):
+    """The 128 leading bits of 10**q, rounded down."""
+    if q >= 0:
+        pow10 = 10 ** q
+        shift = pow10.bit_length() - 128
+        if shift >= 0:
+            return pow10 >> shift
+        return pow10 << -shift
+    pow10 = 10 ** -q
+    return (1 << (127 + pow10.bit_length())) // pow10
+
+
+def entry(value, macro):
+    """value as {low, high}, each word made by macro(high half, low half)."""
+    assert 0 < value < 1 << 128
+    words = [(value >> shift) & 0xffffffff for shift in (32, 0, 96, 64)]
+    return "{%s(0x%08x, 0x%08x), %s(0x%08x, 0x%08x)}" % (
+        macro, words[0], words[1], macro, words[2], words[3])
+
+
+def table(out, name, comment, values, macro):
+    out.write("/* %s */\n" % comment)
+    out.write("static const PY_UINT64_T %s[%d][2] = {\n" % (name, len(values)))
+    for value in values:
+        out.write("    %s,\n" % entry(value, macro))
+    out.write("};\n\n")
+
+
+def header(out):
+    out.write("/* this file was generated by %s */\n\n" %
+              "Tools/scripts/makefloattables.py")
+
+
+def write_ryu_tables(path):
+    # largest indexes ryu.c uses: q for e2 >= 0, and -e2 - q for e2 < 0
+    inv_size = log10pow2(E2_MAX) - 1 + 1
+    pow5_size = -E2_MIN - (log10pow5(-E2_MIN) - 1) + 1
+    out = open(path, "w")
+    header(out)
+    out.write("#define RYU_POW5_BITCOUNT %d\n" % POW5_BITCOUNT)
+    out.write("#define RYU_POW5_INV_BITCOUNT %d\n\n" % POW5_INV_BITCOUNT)
+    table(out, "ryu_pow5_inv_split",
+          "floor(2**(pow5bits(q) - 1 + %d) / 5**q) + 1, low word first"
+          % POW5_INV_BITCOUNT,
+          [pow5_inv_split(q) for q in range(inv_size)], "RYU_U64")
+    table(out, "ryu_pow5_split",
+          "the leading %d bits of 5**i, low word first" % POW5_BITCOUNT,
+          [pow5_split(i) for i in range(pow5_size)], "RYU_U64")
+    out.close()
+
+
+def write_eisel_lemire_tables(path):
+    out = open(path, "w")
+    header(out)
+    out.write("#define EL_MIN_EXP10 %d\n" % EISEL_LEMIRE_MIN_EXP10)
+    out.write("#define EL_MAX_EXP10 %d\n\n" % EISEL_LEMIRE_MAX_EXP10)
+    table(out, "el_pow10_split",
+          "the leading 128 bits of 10**q, rounded down, for q from "
+          "EL_MIN_EXP10;\n   low word first",
+          [pow10_split(q) for q in range(EISEL_LEMIRE_MIN_EXP10,
+                                         EISEL_LEMIRE_MAX_EXP10 + 1)],
+          "EL_U64")
+    out.close()
+
+
+def main():
+    directory = sys.argv[1] if len(sys.argv) > 1 else "Python"
+    write_ryu_tables(os.path.join(directory, "ryu_tables.h"))
+    write_eisel_lemire_tables(os.path.join(directory,
+                                           "eisel_lemire_tables.h"))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,165 @@
+# -*- coding: utf-8 -*-
+"""Time substring search over log files, as grep-like scripts do it.
+
+A log of web server and application lines is generated from a fixed seed,
+so that runs are comparable between interpreters.  Each workload searches
+it with str, unicode (with some non-ASCII lines, as real logs have) and
+bytearray methods: find() and "in", count(), split(), replace() and
+partition().  The "adversarial" group searches for needles that make a
+naive search quadratic, such as a long run of one character ended by
+another.
+"""
+
+import random
+import time
+from optparse import OptionParser
+
+METHODS = ["GET", "GET", "GET", "POST", "PUT", "DELETE"]
+PATHS = ["/", "/index.html", "/api/v1/users", "/api/v1/orders",
+         "/static/app.js", "/static/style.css", "/login", "/search"]
+LEVELS = ["DEBUG", "INFO", "INFO", "INFO", "WARNING", "ERROR"]
+WORDS = ["request", "handled", "user", "session", "cache", "miss", "hit",
+         "timeout", "retry", "connection", "closed", "opened", "query",
+         "slow", "backend", "upstream", "worker", "queue", "job", "done"]
+NAMES = [u"Zoë", u"José", u"Łukasz", u"Ærøskøbing", u"Müller"]
+
+
+def make_log(lines, seed=1):
+    """Return the log as a unicode string."""
+    rng = random.Random(seed)
+    out = []
+    for i in xrange(lines):
+        stamp = u"2012-04-%02d %02d:%02d:%02d,%03d" % (
+            1 + i * 30 // lines, rng.randrange(24), rng.randrange(60),
+            rng.randrange(60), rng.randrange(1000))
+        if rng.random() < 0.6:
+            out.append(u'%s 10.0.%d.%d "%s %s HTTP/1.1" %d %d\n' % (
+                stamp, rng.randrange(256), rng.randrange(256),
+                rng.choice(METHODS), rng.choice(PATHS),
+                rng.choice((200, 200, 200, 304, 404, 500)),
+                rng.randrange(100000)))
+        else:
+            words = u" ".join(rng.choice(WORDS)
+                              for j in range(rng.randrange(3, 12)))
+            if rng.random() < 0.05:
+                words += u" for " + rng.choice(NAMES)
+            out.append(u"%s %s [worker-%d] %s\n" % (
+                stamp, rng.choice(LEVELS), rng.randrange(16), words))
+    return u"".join(out)
+
+
+def workloads(log):
+    """Yield (group, name, function) for each workload over log."""
+    # find() and "in" mostly scan the whole log, as they do for a line
+    # that isn't there
+    for name, needle in [("char", u"|"), ("word", u"FATAL"),
+                         ("phrase", u"upstream timeout retry"),
+                         ("long", u"Segmentation fault (core dumped)")]:
+        yield "find", name, lambda h=log, n=needle: h.find(n)
+        yield "find", name + " in", lambda h=log, n=needle: n in h
+    for name, needle in [("char", u"E"), ("word", u"ERROR"),
+                         ("phrase", u"connection closed")]:
+        yield "count", name, lambda h=log, n=needle: h.count(n)
+    yield "split", "lines", lambda h=log, n=u"\n": h.split(n)
+    yield "split", "fields", lambda h=log, n=u" [worker-": h.split(n)
+    yield "replace", "level", \
+          lambda h=log, o=u"WARNING", n=u"WARN": h.replace(o, n)
+    yield "replace", "missing", \
+          lambda h=log, o=u"FATAL", n=u"CRIT": h.replace(o, n)
+    yield "partition", "rpartition", \
+          lambda h=log, n=u" 500 ": h.rpartition(n)
+    yield "partition", "partition", \
+          lambda h=log, n=u"job done\n": h.partition(n)
+
+    n = len(log)
+    bad = [("run+1", u"a" * n, u"a" * 1000 + u"ba"),
+           ("run+1 short", u"a" * n, u"a" * 30 + u"ba"),
+           ("periodic", u"ab" * (n // 2), u"ab" * 300 + u"bb" + u"ab" * 10),
+           ("near miss", (u"x" * 99 + u"\n") * (n // 100),
+            u"x" * 100 + u"\n")]
+    for name, hay, needle in bad:
+        yield "adversarial", name, lambda h=hay, n=needle: h.find(n)
+        yield "adversarial", name + " count", \
+              lambda h=hay, n=needle: h.count(n)
+        # the same search from the other end
+        yield "adversarial", name + " rfind", \
+              lambda h=hay[::-1], n=needle[::-1]: h.rfind(n)
+
+
+def convert(func, kind):
+    """Bind func's default arguments, the haystack and the needles, to
+    strings of the given kind."""
+    defaults = func.func_defaults
+    if kind == "str":
+        defaults = tuple(d.encode("utf-8") for d in defaults)
+    elif kind == "bytearray":
+        defaults = tuple(bytearray(d.encode("utf-8")) for d in defaults)
+    return type(func)(func.func_code, func.func_globals, func.func_name,
+                      defaults)
+
+
+def bench(func, repeat, target=0.05):
+    """Return the best time of one call to func, in seconds."""
+    loops = 1
+    while True:
+        t = time.time()
+        for i in xrange(loops):
+            func()
+        t = time.time() - t
+        if t >= target or loops >= 1 << 20:
+            break
+        loops *= 2
+    best = t / loops
+    for r in xrange(repeat - 1):
+        t = time.time()
+        for i in xrange(loops):
+            func()
+        best = min(best, (time.time() - t) / loops)
+    return best
+
+
+def run(options):
+    log = make_log(options.lines)
+    print("log: %d lines, %d characters" % (options.lines, len(log)))
+    kinds = options.kinds.split(",")
+    print("%-12s %-16s" % ("", "") +
+          "".join("%12s" % kind for kind in kinds))
+    total = dict.fromkeys(kinds, 0.0)
+    for group, name, func in workloads(log):
+        if options.groups and group not in options.groups:
+            continue
+        row = []
+        for kind in kinds:
+            t = bench(convert(func, kind), options.repeat)
+            total[kind] += t
+            row.append("%10.3f" % (t * 1e3) + "ms")
+        print("%-12s %-16s" % (group, name) + "".join(row))
+    print("%-12s %-16s" % ("total", "") +
+          "".join("%10.3f" % (total[kind] * 1e3) + "ms" for kind in kinds))
+
+
+def main():
+    usage = "usage: %prog [-h|--help] [options] [group ...]"
+    parser = OptionParser(usage=usage)
+    parser.add_option("-n", "--lines",
+                      action="store", type="int", dest="lines",
+                      default=20000,
+                      help="lines of log to search (default: 20000)")
+    parser.add_option("-r", "--repeat",
+                      action="store", type="int", dest="repeat", default=5,
+                      help="runs of each workload to take the best of "
+                           "(default: 5)")
+    parser.add_option("-k", "--kinds",
+                      action="store", type="string", dest="kinds",
+                      default="str,unicode,bytearray",
+                      help="comma-separated string types to time "
+                           "(default: str,unicode,bytearray)")
+    options, args = parser.parse_args()
+    options.groups = args
+    for kind in options.kinds.split(","):
+        if kind not in ("str", "unicode", "bytearray"):
+            parser.error("unknown string type: %r" % kind)
+    run(options)
+
+if __name__ == "__main__":
+    main()
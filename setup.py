@@ -530,6 +530,9 @@ class PyBuildExt(build_ext):
         # profilers (_lsprof is for cProfile.py)
         exts.append( Extension('_hotshot', ['_hotshot.c']) )
         exts.append( Extension('_lsprof', ['_lsprof.c', 'rotatingtree.c']) )
+        # allocation tracing (for tracemalloc.py)
+        exts.append( Extension('_tracemalloc', ['_tracemalloc.c'],
+                               libraries=math_libs) )
         # static Unicode character database
         if have_unicode:
             exts.append( Extension('unicodedata', ['unicodedata.c']) )